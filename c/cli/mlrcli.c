@@ -113,6 +113,10 @@ static void usage_unrecognized_verb(char* argv0, char* arg);
 
 static void check_arg_count(char** argv, int argi, int argc, int n);
 static mapper_setup_t* look_up_mapper_setup(char* verb);
+static sllv_t* cli_parse_mappers_up_to(char** argv, int* pargi, int argc, cli_opts_t* popts, int* pno_input,
+	int max_mapper_count);
+static char** copy_argv(int argc, char** argv);
+static void free_argv(int argc, char** argv);
 
 static int handle_terminal_usage(char** argv, int argc, int argi);
 
@@ -179,6 +183,17 @@ cli_opts_t* parse_command_line(int argc, char** argv, sllv_t** ppmapper_list) {
 			}
 			argi += 2;
 
+		} else if (streq(argv[argi], "--threads")) {
+			check_arg_count(argv, argi, argc, 2);
+			if (sscanf(argv[argi+1], "%d", &popts->nthreads) != 1 || popts->nthreads <= 0) {
+				fprintf(stderr,
+					"%s: --threads argument must be a positive integer; got \"%s\".\n",
+					MLR_GLOBALS.bargv0, argv[argi+1]);
+				main_usage_short(stderr, MLR_GLOBALS.bargv0);
+				exit(1);
+			}
+			argi += 2;
+
 		} else if (streq(argv[argi], "--seed")) {
 			check_arg_count(argv, argi, argc, 2);
 			if (sscanf(argv[argi+1], "0x%x", &rand_seed) == 1) {
@@ -237,8 +252,11 @@ cli_opts_t* parse_command_line(int argc, char** argv, sllv_t** ppmapper_list) {
 	// mappers operate on all input files. Also retain information needed to construct them
 	// for each input file, for in-place mode.
 	popts->mapper_argb = argi;
-	popts->argv = argv;
+	popts->argv = copy_argv(argc, argv);
 	popts->argc = argc;
+	// Set ahead of mlr_global_init since put and filter evaluate constant expressions as they're
+	// parsed, which may involve formatting floats.
+	MLR_GLOBALS.ofmt = popts->ofmt;
 	*ppmapper_list = cli_parse_mappers(argv, &argi, argc, popts, &no_input);
 
 	for ( ; argi < argc; argi++) {
@@ -271,8 +289,55 @@ cli_opts_t* parse_command_line(int argc, char** argv, sllv_t** ppmapper_list) {
 // Returns a list of mappers, from the starting point in argv given by *pargi. Bumps *pargi to
 // point to remaining post-mapper-setup args, i.e. filenames.
 sllv_t* cli_parse_mappers(char** argv, int* pargi, int argc, cli_opts_t* popts, int* pno_input) {
+	return cli_parse_mappers_up_to(argv, pargi, argc, popts, pno_input, -1);
+}
+
+// Mapper CLI parsers may modify their arguments in place (e.g. splitting comma-separated lists
+// with strsep) and keep pointers into them, so each reconstruction gets its own copy of the
+// original arguments, which the caller frees along with the mappers.
+sllv_t* cli_reparse_mappers(cli_opts_t* popts, char*** pargv_copy) {
+	int argi = popts->mapper_argb;
+	int unused;
+	*pargv_copy = copy_argv(popts->argc, popts->argv);
+	return cli_parse_mappers_up_to(*pargv_copy, &argi, popts->argc, popts, &unused, -1);
+}
+
+sllv_t* cli_parse_stateless_mappers(cli_opts_t* popts, char*** pargv_copy) {
+	MLR_INTERNAL_CODING_ERROR_IF(popts->num_stateless_mappers < 1);
+	int argi = popts->mapper_argb;
+	int unused;
+	*pargv_copy = copy_argv(popts->argc, popts->argv);
+	return cli_parse_mappers_up_to(*pargv_copy, &argi, popts->argc, popts, &unused,
+		popts->num_stateless_mappers);
+}
+
+void cli_argv_copy_free(cli_opts_t* popts, char** argv_copy) {
+	free_argv(popts->argc, argv_copy);
+}
+
+static char** copy_argv(int argc, char** argv) {
+	char** copy = mlr_malloc_or_die((argc + 1) * sizeof(char*));
+	for (int i = 0; i < argc; i++)
+		copy[i] = mlr_strdup_or_die(argv[i]);
+	copy[argc] = NULL;
+	return copy;
+}
+
+static void free_argv(int argc, char** argv) {
+	for (int i = 0; i < argc; i++)
+		free(argv[i]);
+	free(argv);
+}
+
+// With max_mapper_count of -1, parses the whole then-chain and records the length of its stateless
+// prefix in popts; else, stops after max_mapper_count mappers.
+static sllv_t* cli_parse_mappers_up_to(char** argv, int* pargi, int argc, cli_opts_t* popts, int* pno_input,
+	int max_mapper_count)
+{
 	sllv_t* pmapper_list = sllv_alloc();
 	int argi = *pargi;
+	int num_stateless_mappers = 0;
+	mapper_setup_t* pprev_mapper_setup = NULL;
 
 	// Allow then-chains to start with an initial 'then': 'mlr verb1 then verb2 then verb3' or
 	// 'mlr then verb1 then verb2 then verb3'. Particuarly useful in backslashy scripting contexts.
@@ -317,13 +382,33 @@ sllv_t* cli_parse_mappers(char** argv, int* pargi, int argc, cli_opts_t* popts,
 			*pno_input = TRUE;
 		}
 
+		if (num_stateless_mappers == pmapper_list->length && pmapper_setup->pis_stateless_func != NULL
+			&& pmapper_setup->pis_stateless_func(pmapper))
+		{
+			num_stateless_mappers++;
+		}
+
+		// E.g. 'sort -nr x then head -n 10': the sort need keep only the top ten.
+		if (pprev_mapper_setup != NULL && pprev_mapper_setup->pset_output_limit_func != NULL
+			&& pmapper_setup->pget_input_limit_func != NULL)
+		{
+			long long limit = pmapper_setup->pget_input_limit_func(pmapper);
+			if (limit >= 0LL)
+				pprev_mapper_setup->pset_output_limit_func(pmapper_list->ptail->pvvalue, limit);
+		}
+		pprev_mapper_setup = pmapper_setup;
+
 		sllv_append(pmapper_list, pmapper);
 
+		if (pmapper_list->length == max_mapper_count)
+			break;
 		if (argi >= argc || !streq(argv[argi], "then"))
 			break;
 		argi++;
 	}
 
+	if (max_mapper_count < 0)
+		popts->num_stateless_mappers = num_stateless_mappers;
 	*pargi = argi;
 	return pmapper_list;
 }
@@ -334,6 +419,7 @@ void cli_opts_free(cli_opts_t* popts) {
 		return;
 
 	slls_free(popts->filenames);
+	free_argv(popts->argc, popts->argv);
 	free(popts);
 	free_opt_singletons();
 }
@@ -874,6 +960,19 @@ static void main_usage_other_options(FILE* o, char* argv0) {
 	fprintf(o, "                     urand()/urandint()/urand32().\n");
 	fprintf(o, "  --nr-progress-mod {m}, with m a positive integer: print filename and record\n");
 	fprintf(o, "                     count to stderr every m input records.\n");
+	fprintf(o, "  --threads {n}      With n > 1, run the record reader, the verb chain, and the\n");
+	fprintf(o, "                     record writer concurrently on separate threads. Record\n");
+	fprintf(o, "                     order is preserved, but text which verbs write directly\n");
+	fprintf(o, "                     to standard output (e.g. put's print/dump/tee > stdout)\n");
+	fprintf(o, "                     may interleave differently with the record output.\n");
+	fprintf(o, "                     Memory-mapped DKVP, NIDX, and CSV-lite input files are\n");
+	fprintf(o, "                     additionally split into chunks which are parsed by n\n");
+	fprintf(o, "                     threads in parallel. Likewise, if the then-chain starts\n");
+	fprintf(o, "                     with per-record verbs such as cat, cut, rename, label,\n");
+	fprintf(o, "                     grep, sec2gmt, or put/filter without begin/end blocks,\n");
+	fprintf(o, "                     out-of-stream variables, or output statements, those run\n");
+	fprintf(o, "                     on n threads in parallel. Some verbs, such as stats1\n");
+	fprintf(o, "                     and join -u, also use n worker threads. Defaults to 1.\n");
 	fprintf(o, "  --from {filename}  Use this to specify an input file before the verb(s),\n");
 	fprintf(o, "                     rather than after. May be used more than once. Example:\n");
 	fprintf(o, "                     \"%s --from a.dat --from b.dat cat\" is the same as\n", argv0);
@@ -976,6 +1075,8 @@ void cli_opts_init(cli_opts_t* popts) {
 
 	popts->ofmt            = NULL;
 	popts->nr_progress_mod = 0LL;
+	popts->nthreads        = 1;
+	popts->num_stateless_mappers = 0;
 
 	popts->do_in_place     = FALSE;
 }
@@ -71,6 +71,9 @@ typedef struct _cli_opts_t {
 
 	char* ofmt;
 	long long nr_progress_mod;
+	int nthreads;
+	// Length of the stateless prefix of the mapper chain; see mapper_is_stateless_func_t.
+	int num_stateless_mappers;
 
 	int do_in_place;
 
@@ -82,6 +85,14 @@ cli_opts_t* parse_command_line(int argc, char** argv, sllv_t** ppmapper_list);
 // See stream.c. The idea is that the mapper-chain is constructed once for normal stream-over-all-files
 // mode, but per-file for in-place mode.
 sllv_t* cli_parse_mappers(char** argv, int* pargi, int argc, cli_opts_t* popts, int* pno_input);
+// Constructs another instance of the mapper chain, e.g. per file in in-place mode. The mappers may
+// keep pointers into their arguments, so these are parsed from a copy, returned in *pargv_copy, to
+// be freed with cli_argv_copy_free once the mappers are.
+sllv_t* cli_reparse_mappers(cli_opts_t* popts, char*** pargv_copy);
+// Constructs another instance of the stateless prefix of the mapper chain, for a worker thread.
+// Likewise for *pargv_copy.
+sllv_t* cli_parse_stateless_mappers(cli_opts_t* popts, char*** pargv_copy);
+void cli_argv_copy_free(cli_opts_t* popts, char** argv_copy);
 
 int cli_handle_reader_options(char** argv, int argc, int *pargi, cli_reader_opts_t* preader_opts);
 int cli_handle_writer_options(char** argv, int argc, int *pargi, cli_writer_opts_t* pwriter_opts);
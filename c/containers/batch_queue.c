@@ -0,0 +1,65 @@
+#include "lib/mlrutil.h"
+#include "containers/batch_queue.h"
+
+// ----------------------------------------------------------------
+batch_queue_t* batch_queue_alloc(int capacity) {
+	MLR_INTERNAL_CODING_ERROR_IF(capacity < 1);
+	batch_queue_t* pqueue = mlr_malloc_or_die(sizeof(batch_queue_t));
+	pqueue->pvvalues  = mlr_malloc_or_die(capacity * sizeof(void*));
+	pqueue->capacity  = capacity;
+	pqueue->head      = 0;
+	pqueue->length    = 0;
+	pqueue->is_closed = FALSE;
+	pthread_mutex_init(&pqueue->mutex, NULL);
+	pthread_cond_init(&pqueue->not_empty, NULL);
+	pthread_cond_init(&pqueue->not_full, NULL);
+	return pqueue;
+}
+
+// ----------------------------------------------------------------
+void batch_queue_free(batch_queue_t* pqueue) {
+	if (pqueue == NULL)
+		return;
+	pthread_mutex_destroy(&pqueue->mutex);
+	pthread_cond_destroy(&pqueue->not_empty);
+	pthread_cond_destroy(&pqueue->not_full);
+	free(pqueue->pvvalues);
+	free(pqueue);
+}
+
+// ----------------------------------------------------------------
+void batch_queue_put(batch_queue_t* pqueue, void* pvvalue) {
+	MLR_INTERNAL_CODING_ERROR_IF(pvvalue == NULL);
+	pthread_mutex_lock(&pqueue->mutex);
+	MLR_INTERNAL_CODING_ERROR_IF(pqueue->is_closed);
+	while (pqueue->length == pqueue->capacity)
+		pthread_cond_wait(&pqueue->not_full, &pqueue->mutex);
+	pqueue->pvvalues[(pqueue->head + pqueue->length) % pqueue->capacity] = pvvalue;
+	pqueue->length++;
+	pthread_cond_signal(&pqueue->not_empty);
+	pthread_mutex_unlock(&pqueue->mutex);
+}
+
+// ----------------------------------------------------------------
+void* batch_queue_get(batch_queue_t* pqueue) {
+	pthread_mutex_lock(&pqueue->mutex);
+	while (pqueue->length == 0 && !pqueue->is_closed)
+		pthread_cond_wait(&pqueue->not_empty, &pqueue->mutex);
+	void* pvvalue = NULL;
+	if (pqueue->length > 0) {
+		pvvalue = pqueue->pvvalues[pqueue->head];
+		pqueue->head = (pqueue->head + 1) % pqueue->capacity;
+		pqueue->length--;
+		pthread_cond_signal(&pqueue->not_full);
+	}
+	pthread_mutex_unlock(&pqueue->mutex);
+	return pvvalue;
+}
+
+// ----------------------------------------------------------------
+void batch_queue_close(batch_queue_t* pqueue) {
+	pthread_mutex_lock(&pqueue->mutex);
+	pqueue->is_closed = TRUE;
+	pthread_cond_broadcast(&pqueue->not_empty);
+	pthread_mutex_unlock(&pqueue->mutex);
+}
@@ -0,0 +1,33 @@
+// ================================================================
+// Bounded blocking FIFO of void-star, for handing batches of records between
+// stream stages which run on separate threads. Producers block while the queue
+// is full and consumers block while it is empty. The producer calls
+// batch_queue_close() at end of stream, after which batch_queue_get() returns
+// NULL once the remaining items have been drained.
+// ================================================================
+
+#ifndef BATCH_QUEUE_H
+#define BATCH_QUEUE_H
+
+#include <pthread.h>
+
+typedef struct _batch_queue_t {
+	void**          pvvalues; // circular buffer
+	int             capacity;
+	int             head;
+	int             length;
+	int             is_closed;
+	pthread_mutex_t mutex;
+	pthread_cond_t  not_empty;
+	pthread_cond_t  not_full;
+} batch_queue_t;
+
+batch_queue_t* batch_queue_alloc(int capacity);
+void batch_queue_free(batch_queue_t* pqueue);
+
+// The value must be non-null since null is the end-of-stream indicator for batch_queue_get.
+void  batch_queue_put(batch_queue_t* pqueue, void* pvvalue);
+void* batch_queue_get(batch_queue_t* pqueue);
+void  batch_queue_close(batch_queue_t* pqueue);
+
+#endif // BATCH_QUEUE_H
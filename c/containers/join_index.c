@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "lib/mlrutil.h"
+#include "lib/mlr_globals.h"
+#include "lib/string_builder.h"
+#include "containers/join_bucket_keeper.h"
+#include "containers/lrec_spill.h"
+#include "containers/join_index.h"
+
+// ----------------------------------------------------------------
+// File layout: the header is an array of unsigned 64-bit words in native byte order, indexed as
+// follows; the byte-order word detects an index copied between unlike machines. Offsets are from
+// the start of the file. Each bucket is four words: hash, join-field-values offset, records
+// offset, record count. Join-field values are stored NUL-terminated, back to back.
+
+#define JOIN_INDEX_MAGIC "MLRJIX01"
+#define JOIN_INDEX_BYTE_ORDER 0x0102030405060708ULL
+
+#define HDR_MAGIC              0
+#define HDR_BYTE_ORDER         1
+#define HDR_LEFT_FILE_SIZE     2
+#define HDR_LEFT_FILE_MTIME    3
+#define HDR_LEFT_FILE_MTIME_NS 4
+#define HDR_LEFT_FILE_INODE    5
+#define HDR_OPTIONS_OFFSET     6
+#define HDR_NUM_BUCKETS        7
+#define HDR_BUCKETS_OFFSET     8
+#define HDR_HASH_TABLE_SIZE    9
+#define HDR_HASH_TABLE_OFFSET  10
+#define HDR_NUM_UNPAIRED       11
+#define HDR_UNPAIRED_OFFSET    12
+#define HDR_FILE_SIZE          13
+#define HDR_NUM_WORDS          16
+
+#define BUCKET_HASH           0
+#define BUCKET_VALUES_OFFSET  1
+#define BUCKET_RECORDS_OFFSET 2
+#define BUCKET_NUM_RECORDS    3
+#define BUCKET_NUM_WORDS      4
+
+static char* join_index_options_string(cli_reader_opts_t* preader_opts, slls_t* pleft_field_names);
+static void stat_left_file_or_die(char* left_file_name, struct stat* pstat);
+static unsigned long long join_index_hash(slls_t* pleft_field_values);
+static lrec_t* join_index_decode_record(char** pp);
+static void fwrite_or_die(void* p, size_t size, FILE* fp, char* file_name);
+
+// ----------------------------------------------------------------
+void join_index_write(char* index_file_name, char* left_file_name, cli_reader_opts_t* preader_opts,
+	slls_t* pleft_field_names, lhmslv_t* pbuckets, sllv_t* punpaired_records)
+{
+	unsigned long long header[HDR_NUM_WORDS];
+	memset(header, 0, sizeof(header));
+	memcpy(&header[HDR_MAGIC], JOIN_INDEX_MAGIC, sizeof(header[HDR_MAGIC]));
+	header[HDR_BYTE_ORDER] = JOIN_INDEX_BYTE_ORDER;
+
+	struct stat left_stat;
+	stat_left_file_or_die(left_file_name, &left_stat);
+	header[HDR_LEFT_FILE_SIZE]     = left_stat.st_size;
+	header[HDR_LEFT_FILE_MTIME]    = left_stat.st_mtim.tv_sec;
+	header[HDR_LEFT_FILE_MTIME_NS] = left_stat.st_mtim.tv_nsec;
+	header[HDR_LEFT_FILE_INODE]    = left_stat.st_ino;
+
+	char* temp_file_name = mlr_paste_2_strings(index_file_name, ".XXXXXX");
+	int fd = mkstemp(temp_file_name);
+	if (fd < 0) {
+		fprintf(stderr, "%s join: could not create \"%s\": %s\n",
+			MLR_GLOBALS.bargv0, temp_file_name, strerror(errno));
+		exit(1);
+	}
+	// mkstemp makes the file private to the user; make it as readable as a plain create would.
+	mode_t mask = umask(0);
+	umask(mask);
+	fchmod(fd, 0666 & ~mask);
+	FILE* fp = fdopen(fd, "w");
+	if (fp == NULL) {
+		perror("fdopen");
+		exit(1);
+	}
+
+	fwrite_or_die(header, sizeof(header), fp, temp_file_name);
+
+	char* options = join_index_options_string(preader_opts, pleft_field_names);
+	header[HDR_OPTIONS_OFFSET] = ftell(fp);
+	fwrite_or_die(options, strlen(options) + 1, fp, temp_file_name);
+	free(options);
+
+	unsigned long long num_buckets = pbuckets->num_occupied;
+	unsigned long long* pbucket_words = mlr_malloc_or_die((num_buckets + 1) * BUCKET_NUM_WORDS * sizeof(unsigned long long));
+	unsigned long long bi = 0;
+	for (lhmslve_t* pe = pbuckets->phead; pe != NULL; pe = pe->pnext, bi++) {
+		join_bucket_t* pbucket = pe->pvvalue;
+		unsigned long long* pwords = &pbucket_words[bi * BUCKET_NUM_WORDS];
+		pwords[BUCKET_HASH] = join_index_hash(pbucket->pleft_field_values);
+		pwords[BUCKET_VALUES_OFFSET] = ftell(fp);
+		for (sllse_t* pf = pbucket->pleft_field_values->phead; pf != NULL; pf = pf->pnext)
+			fwrite_or_die(pf->value, strlen(pf->value) + 1, fp, temp_file_name);
+		pwords[BUCKET_RECORDS_OFFSET] = ftell(fp);
+		pwords[BUCKET_NUM_RECORDS] = pbucket->precords->length;
+		for (sllve_t* pf = pbucket->precords->phead; pf != NULL; pf = pf->pnext)
+			lrec_spill_write(fp, pf->pvvalue);
+	}
+
+	header[HDR_NUM_UNPAIRED] = punpaired_records->length;
+	header[HDR_UNPAIRED_OFFSET] = ftell(fp);
+	for (sllve_t* pf = punpaired_records->phead; pf != NULL; pf = pf->pnext)
+		lrec_spill_write(fp, pf->pvvalue);
+
+	// The bucket array and hash table are accessed in place so they must be word-aligned.
+	static char zeroes[sizeof(unsigned long long)];
+	long offset = ftell(fp);
+	fwrite_or_die(zeroes, (sizeof(unsigned long long) - offset % sizeof(unsigned long long)) % sizeof(unsigned long long),
+		fp, temp_file_name);
+
+	header[HDR_NUM_BUCKETS] = num_buckets;
+	header[HDR_BUCKETS_OFFSET] = ftell(fp);
+	fwrite_or_die(pbucket_words, num_buckets * BUCKET_NUM_WORDS * sizeof(unsigned long long), fp, temp_file_name);
+
+	// Load factor at most one half, for short probe sequences.
+	unsigned long long hash_table_size = 16;
+	while (hash_table_size < 2 * num_buckets)
+		hash_table_size <<= 1;
+	unsigned long long* phash_table = mlr_malloc_or_die(hash_table_size * sizeof(unsigned long long));
+	memset(phash_table, 0, hash_table_size * sizeof(unsigned long long));
+	for (bi = 0; bi < num_buckets; bi++) {
+		unsigned long long slot = pbucket_words[bi * BUCKET_NUM_WORDS + BUCKET_HASH] & (hash_table_size - 1);
+		while (phash_table[slot] != 0)
+			slot = (slot + 1) & (hash_table_size - 1);
+		phash_table[slot] = bi + 1;
+	}
+	header[HDR_HASH_TABLE_SIZE] = hash_table_size;
+	header[HDR_HASH_TABLE_OFFSET] = ftell(fp);
+	fwrite_or_die(phash_table, hash_table_size * sizeof(unsigned long long), fp, temp_file_name);
+	header[HDR_FILE_SIZE] = ftell(fp);
+
+	rewind(fp);
+	fwrite_or_die(header, sizeof(header), fp, temp_file_name);
+	if (fclose(fp) != 0) {
+		fprintf(stderr, "%s join: could not write \"%s\": %s\n",
+			MLR_GLOBALS.bargv0, temp_file_name, strerror(errno));
+		exit(1);
+	}
+	if (rename(temp_file_name, index_file_name) != 0) {
+		fprintf(stderr, "%s join: could not rename \"%s\" to \"%s\": %s\n",
+			MLR_GLOBALS.bargv0, temp_file_name, index_file_name, strerror(errno));
+		unlink(temp_file_name);
+		exit(1);
+	}
+
+	free(phash_table);
+	free(pbucket_words);
+	free(temp_file_name);
+}
+
+// ----------------------------------------------------------------
+join_index_t* join_index_open(char* index_file_name, char* left_file_name, cli_reader_opts_t* preader_opts,
+	slls_t* pleft_field_names)
+{
+	int fd = open(index_file_name, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "%s join: could not open index \"%s\": %s\n",
+			MLR_GLOBALS.bargv0, index_file_name, strerror(errno));
+		exit(1);
+	}
+	struct stat index_stat;
+	if (fstat(fd, &index_stat) < 0) {
+		perror("fstat");
+		fprintf(stderr, "%s join: could not fstat \"%s\"\n", MLR_GLOBALS.bargv0, index_file_name);
+		exit(1);
+	}
+	unsigned long long* header = NULL;
+	if (index_stat.st_size >= HDR_NUM_WORDS * sizeof(unsigned long long)) {
+		header = mmap(NULL, (size_t)index_stat.st_size, PROT_READ|PROT_WRITE, MAP_FILE|MAP_PRIVATE, fd, (off_t)0);
+		if (header == MAP_FAILED) {
+			perror("mmap");
+			fprintf(stderr, "%s join: could not mmap \"%s\"\n", MLR_GLOBALS.bargv0, index_file_name);
+			exit(1);
+		}
+	}
+	close(fd);
+
+	if (header == NULL || memcmp(&header[HDR_MAGIC], JOIN_INDEX_MAGIC, sizeof(header[HDR_MAGIC])) != 0
+		|| header[HDR_BYTE_ORDER] != JOIN_INDEX_BYTE_ORDER || header[HDR_FILE_SIZE] != index_stat.st_size)
+	{
+		fprintf(stderr, "%s join: \"%s\" is not a join index written by this version of %s.\n",
+			MLR_GLOBALS.bargv0, index_file_name, MLR_GLOBALS.bargv0);
+		exit(1);
+	}
+
+	struct stat left_stat;
+	stat_left_file_or_die(left_file_name, &left_stat);
+	char* options = join_index_options_string(preader_opts, pleft_field_names);
+	if (header[HDR_LEFT_FILE_SIZE] != left_stat.st_size
+		|| header[HDR_LEFT_FILE_MTIME] != left_stat.st_mtim.tv_sec
+		|| header[HDR_LEFT_FILE_MTIME_NS] != left_stat.st_mtim.tv_nsec
+		|| header[HDR_LEFT_FILE_INODE] != left_stat.st_ino)
+	{
+		fprintf(stderr, "%s join: index \"%s\" is out of date with respect to \"%s\"; please rebuild it using --build-index.\n",
+			MLR_GLOBALS.bargv0, index_file_name, left_file_name);
+		exit(1);
+	}
+	if (!streq((char*)header + header[HDR_OPTIONS_OFFSET], options)) {
+		fprintf(stderr, "%s join: index \"%s\" was built with different join-field names or input options; please rebuild it using --build-index.\n",
+			MLR_GLOBALS.bargv0, index_file_name);
+		exit(1);
+	}
+	free(options);
+
+	join_index_t* pindex = mlr_malloc_or_die(sizeof(join_index_t));
+	pindex->base                 = (char*)header;
+	pindex->phash_table          = (unsigned long long*)(pindex->base + header[HDR_HASH_TABLE_OFFSET]);
+	pindex->hash_table_size      = header[HDR_HASH_TABLE_SIZE];
+	pindex->pbuckets             = (unsigned long long*)(pindex->base + header[HDR_BUCKETS_OFFSET]);
+	pindex->num_buckets          = header[HDR_NUM_BUCKETS];
+	pindex->punpaired_records    = pindex->base + header[HDR_UNPAIRED_OFFSET];
+	pindex->num_unpaired_records = header[HDR_NUM_UNPAIRED];
+	return pindex;
+}
+
+// Here we intentionally do not munmap: see the top of join_index.h.
+void join_index_free(join_index_t* pindex) {
+	free(pindex);
+}
+
+// ----------------------------------------------------------------
+long long join_index_find(join_index_t* pindex, slls_t* pleft_field_values) {
+	unsigned long long hash = join_index_hash(pleft_field_values);
+	unsigned long long mask = pindex->hash_table_size - 1;
+	for (unsigned long long slot = hash & mask; pindex->phash_table[slot] != 0; slot = (slot + 1) & mask) {
+		unsigned long long bi = pindex->phash_table[slot] - 1;
+		unsigned long long* pwords = &pindex->pbuckets[bi * BUCKET_NUM_WORDS];
+		if (pwords[BUCKET_HASH] != hash)
+			continue;
+		char* p = pindex->base + pwords[BUCKET_VALUES_OFFSET];
+		sllse_t* pe = pleft_field_values->phead;
+		for ( ; pe != NULL; pe = pe->pnext) {
+			if (!streq(p, pe->value))
+				break;
+			p += strlen(p) + 1;
+		}
+		if (pe == NULL)
+			return bi;
+	}
+	return -1LL;
+}
+
+sllv_t* join_index_bucket_records(join_index_t* pindex, long long bucket_index) {
+	unsigned long long* pwords = &pindex->pbuckets[bucket_index * BUCKET_NUM_WORDS];
+	sllv_t* precords = sllv_alloc();
+	char* p = pindex->base + pwords[BUCKET_RECORDS_OFFSET];
+	for (unsigned long long i = 0; i < pwords[BUCKET_NUM_RECORDS]; i++)
+		sllv_append(precords, join_index_decode_record(&p));
+	return precords;
+}
+
+sllv_t* join_index_unpaired_records(join_index_t* pindex) {
+	sllv_t* precords = sllv_alloc();
+	char* p = pindex->punpaired_records;
+	for (unsigned long long i = 0; i < pindex->num_unpaired_records; i++)
+		sllv_append(precords, join_index_decode_record(&p));
+	return precords;
+}
+
+// ----------------------------------------------------------------
+// Everything which affects the contents of the buckets, other than the left file itself.
+static char* join_index_options_string(cli_reader_opts_t* preader_opts, slls_t* pleft_field_names) {
+	string_builder_t* psb = sb_alloc(256);
+	sb_append_string(psb, "fields=");
+	for (sllse_t* pe = pleft_field_names->phead; pe != NULL; pe = pe->pnext) {
+		sb_append_string(psb, pe->value);
+		sb_append_char(psb, 0x1f);
+	}
+	char* names[] = { "\nfmt=", "\nirs=", "\nifs=", "\nips=", "\nflatsep=", "\nprepipe=" };
+	char* values[] = {
+		preader_opts->ifile_fmt, preader_opts->irs, preader_opts->ifs, preader_opts->ips,
+		preader_opts->input_json_flatten_separator, preader_opts->prepipe
+	};
+	for (int i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		sb_append_string(psb, names[i]);
+		if (values[i] != NULL)
+			sb_append_string(psb, values[i]);
+	}
+	sb_append_string(psb, "\nflags=");
+	sb_append_char(psb, '0' + preader_opts->json_skip_arrays_on_input);
+	sb_append_char(psb, '0' + preader_opts->allow_repeat_ifs);
+	sb_append_char(psb, '0' + preader_opts->allow_repeat_ips);
+	sb_append_char(psb, '0' + preader_opts->use_implicit_csv_header);
+	char* options = sb_finish(psb);
+	sb_free(psb);
+	return options;
+}
+
+static void stat_left_file_or_die(char* left_file_name, struct stat* pstat) {
+	if (stat(left_file_name, pstat) < 0 || !S_ISREG(pstat->st_mode)) {
+		fprintf(stderr, "%s join: join indices need a regular left file; got \"%s\".\n",
+			MLR_GLOBALS.bargv0, left_file_name);
+		exit(1);
+	}
+}
+
+static unsigned long long join_index_hash(slls_t* pleft_field_values) {
+	unsigned long long h = (unsigned)slls_hash_func(pleft_field_values);
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return h;
+}
+
+// As in lrec_spill.c, but from memory. Advances *pp past the record.
+static lrec_t* join_index_decode_record(char** pp) {
+	unsigned char* p = (unsigned char*)*pp;
+	unsigned long long length = 0ULL;
+	int shift = 0;
+	do {
+		length |= (unsigned long long)(*p & 0x7f) << shift;
+		shift += 7;
+	} while (*p++ & 0x80);
+
+	lrec_t* prec = lrec_unbacked_alloc();
+	char* q = (char*)p;
+	char* end = q + length;
+	while (q < end) {
+		char* key = q;
+		q += strlen(q) + 1;
+		char* value = q;
+		q += strlen(q) + 1;
+		lrec_put(prec, key, value, NO_FREE);
+	}
+	*pp = end;
+	return prec;
+}
+
+static void fwrite_or_die(void* p, size_t size, FILE* fp, char* file_name) {
+	if (size > 0 && fwrite(p, 1, size, fp) != size) {
+		fprintf(stderr, "%s join: could not write \"%s\": %s\n",
+			MLR_GLOBALS.bargv0, file_name, strerror(errno));
+		exit(1);
+	}
+}
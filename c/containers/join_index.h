@@ -0,0 +1,61 @@
+// ================================================================
+// On-disk hash index of a left file for mlr join, so that repeated joins
+// against the same left file can probe it without reparsing that file.
+//
+// The index is written from the buckets of an unsorted-join ingest and holds:
+// * A header with a fingerprint of the left file (size, mtime, inode) and of
+//   the options affecting how it was read (join-field names, format,
+//   separators, prepipe). Opening an index whose fingerprint doesn't match is
+//   a fatal error, so a stale index is never used.
+// * The buckets, in first-seen order as with the in-memory join, each with its
+//   join-field values and the location of its records.
+// * An open-addressing hash table from join-field values to bucket.
+// * The records themselves, each bucket's contiguously, followed by those
+//   lacking the join fields. They are stored as in lrec_spill.h, so the index
+//   doesn't depend on the left file's format.
+//
+// The index is mmapped for reading; records are instantiated on demand with
+// keys and values pointing into the mapping. As with the mmap file readers the
+// mapping is never unmapped, since such records may outlive the index handle.
+// ================================================================
+
+#ifndef JOIN_INDEX_H
+#define JOIN_INDEX_H
+
+#include "cli/mlrcli.h"
+#include "containers/lrec.h"
+#include "containers/slls.h"
+#include "containers/sllv.h"
+#include "containers/lhmslv.h"
+
+typedef struct _join_index_t {
+	char*               base;
+	unsigned long long* phash_table; // bucket index plus one, or zero for empty slot
+	unsigned long long  hash_table_size; // power of two
+	unsigned long long* pbuckets;
+	unsigned long long  num_buckets;
+	char*               punpaired_records;
+	unsigned long long  num_unpaired_records;
+} join_index_t;
+
+// The buckets are as in mapper_join's unsorted case: a map from join-field values to
+// join_bucket_t*. The unpaired records are the left records lacking the join fields. The file is
+// written under a temporary name and renamed into place, so concurrent readers see either the old
+// index or the new one. Errors are fatal.
+void join_index_write(char* index_file_name, char* left_file_name, cli_reader_opts_t* preader_opts,
+	slls_t* pleft_field_names, lhmslv_t* pbuckets, sllv_t* punpaired_records);
+
+// Errors, including a fingerprint mismatch, are fatal.
+join_index_t* join_index_open(char* index_file_name, char* left_file_name, cli_reader_opts_t* preader_opts,
+	slls_t* pleft_field_names);
+void join_index_free(join_index_t* pindex);
+
+// Returns the bucket index, or -1 if there is none for the given join-field values.
+long long join_index_find(join_index_t* pindex, slls_t* pleft_field_values);
+
+// The records are newly allocated, in left-file order, with keys and values pointing into the
+// index mapping; the caller should free them and the list.
+sllv_t* join_index_bucket_records(join_index_t* pindex, long long bucket_index);
+sllv_t* join_index_unpaired_records(join_index_t* pindex);
+
+#endif // JOIN_INDEX_H
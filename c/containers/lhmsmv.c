@@ -228,6 +228,22 @@ mv_t* lhmsmv_get(lhmsmv_t* pmap, char* key) {
 	}
 }
 
+// ----------------------------------------------------------------
+lhmsmve_t* lhmsmv_get_entry(lhmsmv_t* pmap, char* key) {
+	int ideal_index = 0;
+	int index = lhmsmv_find_index_for_key(pmap, key, &ideal_index);
+	lhmsmve_t* pe = &pmap->entries[index];
+
+	if (pmap->states[index] == OCCUPIED) {
+		return pe;
+	} else if (pmap->states[index] == EMPTY) {
+		return NULL;
+	} else {
+		fprintf(stderr, "%s: lhmsmv_find_index_for_key did not find end of chain.\n", MLR_GLOBALS.bargv0);
+		exit(1);
+	}
+}
+
 // ----------------------------------------------------------------
 int lhmsmv_has_key(lhmsmv_t* pmap, char* key) {
 	int ideal_index = 0;
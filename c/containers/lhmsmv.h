@@ -49,6 +49,8 @@ void  lhmsmv_free(lhmsmv_t* pmap);
 
 void  lhmsmv_put(lhmsmv_t* pmap, char* key, mv_t* pvalue, char free_flags);
 mv_t* lhmsmv_get(lhmsmv_t* pmap, char* key);
+// Entries stay where they are until the map is enlarged, which changes array_length.
+lhmsmve_t* lhmsmv_get_entry(lhmsmv_t* pmap, char* key);
 int   lhmsmv_has_key(lhmsmv_t* pmap, char* key);
 
 void  lhmsmv_dump(lhmsmv_t* pmap);
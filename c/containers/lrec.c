@@ -1,3 +1,4 @@
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,10 +9,201 @@
 
 #define SB_ALLOC_LENGTH 256
 
+// ----------------------------------------------------------------
+// Arena allocation: a record's lrec_t, its lrece_t's, and any strings from lrec_strdup are
+// bump-allocated from a chain of chunks owned by the record. lrec_free releases the chain in one go
+// rather than doing a free per field.
+//
+// Since verbs such as tac and sort retain all their records, the first chunk is sized to fit the
+// record as well as can be guessed -- from the line length, for records read from input -- and
+// further chunks double in size up to a cap. Chunk sizes are rounded up to a small set of size
+// classes, each with a per-thread free list for recycling; records freed on a thread other than
+// the one which allocated them simply feed that thread's lists, up to their cap.
+
+#define LREC_ARENA_MIN_CHUNK_SIZE    256
+#define LREC_ARENA_MAX_CHUNK_SIZE    4096
+#define LREC_ARENA_SMALL_CLASS_STEP  16   // Classes are multiples of this up to 1024, then 2048 and 4096
+#define LREC_ARENA_NUM_SMALL_CLASSES 64
+#define LREC_ARENA_NUM_CLASSES       (LREC_ARENA_NUM_SMALL_CLASSES + 2)
+#define LREC_ARENA_MAX_FREE          128  // Per class
+#define LREC_ARENA_ALIGN(n)          (((n) + 15) & ~((size_t)15))
+// Guess at the number of fields in a line of input, for sizing the record's first chunk.
+#define LREC_ARENA_BYTES_PER_FIELD   12
+
+typedef struct _lrec_arena_chunk_t {
+	struct _lrec_arena_chunk_t* pnext;
+	size_t size; // of the entire chunk including this header
+	size_t used; // likewise
+} lrec_arena_chunk_t;
+
+#define LREC_ARENA_HEADER_SIZE LREC_ARENA_ALIGN(sizeof(lrec_arena_chunk_t))
+
+static __thread lrec_arena_chunk_t* pfree_chunks[LREC_ARENA_NUM_CLASSES];
+static __thread int num_free_chunks[LREC_ARENA_NUM_CLASSES];
+
+// The thread-specific key is only for freeing a thread's free lists when it exits.
+static __thread int free_chunks_key_is_set = FALSE;
+static pthread_key_t  free_chunks_key;
+static pthread_once_t free_chunks_key_once = PTHREAD_ONCE_INIT;
+
+static void lrec_arena_free_lists_free(void* _) {
+	for (int i = 0; i < LREC_ARENA_NUM_CLASSES; i++) {
+		while (pfree_chunks[i] != NULL) {
+			lrec_arena_chunk_t* pnext = pfree_chunks[i]->pnext;
+			free(pfree_chunks[i]);
+			pfree_chunks[i] = pnext;
+		}
+		num_free_chunks[i] = 0;
+	}
+}
+
+static void lrec_arena_make_free_chunks_key() {
+	pthread_key_create(&free_chunks_key, lrec_arena_free_lists_free);
+}
+
+// Size classes are indexed from 0; sizes over the largest class have none.
+static int lrec_arena_class_index(size_t size) {
+	if (size <= LREC_ARENA_NUM_SMALL_CLASSES * LREC_ARENA_SMALL_CLASS_STEP)
+		return (size + LREC_ARENA_SMALL_CLASS_STEP - 1) / LREC_ARENA_SMALL_CLASS_STEP - 1;
+	else if (size <= 2048)
+		return LREC_ARENA_NUM_SMALL_CLASSES;
+	else if (size <= LREC_ARENA_MAX_CHUNK_SIZE)
+		return LREC_ARENA_NUM_SMALL_CLASSES + 1;
+	else
+		return -1;
+}
+
+static size_t lrec_arena_class_size(int class_index) {
+	if (class_index < LREC_ARENA_NUM_SMALL_CLASSES)
+		return (class_index + 1) * LREC_ARENA_SMALL_CLASS_STEP;
+	else if (class_index == LREC_ARENA_NUM_SMALL_CLASSES)
+		return 2048;
+	else
+		return LREC_ARENA_MAX_CHUNK_SIZE;
+}
+
+// Sizes up to LREC_ARENA_MAX_CHUNK_SIZE are rounded up to their class; larger ones are exact.
+static lrec_arena_chunk_t* lrec_arena_chunk_alloc(size_t size) {
+	lrec_arena_chunk_t* pchunk;
+	int class_index = lrec_arena_class_index(size);
+	if (class_index >= 0 && pfree_chunks[class_index] != NULL) {
+		pchunk = pfree_chunks[class_index];
+		pfree_chunks[class_index] = pchunk->pnext;
+		num_free_chunks[class_index]--;
+	} else {
+		if (class_index >= 0)
+			size = lrec_arena_class_size(class_index);
+		pchunk = mlr_malloc_or_die(size);
+		pchunk->size = size;
+	}
+	pchunk->pnext = NULL;
+	pchunk->used  = LREC_ARENA_HEADER_SIZE;
+	return pchunk;
+}
+
+static void lrec_arena_chunks_free(lrec_arena_chunk_t* pchunk) {
+	while (pchunk != NULL) {
+		lrec_arena_chunk_t* pnext = pchunk->pnext;
+		int class_index = lrec_arena_class_index(pchunk->size);
+		if (class_index >= 0 && lrec_arena_class_size(class_index) == pchunk->size
+			&& num_free_chunks[class_index] < LREC_ARENA_MAX_FREE)
+		{
+			if (!free_chunks_key_is_set) {
+				pthread_once(&free_chunks_key_once, lrec_arena_make_free_chunks_key);
+				pthread_setspecific(free_chunks_key, &free_chunks_key_is_set); // any non-null value
+				free_chunks_key_is_set = TRUE;
+			}
+			pchunk->pnext = pfree_chunks[class_index];
+			pfree_chunks[class_index] = pchunk;
+			num_free_chunks[class_index]++;
+		} else {
+			free(pchunk);
+		}
+		pchunk = pnext;
+	}
+}
+
+static void* lrec_arena_alloc(lrec_t* prec, size_t size) {
+	size = LREC_ARENA_ALIGN(size);
+	lrec_arena_chunk_t* pchunk = prec->parena;
+	if (pchunk->used + size > pchunk->size) {
+		if (LREC_ARENA_HEADER_SIZE + size > LREC_ARENA_MAX_CHUNK_SIZE / 2) {
+			// Give large allocations their own chunk, behind the current one so the latter's
+			// remaining space is still used.
+			lrec_arena_chunk_t* pbig = lrec_arena_chunk_alloc(LREC_ARENA_HEADER_SIZE + size);
+			pbig->used = pbig->size;
+			pbig->pnext = pchunk->pnext;
+			pchunk->pnext = pbig;
+			return (char*)pbig + LREC_ARENA_HEADER_SIZE;
+		}
+		size_t next_size = 2 * pchunk->size;
+		if (next_size < LREC_ARENA_HEADER_SIZE + size)
+			next_size = LREC_ARENA_HEADER_SIZE + size;
+		if (next_size > LREC_ARENA_MAX_CHUNK_SIZE)
+			next_size = LREC_ARENA_MAX_CHUNK_SIZE;
+		pchunk = lrec_arena_chunk_alloc(next_size);
+		pchunk->pnext = prec->parena;
+		prec->parena = pchunk;
+	}
+	void* pv = (char*)pchunk + pchunk->used;
+	pchunk->used += size;
+	return pv;
+}
+
+// The size hint is the expected arena usage beyond the record struct itself.
+static lrec_t* lrec_arena_alloc_record(size_t size_hint) {
+	size_t size = LREC_ARENA_HEADER_SIZE + LREC_ARENA_ALIGN(sizeof(lrec_t)) + size_hint;
+	if (size < LREC_ARENA_MIN_CHUNK_SIZE)
+		size = LREC_ARENA_MIN_CHUNK_SIZE;
+	else if (size > LREC_ARENA_MAX_CHUNK_SIZE)
+		size = LREC_ARENA_MAX_CHUNK_SIZE;
+	lrec_arena_chunk_t* pchunk = lrec_arena_chunk_alloc(size);
+	lrec_t* prec = (lrec_t*)((char*)pchunk + pchunk->used);
+	pchunk->used += LREC_ARENA_ALIGN(sizeof(lrec_t));
+	memset(prec, 0, sizeof(lrec_t));
+	prec->parena = pchunk;
+	return prec;
+}
+
+// For a record whose fields are parsed from a line of the given length, as read from input.
+static size_t lrec_arena_size_hint_for_line_length(size_t line_length) {
+	size_t num_fields = (line_length + LREC_ARENA_BYTES_PER_FIELD / 2) / LREC_ARENA_BYTES_PER_FIELD;
+	return (num_fields > 0 ? num_fields : 1) * LREC_ARENA_ALIGN(sizeof(lrece_t));
+}
+
+static lrece_t* lrec_alloc_entry(lrec_t* prec) {
+	lrece_t* pe = prec->pfree_entries;
+	if (pe != NULL) {
+		prec->pfree_entries = pe->pnext;
+		return pe;
+	}
+	return lrec_arena_alloc(prec, sizeof(lrece_t));
+}
+
+static void lrec_free_entry(lrec_t* prec, lrece_t* pe) {
+	pe->pnext = prec->pfree_entries;
+	prec->pfree_entries = pe;
+}
+
+char* lrec_strdup(lrec_t* prec, char* string) {
+	size_t size = strlen(string) + 1;
+	char* copy = lrec_arena_alloc(prec, size);
+	memcpy(copy, string, size);
+	return copy;
+}
+
+char* lrec_alloc_string(lrec_t* prec, size_t size) {
+	return lrec_arena_alloc(prec, size);
+}
+
+// ----------------------------------------------------------------
 static lrece_t* lrec_find_entry(lrec_t* prec, char* key);
 static void lrec_link_at_head(lrec_t* prec, lrece_t* pe);
 static void lrec_link_at_tail(lrec_t* prec, lrece_t* pe);
 
+static void lrec_index_add(lrec_t* prec, lrece_t* pe);
+static void lrec_index_remove(lrec_t* prec, lrece_t* pe);
+
 static void lrec_unbacked_free(lrec_t* prec);
 static void lrec_free_single_line_backing(lrec_t* prec);
 static void lrec_free_csv_backing(lrec_t* prec);
@@ -19,72 +211,89 @@ static void lrec_free_multiline_backing(lrec_t* prec);
 
 // ----------------------------------------------------------------
 lrec_t* lrec_unbacked_alloc() {
-	lrec_t* prec = mlr_malloc_or_die(sizeof(lrec_t));
-	memset(prec, 0, sizeof(lrec_t));
+	lrec_t* prec = lrec_arena_alloc_record(0);
+	prec->pfree_backing_func = lrec_unbacked_free;
+	return prec;
+}
+
+lrec_t* lrec_unbacked_alloc_for_fields(int num_fields) {
+	lrec_t* prec = lrec_arena_alloc_record(num_fields * LREC_ARENA_ALIGN(sizeof(lrece_t)));
+	prec->pfree_backing_func = lrec_unbacked_free;
+	return prec;
+}
+
+lrec_t* lrec_unbacked_alloc_for_line_length(size_t line_length) {
+	lrec_t* prec = lrec_arena_alloc_record(lrec_arena_size_hint_for_line_length(line_length));
 	prec->pfree_backing_func = lrec_unbacked_free;
 	return prec;
 }
 
 lrec_t* lrec_dkvp_alloc(char* line) {
-	lrec_t* prec = mlr_malloc_or_die(sizeof(lrec_t));
-	memset(prec, 0, sizeof(lrec_t));
+	lrec_t* prec = lrec_arena_alloc_record(lrec_arena_size_hint_for_line_length(strlen(line)));
 	prec->psingle_line = line;
 	prec->pfree_backing_func = lrec_free_single_line_backing;
 	return prec;
 }
 
 lrec_t* lrec_nidx_alloc(char* line) {
-	lrec_t* prec = mlr_malloc_or_die(sizeof(lrec_t));
-	memset(prec, 0, sizeof(lrec_t));
+	lrec_t* prec = lrec_arena_alloc_record(lrec_arena_size_hint_for_line_length(strlen(line)));
 	prec->psingle_line  = line;
 	prec->pfree_backing_func = lrec_free_single_line_backing;
 	return prec;
 }
 
 lrec_t* lrec_csvlite_alloc(char* data_line) {
-	lrec_t* prec = mlr_malloc_or_die(sizeof(lrec_t));
-	memset(prec, 0, sizeof(lrec_t));
+	lrec_t* prec = lrec_arena_alloc_record(lrec_arena_size_hint_for_line_length(strlen(data_line)));
 	prec->psingle_line = data_line;
 	prec->pfree_backing_func = lrec_free_csv_backing;
 	return prec;
 }
 
 lrec_t* lrec_csv_alloc(char* data_line) {
-	lrec_t* prec = mlr_malloc_or_die(sizeof(lrec_t));
-	memset(prec, 0, sizeof(lrec_t));
+	lrec_t* prec = lrec_arena_alloc_record(lrec_arena_size_hint_for_line_length(strlen(data_line)));
 	prec->psingle_line = data_line;
 	prec->pfree_backing_func = lrec_free_csv_backing;
 	return prec;
 }
 
 lrec_t* lrec_xtab_alloc(slls_t* pxtab_lines) {
-	lrec_t* prec = mlr_malloc_or_die(sizeof(lrec_t));
-	memset(prec, 0, sizeof(lrec_t));
+	lrec_t* prec = lrec_arena_alloc_record(pxtab_lines->length * LREC_ARENA_ALIGN(sizeof(lrece_t)));
 	prec->pxtab_lines = pxtab_lines;
 	prec->pfree_backing_func = lrec_free_multiline_backing;
 	return prec;
 }
 
 // ----------------------------------------------------------------
+// The entries themselves are arena-allocated; only their owned keys and values need freeing here.
 static void lrec_free_contents(lrec_t* prec) {
-	for (lrece_t* pe = prec->phead; pe != NULL; /*pe = pe->pnext*/) {
+	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
 		if (pe->free_flags & FREE_ENTRY_KEY)
 			free(pe->key);
 		if (pe->free_flags & FREE_ENTRY_VALUE)
 			free(pe->value);
-		lrece_t* ope = pe;
-		pe = pe->pnext;
-		free(ope);
 	}
 	prec->pfree_backing_func(prec);
 }
 
 // ----------------------------------------------------------------
+// The chunk holding the record struct itself is kept; the others are released.
 void lrec_clear(lrec_t* prec) {
 	if (prec == NULL)
 		return;
 	lrec_free_contents(prec);
+	lrec_arena_chunk_t* pself = (lrec_arena_chunk_t*)((char*)prec - LREC_ARENA_HEADER_SIZE);
+	for (lrec_arena_chunk_t* pchunk = prec->parena; pchunk != NULL; ) {
+		lrec_arena_chunk_t* pnext = pchunk->pnext;
+		if (pchunk != pself) {
+			pchunk->pnext = NULL;
+			lrec_arena_chunks_free(pchunk);
+		}
+		pchunk = pnext;
+	}
+	pself->pnext = NULL;
+	pself->used = LREC_ARENA_HEADER_SIZE + LREC_ARENA_ALIGN(sizeof(lrec_t));
 	memset(prec, 0, sizeof(lrec_t));
+	prec->parena = pself;
 	prec->pfree_backing_func = lrec_unbacked_free;
 }
 
@@ -93,21 +302,46 @@ void lrec_free(lrec_t* prec) {
 	if (prec == NULL)
 		return;
 	lrec_free_contents(prec);
-	free(prec);
+	lrec_arena_chunks_free(prec->parena);
+}
+
+// ----------------------------------------------------------------
+size_t lrec_memory_size(lrec_t* prec) {
+	size_t size = 0;
+	for (lrec_arena_chunk_t* pchunk = prec->parena; pchunk != NULL; pchunk = pchunk->pnext)
+		size += pchunk->size;
+	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
+		if (pe->free_flags & FREE_ENTRY_KEY)
+			size += strlen(pe->key) + 1;
+		if (pe->free_flags & FREE_ENTRY_VALUE)
+			size += strlen(pe->value) + 1;
+	}
+	if (prec->psingle_line != NULL)
+		size += strlen(prec->psingle_line) + 1;
+	if (prec->pxtab_lines != NULL)
+		for (sllse_t* pe = prec->pxtab_lines->phead; pe != NULL; pe = pe->pnext)
+			size += strlen(pe->value) + 1;
+	return size;
 }
 
 // ----------------------------------------------------------------
 lrec_t* lrec_copy(lrec_t* pinrec) {
-	lrec_t* poutrec = lrec_unbacked_alloc();
+	size_t size_hint = 0;
+	for (lrece_t* pe = pinrec->phead; pe != NULL; pe = pe->pnext)
+		size_hint += LREC_ARENA_ALIGN(sizeof(lrece_t)) + LREC_ARENA_ALIGN(strlen(pe->key) + 1)
+			+ LREC_ARENA_ALIGN(strlen(pe->value) + 1);
+	lrec_t* poutrec = lrec_arena_alloc_record(size_hint);
+	poutrec->pfree_backing_func = lrec_unbacked_free;
 	for (lrece_t* pe = pinrec->phead; pe != NULL; pe = pe->pnext) {
-		lrec_put(poutrec, mlr_strdup_or_die(pe->key), mlr_strdup_or_die(pe->value),
-			FREE_ENTRY_KEY|FREE_ENTRY_VALUE);
+		lrece_t* pcopy = lrec_put(poutrec, lrec_strdup(poutrec, pe->key), lrec_strdup(poutrec, pe->value), NO_FREE);
+		pcopy->scan_type = pe->scan_type;
+		pcopy->scanned   = pe->scanned;
 	}
 	return poutrec;
 }
 
 // ----------------------------------------------------------------
-void lrec_put(lrec_t* prec, char* key, char* value, char free_flags) {
+lrece_t* lrec_put(lrec_t* prec, char* key, char* value, char free_flags) {
 	lrece_t* pe = lrec_find_entry(prec, key);
 
 	if (pe != NULL) {
@@ -117,16 +351,18 @@ void lrec_put(lrec_t* prec, char* key, char* value, char free_flags) {
 		if (free_flags & FREE_ENTRY_KEY)
 			free(key);
 		pe->value = value;
+		pe->scan_type = LRECE_NOT_SCANNED;
 		if (free_flags & FREE_ENTRY_VALUE)
 			pe->free_flags |= FREE_ENTRY_VALUE;
 		else
 			pe->free_flags &= ~FREE_ENTRY_VALUE;
 	} else {
-		pe = mlr_malloc_or_die(sizeof(lrece_t));
+		pe = lrec_alloc_entry(prec);
 		pe->key         = key;
 		pe->value       = value;
 		pe->free_flags  = free_flags;
 		pe->quote_flags = 0;
+		pe->scan_type   = LRECE_NOT_SCANNED;
 
 		if (prec->phead == NULL) {
 			pe->pprev   = NULL;
@@ -140,7 +376,9 @@ void lrec_put(lrec_t* prec, char* key, char* value, char free_flags) {
 			prec->ptail = pe;
 		}
 		prec->field_count++;
+		lrec_index_add(prec, pe);
 	}
+	return pe;
 }
 
 void lrec_put_ext(lrec_t* prec, char* key, char* value, char free_flags, char quote_flags) {
@@ -153,16 +391,18 @@ void lrec_put_ext(lrec_t* prec, char* key, char* value, char free_flags, char qu
 		if (free_flags & FREE_ENTRY_KEY)
 			free(key);
 		pe->value = value;
+		pe->scan_type = LRECE_NOT_SCANNED;
 		if (free_flags & FREE_ENTRY_VALUE)
 			pe->free_flags |= FREE_ENTRY_VALUE;
 		else
 			pe->free_flags &= ~FREE_ENTRY_VALUE;
 	} else {
-		pe = mlr_malloc_or_die(sizeof(lrece_t));
+		pe = lrec_alloc_entry(prec);
 		pe->key         = key;
 		pe->value       = value;
 		pe->free_flags  = free_flags;
 		pe->quote_flags = quote_flags;
+		pe->scan_type   = LRECE_NOT_SCANNED;
 
 		if (prec->phead == NULL) {
 			pe->pprev   = NULL;
@@ -176,6 +416,7 @@ void lrec_put_ext(lrec_t* prec, char* key, char* value, char free_flags, char qu
 			prec->ptail = pe;
 		}
 		prec->field_count++;
+		lrec_index_add(prec, pe);
 	}
 }
 
@@ -187,15 +428,17 @@ void lrec_prepend(lrec_t* prec, char* key, char* value, char free_flags) {
 			free(pe->value);
 		}
 		pe->value = value;
+		pe->scan_type = LRECE_NOT_SCANNED;
 		pe->free_flags &= ~FREE_ENTRY_VALUE;
 		if (free_flags & FREE_ENTRY_VALUE)
 			pe->free_flags |= FREE_ENTRY_VALUE;
 	} else {
-		pe = mlr_malloc_or_die(sizeof(lrece_t));
+		pe = lrec_alloc_entry(prec);
 		pe->key         = key;
 		pe->value       = value;
 		pe->free_flags  = free_flags;
 		pe->quote_flags = 0;
+		pe->scan_type   = LRECE_NOT_SCANNED;
 
 		if (prec->phead == NULL) {
 			pe->pprev   = NULL;
@@ -209,6 +452,7 @@ void lrec_prepend(lrec_t* prec, char* key, char* value, char free_flags) {
 			prec->phead = pe;
 		}
 		prec->field_count++;
+		lrec_index_add(prec, pe);
 	}
 }
 
@@ -220,15 +464,17 @@ lrece_t* lrec_put_after(lrec_t* prec, lrece_t* pd, char* key, char* value, char
 			free(pe->value);
 		}
 		pe->value = value;
+		pe->scan_type = LRECE_NOT_SCANNED;
 		pe->free_flags &= ~FREE_ENTRY_VALUE;
 		if (free_flags & FREE_ENTRY_VALUE)
 			pe->free_flags |= FREE_ENTRY_VALUE;
 	} else { // Insert after specified entry
-		pe = mlr_malloc_or_die(sizeof(lrece_t));
+		pe = lrec_alloc_entry(prec);
 		pe->key         = key;
 		pe->value       = value;
 		pe->free_flags  = free_flags;
 		pe->quote_flags = 0;
+		pe->scan_type   = LRECE_NOT_SCANNED;
 
 		if (pd->pnext == NULL) { // Append at end of list
 			pd->pnext = pe;
@@ -245,6 +491,7 @@ lrece_t* lrec_put_after(lrec_t* prec, lrece_t* pd, char* key, char* value, char
 		}
 
 		prec->field_count++;
+		lrec_index_add(prec, pe);
 	}
 	return pe;
 }
@@ -296,7 +543,7 @@ void lrec_remove(lrec_t* prec, char* key) {
 		free(pe->value);
 	}
 
-	free(pe);
+	lrec_free_entry(prec, pe);
 }
 
 // Before:
@@ -315,6 +562,12 @@ void lrec_rename(lrec_t* prec, char* old_key, char* new_key, int new_needs_freei
 	lrece_t* pold = lrec_find_entry(prec, old_key);
 	if (pold != NULL) {
 		lrece_t* pnew = lrec_find_entry(prec, new_key);
+		if (pnew == pold) { // E.g. rename "x" to "x"
+			if (new_needs_freeing)
+				free(new_key);
+			return;
+		}
+		lrec_index_remove(prec, pold); // re-added under the new key below
 
 		if (pnew == NULL) { // E.g. rename "x" to "y" when "y" is not present
 			if (pold->free_flags & FREE_ENTRY_KEY) {
@@ -342,8 +595,9 @@ void lrec_rename(lrec_t* prec, char* old_key, char* new_key, int new_needs_freei
 			else
 				pold->free_flags &= ~FREE_ENTRY_KEY;
 			lrec_unlink(prec, pnew);
-			free(pnew);
+			lrec_free_entry(prec, pnew);
 		}
+		lrec_index_add(prec, pold);
 	}
 }
 
@@ -385,15 +639,16 @@ void lrec_unlink(lrec_t* prec, lrece_t* pe) {
 		}
 	}
 	prec->field_count--;
+	lrec_index_remove(prec, pe);
 }
 
 void lrec_unlink_and_free(lrec_t* prec, lrece_t* pe) {
+	lrec_unlink(prec, pe); // before the key is freed, since the index hashes it
 	if (pe->free_flags & FREE_ENTRY_KEY)
 		free(pe->key);
 	if (pe->free_flags & FREE_ENTRY_VALUE)
 		free(pe->value);
-	lrec_unlink(prec, pe);
-	free(pe);
+	lrec_free_entry(prec, pe);
 }
 
 // ----------------------------------------------------------------
@@ -412,6 +667,7 @@ static void lrec_link_at_head(lrec_t* prec, lrece_t* pe) {
 		prec->phead = pe;
 	}
 	prec->field_count++;
+	lrec_index_add(prec, pe);
 }
 
 static void lrec_link_at_tail(lrec_t* prec, lrece_t* pe) {
@@ -428,6 +684,7 @@ static void lrec_link_at_tail(lrec_t* prec, lrece_t* pe) {
 		prec->ptail = pe;
 	}
 	prec->field_count++;
+	lrec_index_add(prec, pe);
 }
 
 // ----------------------------------------------------------------
@@ -478,6 +735,68 @@ static void lrec_free_multiline_backing(lrec_t* prec) {
 }
 
 // ================================================================
+// Key-to-entry index for wide records. The index holds exactly the entries in
+// the list, so once built it's maintained on every link, unlink, and rename.
+// Deletion is by backward shift, so there are no tombstones and lookups stop at
+// the first empty slot.
+
+#define LREC_INDEX_MIN_CAPACITY 64
+
+static inline unsigned lrec_index_hash(char* key) {
+	unsigned h = (unsigned)mlr_string_hash_func(key);
+	return h ^ (h >> 15);
+}
+
+static void lrec_index_place(lrec_t* prec, lrece_t* pe) {
+	unsigned mask = prec->index_mask;
+	unsigned i = lrec_index_hash(pe->key) & mask;
+	while (prec->pindex[i] != NULL)
+		i = (i + 1) & mask;
+	prec->pindex[i] = pe;
+}
+
+static void lrec_index_build(lrec_t* prec) {
+	unsigned capacity = LREC_INDEX_MIN_CAPACITY;
+	while (capacity < 2 * prec->field_count)
+		capacity <<= 1;
+	prec->pindex = lrec_arena_alloc(prec, capacity * sizeof(lrece_t*));
+	memset(prec->pindex, 0, capacity * sizeof(lrece_t*));
+	prec->index_mask = capacity - 1;
+	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext)
+		lrec_index_place(prec, pe);
+}
+
+// Called after the entry has been linked into the list.
+static void lrec_index_add(lrec_t* prec, lrece_t* pe) {
+	if (prec->pindex == NULL)
+		return;
+	if (2 * prec->field_count > prec->index_mask + 1)
+		lrec_index_build(prec); // The old table is reclaimed with the arena.
+	else
+		lrec_index_place(prec, pe);
+}
+
+// Called while the entry's key is still intact.
+static void lrec_index_remove(lrec_t* prec, lrece_t* pe) {
+	if (prec->pindex == NULL)
+		return;
+	unsigned mask = prec->index_mask;
+	unsigned i = lrec_index_hash(pe->key) & mask;
+	while (prec->pindex[i] != pe) {
+		MLR_INTERNAL_CODING_ERROR_IF(prec->pindex[i] == NULL);
+		i = (i + 1) & mask;
+	}
+	// Shift back any later entries in the probe run which would otherwise become unreachable.
+	for (unsigned j = (i + 1) & mask; prec->pindex[j] != NULL; j = (j + 1) & mask) {
+		unsigned home = lrec_index_hash(prec->pindex[j]->key) & mask;
+		int stays = (i < j) ? (i < home && home <= j) : (i < home || home <= j);
+		if (!stays) {
+			prec->pindex[i] = prec->pindex[j];
+			i = j;
+		}
+	}
+	prec->pindex[i] = NULL;
+}
 
 // ----------------------------------------------------------------
 // Note on efficiency:
@@ -490,6 +809,16 @@ static void lrec_free_multiline_backing(lrec_t* prec) {
 // myself (on my particular system).
 
 static lrece_t* lrec_find_entry(lrec_t* prec, char* key) {
+	if (prec->field_count >= LREC_INDEX_MIN_FIELDS) {
+		if (prec->pindex == NULL)
+			lrec_index_build(prec);
+		unsigned mask = prec->index_mask;
+		for (unsigned i = lrec_index_hash(key) & mask; prec->pindex[i] != NULL; i = (i + 1) & mask) {
+			if (streq(prec->pindex[i]->key, key))
+				return prec->pindex[i];
+		}
+		return NULL;
+	}
 #if 1
 	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
 		char* pa = pe->key;
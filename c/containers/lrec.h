@@ -35,6 +35,12 @@
 // * Added benefit: the field-rename operation (preserving field order) becomes
 //   trivial.
 //
+// * Exception: for wide records (hundreds of columns, with the DSL or verbs
+//   touching dozens of them) the sequential scan is quadratic in practice.
+//   So once a record has LREC_INDEX_MIN_FIELDS fields, the first lookup builds
+//   a small open-addressing index from key to entry, which is then kept up to
+//   date by all the operations below. Narrow records never pay for hashing.
+//
 // Notes:
 // * null key is not supported.
 // * null value is supported.
@@ -43,14 +49,19 @@
 #ifndef LREC_H
 #define LREC_H
 
+#include "lib/mlrutil.h"
 #include "lib/free_flags.h"
 #include "containers/sllv.h"
 #include "containers/header_keeper.h"
 
 #define FIELD_QUOTED_ON_INPUT 0x02
 
+// Records with at least this many fields get a hashed key-to-entry index.
+#define LREC_INDEX_MIN_FIELDS 32
+
 struct _lrec_t; // forward reference
 typedef struct _lrec_t lrec_t;
+struct _lrec_arena_chunk_t; // private to lrec.c
 
 typedef void lrec_free_func_t(lrec_t* prec);
 
@@ -66,6 +77,15 @@ typedef struct _lrece_t {
 	char free_flags;
 	char quote_flags;
 
+	// The result of scanning the value as a number, kept so that it's scanned at most once however
+	// many verbs in a then-chain, or DSL expressions, read it. See lrece_scan_int_or_float. Reset
+	// whenever the value is changed.
+	char scan_type;
+	union {
+		long long intv;
+		double    fltv;
+	} scanned;
+
 	struct _lrece_t *pprev;
 	struct _lrece_t *pnext;
 } lrece_t;
@@ -90,10 +110,59 @@ struct _lrec_t {
 	//  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 	// Format-dependent virtual-function pointer:
 	lrec_free_func_t* pfree_backing_func;
+
+	//  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+	// The record struct, its entries, and lrec_strdup'ed strings are bump-allocated from
+	// a per-record chain of arena chunks which is released all at once by lrec_free.
+	struct _lrec_arena_chunk_t* parena;
+	lrece_t* pfree_entries; // removed entries, for reuse by subsequent puts
+
+	//  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+	// Key-to-entry index for wide records; arena-allocated, NULL until built.
+	// Linear probing; the capacity is a power of two and at least twice the field count.
+	lrece_t** pindex;
+	unsigned  index_mask;
 };
 
+// ----------------------------------------------------------------
+// Values of lrece_t's scan_type: not yet scanned, else one more than MLR_SCANNED_NEITHER,
+// MLR_SCANNED_INT, or MLR_SCANNED_FLOAT.
+#define LRECE_NOT_SCANNED 0
+
+// Same as mlr_try_int_or_float_from_string on the entry's value, but remembering the result.
+static inline int lrece_scan_int_or_float(lrece_t* pe, long long* pintv, double* pfltv) {
+	if (pe->scan_type == LRECE_NOT_SCANNED) {
+		long long intv = 0LL;
+		double fltv = 0.0;
+		int scan_result = mlr_try_int_or_float_from_string(pe->value, &intv, &fltv);
+		if (scan_result == MLR_SCANNED_INT)
+			pe->scanned.intv = intv;
+		else if (scan_result == MLR_SCANNED_FLOAT)
+			pe->scanned.fltv = fltv;
+		pe->scan_type = scan_result + 1;
+	}
+	int scan_result = pe->scan_type - 1;
+	if (scan_result == MLR_SCANNED_INT)
+		*pintv = pe->scanned.intv;
+	else if (scan_result == MLR_SCANNED_FLOAT)
+		*pfltv = pe->scanned.fltv;
+	return scan_result;
+}
+
+// For callers which have just formatted the value from an int, so that scanning it would give
+// back the same int.
+static inline void lrece_set_scanned_int(lrece_t* pe, long long intv) {
+	pe->scanned.intv = intv;
+	pe->scan_type = MLR_SCANNED_INT + 1;
+}
+
 // ----------------------------------------------------------------
 lrec_t* lrec_unbacked_alloc();
+// As lrec_unbacked_alloc, but with the record's first arena chunk sized for about the given number
+// of fields, or for fields parsed from a line of about the given length. For readers, so that
+// records retained by verbs such as tac and sort don't take more memory than they need.
+lrec_t* lrec_unbacked_alloc_for_fields(int num_fields);
+lrec_t* lrec_unbacked_alloc_for_line_length(size_t line_length);
 lrec_t* lrec_dkvp_alloc(char* line);
 lrec_t* lrec_nidx_alloc(char* line);
 lrec_t* lrec_csvlite_alloc(char* data_line);
@@ -104,6 +173,17 @@ void lrec_clear(lrec_t* prec);
 void  lrec_free(lrec_t* prec);
 lrec_t* lrec_copy(lrec_t* pinrec);
 
+// Approximate bytes of memory held by the record: its arena chunks, the keys and values it owns,
+// and the line it was parsed from if any. Fields pointing into an mmapped input file aren't
+// counted. For verbs such as sort which bound the memory they retain.
+size_t lrec_memory_size(lrec_t* prec);
+
+// Returns a copy of the string allocated from the record's arena. It lives exactly as long as the
+// record, so it should be put into that record with NO_FREE.
+char* lrec_strdup(lrec_t* prec, char* string);
+// Likewise, uninitialized storage of the given size, for strings which are built rather than copied.
+char* lrec_alloc_string(lrec_t* prec, size_t size);
+
 // The only difference between lrec_put and lrec_prepend is that the latter
 // adds to the end of the record, while the former adds to the beginning.
 //
@@ -121,7 +201,8 @@ lrec_t* lrec_copy(lrec_t* pinrec);
 //
 //   o The respective free_flag(s) should not be set and the caller should
 //     free the memory (else, there will be a memory leak).
-void  lrec_put(lrec_t* prec, char* key, char* value, char free_flags);
+// lrec_put returns a pointer to the added/modified entry.
+lrece_t* lrec_put(lrec_t* prec, char* key, char* value, char free_flags);
 void  lrec_put_ext(lrec_t* prec, char* key, char* value, char free_flags, char quote_flags);
 // Like lrec_put: if key is present, modify value. But if not, add new field at start of record, not at end.
 void  lrec_prepend(lrec_t* prec, char* key, char* value, char free_flags);
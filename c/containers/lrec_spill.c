@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "lib/mlrutil.h"
+#include "lib/mlr_globals.h"
+#include "containers/lrec_spill.h"
+
+#define LREC_SPILL_BUFFER_SIZE (1 << 16)
+
+// ----------------------------------------------------------------
+char* lrec_spill_default_tmpdir() {
+	char* tmpdir = getenv("TMPDIR");
+	return (tmpdir == NULL || *tmpdir == 0) ? "/tmp" : tmpdir;
+}
+
+// ----------------------------------------------------------------
+FILE* lrec_spill_file_open_or_die(char* tmpdir) {
+	char* path = mlr_paste_2_strings(tmpdir, "/mlr-spill-XXXXXX");
+	int fd = mkstemp(path);
+	if (fd < 0) {
+		fprintf(stderr, "%s: could not create temporary file in \"%s\": %s\n",
+			MLR_GLOBALS.bargv0, tmpdir, strerror(errno));
+		exit(1);
+	}
+	unlink(path);
+	free(path);
+	FILE* fp = fdopen(fd, "w+");
+	if (fp == NULL) {
+		perror("fdopen");
+		exit(1);
+	}
+	setvbuf(fp, NULL, _IOFBF, LREC_SPILL_BUFFER_SIZE);
+	return fp;
+}
+
+// This is where write errors such as a full disk are detected.
+void lrec_spill_file_rewind_or_die(FILE* fp) {
+	if (fflush(fp) != 0 || ferror(fp)) {
+		fprintf(stderr, "%s: could not write temporary file: %s\n", MLR_GLOBALS.bargv0, strerror(errno));
+		exit(1);
+	}
+	rewind(fp);
+}
+
+// ----------------------------------------------------------------
+void lrec_spill_write(FILE* fp, lrec_t* prec) {
+	unsigned long long length = 0ULL;
+	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext)
+		length += strlen(pe->key) + strlen(pe->value) + 2;
+	do { // Varint: seven bits at a time, low-order first, high bit set on all but the last byte
+		int byte = length & 0x7f;
+		length >>= 7;
+		putc((length != 0ULL) ? (byte | 0x80) : byte, fp);
+	} while (length != 0ULL);
+	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
+		fwrite(pe->key,   1, strlen(pe->key)   + 1, fp);
+		fwrite(pe->value, 1, strlen(pe->value) + 1, fp);
+	}
+}
+
+lrec_t* lrec_spill_read(FILE* fp) {
+	unsigned long long length = 0ULL;
+	int shift = 0;
+	int c;
+	do {
+		c = getc(fp);
+		if (c == EOF) {
+			if (shift == 0 && !ferror(fp))
+				return NULL;
+			fprintf(stderr, "%s: could not read temporary file.\n", MLR_GLOBALS.bargv0);
+			exit(1);
+		}
+		length |= (unsigned long long)(c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+
+	char* line = mlr_malloc_or_die(length + 1);
+	if (fread(line, 1, length, fp) != length) {
+		fprintf(stderr, "%s: could not read temporary file.\n", MLR_GLOBALS.bargv0);
+		exit(1);
+	}
+	lrec_t* prec = lrec_dkvp_alloc(line);
+	char* end = line + length;
+	for (char* p = line; p < end; ) {
+		char* key = p;
+		p += strlen(p) + 1;
+		char* value = p;
+		p += strlen(p) + 1;
+		lrec_put(prec, key, value, NO_FREE);
+	}
+	return prec;
+}
+
+// ----------------------------------------------------------------
+long long lrec_spill_parse_memory_size(char* s) {
+	char* end = NULL;
+	errno = 0;
+	long long size = strtoll(s, &end, 10);
+	if (errno != 0 || end == s)
+		return 0LL;
+	switch (*end) {
+	case 'k': case 'K': size <<= 10; end++; break;
+	case 'm': case 'M': size <<= 20; end++; break;
+	case 'g': case 'G': size <<= 30; end++; break;
+	}
+	return (*end == 0) ? size : 0LL;
+}
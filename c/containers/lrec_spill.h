@@ -0,0 +1,30 @@
+// ================================================================
+// Temporary files of records, for verbs which hold more data than fits in
+// memory (e.g. sort and join with --max-memory). Each record is stored as a
+// varint byte count followed by that many bytes of NUL-terminated keys and
+// values alternating. The files are unlinked on creation, so they go away when
+// closed, however Miller exits. I/O errors such as a full disk are fatal.
+// ================================================================
+
+#ifndef LREC_SPILL_H
+#define LREC_SPILL_H
+
+#include <stdio.h>
+#include "containers/lrec.h"
+
+// $TMPDIR if set and non-empty, else /tmp.
+char*   lrec_spill_default_tmpdir();
+
+FILE*   lrec_spill_file_open_or_die(char* tmpdir);
+// Switches the file from writing to reading.
+void    lrec_spill_file_rewind_or_die(FILE* fp);
+
+void    lrec_spill_write(FILE* fp, lrec_t* prec);
+// Returns null at end of file. The keys and values point into a single buffer which is freed
+// along with the record.
+lrec_t* lrec_spill_read(FILE* fp);
+
+// E.g. "1000000", "64k", "500m", "8g". Returns zero if unparseable.
+long long lrec_spill_parse_memory_size(char* s);
+
+#endif // LREC_SPILL_H
@@ -90,6 +90,19 @@ void mlr_reference_values_from_record_into_string_array(lrec_t* prec, string_arr
 	}
 }
 
+void mlr_reference_entries_from_record_into_array(lrec_t* prec, string_array_t* pselected_field_names,
+	lrece_t** pentries)
+{
+	for (int i = 0; i < pselected_field_names->length; i++) {
+		char* selected_field_name = pselected_field_names->strings[i];
+		if (selected_field_name == NULL) {
+			pentries[i] = NULL;
+		} else {
+			lrec_get_ext(prec, selected_field_name, &pentries[i]);
+		}
+	}
+}
+
 int record_has_all_keys(lrec_t* prec, slls_t* pselected_field_names) {
 	for (sllse_t* pe = pselected_field_names->phead; pe != NULL; pe = pe->pnext) {
 		char* selected_field_name = pe->value;
@@ -183,3 +196,92 @@ int lrec_keys_equal_list(
 		pf = pf->pnext;
 	}
 }
+
+// ----------------------------------------------------------------
+// An int scanned by the fast path of mlr_try_int_or_float_from_string -- an optional minus sign, no
+// leading zeros, and at most 18 digits -- scans as a float to the same value. Others, such as
+// octal 0755 or -0, needn't.
+static int scanned_int_is_float_exact(char* value) {
+	char* p = (*value == '-') ? value + 1 : value;
+	if (*p == '0')
+		return p[1] == 0 && p == value;
+	if (*p < '1' || *p > '9')
+		return FALSE;
+	return strlen(p) <= 18;
+}
+
+static int scan_entry_as_float(lrece_t* pe, double* pfltv) {
+	long long intv = 0LL;
+	switch (lrece_scan_int_or_float(pe, &intv, pfltv)) {
+	case MLR_SCANNED_FLOAT:
+		return TRUE;
+	case MLR_SCANNED_INT:
+		if (scanned_int_is_float_exact(pe->value)) {
+			*pfltv = (double)intv;
+			return TRUE;
+		}
+		return mlr_try_float_from_string(pe->value, pfltv);
+	default:
+		return FALSE;
+	}
+}
+
+mv_t mv_ref_type_infer_entry_string_or_float(lrece_t* pe) {
+	if (pe == NULL || pe->value == NULL) {
+		return mv_absent();
+	} else if (*pe->value == 0) {
+		return mv_empty();
+	} else {
+		double fltv;
+		if (scan_entry_as_float(pe, &fltv)) {
+			return mv_from_float(fltv);
+		} else {
+			return mv_from_string(pe->value, NO_FREE);
+		}
+	}
+}
+
+mv_t mv_ref_type_infer_entry_string_or_float_or_int(lrece_t* pe) {
+	if (pe == NULL || pe->value == NULL) {
+		return mv_absent();
+	} else if (*pe->value == 0) {
+		return mv_empty();
+	} else {
+		long long intv;
+		double fltv;
+		switch (lrece_scan_int_or_float(pe, &intv, &fltv)) {
+		case MLR_SCANNED_INT:
+			return mv_from_int(intv);
+		case MLR_SCANNED_FLOAT:
+			return mv_from_float(fltv);
+		default:
+			return mv_from_string(pe->value, NO_FREE);
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+double mlr_double_from_entry_or_die(lrece_t* pe) {
+	double fltv;
+	if (!scan_entry_as_float(pe, &fltv)) {
+		fprintf(stderr, "%s: couldn't parse \"%s\" as number.\n",
+			MLR_GLOBALS.bargv0, pe->value);
+		exit(1);
+	}
+	return fltv;
+}
+
+mv_t mv_scan_entry_number_or_die(lrece_t* pe) {
+	long long intv;
+	double fltv;
+	switch (lrece_scan_int_or_float(pe, &intv, &fltv)) {
+	case MLR_SCANNED_INT:
+		return mv_from_int(intv);
+	case MLR_SCANNED_FLOAT:
+		return mv_from_float(fltv);
+	default:
+		fprintf(stderr, "%s: couldn't parse \"%s\" as number.\n",
+			MLR_GLOBALS.bargv0, pe->value);
+		exit(1);
+	}
+}
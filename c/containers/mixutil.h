@@ -5,6 +5,7 @@
 #ifndef MIXUTIL_H
 #define MIXUTIL_H
 #include "containers/lrec.h"
+#include "containers/mlrval.h"
 #include "containers/slls.h"
 #include "containers/hss.h"
 #include "lib/string_array.h"
@@ -28,6 +29,9 @@ slls_t* mlr_copy_keys_from_record(lrec_t* prec);
 slls_t* mlr_reference_selected_values_from_record(lrec_t* prec, slls_t* pselected_field_names);
 void mlr_reference_values_from_record_into_string_array(lrec_t* prec, string_array_t* pselected_field_names,
 	string_array_t* pvalues);
+// Likewise, but with the entries, so the caller can use their cached number scans; NULL where absent.
+void mlr_reference_entries_from_record_into_array(lrec_t* prec, string_array_t* pselected_field_names,
+	lrece_t** pentries);
 int record_has_all_keys(lrec_t* prec, slls_t* pselected_field_names);
 
 // Copies data; no referencing concerns.
@@ -54,4 +58,14 @@ int lrec_keys_equal_list(
 	lrec_t* prec,
 	slls_t* plist);
 
+// Same as mv_ref_type_infer_string_or_float and mv_ref_type_infer_string_or_float_or_int on the
+// entry's value, or on NULL for a NULL entry, but scanning the value at most once (see
+// lrece_scan_int_or_float).
+mv_t mv_ref_type_infer_entry_string_or_float(lrece_t* pe);
+mv_t mv_ref_type_infer_entry_string_or_float_or_int(lrece_t* pe);
+
+// Likewise for mlr_double_from_string_or_die and mv_scan_number_or_die.
+double mlr_double_from_entry_or_die(lrece_t* pe);
+mv_t mv_scan_entry_number_or_die(lrece_t* pe);
+
 #endif // MIXUTIL_H
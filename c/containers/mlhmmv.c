@@ -17,6 +17,7 @@
 
 #include "lib/mlr_globals.h"
 #include "lib/mlrutil.h"
+#include "lib/output_buffer.h"
 #include "containers/mlhmmv.h"
 #include "containers/mvfuncs.h"
 
@@ -37,8 +38,8 @@
 
 // ================================================================
 static int  mlhmmv_hash_func(mv_t* plevel_key);
-static void json_decimal_print       (FILE* ostream, char* s);
-static void json_print_string_escaped(FILE* ostream, char* s);
+static void json_decimal_print       (output_buffer_t* pobuf, char* s);
+static void json_print_string_escaped(output_buffer_t* pobuf, char* s);
 
 // ----------------------------------------------------------------
 static void mlhmmv_level_init(mlhmmv_level_t  *plevel, int length);
@@ -95,8 +96,13 @@ static void mlhhmv_levels_to_lrecs_lashed_within_records(
 	int              do_full_prefixing,
 	char*            flatten_separator);
 
+static void mlhmmv_print_terminal_obuf(mv_t* pmv, int quote_keys_always, int quote_values_always,
+	output_buffer_t* pobuf);
+static void mlhmmv_level_print_stacked_obuf(mlhmmv_level_t* plevel, int depth,
+	int do_final_comma, int quote_keys_always, int quote_values_always, char* line_indent, char* line_term,
+	output_buffer_t* pobuf);
 static void mlhmmv_level_print_single_line(mlhmmv_level_t* plevel, int depth,
-	int do_final_comma, int quote_keys_always, int quote_values_always, FILE* ostream);
+	int do_final_comma, int quote_keys_always, int quote_values_always, output_buffer_t* pobuf);
 
 // ----------------------------------------------------------------
 static void mlhmmv_root_put_xvalue(mlhmmv_root_t* pmap, sllmv_t* pmvkeys, mlhmmv_xvalue_t* pvalue);
@@ -132,20 +138,30 @@ static int mlhmmv_hash_func(mv_t* pa) {
 
 // ================================================================
 void mlhmmv_print_terminal(mv_t* pmv, int quote_keys_always, int quote_values_always, FILE* ostream) {
+	output_buffer_t obuf;
+	obuf_init(&obuf, OBUF_DEFAULT_ALLOC_LENGTH);
+	obuf_set_stream(&obuf, ostream);
+	mlhmmv_print_terminal_obuf(pmv, quote_keys_always, quote_values_always, &obuf);
+	obuf_uninit(&obuf);
+}
+
+static void mlhmmv_print_terminal_obuf(mv_t* pmv, int quote_keys_always, int quote_values_always,
+	output_buffer_t* pobuf)
+{
 	char* level_value_string = mv_alloc_format_val(pmv);
 	if (quote_values_always) {
-		json_print_string_escaped(ostream, level_value_string);
+		json_print_string_escaped(pobuf, level_value_string);
 	} else if (pmv->type == MT_STRING) {
 		double unused;
 		if (mlr_try_float_from_string(level_value_string, &unused)) {
-			json_decimal_print(ostream, level_value_string);
+			json_decimal_print(pobuf, level_value_string);
 		} else if (streq(level_value_string, "true") || streq(level_value_string, "false")) {
-			fprintf(ostream, "%s", level_value_string);
+			obuf_puts(pobuf, level_value_string);
 		} else {
-			json_print_string_escaped(ostream, level_value_string);
+			json_print_string_escaped(pobuf, level_value_string);
 		}
 	} else {
-		fprintf(ostream, "%s", level_value_string);
+		obuf_puts(pobuf, level_value_string);
 	}
 	free(level_value_string);
 }
@@ -155,25 +171,27 @@ void mlhmmv_print_terminal(mv_t* pmv, int quote_keys_always, int quote_values_al
 // we make it JSON-compliant.
 //
 // Precondition: the caller has already checked that the string represents a number.
-static void json_decimal_print(FILE* ostream, char* s) {
+static void json_decimal_print(output_buffer_t* pobuf, char* s) {
 	if (s[0] == '.') {
-		fprintf(ostream, "0%s", s);
+		obuf_putc(pobuf, '0');
+		obuf_puts(pobuf, s);
 	} else if (s[0] == '-' && s[1] == '.') {
-		fprintf(ostream, "-0.%s", &s[2]);
+		obuf_puts(pobuf, "-0.");
+		obuf_puts(pobuf, &s[2]);
 	} else {
-		fprintf(ostream, "%s", s);
+		obuf_puts(pobuf, s);
 	}
 }
 
-static void json_print_string_escaped(FILE* ostream, char* s) {
-	fputc('"', ostream);
+static void json_print_string_escaped(output_buffer_t* pobuf, char* s) {
+	obuf_putc(pobuf, '"');
 	for (char* p = s; *p; p++) {
 		char c = *p;
 		if ((c == '"' || c == '\\'))
-			fputc('\\', ostream);
-		fputc(c, ostream);
+			obuf_putc(pobuf, '\\');
+		obuf_putc(pobuf, c);
 	}
-	fputc('"', ostream);
+	obuf_putc(pobuf, '"');
 }
 
 // ================================================================
@@ -1158,98 +1176,115 @@ static void mlhhmv_levels_to_lrecs_lashed_within_records(
 void mlhmmv_level_print_stacked(mlhmmv_level_t* plevel, int depth,
 	int do_final_comma, int quote_keys_always, int quote_values_always, char* line_indent, char* line_term,
 	FILE* ostream)
+{
+	output_buffer_t obuf;
+	obuf_init(&obuf, OBUF_DEFAULT_ALLOC_LENGTH);
+	obuf_set_stream(&obuf, ostream);
+	mlhmmv_level_print_stacked_obuf(plevel, depth, do_final_comma, quote_keys_always, quote_values_always,
+		line_indent, line_term, &obuf);
+	obuf_uninit(&obuf);
+}
+
+static void mlhmmv_level_print_stacked_obuf(mlhmmv_level_t* plevel, int depth,
+	int do_final_comma, int quote_keys_always, int quote_values_always, char* line_indent, char* line_term,
+	output_buffer_t* pobuf)
 {
 	if (plevel == NULL) {
 		return;
 	}
 	static char* leader = "  ";
 	// Top-level opening brace goes on a line by itself; subsequents on the same line after the level key.
-	if (depth == 0)
-		fprintf(ostream, "%s{%s", line_indent, line_term);
+	if (depth == 0) {
+		obuf_puts(pobuf, line_indent);
+		obuf_putc(pobuf, '{');
+		obuf_puts(pobuf, line_term);
+	}
 	for (mlhmmv_level_entry_t* pentry = plevel->phead; pentry != NULL; pentry = pentry->pnext) {
-		fprintf(ostream, "%s", line_indent);
+		obuf_puts(pobuf, line_indent);
 		for (int i = 0; i <= depth; i++)
-			fprintf(ostream, "%s", leader);
+			obuf_puts(pobuf, leader);
 		char* level_key_string = mv_alloc_format_val(&pentry->level_key);
 		if (quote_keys_always || mv_is_string_or_empty(&pentry->level_key)) {
-			json_print_string_escaped(ostream, level_key_string);
+			json_print_string_escaped(pobuf, level_key_string);
 		} else {
-			fputs(level_key_string, ostream);
+			obuf_puts(pobuf, level_key_string);
 		}
 		free(level_key_string);
-		fprintf(ostream, ": ");
+		obuf_puts(pobuf, ": ");
 
 		if (pentry->level_xvalue.is_terminal) {
-			mlhmmv_print_terminal(&pentry->level_xvalue.terminal_mlrval, quote_keys_always,
-				quote_values_always, ostream);
+			mlhmmv_print_terminal_obuf(&pentry->level_xvalue.terminal_mlrval, quote_keys_always,
+				quote_values_always, pobuf);
 
 			if (pentry->pnext != NULL)
-				fprintf(ostream, ",%s", line_term);
-			else
-				fprintf(ostream, "%s", line_term);
+				obuf_putc(pobuf, ',');
+			obuf_puts(pobuf, line_term);
 		} else {
-			fprintf(ostream, "%s{%s", line_indent, line_term);
-			mlhmmv_level_print_stacked(pentry->level_xvalue.pnext_level, depth + 1,
+			obuf_puts(pobuf, line_indent);
+			obuf_putc(pobuf, '{');
+			obuf_puts(pobuf, line_term);
+			mlhmmv_level_print_stacked_obuf(pentry->level_xvalue.pnext_level, depth + 1,
 				pentry->pnext != NULL, quote_keys_always, quote_values_always, line_indent, line_term,
-				ostream);
+				pobuf);
 		}
 	}
 	for (int i = 0; i < depth; i++)
-		fprintf(ostream, "%s", leader);
-	if (do_final_comma)
-		fprintf(ostream, "%s},%s", line_indent, line_term);
-	else
-		fprintf(ostream, "%s}%s", line_indent, line_term);
+		obuf_puts(pobuf, leader);
+	obuf_puts(pobuf, line_indent);
+	obuf_puts(pobuf, do_final_comma ? "}," : "}");
+	obuf_puts(pobuf, line_term);
 }
 
 // ----------------------------------------------------------------
 static void mlhmmv_level_print_single_line(mlhmmv_level_t* plevel, int depth,
-	int do_final_comma, int quote_keys_always, int quote_values_always, FILE* ostream)
+	int do_final_comma, int quote_keys_always, int quote_values_always, output_buffer_t* pobuf)
 {
 	// Top-level opening brace goes on a line by itself; subsequents on the same line after the level key.
 	if (depth == 0)
-		fprintf(ostream, "{ ");
+		obuf_puts(pobuf, "{ ");
 	for (mlhmmv_level_entry_t* pentry = plevel->phead; pentry != NULL; pentry = pentry->pnext) {
 		char* level_key_string = mv_alloc_format_val(&pentry->level_key);
 		if (quote_keys_always || mv_is_string_or_empty(&pentry->level_key)) {
-			json_print_string_escaped(ostream, level_key_string);
+			json_print_string_escaped(pobuf, level_key_string);
 		} else {
-			fputs(level_key_string, ostream);
+			obuf_puts(pobuf, level_key_string);
 		}
 		free(level_key_string);
-		fprintf(ostream, ": ");
+		obuf_puts(pobuf, ": ");
 
 		if (pentry->level_xvalue.is_terminal) {
 			char* level_value_string = mv_alloc_format_val(&pentry->level_xvalue.terminal_mlrval);
 
 			if (quote_values_always) {
-				fprintf(ostream, "\"%s\"", level_value_string);
+				obuf_putc(pobuf, '"');
+				obuf_puts(pobuf, level_value_string);
+				obuf_putc(pobuf, '"');
 			} else if (pentry->level_xvalue.terminal_mlrval.type == MT_STRING) {
 				double unused;
 				if (mlr_try_float_from_string(level_value_string, &unused)) {
-					fprintf(ostream, "%s", level_value_string);
+					obuf_puts(pobuf, level_value_string);
 				} else if (streq(level_value_string, "true") || streq(level_value_string, "false")) {
-					fprintf(ostream, "%s", level_value_string);
+					obuf_puts(pobuf, level_value_string);
 				} else {
-					json_print_string_escaped(ostream,level_value_string);
+					json_print_string_escaped(pobuf,level_value_string);
 				}
 			} else {
-				fprintf(ostream, "%s", level_value_string);
+				obuf_puts(pobuf, level_value_string);
 			}
 
 			free(level_value_string);
 			if (pentry->pnext != NULL)
-				fprintf(ostream, ", ");
+				obuf_puts(pobuf, ", ");
 		} else {
-			fprintf(ostream, "{");
+			obuf_puts(pobuf, "{");
 			mlhmmv_level_print_single_line(pentry->level_xvalue.pnext_level, depth + 1,
-				pentry->pnext != NULL, quote_keys_always, quote_values_always, ostream);
+				pentry->pnext != NULL, quote_keys_always, quote_values_always, pobuf);
 		}
 	}
 	if (do_final_comma)
-		fprintf(ostream, " },");
+		obuf_puts(pobuf, " },");
 	else
-		fprintf(ostream, " }");
+		obuf_puts(pobuf, " }");
 }
 
 // ----------------------------------------------------------------
@@ -1527,13 +1562,30 @@ void mlhmmv_root_print_json_stacked(mlhmmv_root_t* pmap, int quote_keys_always,
 		quote_values_always, line_indent, line_term, ostream);
 }
 
+void mlhmmv_root_print_json_stacked_obuf(mlhmmv_root_t* pmap, int quote_keys_always, int quote_values_always,
+	char* line_indent, char* line_term, output_buffer_t* pobuf)
+{
+	mlhmmv_level_print_stacked_obuf(pmap->root_xvalue.pnext_level, 0, FALSE, quote_keys_always,
+		quote_values_always, line_indent, line_term, pobuf);
+}
+
 // ----------------------------------------------------------------
 void mlhmmv_root_print_json_single_lines(mlhmmv_root_t* pmap, int quote_keys_always, int quote_values_always,
 	char* line_term, FILE* ostream)
+{
+	output_buffer_t obuf;
+	obuf_init(&obuf, OBUF_DEFAULT_ALLOC_LENGTH);
+	obuf_set_stream(&obuf, ostream);
+	mlhmmv_root_print_json_single_lines_obuf(pmap, quote_keys_always, quote_values_always, line_term, &obuf);
+	obuf_uninit(&obuf);
+}
+
+void mlhmmv_root_print_json_single_lines_obuf(mlhmmv_root_t* pmap, int quote_keys_always, int quote_values_always,
+	char* line_term, output_buffer_t* pobuf)
 {
 	mlhmmv_level_print_single_line(pmap->root_xvalue.pnext_level, 0, FALSE, quote_keys_always,
-		quote_values_always, ostream);
-	fprintf(ostream, "%s", line_term);
+		quote_values_always, pobuf);
+	obuf_puts(pobuf, line_term);
 }
 
 // Used for emit of localvars. Puts the xvalue in a single-key-value-pair map
@@ -19,6 +19,7 @@
 #include "containers/sllmv.h"
 #include "containers/sllv.h"
 #include "containers/lrec.h"
+#include "lib/output_buffer.h"
 
 #define MLHMMV_ERROR_NONE                0x0000
 #define MLHMMV_ERROR_KEYLIST_TOO_DEEP    0xdeef
@@ -304,6 +305,12 @@ void mlhmmv_root_print_json_stacked(mlhmmv_root_t* pmap,
 	FILE* ostream);
 void mlhmmv_root_print_json_single_lines(mlhmmv_root_t* pmap, int quote_keys_always, int quote_values_always,
 	char* line_term, FILE* ostream);
+// As above but appending to an output buffer, for the record writers.
+void mlhmmv_root_print_json_stacked_obuf(mlhmmv_root_t* pmap,
+	int quote_keys_always, int quote_values_always, char* line_indent, char* line_term,
+	output_buffer_t* pobuf);
+void mlhmmv_root_print_json_single_lines_obuf(mlhmmv_root_t* pmap, int quote_keys_always, int quote_values_always,
+	char* line_term, output_buffer_t* pobuf);
 
 // Used for emit of localvars. Puts the xvalue in a single-key-value-pair map
 // keyed by the specified name. The xvalue is referenced, not copied.
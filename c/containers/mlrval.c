@@ -389,11 +389,12 @@ mv_t mv_ref_type_infer_string_or_float_or_int(char* string) {
 	} else {
 		long long intv;
 		double fltv;
-		if (mlr_try_int_from_string(string, &intv)) {
+		switch (mlr_try_int_or_float_from_string(string, &intv, &fltv)) {
+		case MLR_SCANNED_INT:
 			return mv_from_int(intv);
-		} else if (mlr_try_float_from_string(string, &fltv)) {
+		case MLR_SCANNED_FLOAT:
 			return mv_from_float(fltv);
-		} else {
+		default:
 			return mv_from_string(string, NO_FREE);
 		}
 	}
@@ -122,11 +122,9 @@ mv_t s_xx_dot_func(mv_t* pval1, mv_t* pval2) { return (dot_dispositions[pval1->t
 
 // ----------------------------------------------------------------
 mv_t sub_no_precomp_func(mv_t* pval1, mv_t* pval2, mv_t* pval3) {
-	regex_t regex;
 	string_builder_t *psb = sb_alloc(MV_SB_ALLOC_LENGTH);
-	mv_t rv = sub_precomp_func(pval1, regcomp_or_die(&regex, pval2->u.strv, 0), psb, pval3);
+	mv_t rv = sub_precomp_func(pval1, regcomp_cached_or_die(pval2->u.strv, 0), psb, pval3);
 	sb_free(psb);
-	regfree(&regex);
 	mv_free(pval2);
 	return rv;
 }
@@ -143,7 +141,7 @@ mv_t sub_no_precomp_func(mv_t* pval1, mv_t* pval2, mv_t* pval3) {
 // *  len3 = 1 = length of "o"
 // *  len4 = 6 = 2+3+1
 
-mv_t sub_precomp_func(mv_t* pval1, regex_t* pregex, string_builder_t* psb, mv_t* pval3) {
+mv_t sub_precomp_func(mv_t* pval1, mlr_regex_t* pregex, string_builder_t* psb, mv_t* pval3) {
 	int matched      = FALSE;
 	int all_captured = FALSE;
 	char* input      = pval1->u.strv;
@@ -167,16 +165,14 @@ mv_t sub_precomp_func(mv_t* pval1, regex_t* pregex, string_builder_t* psb, mv_t*
 // *  len4 = 6 = 2+3+1
 
 mv_t gsub_no_precomp_func(mv_t* pval1, mv_t* pval2, mv_t* pval3) {
-	regex_t regex;
 	string_builder_t *psb = sb_alloc(MV_SB_ALLOC_LENGTH);
-	mv_t rv = gsub_precomp_func(pval1, regcomp_or_die(&regex, pval2->u.strv, 0), psb, pval3);
+	mv_t rv = gsub_precomp_func(pval1, regcomp_cached_or_die(pval2->u.strv, 0), psb, pval3);
 	sb_free(psb);
-	regfree(&regex);
 	mv_free(pval2);
 	return rv;
 }
 
-mv_t gsub_precomp_func(mv_t* pval1, regex_t* pregex, string_builder_t* psb, mv_t* pval3) {
+mv_t gsub_precomp_func(mv_t* pval1, mlr_regex_t* pregex, string_builder_t* psb, mv_t* pval3) {
 	int matched      = FALSE;
 	int all_captured = FALSE;
 	char* input      = pval1->u.strv;
@@ -1876,28 +1872,25 @@ int mvnecopy(mv_t* pval1, mv_t* pval2) {
 }
 
 // ----------------------------------------------------------------
-// arg2 evaluates to string via compound expression; regexes compiled on each call.
+// arg2 evaluates to string via compound expression; regexes compiled on first use and cached.
 mv_t matches_no_precomp_func(mv_t* pval1, mv_t* pval2, string_array_t** ppregex_captures) {
 	char* s1 = pval1->u.strv;
 	char* s2 = pval2->u.strv;
 
-	regex_t regex;
 	char* sstr   = s1;
 	char* sregex = s2;
 
-	regcomp_or_die(&regex, sregex, REG_NOSUB);
+	mlr_regex_t* pregex = regcomp_cached_or_die(sregex, REG_NOSUB);
 
 	const size_t nmatchmax = 10; // Capture-groups \1 through \9 supported, along with entire-string match
 	regmatch_t matches[nmatchmax];
-	if (regmatch_or_die(&regex, sstr, nmatchmax, matches)) {
+	if (regmatch_or_die(pregex, sstr, nmatchmax, matches)) {
 		if (ppregex_captures != NULL && *ppregex_captures != NULL)
 			save_regex_captures(ppregex_captures, pval1->u.strv, matches, nmatchmax);
-		regfree(&regex);
 		mv_free(pval1);
 		mv_free(pval2);
 		return mv_from_true();
 	} else {
-		regfree(&regex);
 		mv_free(pval1);
 		mv_free(pval2);
 		return mv_from_false();
@@ -1912,7 +1905,7 @@ mv_t does_not_match_no_precomp_func(mv_t* pval1, mv_t* pval2, string_array_t** p
 
 // ----------------------------------------------------------------
 // arg2 is a string, compiled to regex only once at alloc time
-mv_t matches_precomp_func(mv_t* pval1, regex_t* pregex, string_builder_t* psb, string_array_t** ppregex_captures) {
+mv_t matches_precomp_func(mv_t* pval1, mlr_regex_t* pregex, string_builder_t* psb, string_array_t** ppregex_captures) {
 	const size_t nmatchmax = 10; // Capture-groups \1 through \9 supported, along with entire-string match
 	regmatch_t matches[nmatchmax];
 	if (regmatch_or_die(pregex, pval1->u.strv, nmatchmax, matches)) {
@@ -1935,7 +1928,7 @@ mv_t matches_precomp_func(mv_t* pval1, regex_t* pregex, string_builder_t* psb, s
 	}
 }
 
-mv_t does_not_match_precomp_func(mv_t* pval1, regex_t* pregex, string_builder_t* psb, string_array_t** ppregex_captures) {
+mv_t does_not_match_precomp_func(mv_t* pval1, mlr_regex_t* pregex, string_builder_t* psb, string_array_t** ppregex_captures) {
 	mv_t rv = matches_precomp_func(pval1, pregex, psb, ppregex_captures);
 	rv.u.boolv = !rv.u.boolv;
 	return rv;
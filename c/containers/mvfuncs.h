@@ -10,6 +10,7 @@
 #include "../lib/mlrutil.h"
 #include "../lib/mlrdatetime.h"
 #include "../lib/mtrand.h"
+#include "../lib/mlrregex.h"
 #include "../lib/string_builder.h"
 #include "../lib/string_array.h"
 #include "../containers/mlrval.h"
@@ -25,9 +26,9 @@ typedef mv_t mv_zary_func_t();
 typedef mv_t mv_unary_func_t(mv_t* pval1);
 typedef mv_t mv_binary_func_t(mv_t* pval1, mv_t* pval2);
 typedef mv_t mv_binary_arg3_capture_func_t(mv_t* pval1, mv_t* pval2, string_array_t** ppregex_captures);
-typedef mv_t mv_binary_arg2_regex_func_t(mv_t* pval1, regex_t* pregex, string_builder_t* psb, string_array_t** ppregex_captures);
+typedef mv_t mv_binary_arg2_regex_func_t(mv_t* pval1, mlr_regex_t* pregex, string_builder_t* psb, string_array_t** ppregex_captures);
 typedef mv_t mv_ternary_func_t(mv_t* pval1, mv_t* pval2, mv_t* pval3);
-typedef mv_t mv_ternary_arg2_regex_func_t(mv_t* pval1, regex_t* pregex, string_builder_t* psb, mv_t* pval3);
+typedef mv_t mv_ternary_arg2_regex_func_t(mv_t* pval1, mlr_regex_t* pregex, string_builder_t* psb, mv_t* pval3);
 
 // ----------------------------------------------------------------
 static inline mv_t b_b_not_func(mv_t* pval1) {
@@ -170,9 +171,9 @@ mv_t s_x_typeof_func(mv_t* pval1);
 mv_t s_xx_dot_func(mv_t* pval1, mv_t* pval2);
 
 mv_t sub_no_precomp_func(mv_t* pval1, mv_t* pval2, mv_t* pval3);
-mv_t sub_precomp_func(mv_t* pval1, regex_t* pregex, string_builder_t* psb, mv_t* pval3);
+mv_t sub_precomp_func(mv_t* pval1, mlr_regex_t* pregex, string_builder_t* psb, mv_t* pval3);
 mv_t gsub_no_precomp_func(mv_t* pval1, mv_t* pval2, mv_t* pval3);
-mv_t gsub_precomp_func(mv_t* pval1, regex_t* pregex, string_builder_t* psb, mv_t* pval3);
+mv_t gsub_precomp_func(mv_t* pval1, mlr_regex_t* pregex, string_builder_t* psb, mv_t* pval3);
 
 // ----------------------------------------------------------------
 mv_t s_x_sec2gmt_func(mv_t* pval1);
@@ -197,8 +198,8 @@ mv_t time_string_from_seconds(mv_t* psec, char* format);
 mv_t matches_no_precomp_func(mv_t* pval1, mv_t* pval2, string_array_t** ppregex_captures);
 mv_t does_not_match_no_precomp_func(mv_t* pval1, mv_t* pval2, string_array_t** ppregex_captures);
 // arg2 is a string, compiled to regex only once at alloc time
-mv_t matches_precomp_func(mv_t* pval1, regex_t* pregex, string_builder_t* psb, string_array_t** ppregex_captures);
-mv_t does_not_match_precomp_func(mv_t* pval1, regex_t* pregex, string_builder_t* psb, string_array_t** ppregex_captures);
+mv_t matches_precomp_func(mv_t* pval1, mlr_regex_t* pregex, string_builder_t* psb, string_array_t** ppregex_captures);
+mv_t does_not_match_precomp_func(mv_t* pval1, mlr_regex_t* pregex, string_builder_t* psb, string_array_t** ppregex_captures);
 
 // For filter/put DSL:
 mv_t eq_op_func(mv_t* pval1, mv_t* pval2);
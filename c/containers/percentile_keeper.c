@@ -40,6 +40,19 @@ void percentile_keeper_ingest(percentile_keeper_t* ppercentile_keeper, mv_t valu
 	ppercentile_keeper->sorted = FALSE;
 }
 
+// ----------------------------------------------------------------
+void percentile_keeper_merge(percentile_keeper_t* pinto, percentile_keeper_t* pfrom) {
+	int new_size = pinto->size + pfrom->size;
+	if (new_size > pinto->capacity) {
+		while (new_size > pinto->capacity)
+			pinto->capacity = (int)(pinto->capacity * GROWTH_FACTOR);
+		pinto->data = (mv_t*)mlr_realloc_or_die(pinto->data, pinto->capacity*sizeof(mv_t));
+	}
+	memcpy(&pinto->data[pinto->size], pfrom->data, pfrom->size*sizeof(mv_t));
+	pinto->size = new_size;
+	pinto->sorted = FALSE;
+}
+
 // ================================================================
 // Non-interpolated percentiles (see also https://en.wikipedia.org/wiki/Percentile)
 
@@ -16,6 +16,8 @@ typedef struct _percentile_keeper_t {
 percentile_keeper_t* percentile_keeper_alloc();
 void percentile_keeper_free(percentile_keeper_t* ppercentile_keeper);
 void percentile_keeper_ingest(percentile_keeper_t* ppercentile_keeper, mv_t value);
+// Appends all the other keeper's values; the other keeper is unchanged.
+void percentile_keeper_merge(percentile_keeper_t* pinto, percentile_keeper_t* pfrom);
 
 typedef mv_t percentile_keeper_emitter_t(percentile_keeper_t* ppercentile_keeper, double percentile);
 mv_t percentile_keeper_emit_non_interpolated(percentile_keeper_t* ppercentile_keeper, double percentile);
@@ -0,0 +1,494 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "lib/mlr_globals.h"
+#include "lib/mlrutil.h"
+#include "lib/mlrregex.h"
+#include "dsl/batch_filter.h"
+
+// Doubles hold all ints of magnitude less than this exactly.
+#define EXACT_LIMIT 9007199254740992.0 // 2^53
+
+typedef enum _bf_node_kind_t {
+	// Number-valued
+	BF_FIELD_NUMBER,
+	BF_NUMBER_LITERAL,
+	BF_NEGATE,
+	BF_PLUS,
+	BF_MINUS,
+	BF_TIMES,
+	BF_DIVIDE,
+	// Boolean-valued
+	BF_BOOLEAN_LITERAL,
+	BF_COMPARE_NUMBERS,
+	BF_COMPARE_FIELD_STRING, // field with string literal
+	BF_MATCH,                // field with literal regex
+	BF_NOT,
+	BF_AND,
+	BF_OR,
+} bf_node_kind_t;
+
+typedef enum _bf_comparison_t {
+	BF_EQ, BF_NE, BF_LT, BF_LE, BF_GT, BF_GE
+} bf_comparison_t;
+
+// The values of one field over the batch, as numbers or as strings. Values of undecided records
+// are zero or empty.
+typedef struct _bf_column_t {
+	char*   field_name;
+	int     is_string;
+	double* pnumbers;
+	char**  pstrings;
+} bf_column_t;
+
+typedef struct _bf_node_t {
+	bf_node_kind_t     kind;
+	struct _bf_node_t* pleft;
+	struct _bf_node_t* pright;
+	int                column_index; // for fields
+	bf_comparison_t    comparison;
+	char*              string;       // BF_COMPARE_FIELD_STRING
+	mlr_regex_t        regex;        // BF_MATCH
+	int                negate;       // BF_MATCH: TRUE for !=~
+	double*            pnumbers;     // output of number-valued nodes; for fields, their column's values
+	unsigned char*     pbits;        // output of boolean-valued nodes
+} bf_node_t;
+
+struct _batch_filter_t {
+	bf_node_t*     proot;
+	bf_column_t*   pcolumns;
+	int            num_columns;
+	int            capacity;
+	unsigned char* pundecided;
+};
+
+static bf_node_t* compile_number(batch_filter_t* pfilter, mlr_dsl_ast_node_t* pnode);
+static bf_node_t* compile_boolean(batch_filter_t* pfilter, mlr_dsl_ast_node_t* pnode);
+static bf_node_t* compile_comparison(batch_filter_t* pfilter, mlr_dsl_ast_node_t* pnode,
+	bf_comparison_t comparison);
+static bf_node_t* node_alloc(batch_filter_t* pfilter, bf_node_kind_t kind, int is_boolean);
+static void node_free(bf_node_t* pnode);
+static int column_for_field(batch_filter_t* pfilter, char* field_name, int is_string);
+static int lookup_comparison(char* op, bf_comparison_t* pcomparison);
+static void extract_columns(batch_filter_t* pfilter, lrec_t** precords, int n);
+static void evaluate_node(batch_filter_t* pfilter, bf_node_t* pnode, int n);
+
+// ----------------------------------------------------------------
+batch_filter_t* batch_filter_alloc(mlr_dsl_ast_node_t* proot, int capacity) {
+	if (proot->type != MD_AST_NODE_TYPE_STATEMENT_BLOCK || proot->pchildren == NULL
+		|| proot->pchildren->length != 1)
+	{
+		return NULL;
+	}
+
+	batch_filter_t* pfilter = mlr_malloc_or_die(sizeof(batch_filter_t));
+	pfilter->pcolumns    = NULL;
+	pfilter->num_columns = 0;
+	pfilter->capacity    = capacity;
+	pfilter->pundecided  = mlr_malloc_or_die(capacity);
+	pfilter->proot       = compile_boolean(pfilter, proot->pchildren->phead->pvvalue);
+	if (pfilter->proot == NULL) {
+		batch_filter_free(pfilter);
+		return NULL;
+	}
+	return pfilter;
+}
+
+void batch_filter_free(batch_filter_t* pfilter) {
+	if (pfilter == NULL)
+		return;
+	node_free(pfilter->proot);
+	for (int j = 0; j < pfilter->num_columns; j++) {
+		bf_column_t* pcolumn = &pfilter->pcolumns[j];
+		free(pcolumn->field_name);
+		free(pcolumn->pnumbers);
+		free(pcolumn->pstrings);
+	}
+	free(pfilter->pcolumns);
+	free(pfilter->pundecided);
+	free(pfilter);
+}
+
+// ----------------------------------------------------------------
+// Each of these returns NULL if the expression isn't one the columnar evaluation handles.
+
+static bf_node_t* compile_number(batch_filter_t* pfilter, mlr_dsl_ast_node_t* pnode) {
+	int num_children = (pnode->pchildren == NULL) ? 0 : pnode->pchildren->length;
+
+	if (pnode->type == MD_AST_NODE_TYPE_FIELD_NAME) {
+		bf_node_t* presult = node_alloc(pfilter, BF_FIELD_NUMBER, FALSE);
+		presult->column_index = column_for_field(pfilter, pnode->text, FALSE);
+		presult->pnumbers = pfilter->pcolumns[presult->column_index].pnumbers;
+		return presult;
+
+	} else if (pnode->type == MD_AST_NODE_TYPE_NUMERIC_LITERAL) {
+		// As rval_evaluator_alloc_from_numeric_literal would type it
+		long long intv;
+		double fltv;
+		if (mlr_try_int_from_string(pnode->text, &intv))
+			fltv = (double)intv;
+		else if (!mlr_try_float_from_string(pnode->text, &fltv))
+			return NULL;
+		if (!(fabs(fltv) < EXACT_LIMIT))
+			return NULL;
+		bf_node_t* presult = node_alloc(pfilter, BF_NUMBER_LITERAL, FALSE);
+		for (int i = 0; i < pfilter->capacity; i++)
+			presult->pnumbers[i] = fltv;
+		return presult;
+
+	} else if (pnode->type != MD_AST_NODE_TYPE_OPERATOR) {
+		return NULL;
+
+	} else if (num_children == 1 && streq(pnode->text, "-")) {
+		bf_node_t* poperand = compile_number(pfilter, pnode->pchildren->phead->pvvalue);
+		if (poperand == NULL)
+			return NULL;
+		bf_node_t* presult = node_alloc(pfilter, BF_NEGATE, FALSE);
+		presult->pleft = poperand;
+		return presult;
+
+	} else if (num_children == 2) {
+		bf_node_kind_t kind;
+		if (streq(pnode->text, "+"))
+			kind = BF_PLUS;
+		else if (streq(pnode->text, "-"))
+			kind = BF_MINUS;
+		else if (streq(pnode->text, "*"))
+			kind = BF_TIMES;
+		else if (streq(pnode->text, "/"))
+			kind = BF_DIVIDE;
+		else
+			return NULL;
+
+		bf_node_t* pleft = compile_number(pfilter, pnode->pchildren->phead->pvvalue);
+		bf_node_t* pright = compile_number(pfilter, pnode->pchildren->phead->pnext->pvvalue);
+		if (pleft == NULL || pright == NULL) {
+			node_free(pleft);
+			node_free(pright);
+			return NULL;
+		}
+		bf_node_t* presult = node_alloc(pfilter, kind, FALSE);
+		presult->pleft = pleft;
+		presult->pright = pright;
+		return presult;
+
+	} else {
+		return NULL;
+	}
+}
+
+static bf_node_t* compile_boolean(batch_filter_t* pfilter, mlr_dsl_ast_node_t* pnode) {
+	int num_children = (pnode->pchildren == NULL) ? 0 : pnode->pchildren->length;
+	bf_comparison_t comparison;
+
+	if (pnode->type == MD_AST_NODE_TYPE_BOOLEAN_LITERAL) {
+		bf_node_t* presult = node_alloc(pfilter, BF_BOOLEAN_LITERAL, TRUE);
+		memset(presult->pbits, streq(pnode->text, "true") ? 1 : 0, pfilter->capacity);
+		return presult;
+
+	} else if (pnode->type != MD_AST_NODE_TYPE_OPERATOR) {
+		return NULL;
+
+	} else if (num_children == 1 && streq(pnode->text, "!")) {
+		bf_node_t* poperand = compile_boolean(pfilter, pnode->pchildren->phead->pvvalue);
+		if (poperand == NULL)
+			return NULL;
+		bf_node_t* presult = node_alloc(pfilter, BF_NOT, TRUE);
+		presult->pleft = poperand;
+		return presult;
+
+	} else if (num_children != 2) {
+		return NULL;
+
+	} else if (streq(pnode->text, "&&") || streq(pnode->text, "||")) {
+		bf_node_t* pleft = compile_boolean(pfilter, pnode->pchildren->phead->pvvalue);
+		bf_node_t* pright = compile_boolean(pfilter, pnode->pchildren->phead->pnext->pvvalue);
+		if (pleft == NULL || pright == NULL) {
+			node_free(pleft);
+			node_free(pright);
+			return NULL;
+		}
+		bf_node_t* presult = node_alloc(pfilter, streq(pnode->text, "&&") ? BF_AND : BF_OR, TRUE);
+		presult->pleft = pleft;
+		presult->pright = pright;
+		return presult;
+
+	} else if (streq(pnode->text, "=~") || streq(pnode->text, "!=~")) {
+		// As fmgr_alloc_evaluator_from_binary_regex_arg2_func_name would compile it
+		mlr_dsl_ast_node_t* pleft_node = pnode->pchildren->phead->pvvalue;
+		mlr_dsl_ast_node_t* pright_node = pnode->pchildren->phead->pnext->pvvalue;
+		if (pleft_node->type != MD_AST_NODE_TYPE_FIELD_NAME)
+			return NULL;
+		int cflags = REG_NOSUB;
+		if (pright_node->type == MD_AST_NODE_TYPE_REGEXI)
+			cflags |= REG_ICASE;
+		else if (pright_node->type != MD_AST_NODE_TYPE_STRING_LITERAL)
+			return NULL;
+		bf_node_t* presult = node_alloc(pfilter, BF_MATCH, TRUE);
+		presult->column_index = column_for_field(pfilter, pleft_node->text, TRUE);
+		regcomp_or_die(&presult->regex, pright_node->text, cflags);
+		presult->negate = streq(pnode->text, "!=~");
+		return presult;
+
+	} else if (lookup_comparison(pnode->text, &comparison)) {
+		return compile_comparison(pfilter, pnode, comparison);
+
+	} else {
+		return NULL;
+	}
+}
+
+static bf_node_t* compile_comparison(batch_filter_t* pfilter, mlr_dsl_ast_node_t* pnode,
+	bf_comparison_t comparison)
+{
+	mlr_dsl_ast_node_t* pleft_node = pnode->pchildren->phead->pvvalue;
+	mlr_dsl_ast_node_t* pright_node = pnode->pchildren->phead->pnext->pvvalue;
+
+	// A string literal with the field on the other side. Literals with backslashes are left alone
+	// since they may be regex captures such as "\1".
+	if (pleft_node->type == MD_AST_NODE_TYPE_STRING_LITERAL) {
+		mlr_dsl_ast_node_t* ptemp = pleft_node;
+		pleft_node = pright_node;
+		pright_node = ptemp;
+		switch (comparison) {
+		case BF_LT: comparison = BF_GT; break;
+		case BF_LE: comparison = BF_GE; break;
+		case BF_GT: comparison = BF_LT; break;
+		case BF_GE: comparison = BF_LE; break;
+		default: break;
+		}
+	}
+	if (pright_node->type == MD_AST_NODE_TYPE_STRING_LITERAL) {
+		if (pleft_node->type != MD_AST_NODE_TYPE_FIELD_NAME || strchr(pright_node->text, '\\') != NULL)
+			return NULL;
+		bf_node_t* presult = node_alloc(pfilter, BF_COMPARE_FIELD_STRING, TRUE);
+		presult->column_index = column_for_field(pfilter, pleft_node->text, TRUE);
+		presult->comparison = comparison;
+		presult->string = mlr_strdup_or_die(pright_node->text);
+		return presult;
+	}
+
+	bf_node_t* pleft = compile_number(pfilter, pleft_node);
+	bf_node_t* pright = compile_number(pfilter, pright_node);
+	if (pleft == NULL || pright == NULL) {
+		node_free(pleft);
+		node_free(pright);
+		return NULL;
+	}
+	bf_node_t* presult = node_alloc(pfilter, BF_COMPARE_NUMBERS, TRUE);
+	presult->pleft = pleft;
+	presult->pright = pright;
+	presult->comparison = comparison;
+	return presult;
+}
+
+// ----------------------------------------------------------------
+static bf_node_t* node_alloc(batch_filter_t* pfilter, bf_node_kind_t kind, int is_boolean) {
+	bf_node_t* pnode = mlr_malloc_or_die(sizeof(bf_node_t));
+	memset(pnode, 0, sizeof(bf_node_t));
+	pnode->kind = kind;
+	pnode->column_index = -1;
+	if (is_boolean)
+		pnode->pbits = mlr_malloc_or_die(pfilter->capacity);
+	else if (kind != BF_FIELD_NUMBER)
+		pnode->pnumbers = mlr_malloc_or_die(pfilter->capacity * sizeof(double));
+	return pnode;
+}
+
+static void node_free(bf_node_t* pnode) {
+	if (pnode == NULL)
+		return;
+	node_free(pnode->pleft);
+	node_free(pnode->pright);
+	if (pnode->kind == BF_MATCH)
+		mlr_regfree(&pnode->regex);
+	if (pnode->kind != BF_FIELD_NUMBER)
+		free(pnode->pnumbers);
+	free(pnode->pbits);
+	free(pnode->string);
+	free(pnode);
+}
+
+// A field read both as a number and as a string gets a column for each.
+static int column_for_field(batch_filter_t* pfilter, char* field_name, int is_string) {
+	for (int j = 0; j < pfilter->num_columns; j++) {
+		bf_column_t* pcolumn = &pfilter->pcolumns[j];
+		if (pcolumn->is_string == is_string && streq(pcolumn->field_name, field_name))
+			return j;
+	}
+	pfilter->pcolumns = mlr_realloc_or_die(pfilter->pcolumns, (pfilter->num_columns + 1) * sizeof(bf_column_t));
+	bf_column_t* pcolumn = &pfilter->pcolumns[pfilter->num_columns];
+	pcolumn->field_name = mlr_strdup_or_die(field_name);
+	pcolumn->is_string  = is_string;
+	pcolumn->pnumbers   = is_string ? NULL : mlr_malloc_or_die(pfilter->capacity * sizeof(double));
+	pcolumn->pstrings   = is_string ? mlr_malloc_or_die(pfilter->capacity * sizeof(char*)) : NULL;
+	return pfilter->num_columns++;
+}
+
+static int lookup_comparison(char* op, bf_comparison_t* pcomparison) {
+	if      (streq(op, "==")) *pcomparison = BF_EQ;
+	else if (streq(op, "!=")) *pcomparison = BF_NE;
+	else if (streq(op, "<"))  *pcomparison = BF_LT;
+	else if (streq(op, "<=")) *pcomparison = BF_LE;
+	else if (streq(op, ">"))  *pcomparison = BF_GT;
+	else if (streq(op, ">=")) *pcomparison = BF_GE;
+	else return FALSE;
+	return TRUE;
+}
+
+// ----------------------------------------------------------------
+void batch_filter_evaluate(batch_filter_t* pfilter, lrec_t** precords, int num_records, char* pverdicts) {
+	MLR_INTERNAL_CODING_ERROR_IF(num_records > pfilter->capacity);
+	memset(pfilter->pundecided, 0, num_records);
+	extract_columns(pfilter, precords, num_records);
+	evaluate_node(pfilter, pfilter->proot, num_records);
+
+	unsigned char* pundecided = pfilter->pundecided;
+	unsigned char* pbits = pfilter->proot->pbits;
+	for (int i = 0; i < num_records; i++)
+		pverdicts[i] = pundecided[i] ? BATCH_FILTER_UNDECIDED : pbits[i];
+}
+
+// Fields are typed as by the DSL without -S or -F (see mv_ref_type_infer_entry_string_or_float_or_int):
+// a field read as a number is undecided if absent, empty, or a string, and one read as a string is
+// undecided if absent or a number.
+static void extract_columns(batch_filter_t* pfilter, lrec_t** precords, int n) {
+	unsigned char* pundecided = pfilter->pundecided;
+	for (int j = 0; j < pfilter->num_columns; j++) {
+		bf_column_t* pcolumn = &pfilter->pcolumns[j];
+		for (int i = 0; i < n; i++) {
+			lrece_t* pe = NULL;
+			lrec_get_ext(precords[i], pcolumn->field_name, &pe);
+			long long intv = 0LL;
+			double fltv = 0.0;
+			int scan_result = MLR_SCANNED_NEITHER;
+			if (pe == NULL || pe->value == NULL)
+				pundecided[i] = TRUE;
+			else if (*pe->value != 0)
+				scan_result = lrece_scan_int_or_float(pe, &intv, &fltv);
+
+			if (pcolumn->is_string) {
+				if (pundecided[i] || scan_result != MLR_SCANNED_NEITHER) {
+					pundecided[i] = TRUE;
+					pcolumn->pstrings[i] = "";
+				} else {
+					pcolumn->pstrings[i] = pe->value;
+				}
+			} else {
+				if (scan_result == MLR_SCANNED_INT)
+					fltv = (double)intv;
+				else if (scan_result != MLR_SCANNED_FLOAT)
+					pundecided[i] = TRUE;
+				if (!(fabs(fltv) < EXACT_LIMIT)) {
+					pundecided[i] = TRUE;
+					fltv = 0.0;
+				}
+				pcolumn->pnumbers[i] = fltv;
+			}
+		}
+	}
+}
+
+// Sums, differences, products, and quotients of numbers less than 2^53 in magnitude are, as
+// doubles, what Miller's int or float arithmetic would give as long as they're likewise less than
+// 2^53 in magnitude. Otherwise, including for infinities and NaNs from division by zero, the
+// record is undecided.
+static void mark_out_of_range(unsigned char* restrict pundecided, double* restrict pnumbers, int n) {
+	for (int i = 0; i < n; i++)
+		pundecided[i] |= !(fabs(pnumbers[i]) < EXACT_LIMIT);
+}
+
+static void evaluate_node(batch_filter_t* pfilter, bf_node_t* pnode, int n) {
+	if (pnode->pleft != NULL)
+		evaluate_node(pfilter, pnode->pleft, n);
+	if (pnode->pright != NULL)
+		evaluate_node(pfilter, pnode->pright, n);
+
+	unsigned char* restrict pundecided = pfilter->pundecided;
+	double* restrict a = (pnode->pleft != NULL) ? pnode->pleft->pnumbers : NULL;
+	double* restrict b = (pnode->pright != NULL) ? pnode->pright->pnumbers : NULL;
+	unsigned char* restrict p = (pnode->pleft != NULL) ? pnode->pleft->pbits : NULL;
+	unsigned char* restrict q = (pnode->pright != NULL) ? pnode->pright->pbits : NULL;
+	double* restrict out = pnode->pnumbers;
+	unsigned char* restrict bits = pnode->pbits;
+
+	switch (pnode->kind) {
+
+	case BF_FIELD_NUMBER:
+	case BF_NUMBER_LITERAL:
+	case BF_BOOLEAN_LITERAL:
+		break;
+
+	case BF_NEGATE:
+		for (int i = 0; i < n; i++)
+			out[i] = -a[i];
+		break;
+	case BF_PLUS:
+		for (int i = 0; i < n; i++)
+			out[i] = a[i] + b[i];
+		mark_out_of_range(pundecided, out, n);
+		break;
+	case BF_MINUS:
+		for (int i = 0; i < n; i++)
+			out[i] = a[i] - b[i];
+		mark_out_of_range(pundecided, out, n);
+		break;
+	case BF_TIMES:
+		for (int i = 0; i < n; i++)
+			out[i] = a[i] * b[i];
+		mark_out_of_range(pundecided, out, n);
+		break;
+	case BF_DIVIDE:
+		for (int i = 0; i < n; i++)
+			out[i] = a[i] / b[i];
+		mark_out_of_range(pundecided, out, n);
+		break;
+
+	case BF_COMPARE_NUMBERS:
+		switch (pnode->comparison) {
+		case BF_EQ: for (int i = 0; i < n; i++) bits[i] = a[i] == b[i]; break;
+		case BF_NE: for (int i = 0; i < n; i++) bits[i] = a[i] != b[i]; break;
+		case BF_LT: for (int i = 0; i < n; i++) bits[i] = a[i] <  b[i]; break;
+		case BF_LE: for (int i = 0; i < n; i++) bits[i] = a[i] <= b[i]; break;
+		case BF_GT: for (int i = 0; i < n; i++) bits[i] = a[i] >  b[i]; break;
+		case BF_GE: for (int i = 0; i < n; i++) bits[i] = a[i] >= b[i]; break;
+		}
+		break;
+
+	case BF_COMPARE_FIELD_STRING: {
+		char** pstrings = pfilter->pcolumns[pnode->column_index].pstrings;
+		for (int i = 0; i < n; i++) {
+			int c = strcmp(pstrings[i], pnode->string);
+			switch (pnode->comparison) {
+			case BF_EQ: bits[i] = c == 0; break;
+			case BF_NE: bits[i] = c != 0; break;
+			case BF_LT: bits[i] = c <  0; break;
+			case BF_LE: bits[i] = c <= 0; break;
+			case BF_GT: bits[i] = c >  0; break;
+			case BF_GE: bits[i] = c >= 0; break;
+			}
+		}
+		break;
+	}
+
+	case BF_MATCH: {
+		char** pstrings = pfilter->pcolumns[pnode->column_index].pstrings;
+		for (int i = 0; i < n; i++)
+			bits[i] = pundecided[i] ? 0 : regmatch_or_die(&pnode->regex, pstrings[i], 0, NULL) ^ pnode->negate;
+		break;
+	}
+
+	case BF_NOT:
+		for (int i = 0; i < n; i++)
+			bits[i] = p[i] ^ 1;
+		break;
+	case BF_AND:
+		for (int i = 0; i < n; i++)
+			bits[i] = p[i] & q[i];
+		break;
+	case BF_OR:
+		for (int i = 0; i < n; i++)
+			bits[i] = p[i] | q[i];
+		break;
+	}
+}
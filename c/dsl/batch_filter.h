@@ -0,0 +1,44 @@
+// ================================================================
+// Columnar evaluation of simple filter expressions, for mlr filter --batch. For example in
+//
+//   mlr filter --batch '$status == 200 && $latency > 500'
+//
+// the status and latency fields of a batch of records are scanned into arrays of numbers, then
+// the comparisons and the "&&" are each done in one loop over the batch, rather than the whole
+// expression being evaluated once per record.
+//
+// Only expressions made of fields, number and string literals, arithmetic (unary and binary "-",
+// "+", "*", "/"), comparisons, "=~" and "!=~" against literal regexes, "&&", "||", and "!" are
+// done this way, and only when the expression is all there is to the filter.
+//
+// Rather than follow Miller's typing rules in full, the columnar evaluation handles the common
+// cases only: numbers compared with or combined with numbers, and strings compared with or
+// matched against literals. Numbers are held as doubles, which is exact for ints of magnitude up
+// to 2^53 and for the results of arithmetic on them up to that magnitude. Any record for which
+// this doesn't suffice -- the field is absent or empty, a number was expected but the field is a
+// string or vice versa, a value is too large, or there's a division by zero -- is left undecided,
+// to be evaluated by the DSL in the usual way. So results are the same either way.
+// ================================================================
+
+#ifndef BATCH_FILTER_H
+#define BATCH_FILTER_H
+
+#include "containers/lrec.h"
+#include "dsl/mlr_dsl_ast.h"
+
+// Per-record results of batch_filter_evaluate.
+#define BATCH_FILTER_FALSE     0
+#define BATCH_FILTER_TRUE      1
+#define BATCH_FILTER_UNDECIDED 2
+
+typedef struct _batch_filter_t batch_filter_t;
+
+// Takes the root of the filter's AST before the CST is built from it. Returns NULL if the
+// expression can't be evaluated this way. The capacity is the most records per batch.
+batch_filter_t* batch_filter_alloc(mlr_dsl_ast_node_t* proot, int capacity);
+void batch_filter_free(batch_filter_t* pfilter);
+
+// Sets one verdict per record.
+void batch_filter_evaluate(batch_filter_t* pfilter, lrec_t** precords, int num_records, char* pverdicts);
+
+#endif // BATCH_FILTER_H
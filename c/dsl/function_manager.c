@@ -136,6 +136,10 @@ fmgr_t* fmgr_alloc() {
 	pfmgr->pfunc_callsite_evaluators_to_resolve  = sllv_alloc();
 	pfmgr->pfunc_callsite_xevaluators_to_resolve = sllv_alloc();
 
+	pfmgr->compile_to_bytecode = FALSE;
+	pfmgr->pfolded_evaluators = sllv_alloc();
+	pfmgr->pfield_cache = srec_field_cache_alloc();
+
 	return pfmgr;
 }
 
@@ -144,6 +148,13 @@ void fmgr_free(fmgr_t* pfmgr, context_t* pctx) {
 	if (pfmgr == NULL)
 		return;
 
+	for (sllve_t* pe = pfmgr->pfolded_evaluators->phead; pe != NULL; pe = pe->pnext) {
+		rval_evaluator_t* pevaluator = pe->pvvalue;
+		pevaluator->pfree_func(pevaluator);
+	}
+	sllv_free(pfmgr->pfolded_evaluators);
+	srec_field_cache_free(pfmgr->pfield_cache);
+
 	for (lhmsve_t* pe = pfmgr->pudf_names_to_defsite_states->phead; pe != NULL; pe = pe->pnext) {
 		udf_defsite_state_t * pdefsite_state = pe->pvvalue;
 		free(pdefsite_state->name);
@@ -1034,76 +1045,193 @@ static rval_evaluator_t* fmgr_alloc_evaluator_from_variadic_func_name(char* fnnm
 	} else return NULL;
 }
 
+// ================================================================
+static scalar_builtin_t SCALAR_BUILTIN_TABLE[] = {
+	{"urand",      0, BUILTIN_SHAPE_X_Z,   .pzary_func = f_z_urand_func, .impure = TRUE},
+	{"urand32",    0, BUILTIN_SHAPE_X_Z,   .pzary_func = i_z_urand32_func, .impure = TRUE},
+	{"systime",    0, BUILTIN_SHAPE_X_Z,   .pzary_func = f_z_systime_func, .impure = TRUE},
+
+	{"!",          1, BUILTIN_SHAPE_B_B,   .punary_func = b_b_not_func},
+	{"+",          1, BUILTIN_SHAPE_X_X,   .punary_func = x_x_upos_func},
+	{"-",          1, BUILTIN_SHAPE_X_X,   .punary_func = x_x_uneg_func},
+	{"abs",        1, BUILTIN_SHAPE_X_X,   .punary_func = x_x_abs_func},
+	{"acos",       1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_acos_func},
+	{"acosh",      1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_acosh_func},
+	{"asin",       1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_asin_func},
+	{"asinh",      1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_asinh_func},
+	{"atan",       1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_atan_func},
+	{"atanh",      1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_atanh_func},
+	{"boolean",    1, BUILTIN_SHAPE_X_X,   .punary_func = b_x_boolean_func},
+	{"cbrt",       1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_cbrt_func},
+	{"ceil",       1, BUILTIN_SHAPE_X_X,   .punary_func = x_x_ceil_func},
+	{"cos",        1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_cos_func},
+	{"cosh",       1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_cosh_func},
+	{"dhms2fsec",  1, BUILTIN_SHAPE_F_S,   .punary_func = f_s_dhms2fsec_func},
+	{"dhms2sec",   1, BUILTIN_SHAPE_F_S,   .punary_func = i_s_dhms2sec_func},
+	{"erf",        1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_erf_func},
+	{"erfc",       1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_erfc_func},
+	{"exp",        1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_exp_func},
+	{"expm1",      1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_expm1_func},
+	{"float",      1, BUILTIN_SHAPE_X_X,   .punary_func = f_x_float_func},
+	{"floor",      1, BUILTIN_SHAPE_X_X,   .punary_func = x_x_floor_func},
+	{"fsec2dhms",  1, BUILTIN_SHAPE_S_F,   .punary_func = s_f_fsec2dhms_func},
+	{"fsec2hms",   1, BUILTIN_SHAPE_S_F,   .punary_func = s_f_fsec2hms_func},
+	{"gmt2sec",    1, BUILTIN_SHAPE_I_S,   .punary_func = i_s_gmt2sec_func, .impure = TRUE},
+	{"hexfmt",     1, BUILTIN_SHAPE_X_X,   .punary_func = s_x_hexfmt_func},
+	{"hms2fsec",   1, BUILTIN_SHAPE_F_S,   .punary_func = f_s_hms2fsec_func},
+	{"hms2sec",    1, BUILTIN_SHAPE_F_S,   .punary_func = i_s_hms2sec_func},
+	{"int",        1, BUILTIN_SHAPE_X_X,   .punary_func = i_x_int_func},
+	{"invqnorm",   1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_invqnorm_func},
+	{"log",        1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_log_func},
+	{"log10",      1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_log10_func},
+	{"log1p",      1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_log1p_func},
+	{"qnorm",      1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_qnorm_func},
+	{"round",      1, BUILTIN_SHAPE_X_X,   .punary_func = x_x_round_func},
+	{"sec2dhms",   1, BUILTIN_SHAPE_S_I,   .punary_func = s_i_sec2dhms_func},
+	{"sec2gmt",    1, BUILTIN_SHAPE_X_X,   .punary_func = s_x_sec2gmt_func, .impure = TRUE},
+	{"sec2gmtdate",1, BUILTIN_SHAPE_X_X,   .punary_func = s_x_sec2gmtdate_func, .impure = TRUE},
+	{"sec2hms",    1, BUILTIN_SHAPE_S_I,   .punary_func = s_i_sec2hms_func},
+	{"sgn",        1, BUILTIN_SHAPE_X_X,   .punary_func = x_x_sgn_func},
+	{"sin",        1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_sin_func},
+	{"sinh",       1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_sinh_func},
+	{"sqrt",       1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_sqrt_func},
+	{"string",     1, BUILTIN_SHAPE_X_X,   .punary_func = s_x_string_func},
+	{"strlen",     1, BUILTIN_SHAPE_I_S,   .punary_func = i_s_strlen_func},
+	{"tan",        1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_tan_func},
+	{"tanh",       1, BUILTIN_SHAPE_F_F,   .punary_func = f_f_tanh_func},
+	{"tolower",    1, BUILTIN_SHAPE_S_S,   .punary_func = s_s_tolower_func},
+	{"toupper",    1, BUILTIN_SHAPE_S_S,   .punary_func = s_s_toupper_func},
+	{"~",          1, BUILTIN_SHAPE_I_I,   .punary_func = i_i_bitwise_not_func},
+
+	{"==",         2, BUILTIN_SHAPE_X_XX,  .pbinary_func = eq_op_func},
+	{"!=",         2, BUILTIN_SHAPE_X_XX,  .pbinary_func = ne_op_func},
+	{">",          2, BUILTIN_SHAPE_X_XX,  .pbinary_func = gt_op_func},
+	{">=",         2, BUILTIN_SHAPE_X_XX,  .pbinary_func = ge_op_func},
+	{"<",          2, BUILTIN_SHAPE_X_XX,  .pbinary_func = lt_op_func},
+	{"<=",         2, BUILTIN_SHAPE_X_XX,  .pbinary_func = le_op_func},
+	{".",          2, BUILTIN_SHAPE_X_XX,  .pbinary_func = s_xx_dot_func},
+	{"+",          2, BUILTIN_SHAPE_X_XX,  .pbinary_func = x_xx_plus_func},
+	{"-",          2, BUILTIN_SHAPE_X_XX,  .pbinary_func = x_xx_minus_func},
+	{"*",          2, BUILTIN_SHAPE_X_XX,  .pbinary_func = x_xx_times_func},
+	{"/",          2, BUILTIN_SHAPE_X_XX,  .pbinary_func = x_xx_divide_func},
+	{"//",         2, BUILTIN_SHAPE_X_XX,  .pbinary_func = x_xx_int_divide_func},
+	{"%",          2, BUILTIN_SHAPE_X_XX,  .pbinary_func = x_xx_mod_func},
+	{"**",         2, BUILTIN_SHAPE_F_FF,  .pbinary_func = f_ff_pow_func},
+	{"pow",        2, BUILTIN_SHAPE_F_FF,  .pbinary_func = f_ff_pow_func},
+	{"atan2",      2, BUILTIN_SHAPE_F_FF,  .pbinary_func = f_ff_atan2_func},
+	{"roundm",     2, BUILTIN_SHAPE_X_XX,  .pbinary_func = x_xx_roundm_func},
+	{"fmtnum",     2, BUILTIN_SHAPE_S_XS,  .pbinary_func = s_xs_fmtnum_func},
+	{"urandint",   2, BUILTIN_SHAPE_I_II,  .pbinary_func = i_ii_urandint_func, .impure = TRUE},
+	{"&",          2, BUILTIN_SHAPE_X_XX,  .pbinary_func = x_xx_band_func},
+	{"|",          2, BUILTIN_SHAPE_X_XX,  .pbinary_func = x_xx_bor_func},
+	{"^",          2, BUILTIN_SHAPE_X_XX,  .pbinary_func = x_xx_bxor_func},
+	{"<<",         2, BUILTIN_SHAPE_I_II,  .pbinary_func = i_ii_bitwise_lsh_func},
+	{">>",         2, BUILTIN_SHAPE_I_II,  .pbinary_func = i_ii_bitwise_rsh_func},
+	{"strftime",   2, BUILTIN_SHAPE_X_NS,  .pbinary_func = s_ns_strftime_func, .impure = TRUE},
+	{"strptime",   2, BUILTIN_SHAPE_X_SS,  .pbinary_func = i_ss_strptime_func, .impure = TRUE},
+
+	{"logifit",    3, BUILTIN_SHAPE_F_FFF, .pternary_func = f_fff_logifit_func},
+	{"madd",       3, BUILTIN_SHAPE_I_III, .pternary_func = i_iii_modadd_func, .impure = TRUE},
+	{"msub",       3, BUILTIN_SHAPE_I_III, .pternary_func = i_iii_modsub_func, .impure = TRUE},
+	{"mmul",       3, BUILTIN_SHAPE_I_III, .pternary_func = i_iii_modmul_func, .impure = TRUE},
+	{"mexp",       3, BUILTIN_SHAPE_I_III, .pternary_func = i_iii_modexp_func, .impure = TRUE},
+	{"substr",     3, BUILTIN_SHAPE_S_SII, .pternary_func = s_sii_substr_func},
+
+	{NULL, -1, 0}, // table terminator
+};
+
+scalar_builtin_t* fmgr_look_up_scalar_builtin(char* function_name, int arity) {
+	for (scalar_builtin_t* pbuiltin = &SCALAR_BUILTIN_TABLE[0]; pbuiltin->name != NULL; pbuiltin++) {
+		if (pbuiltin->arity == arity && streq(pbuiltin->name, function_name))
+			return pbuiltin;
+	}
+	return NULL;
+}
+
+// ----------------------------------------------------------------
+// The short-circuiting operators are included since their values are determined by their
+// arguments too; "? :" isn't since it exits on a non-boolean condition.
+int fmgr_is_foldable_builtin(char* function_name, int arity) {
+	if (arity == 2 && (streq(function_name, "&&") || streq(function_name, "||") || streq(function_name, "^^")))
+		return TRUE;
+	if (streq(function_name, "min") || streq(function_name, "max"))
+		return TRUE;
+	scalar_builtin_t* pbuiltin = fmgr_look_up_scalar_builtin(function_name, arity);
+	return pbuiltin != NULL && !pbuiltin->impure;
+}
+
+rval_evaluator_t* fmgr_alloc_foldable_from_operator_or_function_call(fmgr_t* pfmgr, mlr_dsl_ast_node_t* pnode,
+	int type_inferencing, int context_flags)
+{
+	char* function_name = pnode->text;
+	int nargs = pnode->pchildren->length;
+	rval_evaluator_t** pargs = mlr_malloc_or_die((nargs + 1) * sizeof(rval_evaluator_t*));
+	int i = 0;
+	for (sllve_t* pe = pnode->pchildren->phead; pe != NULL; pe = pe->pnext, i++)
+		pargs[i] = rval_evaluator_alloc_from_ast(pe->pvvalue, pfmgr, type_inferencing, context_flags);
+
+	if (streq(function_name, "min") || streq(function_name, "max"))
+		return fmgr_alloc_evaluator_from_variadic_func_name(function_name, pargs, nargs);
+
+	rval_evaluator_t* pevaluator = NULL;
+	switch (nargs) {
+	case 0: pevaluator = fmgr_alloc_evaluator_from_zary_func_name(function_name); break;
+	case 1: pevaluator = fmgr_alloc_evaluator_from_unary_func_name(function_name, pargs[0]); break;
+	case 2: pevaluator = fmgr_alloc_evaluator_from_binary_func_name(function_name, pargs[0], pargs[1]); break;
+	case 3: pevaluator = fmgr_alloc_evaluator_from_ternary_func_name(function_name, pargs[0], pargs[1], pargs[2]); break;
+	}
+	MLR_INTERNAL_CODING_ERROR_IF(pevaluator == NULL);
+	free(pargs);
+	return pevaluator;
+}
+
+// ----------------------------------------------------------------
+static rval_evaluator_t* fmgr_alloc_evaluator_from_scalar_builtin(scalar_builtin_t* pbuiltin,
+	rval_evaluator_t* parg1, rval_evaluator_t* parg2, rval_evaluator_t* parg3)
+{
+	mv_unary_func_t*   pu = pbuiltin->punary_func;
+	mv_binary_func_t*  pb = pbuiltin->pbinary_func;
+	mv_ternary_func_t* pt = pbuiltin->pternary_func;
+	switch (pbuiltin->shape) {
+	case BUILTIN_SHAPE_X_Z:   return rval_evaluator_alloc_from_x_z_func(pbuiltin->pzary_func);
+	case BUILTIN_SHAPE_X_X:   return rval_evaluator_alloc_from_x_x_func(pu, parg1);
+	case BUILTIN_SHAPE_B_B:   return rval_evaluator_alloc_from_b_b_func(pu, parg1);
+	case BUILTIN_SHAPE_F_F:   return rval_evaluator_alloc_from_f_f_func(pu, parg1);
+	case BUILTIN_SHAPE_I_I:   return rval_evaluator_alloc_from_i_i_func(pu, parg1);
+	case BUILTIN_SHAPE_F_S:   return rval_evaluator_alloc_from_f_s_func(pu, parg1);
+	case BUILTIN_SHAPE_I_S:   return rval_evaluator_alloc_from_i_s_func(pu, parg1);
+	case BUILTIN_SHAPE_S_F:   return rval_evaluator_alloc_from_s_f_func(pu, parg1);
+	case BUILTIN_SHAPE_S_I:   return rval_evaluator_alloc_from_s_i_func(pu, parg1);
+	case BUILTIN_SHAPE_S_S:   return rval_evaluator_alloc_from_s_s_func(pu, parg1);
+	case BUILTIN_SHAPE_X_XX:  return rval_evaluator_alloc_from_x_xx_func(pb, parg1, parg2);
+	case BUILTIN_SHAPE_F_FF:  return rval_evaluator_alloc_from_f_ff_func(pb, parg1, parg2);
+	case BUILTIN_SHAPE_I_II:  return rval_evaluator_alloc_from_i_ii_func(pb, parg1, parg2);
+	case BUILTIN_SHAPE_S_XS:  return rval_evaluator_alloc_from_s_xs_func(pb, parg1, parg2);
+	case BUILTIN_SHAPE_X_NS:  return rval_evaluator_alloc_from_x_ns_func(pb, parg1, parg2);
+	case BUILTIN_SHAPE_X_SS:  return rval_evaluator_alloc_from_x_ss_func(pb, parg1, parg2);
+	case BUILTIN_SHAPE_F_FFF: return rval_evaluator_alloc_from_f_fff_func(pt, parg1, parg2, parg3);
+	case BUILTIN_SHAPE_I_III: return rval_evaluator_alloc_from_i_iii_func(pt, parg1, parg2, parg3);
+	case BUILTIN_SHAPE_S_SII: return rval_evaluator_alloc_from_s_sii_func(pt, parg1, parg2, parg3);
+	default:
+		MLR_INTERNAL_CODING_ERROR();
+		return NULL; // not reached
+	}
+}
+
 // ================================================================
 static rval_evaluator_t* fmgr_alloc_evaluator_from_zary_func_name(char* function_name) {
-	if        (streq(function_name, "urand")) {
-		return rval_evaluator_alloc_from_x_z_func(f_z_urand_func);
-	} else if (streq(function_name, "urand32")) {
-		return rval_evaluator_alloc_from_x_z_func(i_z_urand32_func);
-	} else if (streq(function_name, "systime")) {
-		return rval_evaluator_alloc_from_x_z_func(f_z_systime_func);
-	} else  {
+	scalar_builtin_t* pbuiltin = fmgr_look_up_scalar_builtin(function_name, 0);
+	if (pbuiltin == NULL)
 		return NULL;
-	}
+	return fmgr_alloc_evaluator_from_scalar_builtin(pbuiltin, NULL, NULL, NULL);
 }
 
 // ================================================================
 static rval_evaluator_t* fmgr_alloc_evaluator_from_unary_func_name(char* fnnm, rval_evaluator_t* parg1)  {
-	if        (streq(fnnm, "!"))               { return rval_evaluator_alloc_from_b_b_func(b_b_not_func,         parg1);
-	} else if (streq(fnnm, "+"))               { return rval_evaluator_alloc_from_x_x_func(x_x_upos_func,        parg1);
-	} else if (streq(fnnm, "-"))               { return rval_evaluator_alloc_from_x_x_func(x_x_uneg_func,        parg1);
-	} else if (streq(fnnm, "abs"))             { return rval_evaluator_alloc_from_x_x_func(x_x_abs_func,         parg1);
-	} else if (streq(fnnm, "acos"))            { return rval_evaluator_alloc_from_f_f_func(f_f_acos_func,        parg1);
-	} else if (streq(fnnm, "acosh"))           { return rval_evaluator_alloc_from_f_f_func(f_f_acosh_func,       parg1);
-	} else if (streq(fnnm, "asin"))            { return rval_evaluator_alloc_from_f_f_func(f_f_asin_func,        parg1);
-	} else if (streq(fnnm, "asinh"))           { return rval_evaluator_alloc_from_f_f_func(f_f_asinh_func,       parg1);
-
-	} else if (streq(fnnm, "atan"))            { return rval_evaluator_alloc_from_f_f_func(f_f_atan_func,        parg1);
-	} else if (streq(fnnm, "atanh"))           { return rval_evaluator_alloc_from_f_f_func(f_f_atanh_func,       parg1);
-	} else if (streq(fnnm, "boolean"))         { return rval_evaluator_alloc_from_x_x_func(b_x_boolean_func,     parg1);
-	} else if (streq(fnnm, "cbrt"))            { return rval_evaluator_alloc_from_f_f_func(f_f_cbrt_func,        parg1);
-	} else if (streq(fnnm, "ceil"))            { return rval_evaluator_alloc_from_x_x_func(x_x_ceil_func,        parg1);
-	} else if (streq(fnnm, "cos"))             { return rval_evaluator_alloc_from_f_f_func(f_f_cos_func,         parg1);
-	} else if (streq(fnnm, "cosh"))            { return rval_evaluator_alloc_from_f_f_func(f_f_cosh_func,        parg1);
-	} else if (streq(fnnm, "dhms2fsec"))       { return rval_evaluator_alloc_from_f_s_func(f_s_dhms2fsec_func,   parg1);
-	} else if (streq(fnnm, "dhms2sec"))        { return rval_evaluator_alloc_from_f_s_func(i_s_dhms2sec_func,    parg1);
-	} else if (streq(fnnm, "erf"))             { return rval_evaluator_alloc_from_f_f_func(f_f_erf_func,         parg1);
-	} else if (streq(fnnm, "erfc"))            { return rval_evaluator_alloc_from_f_f_func(f_f_erfc_func,        parg1);
-	} else if (streq(fnnm, "exp"))             { return rval_evaluator_alloc_from_f_f_func(f_f_exp_func,         parg1);
-	} else if (streq(fnnm, "expm1"))           { return rval_evaluator_alloc_from_f_f_func(f_f_expm1_func,       parg1);
-	} else if (streq(fnnm, "float"))           { return rval_evaluator_alloc_from_x_x_func(f_x_float_func,       parg1);
-	} else if (streq(fnnm, "floor"))           { return rval_evaluator_alloc_from_x_x_func(x_x_floor_func,       parg1);
-	} else if (streq(fnnm, "fsec2dhms"))       { return rval_evaluator_alloc_from_s_f_func(s_f_fsec2dhms_func,   parg1);
-	} else if (streq(fnnm, "fsec2hms"))        { return rval_evaluator_alloc_from_s_f_func(s_f_fsec2hms_func,    parg1);
-	} else if (streq(fnnm, "gmt2sec"))         { return rval_evaluator_alloc_from_i_s_func(i_s_gmt2sec_func,     parg1);
-	} else if (streq(fnnm, "hexfmt"))          { return rval_evaluator_alloc_from_x_x_func(s_x_hexfmt_func,      parg1);
-	} else if (streq(fnnm, "hms2fsec"))        { return rval_evaluator_alloc_from_f_s_func(f_s_hms2fsec_func,    parg1);
-	} else if (streq(fnnm, "hms2sec"))         { return rval_evaluator_alloc_from_f_s_func(i_s_hms2sec_func,     parg1);
-	} else if (streq(fnnm, "int"))             { return rval_evaluator_alloc_from_x_x_func(i_x_int_func,         parg1);
-	} else if (streq(fnnm, "invqnorm"))        { return rval_evaluator_alloc_from_f_f_func(f_f_invqnorm_func,    parg1);
-
-	} else if (streq(fnnm, "log"))             { return rval_evaluator_alloc_from_f_f_func(f_f_log_func,         parg1);
-	} else if (streq(fnnm, "log10"))           { return rval_evaluator_alloc_from_f_f_func(f_f_log10_func,       parg1);
-	} else if (streq(fnnm, "log1p"))           { return rval_evaluator_alloc_from_f_f_func(f_f_log1p_func,       parg1);
-	} else if (streq(fnnm, "qnorm"))           { return rval_evaluator_alloc_from_f_f_func(f_f_qnorm_func,       parg1);
-	} else if (streq(fnnm, "round"))           { return rval_evaluator_alloc_from_x_x_func(x_x_round_func,       parg1);
-	} else if (streq(fnnm, "sec2dhms"))        { return rval_evaluator_alloc_from_s_i_func(s_i_sec2dhms_func,    parg1);
-	} else if (streq(fnnm, "sec2gmt"))         { return rval_evaluator_alloc_from_x_x_func(s_x_sec2gmt_func,     parg1);
-	} else if (streq(fnnm, "sec2gmtdate"))     { return rval_evaluator_alloc_from_x_x_func(s_x_sec2gmtdate_func, parg1);
-	} else if (streq(fnnm, "sec2hms"))         { return rval_evaluator_alloc_from_s_i_func(s_i_sec2hms_func,     parg1);
-	} else if (streq(fnnm, "sgn"))             { return rval_evaluator_alloc_from_x_x_func(x_x_sgn_func,         parg1);
-	} else if (streq(fnnm, "sin"))             { return rval_evaluator_alloc_from_f_f_func(f_f_sin_func,         parg1);
-	} else if (streq(fnnm, "sinh"))            { return rval_evaluator_alloc_from_f_f_func(f_f_sinh_func,        parg1);
-	} else if (streq(fnnm, "sqrt"))            { return rval_evaluator_alloc_from_f_f_func(f_f_sqrt_func,        parg1);
-	} else if (streq(fnnm, "string"))          { return rval_evaluator_alloc_from_x_x_func(s_x_string_func,      parg1);
-	} else if (streq(fnnm, "strlen"))          { return rval_evaluator_alloc_from_i_s_func(i_s_strlen_func,      parg1);
-	} else if (streq(fnnm, "tan"))             { return rval_evaluator_alloc_from_f_f_func(f_f_tan_func,         parg1);
-	} else if (streq(fnnm, "tanh"))            { return rval_evaluator_alloc_from_f_f_func(f_f_tanh_func,        parg1);
-	} else if (streq(fnnm, "tolower"))         { return rval_evaluator_alloc_from_s_s_func(s_s_tolower_func,     parg1);
-	} else if (streq(fnnm, "toupper"))         { return rval_evaluator_alloc_from_s_s_func(s_s_toupper_func,     parg1);
-	} else if (streq(fnnm, "~"))               { return rval_evaluator_alloc_from_i_i_func(i_i_bitwise_not_func, parg1);
-
-	} else return NULL;
+	scalar_builtin_t* pbuiltin = fmgr_look_up_scalar_builtin(fnnm, 1);
+	if (pbuiltin == NULL)
+		return NULL;
+	return fmgr_alloc_evaluator_from_scalar_builtin(pbuiltin, parg1, NULL, NULL);
 }
 
 // ================================================================
@@ -1116,33 +1244,12 @@ static rval_evaluator_t* fmgr_alloc_evaluator_from_binary_func_name(char* fnnm,
 	} else if (streq(fnnm, "=~"))   { return rval_evaluator_alloc_from_x_ssc_func(
 		matches_no_precomp_func, parg1, parg2);
 	} else if (streq(fnnm, "!=~"))  { return rval_evaluator_alloc_from_x_ssc_func(does_not_match_no_precomp_func, parg1, parg2);
-	} else if (streq(fnnm, "=="))   { return rval_evaluator_alloc_from_x_xx_func(eq_op_func,             parg1, parg2);
-	} else if (streq(fnnm, "!="))   { return rval_evaluator_alloc_from_x_xx_func(ne_op_func,             parg1, parg2);
-	} else if (streq(fnnm, ">"))    { return rval_evaluator_alloc_from_x_xx_func(gt_op_func,             parg1, parg2);
-	} else if (streq(fnnm, ">="))   { return rval_evaluator_alloc_from_x_xx_func(ge_op_func,             parg1, parg2);
-	} else if (streq(fnnm, "<"))    { return rval_evaluator_alloc_from_x_xx_func(lt_op_func,             parg1, parg2);
-	} else if (streq(fnnm, "<="))   { return rval_evaluator_alloc_from_x_xx_func(le_op_func,             parg1, parg2);
-	} else if (streq(fnnm, "."))    { return rval_evaluator_alloc_from_x_xx_func(s_xx_dot_func,          parg1, parg2);
-	} else if (streq(fnnm, "+"))    { return rval_evaluator_alloc_from_x_xx_func(x_xx_plus_func,         parg1, parg2);
-	} else if (streq(fnnm, "-"))    { return rval_evaluator_alloc_from_x_xx_func(x_xx_minus_func,        parg1, parg2);
-	} else if (streq(fnnm, "*"))    { return rval_evaluator_alloc_from_x_xx_func(x_xx_times_func,        parg1, parg2);
-	} else if (streq(fnnm, "/"))    { return rval_evaluator_alloc_from_x_xx_func(x_xx_divide_func,       parg1, parg2);
-	} else if (streq(fnnm, "//"))   { return rval_evaluator_alloc_from_x_xx_func(x_xx_int_divide_func,   parg1, parg2);
-	} else if (streq(fnnm, "%"))    { return rval_evaluator_alloc_from_x_xx_func(x_xx_mod_func,          parg1, parg2);
-	} else if (streq(fnnm, "**"))   { return rval_evaluator_alloc_from_f_ff_func(f_ff_pow_func,          parg1, parg2);
-	} else if (streq(fnnm, "pow"))  { return rval_evaluator_alloc_from_f_ff_func(f_ff_pow_func,          parg1, parg2);
-	} else if (streq(fnnm, "atan2")){ return rval_evaluator_alloc_from_f_ff_func(f_ff_atan2_func,        parg1, parg2);
-	} else if (streq(fnnm, "roundm")) { return rval_evaluator_alloc_from_x_xx_func(x_xx_roundm_func,     parg1, parg2);
-	} else if (streq(fnnm, "fmtnum")) { return rval_evaluator_alloc_from_s_xs_func(s_xs_fmtnum_func,     parg1, parg2);
-	} else if (streq(fnnm, "urandint")) { return rval_evaluator_alloc_from_i_ii_func(i_ii_urandint_func, parg1, parg2);
-	} else if (streq(fnnm, "&"))    { return rval_evaluator_alloc_from_x_xx_func(x_xx_band_func,         parg1, parg2);
-	} else if (streq(fnnm, "|"))    { return rval_evaluator_alloc_from_x_xx_func(x_xx_bor_func,          parg1, parg2);
-	} else if (streq(fnnm, "^"))    { return rval_evaluator_alloc_from_x_xx_func(x_xx_bxor_func,         parg1, parg2);
-	} else if (streq(fnnm, "<<"))   { return rval_evaluator_alloc_from_i_ii_func(i_ii_bitwise_lsh_func,  parg1, parg2);
-	} else if (streq(fnnm, ">>"))   { return rval_evaluator_alloc_from_i_ii_func(i_ii_bitwise_rsh_func,  parg1, parg2);
-	} else if (streq(fnnm, "strftime")) { return rval_evaluator_alloc_from_x_ns_func(s_ns_strftime_func, parg1, parg2);
-	} else if (streq(fnnm, "strptime")) { return rval_evaluator_alloc_from_x_ss_func(i_ss_strptime_func, parg1, parg2);
-	} else  { return NULL; }
+	}
+
+	scalar_builtin_t* pbuiltin = fmgr_look_up_scalar_builtin(fnnm, 2);
+	if (pbuiltin == NULL)
+		return NULL;
+	return fmgr_alloc_evaluator_from_scalar_builtin(pbuiltin, parg1, parg2, NULL);
 }
 
 static rval_evaluator_t* fmgr_alloc_evaluator_from_binary_regex_arg2_func_name(char* fnnm,
@@ -1163,21 +1270,14 @@ static rval_evaluator_t* fmgr_alloc_evaluator_from_ternary_func_name(char* fnnm,
 		return rval_evaluator_alloc_from_s_sss_func(sub_no_precomp_func,  parg1, parg2, parg3);
 	} else if (streq(fnnm, "gsub")) {
 		return rval_evaluator_alloc_from_s_sss_func(gsub_no_precomp_func, parg1, parg2, parg3);
-	} else if (streq(fnnm, "logifit")) {
-		return rval_evaluator_alloc_from_f_fff_func(f_fff_logifit_func,   parg1, parg2, parg3);
-	} else if (streq(fnnm, "madd")) {
-		return rval_evaluator_alloc_from_i_iii_func(i_iii_modadd_func,    parg1, parg2, parg3);
-	} else if (streq(fnnm, "msub")) {
-		return rval_evaluator_alloc_from_i_iii_func(i_iii_modsub_func,    parg1, parg2, parg3);
-	} else if (streq(fnnm, "mmul")) {
-		return rval_evaluator_alloc_from_i_iii_func(i_iii_modmul_func,    parg1, parg2, parg3);
-	} else if (streq(fnnm, "mexp")) {
-		return rval_evaluator_alloc_from_i_iii_func(i_iii_modexp_func,    parg1, parg2, parg3);
-	} else if (streq(fnnm, "substr")) {
-		return rval_evaluator_alloc_from_s_sii_func(s_sii_substr_func,    parg1, parg2, parg3);
 	} else if (streq(fnnm, "? :")) {
 		return rval_evaluator_alloc_from_ternop(parg1, parg2, parg3);
-	} else  { return NULL; }
+	}
+
+	scalar_builtin_t* pbuiltin = fmgr_look_up_scalar_builtin(fnnm, 3);
+	if (pbuiltin == NULL)
+		return NULL;
+	return fmgr_alloc_evaluator_from_scalar_builtin(pbuiltin, parg1, parg2, parg3);
 }
 
 static rval_evaluator_t* fmgr_alloc_evaluator_from_ternary_regex_arg2_func_name(char* fnnm,
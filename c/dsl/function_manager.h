@@ -5,10 +5,12 @@
 #include "containers/mlrval.h"
 #include "containers/lhmsv.h"
 #include "containers/hss.h"
+#include "containers/mvfuncs.h"
 #include "dsl/mlr_dsl_ast.h"
 #include "dsl/rval_evaluator.h"
 #include "dsl/rxval_evaluator.h"
 #include "dsl/type_inference.h"
+#include "dsl/srec_field_cache.h"
 
 // ----------------------------------------------------------------
 // Things a user-defined function (however it is implemented) needs in order to
@@ -38,8 +40,62 @@ typedef struct _fmgr_t {
 	// has been defined).
 	sllv_t* pfunc_callsite_evaluators_to_resolve;  // return value in scalar context
 	sllv_t* pfunc_callsite_xevaluators_to_resolve; // return value in map context
+	// Whether rval_evaluator_alloc_from_ast compiles expressions to bytecode (see
+	// rval_bytecode_evaluators.c) rather than building a tree of evaluators.
+	int compile_to_bytecode;
+	// Evaluators for subexpressions which constant folding made unreachable. They're built anyway,
+	// for the sake of the checks made while building, and are kept until the function manager is
+	// freed since unresolved callsites within them are on the lists above.
+	sllv_t* pfolded_evaluators;
+	// Slots for the $-fields named in expressions and assignments: see srec_field_cache.h.
+	srec_field_cache_t* pfield_cache;
 } fmgr_t;
 
+// ----------------------------------------------------------------
+// Built-in functions of fixed arity from scalars to scalar, e.g. "+" or "strlen". The shape says
+// how arguments are checked and coerced before the function is called, following the naming
+// convention in containers/mlrval.h: e.g. for f_ff both arguments are made floats. The evaluators
+// in rval_func_evaluators.c and the bytecode in rval_bytecode_evaluators.c both dispatch on it.
+//
+// Not included are those needing more at the callsite: "&&", "||", "^^" and "? :" which
+// short-circuit, variadic min and max, and the regex functions "=~", "!=~", sub, and gsub.
+
+typedef enum _builtin_shape_t {
+	BUILTIN_SHAPE_X_Z,
+	BUILTIN_SHAPE_X_X,
+	BUILTIN_SHAPE_B_B,
+	BUILTIN_SHAPE_F_F,
+	BUILTIN_SHAPE_I_I,
+	BUILTIN_SHAPE_F_S,
+	BUILTIN_SHAPE_I_S,
+	BUILTIN_SHAPE_S_F,
+	BUILTIN_SHAPE_S_I,
+	BUILTIN_SHAPE_S_S,
+	BUILTIN_SHAPE_X_XX,
+	BUILTIN_SHAPE_F_FF,
+	BUILTIN_SHAPE_I_II,
+	BUILTIN_SHAPE_S_XS,
+	BUILTIN_SHAPE_X_NS,
+	BUILTIN_SHAPE_X_SS,
+	BUILTIN_SHAPE_F_FFF,
+	BUILTIN_SHAPE_I_III,
+	BUILTIN_SHAPE_S_SII,
+} builtin_shape_t;
+
+typedef struct _scalar_builtin_t {
+	char*              name;
+	int                arity;
+	builtin_shape_t    shape;
+	// Exactly one of these is set, according to arity.
+	mv_zary_func_t*    pzary_func;
+	mv_unary_func_t*   punary_func;
+	mv_binary_func_t*  pbinary_func;
+	mv_ternary_func_t* pternary_func;
+	// Set for functions whose values aren't determined by their arguments, or which may exit or trap
+	// on bad input. Calls to others with constant arguments are evaluated once, as the CST is built.
+	int                impure;
+} scalar_builtin_t;
+
 // ----------------------------------------------------------------
 fmgr_t* fmgr_alloc();
 
@@ -54,6 +110,16 @@ rval_evaluator_t* fmgr_alloc_provisional_from_operator_or_function_call(fmgr_t*
 rxval_evaluator_t* fmgr_xalloc_provisional_from_operator_or_function_call(fmgr_t* pfmgr, mlr_dsl_ast_node_t* pnode,
 	int type_inferencing, int context_flags);
 
+// Returns NULL if there is no such function of that arity in the table described above.
+scalar_builtin_t* fmgr_look_up_scalar_builtin(char* function_name, int arity);
+
+// For constant folding: whether the operator or function is built in and its value depends only
+// on its arguments. The second function builds the evaluator for a call to one at once, rather
+// than leaving it to fmgr_resolve_func_callsites, so that it can be evaluated straight away.
+int fmgr_is_foldable_builtin(char* function_name, int arity);
+rval_evaluator_t* fmgr_alloc_foldable_from_operator_or_function_call(fmgr_t* pfmgr, mlr_dsl_ast_node_t* pnode,
+	int type_inferencing, int context_flags);
+
 void fmgr_mark_callsite_to_resolve(fmgr_t* pfmgr, rval_evaluator_t* pev);
 void fmgr_mark_xcallsite_to_resolve(fmgr_t* pfmgr, rxval_evaluator_t* pxev);
 // Update all function callsites to point to UDF bodies, once all the latter have been defined.
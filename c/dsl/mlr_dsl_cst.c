@@ -56,7 +56,7 @@ static void mlr_dsl_cst_resolve_subr_callsites(mlr_dsl_cst_t* pcst);
 //                 text="6", type=numeric_literal.
 
 mlr_dsl_cst_t* mlr_dsl_cst_alloc(mlr_dsl_ast_t* past, int print_ast, int trace_stack_allocation,
-	int type_inferencing, int flush_every_record,
+	int type_inferencing, int compile_to_bytecode, int flush_every_record,
 	int do_final_filter, int negate_final_filter) // for mlr filter
 {
 	int context_flags = do_final_filter ? IN_MLR_FILTER : 0;
@@ -78,6 +78,7 @@ mlr_dsl_cst_t* mlr_dsl_cst_alloc(mlr_dsl_ast_t* past, int print_ast, int trace_s
 	blocked_ast_allocate_locals(pcst->paast, trace_stack_allocation);
 
 	pcst->pfmgr          = fmgr_alloc();
+	pcst->pfmgr->compile_to_bytecode = compile_to_bytecode;
 	pcst->psubr_defsites = lhmsv_alloc();
 	pcst->psubr_callsite_statements_to_resolve = sllv_alloc();
 	pcst->flush_every_record = flush_every_record;
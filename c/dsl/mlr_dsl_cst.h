@@ -202,10 +202,12 @@ typedef struct _mlr_dsl_cst_t {
 // Notes:
 // * do_final_filter is FALSE for mlr put, TRUE for mlr filter.
 // * negate_final_filter is TRUE for mlr filter -x.
+// * compile_to_bytecode is TRUE for mlr put/filter --bytecode: see rval_bytecode_evaluators.c.
 // * The CST object strips nodes off the raw AST, constructed by the Lemon parser, in order
 //   to do analysis on it. Nonetheless the caller should free what's left.
 mlr_dsl_cst_t* mlr_dsl_cst_alloc(mlr_dsl_ast_t* past, int print_ast, int trace_stack_allocation,
-	int type_inferencing, int flush_every_record, int do_final_filter, int negate_final_filter);
+	int type_inferencing, int compile_to_bytecode, int flush_every_record, int do_final_filter,
+	int negate_final_filter);
 
 mlr_dsl_cst_statement_t* mlr_dsl_cst_alloc_statement(mlr_dsl_cst_t* pcst, mlr_dsl_ast_node_t* pnode,
 	int type_inferencing, int context_flags);
@@ -4,6 +4,40 @@
 #include "mlr_dsl_cst.h"
 #include "context_flags.h"
 
+// ================================================================
+// Dead-branch elimination: conditions which are constant (see rval_expr_evaluators.c) are checked
+// as the CST is built, and blocks which will never run are skipped. They're still built, for the
+// sake of the checks made while doing so.
+
+static mlr_dsl_cst_statement_handler_t handle_never_run;
+
+// Returns TRUE if the condition is constant, with *pholds set to whether it holds. A null condition
+// doesn't; a non-boolean one is left to be reported at run time.
+static int condition_is_constant(mlr_dsl_cst_t* pcst, mlr_dsl_ast_node_t* pnode,
+	int type_inferencing, int context_flags, int* pholds)
+{
+	mv_t val;
+	if (!rval_evaluator_try_fold(pnode, pcst->pfmgr, type_inferencing, context_flags, &val))
+		return FALSE;
+
+	int is_constant = TRUE;
+	if (val.type == MT_BOOLEAN)
+		*pholds = val.u.boolv;
+	else if (mv_is_null(&val))
+		*pholds = FALSE;
+	else
+		is_constant = FALSE;
+	mv_free(&val);
+	return is_constant;
+}
+
+static void handle_never_run(
+	mlr_dsl_cst_statement_t* pstatement,
+	variables_t*             pvars,
+	cst_outputs_t*           pcst_outputs)
+{
+}
+
 // ================================================================
 typedef struct _conditional_block_state_t {
 	rval_evaluator_t* pexpression_evaluator;
@@ -41,9 +75,12 @@ mlr_dsl_cst_statement_t* alloc_conditional_block(mlr_dsl_cst_t* pcst, mlr_dsl_as
 		? mlr_dsl_cst_handle_statement_block_with_break_continue
 		: mlr_dsl_cst_handle_statement_block;
 
+	int holds = TRUE;
+	int is_constant = condition_is_constant(pcst, pleft, type_inferencing, context_flags, &holds);
+
 	return mlr_dsl_cst_statement_valloc_with_block(
 		pnode,
-		handle_conditional_block,
+		(is_constant && !holds) ? handle_never_run : handle_conditional_block,
 		pblock,
 		pblock_handler,
 		free_conditional_block,
@@ -86,6 +123,9 @@ static void handle_conditional_block(
 // ================================================================
 typedef struct _if_head_state_t {
 	sllv_t* pif_chain_statements;
+	// Items after one whose condition is constantly true, or whose own condition is constantly
+	// false. These are kept only to be freed.
+	sllv_t* ppruned_statements;
 } if_head_state_t;
 
 typedef struct _if_item_state_t {
@@ -157,6 +197,8 @@ mlr_dsl_cst_statement_t* alloc_if_head(mlr_dsl_cst_t* pcst, mlr_dsl_ast_node_t*
 	if_head_state_t* pstate = mlr_malloc_or_die(sizeof(if_head_state_t));
 
 	pstate->pif_chain_statements = sllv_alloc();
+	pstate->ppruned_statements = sllv_alloc();
+	int always_taken = FALSE;
 
 	for (sllve_t* pe = pnode->pchildren->phead; pe != NULL; pe = pe->pnext) {
 		// For if and elif:
@@ -175,9 +217,19 @@ mlr_dsl_cst_statement_t* alloc_if_head(mlr_dsl_cst_t* pcst, mlr_dsl_ast_node_t*
 			plistnode = pitemnode->pchildren->phead->pvvalue;
 		}
 
-		sllv_append(pstate->pif_chain_statements,
-			alloc_if_item(pcst, pitemnode, pexprnode, plistnode, type_inferencing, context_flags)
-		);
+		mlr_dsl_cst_statement_t* pitem_statement = alloc_if_item(pcst, pitemnode, pexprnode, plistnode,
+			type_inferencing, context_flags);
+
+		int holds = TRUE;
+		int is_constant = (pexprnode == NULL)
+			|| condition_is_constant(pcst, pexprnode, type_inferencing, context_flags, &holds);
+		if (always_taken || (is_constant && !holds)) {
+			sllv_append(pstate->ppruned_statements, pitem_statement);
+		} else {
+			sllv_append(pstate->pif_chain_statements, pitem_statement);
+			if (is_constant)
+				always_taken = TRUE;
+		}
 	}
 
 	mlr_dsl_cst_block_handler_t* pblock_handler = (context_flags & IN_BREAKABLE)
@@ -232,6 +284,9 @@ static void free_if_head(mlr_dsl_cst_statement_t* pstatement, context_t* pctx) {
 			mlr_dsl_cst_statement_free(pe->pvvalue, pctx);
 		sllv_free(pstate->pif_chain_statements);
 	}
+	for (sllve_t* pe = pstate->ppruned_statements->phead; pe != NULL; pe = pe->pnext)
+		mlr_dsl_cst_statement_free(pe->pvvalue, pctx);
+	sllv_free(pstate->ppruned_statements);
 
 	free(pstate);
 }
@@ -307,9 +362,12 @@ mlr_dsl_cst_statement_t* alloc_while(mlr_dsl_cst_t* pcst, mlr_dsl_ast_node_t* pn
 	pstate->pexpression_evaluator = rval_evaluator_alloc_from_ast(
 		pleft, pcst->pfmgr, type_inferencing, context_flags);
 
+	int holds = TRUE;
+	int is_constant = condition_is_constant(pcst, pleft, type_inferencing, context_flags, &holds);
+
 	return mlr_dsl_cst_statement_valloc_with_block(
 		pnode,
-		handle_while,
+		(is_constant && !holds) ? handle_never_run : handle_while,
 		pblock,
 		mlr_dsl_cst_handle_statement_block_with_break_continue,
 		free_while,
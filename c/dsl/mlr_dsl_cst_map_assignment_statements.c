@@ -117,6 +117,8 @@ static void handle_full_srec_assignment(
 	lhmsmv_free(pvars->ptyped_overlay);
 	pvars->pinrec = poutrec;
 	pvars->ptyped_overlay = pout_typed_overlay;
+	if (pvars->pfield_cache != NULL)
+		srec_field_cache_invalidate(pvars->pfield_cache);
 }
 
 // ================================================================
@@ -7,6 +7,7 @@
 // ================================================================
 typedef struct _srec_assignment_state_t {
 	char*             srec_lhs_field_name;
+	int               lhs_slot_index; // In the function manager's field cache
 	rval_evaluator_t* prhs_evaluator;
 } srec_assignment_state_t;
 
@@ -30,6 +31,7 @@ mlr_dsl_cst_statement_t* alloc_srec_assignment(mlr_dsl_cst_t* pcst, mlr_dsl_ast_
 	MLR_INTERNAL_CODING_ERROR_IF(plhs_node->pchildren != NULL);
 
 	pstate->srec_lhs_field_name = plhs_node->text;
+	pstate->lhs_slot_index = srec_field_cache_slot_for_name(pcst->pfmgr->pfield_cache, plhs_node->text);
 	pstate->prhs_evaluator = rval_evaluator_alloc_from_ast(prhs_node, pcst->pfmgr, type_inferencing, context_flags);
 
 	return mlr_dsl_cst_statement_valloc(
@@ -72,9 +74,24 @@ static void handle_srec_assignment(
 	// values doubly owned by the typed overlay and the lrec would result in double frees, or awkward
 	// bookkeeping. However, the NR variable evaluator reads prec->field_count, so we need to put something
 	// here. And putting something statically allocated minimizes copying/freeing.
+	//
+	// If this field has been resolved for the current record and is already in both, the overlay
+	// entry is updated in place; the record entry already holds the placeholder.
 	if (mv_is_present(&val)) {
-		lhmsmv_put(pvars->ptyped_overlay, srec_lhs_field_name, &val, FREE_ENTRY_VALUE);
-		lrec_put(pvars->pinrec, srec_lhs_field_name, "bug", NO_FREE);
+		srec_field_slot_t* pslot = (pvars->pfield_cache == NULL) ? NULL
+			: srec_field_cache_peek(pvars->pfield_cache, pstate->lhs_slot_index, pvars->ptyped_overlay);
+		if (pslot != NULL && pslot->poverlay_entry != NULL && pslot->prec_entry != NULL) {
+			lhmsmve_t* pe = pslot->poverlay_entry;
+			if (pe->free_flags & FREE_ENTRY_VALUE)
+				mv_free(&pe->value);
+			pe->value = val;
+			pe->free_flags |= FREE_ENTRY_VALUE;
+		} else {
+			lhmsmv_put(pvars->ptyped_overlay, srec_lhs_field_name, &val, FREE_ENTRY_VALUE);
+			lrec_put(pvars->pinrec, srec_lhs_field_name, "bug", NO_FREE);
+			if (pslot != NULL)
+				srec_field_cache_invalidate_slot(pslot);
+		}
 	} else {
 		mv_free(&val);
 	}
@@ -154,6 +171,9 @@ static void handle_indirect_srec_assignment(
 		lhmsmv_put(pvars->ptyped_overlay, mlr_strdup_or_die(srec_lhs_field_name), &rval,
 			FREE_ENTRY_KEY|FREE_ENTRY_VALUE);
 		lrec_put(pvars->pinrec, mlr_strdup_or_die(srec_lhs_field_name), "bug", FREE_ENTRY_KEY | FREE_ENTRY_KEY);
+		// The field may have a slot under its name, resolved without the overlay entry.
+		if (pvars->pfield_cache != NULL)
+			srec_field_cache_invalidate(pvars->pfield_cache);
 	} else {
 		mv_free(&rval);
 	}
@@ -223,7 +243,8 @@ static void handle_env_assignment(
 	mv_t rval = prhs_evaluator->pprocess_func(prhs_evaluator->pvstate, pvars);
 
 	if (mv_is_present(&lval) && mv_is_present(&rval)) {
-		setenv(mlr_strdup_or_die(mv_alloc_format_val(&lval)), mlr_strdup_or_die(mv_alloc_format_val(&rval)), 1);
+		rval_evaluator_set_environment(mlr_strdup_or_die(mv_alloc_format_val(&lval)),
+			mlr_strdup_or_die(mv_alloc_format_val(&rval)));
 	}
 	mv_free(&lval);
 	mv_free(&rval);
@@ -261,6 +261,8 @@ static void handle_unset_full_srec(
 	cst_outputs_t* pcst_outputs)
 {
 	lrec_clear(pvars->pinrec);
+	if (pvars->pfield_cache != NULL)
+		srec_field_cache_invalidate(pvars->pfield_cache);
 }
 
 static void handle_unset_srec_field_name(
@@ -269,6 +271,8 @@ static void handle_unset_srec_field_name(
 	cst_outputs_t* pcst_outputs)
 {
 	lrec_remove(pvars->pinrec, punset_item->srec_field_name);
+	if (pvars->pfield_cache != NULL)
+		srec_field_cache_invalidate(pvars->pfield_cache);
 }
 
 static void handle_unset_indirect_srec_field_name(
@@ -281,6 +285,8 @@ static void handle_unset_indirect_srec_field_name(
 	char free_flags = NO_FREE;
 	char* field_name = mv_maybe_alloc_format_val(&nameval, &free_flags);
 	lrec_remove(pvars->pinrec, field_name);
+	if (pvars->pfield_cache != NULL)
+		srec_field_cache_invalidate(pvars->pfield_cache);
 	if (free_flags & FREE_ENTRY_VALUE)
 		free(field_name);
 	mv_free(&nameval);
@@ -0,0 +1,792 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "lib/mlr_globals.h"
+#include "lib/mlrutil.h"
+#include "lib/mlrregex.h"
+#include "dsl/context_flags.h"
+#include "dsl/rval_evaluators.h"
+
+// ================================================================
+// Bytecode for scalar-valued expressions, selected by mlr put/filter --bytecode, as an alternative
+// to the trees of evaluators in rval_expr_evaluators.c and rval_func_evaluators.c. There, each
+// operator and operand is an evaluator called through a function pointer; here an expression is
+// compiled to a flat sequence of instructions which are run in a single loop. E.g. with -S off,
+//
+//   $z = $x * 2 + $y
+//
+// has for its right-hand side
+//
+//   0: field_sfi  r0 = $x
+//   1: literal    r1 = 2
+//   2: times      r0 = r0, r1
+//   3: field_sfi  r1 = $y
+//   4: plus       r0 = r0, r1
+//
+// The registers are mlrvals, so are typed as mlrvals are. Each operand of an operator or function
+// is computed into the register after the previous operand's, starting at the register the result
+// is to go in. Ownership of values follows the same rules as for values returned by evaluators
+// (see rval_evaluators.h): an instruction consumes the registers it reads from.
+//
+// A field read more than once in an expression is looked up and type-inferred only the first time
+// per evaluation: its value is kept in a cache register after the others, here r2 for $x in
+//
+//   $x * $x + 1
+//
+// and copied from there. This is safe since expressions can't assign to fields.
+//
+// The argument checks the evaluators in rval_func_evaluators.c make are separate guard
+// instructions after each argument. On a null or mistyped argument they set the result and jump
+// past the function call, just as the evaluators return without evaluating the remaining
+// arguments. Likewise "&&", "||", "^^", and "? :" short-circuit via jumps. Addition, subtraction,
+// multiplication, and comparisons of two ints or two floats are done inline; other types go to the
+// same functions the evaluators call.
+//
+// Constant subexpressions are folded just as for evaluators (see rval_expr_evaluators.c), into
+// literal instructions, and "? :" with a constant condition is compiled as the branch it takes.
+//
+// Everything else -- user-defined functions, functions on maps, regexes, oosvars, and so on -- is
+// an eval instruction holding the evaluator rval_evaluator_alloc_from_ast would otherwise return,
+// whose own subexpressions are in turn compiled where possible. So all expressions behave the same
+// either way, and only operators and scalar-valued built-in functions are compiled. Statements are
+// run as they are without --bytecode.
+// ================================================================
+
+typedef enum _bytecode_opcode_t {
+	BC_FIELD_S,           // dst = field, as string; src is the cache register, or -1 for none
+	BC_FIELD_SF,          // dst = field, as string or float
+	BC_FIELD_SFI,         // dst = field, as string, float, or int
+	BC_LITERAL,           // dst = literal
+	BC_STRING_LITERAL,    // dst = literal, with "\1" etc. replaced by regex captures
+	BC_LOCAL,             // dst = non-indexed local variable
+	BC_EVAL,              // dst = value of evaluator
+
+	BC_GUARD_BOOLEAN,     // checks src; on failure sets dst and jumps
+	BC_GUARD_FLOAT,
+	BC_GUARD_FLOAT_STRICT,
+	BC_GUARD_INT,
+	BC_GUARD_INT_STRICT,
+	BC_GUARD_NUMBER,
+	BC_GUARD_STRING,
+
+	BC_CALL_ZARY,         // dst = f()
+	BC_CALL_UNARY,        // dst = f(dst)
+	BC_CALL_BINARY,       // dst = f(dst, dst+1)
+	BC_CALL_TERNARY,      // dst = f(dst, dst+1, dst+2)
+	BC_PLUS,              // As BC_CALL_BINARY, with ints and floats inline
+	BC_MINUS,
+	BC_TIMES,
+	BC_EQ,
+	BC_NE,
+	BC_GT,
+	BC_GE,
+	BC_LT,
+	BC_LE,
+
+	BC_AND_LHS,           // Checks dst, jumping if the result is already known
+	BC_AND_RHS,           // dst = dst && dst+1
+	BC_OR_LHS,
+	BC_OR_RHS,
+	BC_XOR_LHS,
+	BC_XOR_RHS,
+	BC_TERNOP_TEST,       // Jumps to jump if dst is null, else to jump_if_false if dst is false
+	BC_JUMP,
+} bytecode_opcode_t;
+
+typedef struct _bytecode_instr_t {
+	bytecode_opcode_t opcode;
+	int dst;
+	int src;
+	int jump;
+	int jump_if_false;
+	union {
+		struct {
+			char*          name;
+			int            slot_index; // In the function manager's field cache
+		} field;
+		mv_t               literal;
+		int                local_index;
+		rval_evaluator_t*  pevaluator;
+		mv_zary_func_t*    pzary_func;
+		mv_unary_func_t*   punary_func;
+		mv_binary_func_t*  pbinary_func;
+		mv_ternary_func_t* pternary_func;
+	} u;
+} bytecode_instr_t;
+
+typedef struct _bytecode_program_t {
+	bytecode_instr_t* pinstrs;
+	int               ninstrs;
+	int               ninstrs_alloc;
+	int               nregs;
+
+	// Fields read, at compile time, with how many times each is read. Cache registers follow the
+	// nregs others.
+	char**            field_names;
+	int*              field_counts;
+	int               nfields;
+} bytecode_program_t;
+
+// Bits in a 64-bit mask record which cache registers are loaded; further fields aren't cached.
+#define BYTECODE_MAX_CACHED_FIELDS 64
+
+// Registers live on the C stack, rather than in the program, since a program can be re-entered via
+// recursive user-defined functions. Only unusually deeply nested expressions need more.
+#define BYTECODE_STACK_REGS 64
+
+static void bytecode_compile_node(bytecode_program_t* pprog, mlr_dsl_ast_node_t* pnode, int dst,
+	fmgr_t* pfmgr, int type_inferencing, int context_flags);
+static mv_t rval_evaluator_bytecode_func(void* pvstate, variables_t* pvars);
+static void bytecode_assign_cache_registers(bytecode_program_t* pprog);
+static void rval_evaluator_bytecode_free(rval_evaluator_t* pevaluator);
+
+// ----------------------------------------------------------------
+int rval_evaluator_can_compile_to_bytecode(mlr_dsl_ast_node_t* pnode) {
+	if (pnode->type != MD_AST_NODE_TYPE_OPERATOR && pnode->type != MD_AST_NODE_TYPE_FUNCTION_CALLSITE)
+		return FALSE;
+	char* name = pnode->text;
+	int arity = pnode->pchildren->length;
+	if (arity == 2 && (streq(name, "&&") || streq(name, "||") || streq(name, "^^")))
+		return TRUE;
+	if (arity == 3 && streq(name, "? :"))
+		return TRUE;
+	return fmgr_look_up_scalar_builtin(name, arity) != NULL;
+}
+
+rval_evaluator_t* rval_evaluator_alloc_bytecode_from_ast(mlr_dsl_ast_node_t* pnode, fmgr_t* pfmgr,
+	int type_inferencing, int context_flags)
+{
+	bytecode_program_t* pprog = mlr_malloc_or_die(sizeof(bytecode_program_t));
+	pprog->ninstrs_alloc = 16;
+	pprog->pinstrs = mlr_malloc_or_die(pprog->ninstrs_alloc * sizeof(bytecode_instr_t));
+	pprog->ninstrs = 0;
+	pprog->nregs = 1;
+	pprog->field_names = mlr_malloc_or_die(BYTECODE_MAX_CACHED_FIELDS * sizeof(char*));
+	pprog->field_counts = mlr_malloc_or_die(BYTECODE_MAX_CACHED_FIELDS * sizeof(int));
+	pprog->nfields = 0;
+
+	bytecode_compile_node(pprog, pnode, 0, pfmgr, type_inferencing, context_flags);
+	bytecode_assign_cache_registers(pprog);
+
+	rval_evaluator_t* pevaluator = mlr_malloc_or_die(sizeof(rval_evaluator_t));
+	pevaluator->pvstate = pprog;
+	pevaluator->pprocess_func = rval_evaluator_bytecode_func;
+	pevaluator->pfree_func = rval_evaluator_bytecode_free;
+
+	return pevaluator;
+}
+
+static void rval_evaluator_bytecode_free(rval_evaluator_t* pevaluator) {
+	bytecode_program_t* pprog = pevaluator->pvstate;
+	for (int i = 0; i < pprog->ninstrs; i++) {
+		bytecode_instr_t* pinstr = &pprog->pinstrs[i];
+		switch (pinstr->opcode) {
+		case BC_FIELD_S:
+		case BC_FIELD_SF:
+		case BC_FIELD_SFI:
+			free(pinstr->u.field.name);
+			break;
+		case BC_LITERAL:
+		case BC_STRING_LITERAL:
+			mv_free(&pinstr->u.literal);
+			break;
+		case BC_EVAL:
+			pinstr->u.pevaluator->pfree_func(pinstr->u.pevaluator);
+			break;
+		default:
+			break;
+		}
+	}
+	free(pprog->pinstrs);
+	free(pprog->field_names);
+	free(pprog->field_counts);
+	free(pprog);
+	free(pevaluator);
+}
+
+// ================================================================
+// COMPILER
+
+static bytecode_instr_t* bytecode_emit(bytecode_program_t* pprog, bytecode_opcode_t opcode, int dst) {
+	if (pprog->ninstrs >= pprog->ninstrs_alloc) {
+		pprog->ninstrs_alloc *= 2;
+		pprog->pinstrs = mlr_realloc_or_die(pprog->pinstrs, pprog->ninstrs_alloc * sizeof(bytecode_instr_t));
+	}
+	if (dst >= pprog->nregs)
+		pprog->nregs = dst + 1;
+	bytecode_instr_t* pinstr = &pprog->pinstrs[pprog->ninstrs++];
+	memset(pinstr, 0, sizeof(bytecode_instr_t));
+	pinstr->opcode = opcode;
+	pinstr->dst = dst;
+	pinstr->src = dst;
+	pinstr->jump = -1;
+	pinstr->jump_if_false = -1;
+	return pinstr;
+}
+
+// Instructions are addressed by index since the array may be reallocated as it grows.
+static void bytecode_patch_jump(bytecode_program_t* pprog, int instr_index) {
+	pprog->pinstrs[instr_index].jump = pprog->ninstrs;
+}
+
+// ----------------------------------------------------------------
+// Field loads are compiled with src set to the field's index in field_names, if any, and once the
+// whole program has been compiled (so nregs is known) those read more than once are pointed at
+// their cache registers.
+static int bytecode_field_index(bytecode_program_t* pprog, char* field_name) {
+	for (int i = 0; i < pprog->nfields; i++) {
+		if (streq(pprog->field_names[i], field_name)) {
+			pprog->field_counts[i]++;
+			return i;
+		}
+	}
+	if (pprog->nfields >= BYTECODE_MAX_CACHED_FIELDS)
+		return -1;
+	pprog->field_names[pprog->nfields] = field_name;
+	pprog->field_counts[pprog->nfields] = 1;
+	return pprog->nfields++;
+}
+
+static void bytecode_assign_cache_registers(bytecode_program_t* pprog) {
+	for (int i = 0; i < pprog->ninstrs; i++) {
+		bytecode_instr_t* pinstr = &pprog->pinstrs[i];
+		if (pinstr->opcode == BC_FIELD_S || pinstr->opcode == BC_FIELD_SF || pinstr->opcode == BC_FIELD_SFI) {
+			if (pinstr->src >= 0 && pprog->field_counts[pinstr->src] > 1)
+				pinstr->src += pprog->nregs;
+			else
+				pinstr->src = -1;
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+// As in rval_evaluator_alloc_from_numeric_literal.
+static void bytecode_compile_literal(bytecode_program_t* pprog, char* string, int dst, int type_inferencing) {
+	long long intv;
+	double fltv;
+	if (string == NULL) {
+		bytecode_emit(pprog, BC_LITERAL, dst)->u.literal = mv_absent();
+	} else if (type_inferencing == TYPE_INFER_STRING_FLOAT_INT && mlr_try_int_from_string(string, &intv)) {
+		bytecode_emit(pprog, BC_LITERAL, dst)->u.literal = mv_from_int(intv);
+	} else if (type_inferencing != TYPE_INFER_STRING_ONLY && mlr_try_float_from_string(string, &fltv)) {
+		bytecode_emit(pprog, BC_LITERAL, dst)->u.literal = mv_from_float(fltv);
+	} else {
+		bytecode_emit(pprog, BC_STRING_LITERAL, dst)->u.literal = mv_from_string_no_free(string);
+	}
+}
+
+// ----------------------------------------------------------------
+// The checks made on each argument by the evaluator for each shape in rval_func_evaluators.c, or -1
+// for none.
+static int bytecode_guard_for(builtin_shape_t shape, int argi) {
+	switch (shape) {
+	case BUILTIN_SHAPE_B_B:   return BC_GUARD_BOOLEAN;
+	case BUILTIN_SHAPE_F_F:   return BC_GUARD_FLOAT_STRICT;
+	case BUILTIN_SHAPE_I_I:   return BC_GUARD_INT;
+	case BUILTIN_SHAPE_F_S:   return BC_GUARD_STRING;
+	case BUILTIN_SHAPE_I_S:   return BC_GUARD_STRING;
+	case BUILTIN_SHAPE_S_F:   return BC_GUARD_FLOAT;
+	case BUILTIN_SHAPE_S_I:   return BC_GUARD_INT;
+	case BUILTIN_SHAPE_S_S:   return BC_GUARD_STRING;
+	case BUILTIN_SHAPE_F_FF:  return BC_GUARD_FLOAT;
+	case BUILTIN_SHAPE_I_II:  return BC_GUARD_INT_STRICT;
+	case BUILTIN_SHAPE_S_XS:  return (argi == 1) ? BC_GUARD_STRING : -1;
+	case BUILTIN_SHAPE_X_NS:  return (argi == 0) ? BC_GUARD_NUMBER : BC_GUARD_STRING;
+	case BUILTIN_SHAPE_X_SS:  return BC_GUARD_STRING;
+	case BUILTIN_SHAPE_F_FFF: return BC_GUARD_FLOAT;
+	case BUILTIN_SHAPE_I_III: return BC_GUARD_INT_STRICT;
+	case BUILTIN_SHAPE_S_SII: return (argi == 0) ? BC_GUARD_STRING : BC_GUARD_INT;
+	default:                  return -1;
+	}
+}
+
+static void bytecode_compile_builtin_call(bytecode_program_t* pprog, scalar_builtin_t* pbuiltin,
+	mlr_dsl_ast_node_t* pnode, int dst, fmgr_t* pfmgr, int type_inferencing, int context_flags)
+{
+	int guard_indices[3];
+	int nguards = 0;
+
+	int argi = 0;
+	for (sllve_t* pe = pnode->pchildren->phead; pe != NULL; pe = pe->pnext, argi++) {
+		bytecode_compile_node(pprog, pe->pvvalue, dst + argi, pfmgr, type_inferencing, context_flags);
+		int guard = bytecode_guard_for(pbuiltin->shape, argi);
+		if (guard >= 0) {
+			guard_indices[nguards++] = pprog->ninstrs;
+			bytecode_emit(pprog, guard, dst)->src = dst + argi;
+		}
+	}
+
+	bytecode_instr_t* pinstr = NULL;
+	switch (pbuiltin->arity) {
+	case 0:
+		pinstr = bytecode_emit(pprog, BC_CALL_ZARY, dst);
+		pinstr->u.pzary_func = pbuiltin->pzary_func;
+		break;
+	case 1:
+		pinstr = bytecode_emit(pprog, BC_CALL_UNARY, dst);
+		pinstr->u.punary_func = pbuiltin->punary_func;
+		break;
+	case 2: {
+		mv_binary_func_t* pfunc = pbuiltin->pbinary_func;
+		bytecode_opcode_t opcode = BC_CALL_BINARY;
+		if      (pfunc == x_xx_plus_func)  opcode = BC_PLUS;
+		else if (pfunc == x_xx_minus_func) opcode = BC_MINUS;
+		else if (pfunc == x_xx_times_func) opcode = BC_TIMES;
+		else if (pfunc == eq_op_func)      opcode = BC_EQ;
+		else if (pfunc == ne_op_func)      opcode = BC_NE;
+		else if (pfunc == gt_op_func)      opcode = BC_GT;
+		else if (pfunc == ge_op_func)      opcode = BC_GE;
+		else if (pfunc == lt_op_func)      opcode = BC_LT;
+		else if (pfunc == le_op_func)      opcode = BC_LE;
+		pinstr = bytecode_emit(pprog, opcode, dst);
+		pinstr->u.pbinary_func = pfunc;
+		break;
+	}
+	case 3:
+		pinstr = bytecode_emit(pprog, BC_CALL_TERNARY, dst);
+		pinstr->u.pternary_func = pbuiltin->pternary_func;
+		break;
+	default:
+		MLR_INTERNAL_CODING_ERROR();
+		break;
+	}
+
+	for (int i = 0; i < nguards; i++)
+		bytecode_patch_jump(pprog, guard_indices[i]);
+}
+
+// ----------------------------------------------------------------
+static void bytecode_compile_logical(bytecode_program_t* pprog, mlr_dsl_ast_node_t* pnode, int dst,
+	bytecode_opcode_t lhs_opcode, bytecode_opcode_t rhs_opcode,
+	fmgr_t* pfmgr, int type_inferencing, int context_flags)
+{
+	mlr_dsl_ast_node_t* plhs = pnode->pchildren->phead->pvvalue;
+	mlr_dsl_ast_node_t* prhs = pnode->pchildren->phead->pnext->pvvalue;
+
+	bytecode_compile_node(pprog, plhs, dst, pfmgr, type_inferencing, context_flags);
+	int lhs_index = pprog->ninstrs;
+	bytecode_emit(pprog, lhs_opcode, dst);
+	bytecode_compile_node(pprog, prhs, dst + 1, pfmgr, type_inferencing, context_flags);
+	bytecode_emit(pprog, rhs_opcode, dst);
+	bytecode_patch_jump(pprog, lhs_index);
+}
+
+static void bytecode_compile_ternop(bytecode_program_t* pprog, mlr_dsl_ast_node_t* pnode, int dst,
+	fmgr_t* pfmgr, int type_inferencing, int context_flags)
+{
+	mlr_dsl_ast_node_t* pcond = pnode->pchildren->phead->pvvalue;
+	mlr_dsl_ast_node_t* pthen = pnode->pchildren->phead->pnext->pvvalue;
+	mlr_dsl_ast_node_t* pelse = pnode->pchildren->phead->pnext->pnext->pvvalue;
+
+	mv_t cond;
+	if (rval_evaluator_try_fold(pcond, pfmgr, type_inferencing, context_flags, &cond)) {
+		if (cond.type == MT_BOOLEAN) {
+			sllv_append(pfmgr->pfolded_evaluators, rval_evaluator_alloc_from_ast(cond.u.boolv ? pelse : pthen,
+				pfmgr, type_inferencing, context_flags));
+			bytecode_compile_node(pprog, cond.u.boolv ? pthen : pelse, dst, pfmgr, type_inferencing, context_flags);
+			return;
+		}
+		mv_free(&cond);
+	}
+
+	bytecode_compile_node(pprog, pcond, dst, pfmgr, type_inferencing, context_flags);
+	int test_index = pprog->ninstrs;
+	bytecode_emit(pprog, BC_TERNOP_TEST, dst);
+	bytecode_compile_node(pprog, pthen, dst, pfmgr, type_inferencing, context_flags);
+	int jump_index = pprog->ninstrs;
+	bytecode_emit(pprog, BC_JUMP, dst);
+	pprog->pinstrs[test_index].jump_if_false = pprog->ninstrs;
+	bytecode_compile_node(pprog, pelse, dst, pfmgr, type_inferencing, context_flags);
+	bytecode_patch_jump(pprog, test_index);
+	bytecode_patch_jump(pprog, jump_index);
+}
+
+// ----------------------------------------------------------------
+static void bytecode_compile_node(bytecode_program_t* pprog, mlr_dsl_ast_node_t* pnode, int dst,
+	fmgr_t* pfmgr, int type_inferencing, int context_flags)
+{
+	bytecode_instr_t* pinstr = NULL;
+
+	if (pnode->pchildren == NULL) {
+		switch (pnode->type) {
+
+		case MD_AST_NODE_TYPE_FIELD_NAME:
+			if (context_flags & IN_BEGIN_OR_END) {
+				fprintf(stderr, "%s: statements involving $-variables are not valid within begin or end blocks.\n",
+					MLR_GLOBALS.bargv0);
+				exit(1);
+			}
+			pinstr = bytecode_emit(pprog,
+				(type_inferencing == TYPE_INFER_STRING_ONLY) ? BC_FIELD_S :
+				(type_inferencing == TYPE_INFER_STRING_FLOAT) ? BC_FIELD_SF :
+				BC_FIELD_SFI, dst);
+			pinstr->u.field.name = mlr_strdup_or_die(pnode->text);
+			pinstr->u.field.slot_index = srec_field_cache_slot_for_name(pfmgr->pfield_cache, pnode->text);
+			pinstr->src = bytecode_field_index(pprog, pinstr->u.field.name);
+			return;
+
+		case MD_AST_NODE_TYPE_STRING_LITERAL:
+			bytecode_compile_literal(pprog, pnode->text, dst, TYPE_INFER_STRING_ONLY);
+			return;
+
+		case MD_AST_NODE_TYPE_NUMERIC_LITERAL:
+		case MD_AST_NODE_TYPE_REGEXI:
+			bytecode_compile_literal(pprog, pnode->text, dst, type_inferencing);
+			return;
+
+		case MD_AST_NODE_TYPE_BOOLEAN_LITERAL:
+			pinstr = bytecode_emit(pprog, BC_LITERAL, dst);
+			if (streq(pnode->text, "true")) {
+				pinstr->u.literal = mv_from_true();
+			} else if (streq(pnode->text, "false")) {
+				pinstr->u.literal = mv_from_false();
+			} else {
+				MLR_INTERNAL_CODING_ERROR();
+			}
+			return;
+
+		case MD_AST_NODE_TYPE_NONINDEXED_LOCAL_VARIABLE:
+			MLR_INTERNAL_CODING_ERROR_IF(pnode->vardef_frame_relative_index == MD_UNUSED_INDEX);
+			bytecode_emit(pprog, BC_LOCAL, dst)->u.local_index = pnode->vardef_frame_relative_index;
+			return;
+
+		default:
+			break;
+		}
+
+	} else if (rval_evaluator_can_compile_to_bytecode(pnode)) {
+		mv_t val;
+		if (rval_evaluator_try_fold(pnode, pfmgr, type_inferencing, context_flags, &val)) {
+			// BC_LITERAL hands out its value as is, so strings go via an evaluator which doesn't.
+			if (val.type == MT_STRING)
+				bytecode_emit(pprog, BC_EVAL, dst)->u.pevaluator = rval_evaluator_alloc_from_constant(val);
+			else
+				bytecode_emit(pprog, BC_LITERAL, dst)->u.literal = val;
+			return;
+		}
+
+		char* name = pnode->text;
+		int arity = pnode->pchildren->length;
+		if (arity == 2 && streq(name, "&&")) {
+			bytecode_compile_logical(pprog, pnode, dst, BC_AND_LHS, BC_AND_RHS,
+				pfmgr, type_inferencing, context_flags);
+		} else if (arity == 2 && streq(name, "||")) {
+			bytecode_compile_logical(pprog, pnode, dst, BC_OR_LHS, BC_OR_RHS,
+				pfmgr, type_inferencing, context_flags);
+		} else if (arity == 2 && streq(name, "^^")) {
+			bytecode_compile_logical(pprog, pnode, dst, BC_XOR_LHS, BC_XOR_RHS,
+				pfmgr, type_inferencing, context_flags);
+		} else if (arity == 3 && streq(name, "? :")) {
+			bytecode_compile_ternop(pprog, pnode, dst, pfmgr, type_inferencing, context_flags);
+		} else {
+			bytecode_compile_builtin_call(pprog, fmgr_look_up_scalar_builtin(name, arity), pnode, dst,
+				pfmgr, type_inferencing, context_flags);
+		}
+		return;
+	}
+
+	// Everything else, including error reporting for expressions invalid in scalar context.
+	pinstr = bytecode_emit(pprog, BC_EVAL, dst);
+	pinstr->u.pevaluator = rval_evaluator_alloc_from_ast(pnode, pfmgr, type_inferencing, context_flags);
+}
+
+// ================================================================
+// INTERPRETER
+
+// On a null argument, the result is that argument; on a mistyped one, it's an error. Either way,
+// earlier arguments are not passed to the function and so must be freed here.
+static inline void bytecode_guard_fail(mv_t* regs, bytecode_instr_t* pinstr, int mistyped) {
+	for (int r = pinstr->dst; r < pinstr->src; r++)
+		mv_free(&regs[r]);
+	if (mistyped) {
+		mv_free(&regs[pinstr->src]);
+		regs[pinstr->dst] = mv_error();
+	} else {
+		regs[pinstr->dst] = regs[pinstr->src];
+	}
+}
+
+#define BYTECODE_FIELD(regs, nregs, pinstr, pvars, loaded, get_func) { \
+	if (pinstr->src < 0) { \
+		regs[pinstr->dst] = get_func(pinstr->u.field.name, pinstr->u.field.slot_index, pvars); \
+	} else { \
+		unsigned long long bit = 1ULL << (pinstr->src - nregs); \
+		if (!(loaded & bit)) { \
+			regs[pinstr->src] = get_func(pinstr->u.field.name, pinstr->u.field.slot_index, pvars); \
+			loaded |= bit; \
+		} \
+		regs[pinstr->dst] = mv_copy(&regs[pinstr->src]); \
+	} \
+}
+
+static void bytecode_free_cache(mv_t* regs, int nregs, unsigned long long loaded) {
+	for (int i = 0; loaded != 0ULL; i++, loaded >>= 1) {
+		if (loaded & 1ULL)
+			mv_free(&regs[nregs + i]);
+	}
+}
+
+// Macros rather than functions so that the comparison operators can be inlined.
+#define BYTECODE_ARITH(regs, pinstr, op, iop) { \
+	mv_t* pa = &regs[pinstr->dst]; \
+	mv_t* pb = &regs[pinstr->dst + 1]; \
+	if (pa->type == MT_FLOAT && pb->type == MT_FLOAT) { \
+		*pa = mv_from_float(pa->u.fltv op pb->u.fltv); \
+	} else if (pa->type == MT_INT && pb->type == MT_INT && iop(pa->u.intv, pb->u.intv, pa)) { \
+	} else { \
+		*pa = pinstr->u.pbinary_func(pa, pb); \
+	} \
+}
+
+#define BYTECODE_COMPARE(regs, pinstr, op) { \
+	mv_t* pa = &regs[pinstr->dst]; \
+	mv_t* pb = &regs[pinstr->dst + 1]; \
+	if (pa->type == MT_FLOAT && pb->type == MT_FLOAT) { \
+		*pa = mv_from_bool(pa->u.fltv op pb->u.fltv); \
+	} else if (pa->type == MT_INT && pb->type == MT_INT) { \
+		*pa = mv_from_bool(pa->u.intv op pb->u.intv); \
+	} else { \
+		*pa = pinstr->u.pbinary_func(pa, pb); \
+	} \
+}
+
+// Int arithmetic which doesn't overflow; otherwise these return FALSE and the mvfuncs.c functions,
+// which switch to float, are called.
+static inline int bytecode_plus_ii(long long a, long long b, mv_t* pc) {
+	long long c = (long long)((unsigned long long)a + (unsigned long long)b);
+	if (((a ^ c) & (b ^ c)) < 0LL)
+		return FALSE;
+	*pc = mv_from_int(c);
+	return TRUE;
+}
+static inline int bytecode_minus_ii(long long a, long long b, mv_t* pc) {
+	long long c = (long long)((unsigned long long)a - (unsigned long long)b);
+	if (((a ^ b) & (a ^ c)) < 0LL)
+		return FALSE;
+	*pc = mv_from_int(c);
+	return TRUE;
+}
+// As in times_n_ii in mvfuncs.c.
+static inline int bytecode_times_ii(long long a, long long b, mv_t* pc) {
+	double d = (double)a * (double)b;
+	if (fabs(d) > 9223372036854774784.0)
+		return FALSE;
+	*pc = mv_from_int(a * b);
+	return TRUE;
+}
+
+// ----------------------------------------------------------------
+static void bytecode_run(bytecode_program_t* pprog, mv_t* regs, variables_t* pvars) {
+	bytecode_instr_t* pinstrs = pprog->pinstrs;
+	bytecode_instr_t* pend = pinstrs + pprog->ninstrs;
+	bytecode_instr_t* pinstr = pinstrs;
+	int nregs = pprog->nregs;
+	unsigned long long loaded = 0ULL;
+
+	while (pinstr < pend) {
+		mv_t* pdst = &regs[pinstr->dst];
+		mv_t* psrc = &regs[pinstr->src];
+
+		switch (pinstr->opcode) {
+
+		case BC_FIELD_S:
+			BYTECODE_FIELD(regs, nregs, pinstr, pvars, loaded, get_srec_value_string_only_by_slot);
+			break;
+		case BC_FIELD_SF:
+			BYTECODE_FIELD(regs, nregs, pinstr, pvars, loaded, get_srec_value_string_float_by_slot);
+			break;
+		case BC_FIELD_SFI:
+			BYTECODE_FIELD(regs, nregs, pinstr, pvars, loaded, get_srec_value_string_float_int_by_slot);
+			break;
+
+		case BC_LITERAL:
+			*pdst = pinstr->u.literal;
+			break;
+		case BC_STRING_LITERAL: {
+			char* input = pinstr->u.literal.u.strv;
+			if (pvars->ppregex_captures == NULL || *pvars->ppregex_captures == NULL) {
+				*pdst = mv_from_string_no_free(input);
+			} else {
+				int was_allocated = FALSE;
+				char* output = interpolate_regex_captures(input, *pvars->ppregex_captures, &was_allocated);
+				*pdst = was_allocated ? mv_from_string_with_free(output) : mv_from_string_no_free(output);
+			}
+			break;
+		}
+
+		case BC_LOCAL: {
+			local_stack_frame_t* pframe = local_stack_get_top_frame(pvars->plocal_stack);
+			mv_t val = local_stack_frame_get_terminal_from_nonindexed(pframe, pinstr->u.local_index);
+			*pdst = mv_copy(&val);
+			break;
+		}
+
+		case BC_EVAL:
+			*pdst = pinstr->u.pevaluator->pprocess_func(pinstr->u.pevaluator->pvstate, pvars);
+			break;
+
+		// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+		case BC_GUARD_BOOLEAN:
+			if (psrc->type <= MT_EMPTY || psrc->type != MT_BOOLEAN) {
+				bytecode_guard_fail(regs, pinstr, psrc->type > MT_EMPTY);
+				pinstr = pinstrs + pinstr->jump;
+				continue;
+			}
+			break;
+		case BC_GUARD_FLOAT:
+			mv_set_float_nullable(psrc);
+			if (psrc->type <= MT_EMPTY) {
+				bytecode_guard_fail(regs, pinstr, FALSE);
+				pinstr = pinstrs + pinstr->jump;
+				continue;
+			}
+			break;
+		case BC_GUARD_FLOAT_STRICT:
+			mv_set_float_nullable(psrc);
+			if (psrc->type != MT_FLOAT) {
+				bytecode_guard_fail(regs, pinstr, psrc->type > MT_EMPTY);
+				pinstr = pinstrs + pinstr->jump;
+				continue;
+			}
+			break;
+		case BC_GUARD_INT:
+			mv_set_int_nullable(psrc);
+			if (psrc->type <= MT_EMPTY) {
+				bytecode_guard_fail(regs, pinstr, FALSE);
+				pinstr = pinstrs + pinstr->jump;
+				continue;
+			}
+			break;
+		case BC_GUARD_INT_STRICT:
+			mv_set_int_nullable(psrc);
+			if (psrc->type != MT_INT) {
+				bytecode_guard_fail(regs, pinstr, psrc->type > MT_EMPTY);
+				pinstr = pinstrs + pinstr->jump;
+				continue;
+			}
+			break;
+		case BC_GUARD_NUMBER:
+			mv_set_number_nullable(psrc);
+			if (psrc->type <= MT_EMPTY) {
+				bytecode_guard_fail(regs, pinstr, FALSE);
+				pinstr = pinstrs + pinstr->jump;
+				continue;
+			}
+			break;
+		case BC_GUARD_STRING:
+			if (psrc->type < MT_EMPTY || !mv_is_string_or_empty(psrc)) {
+				bytecode_guard_fail(regs, pinstr, psrc->type >= MT_EMPTY);
+				pinstr = pinstrs + pinstr->jump;
+				continue;
+			}
+			break;
+
+		// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+		case BC_CALL_ZARY:
+			*pdst = pinstr->u.pzary_func();
+			break;
+		case BC_CALL_UNARY:
+			*pdst = pinstr->u.punary_func(pdst);
+			break;
+		case BC_CALL_BINARY:
+			*pdst = pinstr->u.pbinary_func(pdst, pdst + 1);
+			break;
+		case BC_CALL_TERNARY:
+			*pdst = pinstr->u.pternary_func(pdst, pdst + 1, pdst + 2);
+			break;
+
+		case BC_PLUS:  BYTECODE_ARITH(regs, pinstr, +, bytecode_plus_ii);  break;
+		case BC_MINUS: BYTECODE_ARITH(regs, pinstr, -, bytecode_minus_ii); break;
+		case BC_TIMES: BYTECODE_ARITH(regs, pinstr, *, bytecode_times_ii); break;
+		case BC_EQ:    BYTECODE_COMPARE(regs, pinstr, ==); break;
+		case BC_NE:    BYTECODE_COMPARE(regs, pinstr, !=); break;
+		case BC_GT:    BYTECODE_COMPARE(regs, pinstr, >);  break;
+		case BC_GE:    BYTECODE_COMPARE(regs, pinstr, >=); break;
+		case BC_LT:    BYTECODE_COMPARE(regs, pinstr, <);  break;
+		case BC_LE:    BYTECODE_COMPARE(regs, pinstr, <=); break;
+
+		// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+		// As in rval_evaluator_b_bb_and_func etc.
+		case BC_AND_LHS:
+		case BC_OR_LHS:
+			if (pdst->type == MT_ERROR || pdst->type == MT_EMPTY) {
+				pinstr = pinstrs + pinstr->jump;
+				continue;
+			} else if (pdst->type == MT_BOOLEAN) {
+				if (pdst->u.boolv == (pinstr->opcode == BC_OR_LHS)) {
+					pinstr = pinstrs + pinstr->jump;
+					continue;
+				}
+			} else if (pdst->type != MT_ABSENT) {
+				mv_free(pdst);
+				*pdst = mv_error();
+				pinstr = pinstrs + pinstr->jump;
+				continue;
+			}
+			break;
+		case BC_XOR_LHS:
+			if (pdst->type == MT_ERROR || pdst->type == MT_EMPTY) {
+				pinstr = pinstrs + pinstr->jump;
+				continue;
+			} else if (pdst->type != MT_BOOLEAN && pdst->type != MT_ABSENT) {
+				mv_free(pdst);
+				*pdst = mv_error();
+				pinstr = pinstrs + pinstr->jump;
+				continue;
+			}
+			break;
+		case BC_AND_RHS:
+		case BC_OR_RHS:
+		case BC_XOR_RHS: {
+			mv_t* prhs = pdst + 1;
+			if (prhs->type == MT_ERROR || prhs->type == MT_EMPTY) {
+				*pdst = *prhs;
+			} else if (prhs->type == MT_BOOLEAN) {
+				if (pinstr->opcode == BC_XOR_RHS && pdst->type == MT_BOOLEAN)
+					*pdst = mv_from_bool(pdst->u.boolv ^ prhs->u.boolv);
+				else
+					*pdst = *prhs;
+			} else if (prhs->type != MT_ABSENT) {
+				mv_free(prhs);
+				*pdst = mv_error();
+			}
+			break;
+		}
+
+		case BC_TERNOP_TEST:
+			if (pdst->type <= MT_EMPTY) {
+				pinstr = pinstrs + pinstr->jump;
+				continue;
+			}
+			mv_set_boolean_strict(pdst);
+			if (!pdst->u.boolv) {
+				pinstr = pinstrs + pinstr->jump_if_false;
+				continue;
+			}
+			break;
+		case BC_JUMP:
+			pinstr = pinstrs + pinstr->jump;
+			continue;
+		}
+
+		pinstr++;
+	}
+
+	bytecode_free_cache(regs, nregs, loaded);
+}
+
+static mv_t rval_evaluator_bytecode_func(void* pvstate, variables_t* pvars) {
+	bytecode_program_t* pprog = pvstate;
+	mv_t stack_regs[BYTECODE_STACK_REGS];
+	int nregs_total = pprog->nregs + pprog->nfields;
+	if (nregs_total <= BYTECODE_STACK_REGS) {
+		bytecode_run(pprog, stack_regs, pvars);
+		return stack_regs[0];
+	} else {
+		mv_t* regs = mlr_malloc_or_die(nregs_total * sizeof(mv_t));
+		bytecode_run(pprog, regs, pvars);
+		mv_t rv = regs[0];
+		free(regs);
+		return rv;
+	}
+}
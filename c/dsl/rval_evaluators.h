@@ -76,6 +76,9 @@ rval_evaluator_t* rval_evaluator_alloc_from_boolean_literal(char* string);
 rval_evaluator_t* rval_evaluator_alloc_from_boolean(int boolval);
 rval_evaluator_t* rval_evaluator_alloc_from_environment(mlr_dsl_ast_node_t* pnode, fmgr_t* pfmgr,
 	int type_inferencing, int context_flags);
+// ENV assignments go through this so that ENV reads with constant names needn't call getenv on
+// every evaluation.
+void rval_evaluator_set_environment(char* name, char* value);
 rval_evaluator_t* rval_evaluator_alloc_from_NF();
 rval_evaluator_t* rval_evaluator_alloc_from_NR();
 rval_evaluator_t* rval_evaluator_alloc_from_FNR();
@@ -95,6 +98,14 @@ rval_evaluator_t* rval_evaluator_alloc_from_local_variable(int vardef_frame_rela
 // For unit test:
 rval_evaluator_t* rval_evaluator_alloc_from_mlrval(mv_t* pval);
 
+// Constant folding, which rval_evaluator_alloc_from_ast does as it goes: if the expression's value
+// can't vary from one evaluation to the next, returns TRUE and sets *pval to it, to be freed by the
+// caller. The value is computed using evaluators built and freed for the purpose.
+int rval_evaluator_try_fold(mlr_dsl_ast_node_t* pnode, fmgr_t* pfmgr, int type_inferencing, int context_flags,
+	mv_t* pval);
+// Takes ownership of the value, returning it without copying.
+rval_evaluator_t* rval_evaluator_alloc_from_constant(mv_t val);
+
 // ================================================================
 // rval_func_evaluators.c
 // ================================================================
@@ -148,6 +159,18 @@ rval_evaluator_t* rval_evaluator_alloc_from_s_sss_func(mv_ternary_func_t* pfunc,
 rval_evaluator_t* rval_evaluator_alloc_from_x_srs_func(mv_ternary_arg2_regex_func_t* pfunc,
 	rval_evaluator_t* parg1, char* regex_string, int ignore_case, rval_evaluator_t* parg3);
 
+// ================================================================
+// rval_bytecode_evaluators.c
+// ================================================================
+
+// With fmgr's compile_to_bytecode set, rval_evaluator_alloc_from_ast uses these for expressions
+// with an operator or scalar-valued built-in function at the top. The rest of the expression is
+// compiled into the same bytecode as far as it consists of such functions, fields, literals, and
+// local variables.
+int rval_evaluator_can_compile_to_bytecode(mlr_dsl_ast_node_t* pnode);
+rval_evaluator_t* rval_evaluator_alloc_bytecode_from_ast(mlr_dsl_ast_node_t* pnode, fmgr_t* pfmgr,
+	int type_inferencing, int context_flags);
+
 // ================================================================
 // rval_list_evaluators.c
 // ================================================================
@@ -163,6 +186,11 @@ mv_t get_srec_value_string_only(char* field_name, lrec_t* pinrec, lhmsmv_t* ptyp
 mv_t get_srec_value_string_float(char* field_name, lrec_t* pinrec, lhmsmv_t* ptyped_overlay);
 mv_t get_srec_value_string_float_int(char* field_name, lrec_t* pinrec, lhmsmv_t* ptyped_overlay);
 
+// Likewise, but using the field's slot in pvars->pfield_cache if there is one. A slot index of -1 means none.
+mv_t get_srec_value_string_only_by_slot(char* field_name, int slot_index, variables_t* pvars);
+mv_t get_srec_value_string_float_by_slot(char* field_name, int slot_index, variables_t* pvars);
+mv_t get_srec_value_string_float_int_by_slot(char* field_name, int slot_index, variables_t* pvars);
+
 // For boundvars in for-srec:
 typedef mv_t type_inferenced_srec_field_copy_getter_t(lrece_t* pentry, lhmsmv_t* ptyped_overlay);
 mv_t get_copy_srec_value_string_only_aux(lrece_t* pentry, lhmsmv_t* ptyped_overlay);
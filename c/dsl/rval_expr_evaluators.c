@@ -1,11 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <ctype.h> // for tolower(), toupper()
 #include "lib/mlr_globals.h"
 #include "lib/mlrutil.h"
 #include "lib/mlrregex.h"
 #include "lib/mtrand.h"
+#include "containers/mixutil.h"
 #include "mapping/mapper.h"
 #include "dsl/rval_evaluators.h"
 #include "dsl/function_manager.h"
@@ -15,6 +17,11 @@
 // See comments in rval_evaluators.h
 // ================================================================
 
+static rval_evaluator_t* rval_evaluator_alloc_folded_from_ast(mlr_dsl_ast_node_t* pnode, fmgr_t* pfmgr,
+	int type_inferencing, int context_flags);
+static rval_evaluator_t* rval_evaluator_alloc_from_field_name_with_slot(char* field_name, int slot_index,
+	int type_inferencing);
+
 // ================================================================
 // The grammar permits certain statements which are syntactically invalid, (a) because it's awkward to handle
 // there, and (b) because we get far better control over error messages here (vs. 'syntax error').
@@ -25,6 +32,13 @@
 rval_evaluator_t* rval_evaluator_alloc_from_ast(mlr_dsl_ast_node_t* pnode, fmgr_t* pfmgr,
 	int type_inferencing, int context_flags)
 {
+	rval_evaluator_t* pfolded = rval_evaluator_alloc_folded_from_ast(pnode, pfmgr, type_inferencing, context_flags);
+	if (pfolded != NULL)
+		return pfolded;
+
+	if (pfmgr->compile_to_bytecode && rval_evaluator_can_compile_to_bytecode(pnode))
+		return rval_evaluator_alloc_bytecode_from_ast(pnode, pfmgr, type_inferencing, context_flags);
+
 	//  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 	if (pnode->pchildren == NULL) {
 		// leaf node
@@ -36,7 +50,8 @@ rval_evaluator_t* rval_evaluator_alloc_from_ast(mlr_dsl_ast_node_t* pnode, fmgr_
 					MLR_GLOBALS.bargv0);
 				exit(1);
 			}
-			return rval_evaluator_alloc_from_field_name(pnode->text, type_inferencing);
+			return rval_evaluator_alloc_from_field_name_with_slot(pnode->text,
+				srec_field_cache_slot_for_name(pfmgr->pfield_cache, pnode->text), type_inferencing);
 			break;
 
 		case MD_AST_NODE_TYPE_STRING_LITERAL:
@@ -139,24 +154,216 @@ rval_evaluator_t* rval_evaluator_alloc_from_ast(mlr_dsl_ast_node_t* pnode, fmgr_
 	}
 }
 
+// ================================================================
+// CONSTANT FOLDING
+//
+// Subexpressions whose values can't vary from one record to the next -- built-in functions of
+// literals, PI, and E, such as 2 * PI / 180 or strlen("abc") -- are evaluated once, as the
+// CST is built, and replaced by their values. Likewise "? :", "&&", and "||" whose outcomes are
+// settled by a constant first argument are replaced by the argument which is used. The unused
+// ones are built anyway, so that the checks made while building (e.g. for $-variables in end
+// blocks) still apply, and are kept on the function manager until it's freed.
+//
+// Functions marked impure in the function manager's table, such as urand and systime, aren't
+// folded; nor is integer division by zero, nor string literals with regex captures such as "\1".
+// ================================================================
+
+static int rval_evaluator_ast_is_constant(mlr_dsl_ast_node_t* pnode, fmgr_t* pfmgr,
+	int type_inferencing, int context_flags);
+
+// ----------------------------------------------------------------
+static int rval_evaluator_has_regex_captures(char* string) {
+	for (char* p = string; *p; p++) {
+		if (p[0] == '\\' && isdigit((unsigned char)p[1]))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+// The node must be constant. The caller should free the return value.
+static mv_t rval_evaluator_evaluate_constant_ast(mlr_dsl_ast_node_t* pnode, fmgr_t* pfmgr,
+	int type_inferencing, int context_flags)
+{
+	rval_evaluator_t* pevaluator = (pnode->pchildren == NULL)
+		? rval_evaluator_alloc_from_ast(pnode, pfmgr, type_inferencing, context_flags)
+		: fmgr_alloc_foldable_from_operator_or_function_call(pfmgr, pnode, type_inferencing, context_flags);
+
+	variables_t vars;
+	memset(&vars, 0, sizeof(vars));
+	mv_t val = pevaluator->pprocess_func(pevaluator->pvstate, &vars);
+
+	mv_t rv = val;
+	if (val.type == MT_STRING) {
+		rv = mv_copy(&val);
+		mv_free(&val);
+	} else if (val.type == MT_EMPTY) {
+		mv_free(&val);
+		rv = mv_empty();
+	}
+	pevaluator->pfree_func(pevaluator);
+	return rv;
+}
+
+static int rval_evaluator_ast_is_constant(mlr_dsl_ast_node_t* pnode, fmgr_t* pfmgr,
+	int type_inferencing, int context_flags)
+{
+	if (pnode->pchildren == NULL) {
+		switch (pnode->type) {
+		case MD_AST_NODE_TYPE_STRING_LITERAL:
+		case MD_AST_NODE_TYPE_NUMERIC_LITERAL:
+			return pnode->text == NULL || !rval_evaluator_has_regex_captures(pnode->text);
+		case MD_AST_NODE_TYPE_BOOLEAN_LITERAL:
+			return TRUE;
+		case MD_AST_NODE_TYPE_CONTEXT_VARIABLE:
+			return streq(pnode->text, "PI") || streq(pnode->text, "E");
+		default:
+			return FALSE;
+		}
+	}
+
+	if (pnode->type != MD_AST_NODE_TYPE_OPERATOR && pnode->type != MD_AST_NODE_TYPE_FUNCTION_CALLSITE)
+		return FALSE;
+	char* name = pnode->text;
+	int nargs = pnode->pchildren->length;
+	if (!fmgr_is_foldable_builtin(name, nargs))
+		return FALSE;
+	for (sllve_t* pe = pnode->pchildren->phead; pe != NULL; pe = pe->pnext) {
+		if (!rval_evaluator_ast_is_constant(pe->pvvalue, pfmgr, type_inferencing, context_flags))
+			return FALSE;
+	}
+
+	// Integer division by zero traps, which is left to happen at run time if at all.
+	if (nargs == 2 && (streq(name, "/") || streq(name, "//") || streq(name, "%"))) {
+		mv_t divisor = rval_evaluator_evaluate_constant_ast(pnode->pchildren->phead->pnext->pvvalue, pfmgr,
+			type_inferencing, context_flags);
+		int is_int_zero = divisor.type == MT_INT && divisor.u.intv == 0LL;
+		mv_free(&divisor);
+		if (is_int_zero)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+// ----------------------------------------------------------------
+int rval_evaluator_try_fold(mlr_dsl_ast_node_t* pnode, fmgr_t* pfmgr, int type_inferencing, int context_flags,
+	mv_t* pval)
+{
+	if (!rval_evaluator_ast_is_constant(pnode, pfmgr, type_inferencing, context_flags))
+		return FALSE;
+	*pval = rval_evaluator_evaluate_constant_ast(pnode, pfmgr, type_inferencing, context_flags);
+	return TRUE;
+}
+
+// ----------------------------------------------------------------
+// Returns NULL if there's nothing to fold at the top of the expression. Leaves are left as they
+// are, being constant or not already.
+static rval_evaluator_t* rval_evaluator_alloc_folded_from_ast(mlr_dsl_ast_node_t* pnode, fmgr_t* pfmgr,
+	int type_inferencing, int context_flags)
+{
+	if (pnode->pchildren == NULL)
+		return NULL;
+	if (pnode->type != MD_AST_NODE_TYPE_OPERATOR && pnode->type != MD_AST_NODE_TYPE_FUNCTION_CALLSITE)
+		return NULL;
+
+	mv_t val;
+	if (rval_evaluator_try_fold(pnode, pfmgr, type_inferencing, context_flags, &val))
+		return rval_evaluator_alloc_from_constant(val);
+
+	char* name = pnode->text;
+	int nargs = pnode->pchildren->length;
+
+	if (nargs == 3 && streq(name, "? :")) {
+		mlr_dsl_ast_node_t* parg1 = pnode->pchildren->phead->pvvalue;
+		mlr_dsl_ast_node_t* parg2 = pnode->pchildren->phead->pnext->pvvalue;
+		mlr_dsl_ast_node_t* parg3 = pnode->pchildren->phead->pnext->pnext->pvvalue;
+		if (!rval_evaluator_try_fold(parg1, pfmgr, type_inferencing, context_flags, &val))
+			return NULL;
+		if (val.type == MT_BOOLEAN) {
+			sllv_append(pfmgr->pfolded_evaluators, rval_evaluator_alloc_from_ast(val.u.boolv ? parg3 : parg2,
+				pfmgr, type_inferencing, context_flags));
+			return rval_evaluator_alloc_from_ast(val.u.boolv ? parg2 : parg3, pfmgr, type_inferencing, context_flags);
+		} else if (val.type <= MT_EMPTY) {
+			// Absent, empty, or error: the value of the "? :" too.
+			sllv_append(pfmgr->pfolded_evaluators,
+				rval_evaluator_alloc_from_ast(parg2, pfmgr, type_inferencing, context_flags));
+			sllv_append(pfmgr->pfolded_evaluators,
+				rval_evaluator_alloc_from_ast(parg3, pfmgr, type_inferencing, context_flags));
+			return rval_evaluator_alloc_from_constant(val);
+		} else {
+			// Not boolean: an error at run time.
+			mv_free(&val);
+			return NULL;
+		}
+
+	} else if (nargs == 2 && (streq(name, "&&") || streq(name, "||"))) {
+		mlr_dsl_ast_node_t* parg1 = pnode->pchildren->phead->pvvalue;
+		mlr_dsl_ast_node_t* parg2 = pnode->pchildren->phead->pnext->pvvalue;
+		if (!rval_evaluator_try_fold(parg1, pfmgr, type_inferencing, context_flags, &val))
+			return NULL;
+		if (val.type == MT_BOOLEAN && val.u.boolv == streq(name, "||")) {
+			sllv_append(pfmgr->pfolded_evaluators,
+				rval_evaluator_alloc_from_ast(parg2, pfmgr, type_inferencing, context_flags));
+			return rval_evaluator_alloc_from_constant(val);
+		}
+		mv_free(&val);
+		return NULL;
+	}
+
+	return NULL;
+}
+
+// ----------------------------------------------------------------
+// Strings are returned without copying, as for literals.
+typedef struct _rval_evaluator_constant_state_t {
+	mv_t value;
+} rval_evaluator_constant_state_t;
+
+static mv_t rval_evaluator_constant_func(void* pvstate, variables_t* pvars) {
+	rval_evaluator_constant_state_t* pstate = pvstate;
+	if (pstate->value.type == MT_STRING)
+		return mv_from_string_no_free(pstate->value.u.strv);
+	else
+		return pstate->value;
+}
+static void rval_evaluator_constant_free(rval_evaluator_t* pevaluator) {
+	rval_evaluator_constant_state_t* pstate = pevaluator->pvstate;
+	mv_free(&pstate->value);
+	free(pstate);
+	free(pevaluator);
+}
+
+rval_evaluator_t* rval_evaluator_alloc_from_constant(mv_t val) {
+	rval_evaluator_constant_state_t* pstate = mlr_malloc_or_die(sizeof(rval_evaluator_constant_state_t));
+	rval_evaluator_t* pevaluator = mlr_malloc_or_die(sizeof(rval_evaluator_t));
+
+	pstate->value = val;
+	pevaluator->pprocess_func = rval_evaluator_constant_func;
+	pevaluator->pfree_func = rval_evaluator_constant_free;
+
+	pevaluator->pvstate = pstate;
+	return pevaluator;
+}
+
 // ================================================================
 typedef struct _rval_evaluator_field_name_state_t {
 	char* field_name;
+	int   slot_index; // In the function manager's field cache, or -1
 } rval_evaluator_field_name_state_t;
 
 static mv_t rval_evaluator_field_name_func_string_only(void* pvstate, variables_t* pvars) {
 	rval_evaluator_field_name_state_t* pstate = pvstate;
-	return get_srec_value_string_only(pstate->field_name, pvars->pinrec, pvars->ptyped_overlay);
+	return get_srec_value_string_only_by_slot(pstate->field_name, pstate->slot_index, pvars);
 }
 
 static mv_t rval_evaluator_field_name_func_string_float(void* pvstate, variables_t* pvars) {
 	rval_evaluator_field_name_state_t* pstate = pvstate;
-	return get_srec_value_string_float(pstate->field_name, pvars->pinrec, pvars->ptyped_overlay);
+	return get_srec_value_string_float_by_slot(pstate->field_name, pstate->slot_index, pvars);
 }
 
 static mv_t rval_evaluator_field_name_func_string_float_int(void* pvstate, variables_t* pvars) {
 	rval_evaluator_field_name_state_t* pstate = pvstate;
-	return get_srec_value_string_float_int(pstate->field_name, pvars->pinrec, pvars->ptyped_overlay);
+	return get_srec_value_string_float_int_by_slot(pstate->field_name, pstate->slot_index, pvars);
 }
 
 static void rval_evaluator_field_name_free(rval_evaluator_t* pevaluator) {
@@ -167,8 +374,15 @@ static void rval_evaluator_field_name_free(rval_evaluator_t* pevaluator) {
 }
 
 rval_evaluator_t* rval_evaluator_alloc_from_field_name(char* field_name, int type_inferencing) {
+	return rval_evaluator_alloc_from_field_name_with_slot(field_name, -1, type_inferencing);
+}
+
+static rval_evaluator_t* rval_evaluator_alloc_from_field_name_with_slot(char* field_name, int slot_index,
+	int type_inferencing)
+{
 	rval_evaluator_field_name_state_t* pstate = mlr_malloc_or_die(sizeof(rval_evaluator_field_name_state_t));
 	pstate->field_name = mlr_strdup_or_die(field_name);
+	pstate->slot_index = slot_index;
 
 	rval_evaluator_t* pevaluator = mlr_malloc_or_die(sizeof(rval_evaluator_t));
 	pevaluator->pvstate = pstate;
@@ -655,14 +869,72 @@ static void rval_evaluator_environment_free(rval_evaluator_t* pevaluator) {
 	free(pevaluator);
 }
 
+// ----------------------------------------------------------------
+// Where the name is constant, as in the example above, the variable is looked up again only after
+// an ENV assignment.
+
+static unsigned long long environment_generation = 1ULL;
+
+void rval_evaluator_set_environment(char* name, char* value) {
+	setenv(name, value, 1);
+	environment_generation++;
+}
+
+typedef struct _rval_evaluator_constant_environment_state_t {
+	char* name;
+	char* value;
+	unsigned long long generation;
+} rval_evaluator_constant_environment_state_t;
+
+static mv_t rval_evaluator_constant_environment_func(void* pvstate, variables_t* pvars) {
+	rval_evaluator_constant_environment_state_t* pstate = pvstate;
+	if (pstate->generation != environment_generation) {
+		pstate->value = getenv(pstate->name);
+		pstate->generation = environment_generation;
+	}
+	return (pstate->value == NULL) ? mv_empty() : mv_from_string(pstate->value, NO_FREE);
+}
+
+static void rval_evaluator_constant_environment_free(rval_evaluator_t* pevaluator) {
+	rval_evaluator_constant_environment_state_t* pstate = pevaluator->pvstate;
+	free(pstate->name);
+	free(pstate);
+	free(pevaluator);
+}
+
+static rval_evaluator_t* rval_evaluator_alloc_from_constant_environment(mv_t* pname) {
+	rval_evaluator_constant_environment_state_t* pstate = mlr_malloc_or_die(
+		sizeof(rval_evaluator_constant_environment_state_t));
+	rval_evaluator_t* pevaluator = mlr_malloc_or_die(sizeof(rval_evaluator_t));
+
+	pstate->name = mv_alloc_format_val(pname);
+	pstate->value = NULL;
+	pstate->generation = 0ULL;
+	pevaluator->pprocess_func = rval_evaluator_constant_environment_func;
+	pevaluator->pfree_func = rval_evaluator_constant_environment_free;
+
+	pevaluator->pvstate = pstate;
+	return pevaluator;
+}
+
+// ----------------------------------------------------------------
 rval_evaluator_t* rval_evaluator_alloc_from_environment(mlr_dsl_ast_node_t* pnode, fmgr_t* pfmgr,
 	int type_inferencing, int context_flags)
 {
+	mlr_dsl_ast_node_t* pnamenode = pnode->pchildren->phead->pnext->pvvalue;
+
+	mv_t name;
+	if (rval_evaluator_try_fold(pnamenode, pfmgr, type_inferencing, context_flags, &name)) {
+		if (mv_is_null(&name))
+			return rval_evaluator_alloc_from_constant(mv_absent());
+		rval_evaluator_t* pevaluator = rval_evaluator_alloc_from_constant_environment(&name);
+		mv_free(&name);
+		return pevaluator;
+	}
+
 	rval_evaluator_environment_state_t* pstate = mlr_malloc_or_die(sizeof(rval_evaluator_environment_state_t));
 	rval_evaluator_t* pevaluator = mlr_malloc_or_die(sizeof(rval_evaluator_t));
 
-	mlr_dsl_ast_node_t* pnamenode = pnode->pchildren->phead->pnext->pvvalue;
-
 	pstate->pname_evaluator = rval_evaluator_alloc_from_ast(pnamenode, pfmgr, type_inferencing, context_flags);
 	pevaluator->pprocess_func = rval_evaluator_environment_func;
 	pevaluator->pfree_func = rval_evaluator_environment_free;
@@ -988,7 +1260,9 @@ mv_t get_srec_value_string_float(char* field_name, lrec_t* pinrec, lhmsmv_t* pty
 		// freed out from underneath it by the evaluator functions.
 		rv = mv_copy(poverlay);
 	} else {
-		rv = mv_ref_type_infer_string_or_float(lrec_get(pinrec, field_name));
+		lrece_t* pentry = NULL;
+		lrec_get_ext(pinrec, field_name, &pentry);
+		rv = mv_ref_type_infer_entry_string_or_float(pentry);
 		rv = mv_copy(&rv);
 	}
 	return rv;
@@ -1005,12 +1279,49 @@ mv_t get_srec_value_string_float_int(char* field_name, lrec_t* pinrec, lhmsmv_t*
 		// freed out from underneath it by the evaluator functions.
 		rv = mv_copy(poverlay);
 	} else {
-		rv = mv_ref_type_infer_string_or_float_or_int(lrec_get(pinrec, field_name));
+		lrece_t* pentry = NULL;
+		lrec_get_ext(pinrec, field_name, &pentry);
+		rv = mv_ref_type_infer_entry_string_or_float_or_int(pentry);
 		rv = mv_copy(&rv);
 	}
 	return rv;
 }
 
+// ----------------------------------------------------------------
+// As above, but with the overlay and record entries found once per record: see srec_field_cache.h.
+mv_t get_srec_value_string_only_by_slot(char* field_name, int slot_index, variables_t* pvars) {
+	if (pvars->pfield_cache == NULL || slot_index < 0)
+		return get_srec_value_string_only(field_name, pvars->pinrec, pvars->ptyped_overlay);
+	srec_field_slot_t* pslot = srec_field_cache_resolve(pvars->pfield_cache, slot_index, field_name,
+		pvars->pinrec, pvars->ptyped_overlay);
+	if (pslot->poverlay_entry != NULL)
+		return mv_copy(&pslot->poverlay_entry->value);
+	mv_t rv = mv_ref_type_infer_string(pslot->prec_entry == NULL ? NULL : pslot->prec_entry->value);
+	return mv_copy(&rv);
+}
+
+mv_t get_srec_value_string_float_by_slot(char* field_name, int slot_index, variables_t* pvars) {
+	if (pvars->pfield_cache == NULL || slot_index < 0)
+		return get_srec_value_string_float(field_name, pvars->pinrec, pvars->ptyped_overlay);
+	srec_field_slot_t* pslot = srec_field_cache_resolve(pvars->pfield_cache, slot_index, field_name,
+		pvars->pinrec, pvars->ptyped_overlay);
+	if (pslot->poverlay_entry != NULL)
+		return mv_copy(&pslot->poverlay_entry->value);
+	mv_t rv = mv_ref_type_infer_entry_string_or_float(pslot->prec_entry);
+	return mv_copy(&rv);
+}
+
+mv_t get_srec_value_string_float_int_by_slot(char* field_name, int slot_index, variables_t* pvars) {
+	if (pvars->pfield_cache == NULL || slot_index < 0)
+		return get_srec_value_string_float_int(field_name, pvars->pinrec, pvars->ptyped_overlay);
+	srec_field_slot_t* pslot = srec_field_cache_resolve(pvars->pfield_cache, slot_index, field_name,
+		pvars->pinrec, pvars->ptyped_overlay);
+	if (pslot->poverlay_entry != NULL)
+		return mv_copy(&pslot->poverlay_entry->value);
+	mv_t rv = mv_ref_type_infer_entry_string_or_float_or_int(pslot->prec_entry);
+	return mv_copy(&rv);
+}
+
 // ----------------------------------------------------------------
 mv_t get_copy_srec_value_string_only_aux(lrece_t* pentry, lhmsmv_t* ptyped_overlay) {
 	// See comments in rval_evaluator.h and mapper_put.c regarding the typed-overlay map.
@@ -1049,12 +1360,8 @@ mv_t get_copy_srec_value_string_float_aux(lrece_t* pentry, lhmsmv_t* ptyped_over
 		} else if (*pentry->value == 0) {
 			rv = mv_empty();
 		} else {
-			double fltv;
-			if (mlr_try_float_from_string(pentry->value, &fltv)) {
-				rv = mv_from_float(fltv);
-			} else {
-				rv = mv_from_string_with_free(mlr_strdup_or_die(pentry->value));
-			}
+			rv = mv_ref_type_infer_entry_string_or_float(pentry);
+			rv = mv_copy(&rv);
 		}
 	}
 	return rv;
@@ -1076,15 +1383,8 @@ mv_t get_copy_srec_value_string_float_int_aux(lrece_t* pentry, lhmsmv_t* ptyped_
 		} else if (*pentry->value == 0) {
 			rv = mv_empty();
 		} else {
-			long long intv;
-			double fltv;
-			if (mlr_try_int_from_string(pentry->value, &intv)) {
-				rv = mv_from_int(intv);
-			} else if (mlr_try_float_from_string(pentry->value, &fltv)) {
-				rv = mv_from_float(fltv);
-			} else {
-				rv = mv_from_string_with_free(mlr_strdup_or_die(pentry->value));
-			}
+			rv = mv_ref_type_infer_entry_string_or_float_or_int(pentry);
+			rv = mv_copy(&rv);
 		}
 	}
 	return rv;
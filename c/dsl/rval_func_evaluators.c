@@ -1077,7 +1077,7 @@ rval_evaluator_t* rval_evaluator_alloc_from_x_ssc_func(mv_binary_arg3_capture_fu
 typedef struct _rval_evaluator_x_sr_state_t {
 	mv_binary_arg2_regex_func_t* pfunc;
 	rval_evaluator_t*             parg1;
-	regex_t                       regex;
+	mlr_regex_t                       regex;
 	string_builder_t*             psb;
 } rval_evaluator_x_sr_state_t;
 
@@ -1094,7 +1094,7 @@ static mv_t rval_evaluator_x_sr_func(void* pvstate, variables_t* pvars) {
 static void rval_evaluator_x_sr_free(rval_evaluator_t* pevaluator) {
 	rval_evaluator_x_sr_state_t* pstate = pevaluator->pvstate;
 	pstate->parg1->pfree_func(pstate->parg1);
-	regfree(&pstate->regex);
+	mlr_regfree(&pstate->regex);
 	sb_free(pstate->psb);
 	free(pstate);
 	free(pevaluator);
@@ -1222,7 +1222,7 @@ rval_evaluator_t* rval_evaluator_alloc_from_s_sss_func(mv_ternary_func_t* pfunc,
 typedef struct _rval_evaluator_x_srs_state_t {
 	mv_ternary_arg2_regex_func_t* pfunc;
 	rval_evaluator_t*             parg1;
-	regex_t                       regex;
+	mlr_regex_t                       regex;
 	rval_evaluator_t*             parg3;
 	string_builder_t*             psb;
 } rval_evaluator_x_srs_state_t;
@@ -1247,7 +1247,7 @@ static mv_t rval_evaluator_x_srs_func(void* pvstate, variables_t* pvars) {
 static void rval_evaluator_x_srs_free(rval_evaluator_t* pevaluator) {
 	rval_evaluator_x_srs_state_t* pstate = pevaluator->pvstate;
 	pstate->parg1->pfree_func(pstate->parg1);
-	regfree(&pstate->regex);
+	mlr_regfree(&pstate->regex);
 	pstate->parg3->pfree_func(pstate->parg3);
 	sb_free(pstate->psb);
 	free(pstate);
@@ -0,0 +1,43 @@
+#include <stdlib.h>
+#include <string.h>
+#include "lib/mlrutil.h"
+#include "dsl/srec_field_cache.h"
+
+#define INITIAL_SLOTS_CAPACITY 16
+
+// ----------------------------------------------------------------
+srec_field_cache_t* srec_field_cache_alloc() {
+	srec_field_cache_t* pcache = mlr_malloc_or_die(sizeof(srec_field_cache_t));
+	pcache->pnames_to_slots = lhmsi_alloc();
+	pcache->pslots = mlr_malloc_or_die(INITIAL_SLOTS_CAPACITY * sizeof(srec_field_slot_t));
+	pcache->num_slots = 0;
+	pcache->slots_capacity = INITIAL_SLOTS_CAPACITY;
+	// Slots start at generation 0, so as unresolved.
+	pcache->generation = 1ULL;
+	pcache->overlay_array_length = 0;
+	return pcache;
+}
+
+void srec_field_cache_free(srec_field_cache_t* pcache) {
+	if (pcache == NULL)
+		return;
+	lhmsi_free(pcache->pnames_to_slots);
+	free(pcache->pslots);
+	free(pcache);
+}
+
+// ----------------------------------------------------------------
+int srec_field_cache_slot_for_name(srec_field_cache_t* pcache, char* field_name) {
+	int slot_index = 0;
+	if (lhmsi_test_and_get(pcache->pnames_to_slots, field_name, &slot_index))
+		return slot_index;
+
+	if (pcache->num_slots >= pcache->slots_capacity) {
+		pcache->slots_capacity *= 2;
+		pcache->pslots = mlr_realloc_or_die(pcache->pslots, pcache->slots_capacity * sizeof(srec_field_slot_t));
+	}
+	slot_index = pcache->num_slots++;
+	memset(&pcache->pslots[slot_index], 0, sizeof(srec_field_slot_t));
+	lhmsi_put(pcache->pnames_to_slots, mlr_strdup_or_die(field_name), slot_index, FREE_ENTRY_KEY);
+	return slot_index;
+}
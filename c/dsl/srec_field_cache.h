@@ -0,0 +1,82 @@
+// ================================================================
+// Per-record resolution of the $-fields a DSL expression names statically, such as $x in
+// '$y = $x . $x'. Without this each read of $x looks it up in the typed overlay and then the
+// record (see variables.h), and each assignment to it does likewise, so a statement touching $x
+// five times finds it five times over.
+//
+// While the CST is being built, each distinct field name is given a slot. Then for each record
+// a slot is resolved on its first use, to the field's entries in the typed overlay and the
+// record, and later uses of the same name reuse those.
+//
+// Resolutions are for one record and are dropped all at once by bumping the generation: this is
+// done at the start of each record, and by statements which move or remove fields or write
+// fields by computed name -- 'unset $x', 'unset $*', '$* = ...', '$[...] = ...'. Assignments to
+// a statically named field update that field's slot. The overlay's entries also move when it is
+// enlarged, which is noticed from its array length.
+// ================================================================
+
+#ifndef SREC_FIELD_CACHE_H
+#define SREC_FIELD_CACHE_H
+
+#include "containers/lrec.h"
+#include "containers/lhmsi.h"
+#include "containers/lhmsmv.h"
+
+typedef struct _srec_field_slot_t {
+	unsigned long long generation; // The slot is resolved if this equals the cache's.
+	lhmsmve_t* poverlay_entry;     // NULL if the field isn't in the typed overlay
+	lrece_t*   prec_entry;         // NULL if the field isn't in the record
+} srec_field_slot_t;
+
+typedef struct _srec_field_cache_t {
+	lhmsi_t*           pnames_to_slots;
+	srec_field_slot_t* pslots;
+	int                num_slots;
+	int                slots_capacity;
+	unsigned long long generation;
+	int                overlay_array_length;
+} srec_field_cache_t;
+
+srec_field_cache_t* srec_field_cache_alloc();
+void srec_field_cache_free(srec_field_cache_t* pcache);
+
+// For use while building the CST.
+int srec_field_cache_slot_for_name(srec_field_cache_t* pcache, char* field_name);
+
+static inline void srec_field_cache_invalidate(srec_field_cache_t* pcache) {
+	pcache->generation++;
+}
+
+// Returns the slot for the field, resolving it if need be.
+static inline srec_field_slot_t* srec_field_cache_resolve(srec_field_cache_t* pcache, int slot_index,
+	char* field_name, lrec_t* pinrec, lhmsmv_t* ptyped_overlay)
+{
+	if (ptyped_overlay->array_length != pcache->overlay_array_length) {
+		pcache->overlay_array_length = ptyped_overlay->array_length;
+		pcache->generation++;
+	}
+	srec_field_slot_t* pslot = &pcache->pslots[slot_index];
+	if (pslot->generation != pcache->generation) {
+		pslot->poverlay_entry = lhmsmv_get_entry(ptyped_overlay, field_name);
+		lrec_get_ext(pinrec, field_name, &pslot->prec_entry);
+		pslot->generation = pcache->generation;
+	}
+	return pslot;
+}
+
+// Returns the slot for the field if it's already resolved, else NULL.
+static inline srec_field_slot_t* srec_field_cache_peek(srec_field_cache_t* pcache, int slot_index,
+	lhmsmv_t* ptyped_overlay)
+{
+	if (ptyped_overlay->array_length != pcache->overlay_array_length)
+		return NULL;
+	srec_field_slot_t* pslot = &pcache->pslots[slot_index];
+	return (pslot->generation == pcache->generation) ? pslot : NULL;
+}
+
+// Marks one slot as needing resolution again, e.g. after the field has been added to the overlay.
+static inline void srec_field_cache_invalidate_slot(srec_field_slot_t* pslot) {
+	pslot->generation = 0ULL;
+}
+
+#endif // SREC_FIELD_CACHE_H
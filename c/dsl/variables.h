@@ -33,11 +33,15 @@
 #include "lib/context.h"
 #include "containers/local_stack.h"
 #include "dsl/return_state.h"
+#include "dsl/srec_field_cache.h"
 
 // Context for DSL evaluation
 typedef struct _variables_t {
 	lrec_t*          pinrec;
 	lhmsmv_t*        ptyped_overlay;
+	// Optional: resolutions of statically named fields for the current record. The caller owns it,
+	// and invalidates it for each record.
+	srec_field_cache_t* pfield_cache;
 	string_array_t** ppregex_captures;
 	mlhmmv_root_t*   poosvars;
 	context_t*       pctx;
@@ -45,6 +45,7 @@ file_reader_mmap_state_t* file_reader_mmap_open(char* prepipe, char* file_name)
 		}
 	}
 	pstate->eof = pstate->sol + stat.st_size;
+	pstate->prev_sol = pstate->sol;
 	// POSIX semantics: the mmap itself increments a reference count to the file, in addition to the
 	// open.  We close the file but keep the mmap reference until a subsequent munmap.
 	if (close(pstate->fd) < 0) {
@@ -65,6 +66,43 @@ void file_reader_mmap_close(file_reader_mmap_state_t* pstate, char* prepipe) {
 	free(pstate);
 }
 
+// ----------------------------------------------------------------
+sllv_t* file_reader_mmap_split(file_reader_mmap_state_t* pstate, char* irs, int irslen, long long chunk_size) {
+	sllv_t* pchunks = sllv_alloc();
+	char* sol = pstate->sol;
+	char* eof = pstate->eof;
+
+	while (sol < eof) {
+		char* p = sol + chunk_size;
+		if (irslen > 1) // Back up in case the nominal cut point is in the middle of an IRS.
+			p -= irslen - 1;
+		while (p < eof) {
+			p = memchr(p, irs[0], eof - p);
+			if (p == NULL) {
+				p = eof;
+			} else if (eof - p >= irslen && memcmp(p, irs, irslen) == 0) {
+				p += irslen;
+				break;
+			} else {
+				p++;
+			}
+		}
+		if (p > eof)
+			p = eof;
+
+		file_reader_mmap_state_t* pchunk = mlr_malloc_or_die(sizeof(file_reader_mmap_state_t));
+		pchunk->sol = sol;
+		pchunk->eof = p;
+		pchunk->fd  = pstate->fd;
+		pchunk->prev_sol = sol;
+		sllv_append(pchunks, pchunk);
+		sol = p;
+	}
+
+	pstate->sol = eof;
+	return pchunks;
+}
+
 // ----------------------------------------------------------------
 void* file_reader_mmap_vopen(void* pvstate, char* prepipe, char* file_name) {
 	return file_reader_mmap_open(prepipe, file_name);
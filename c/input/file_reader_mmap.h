@@ -5,15 +5,32 @@
 #ifndef FILE_READER_MMAP_H
 #define FILE_READER_MMAP_H
 
+#include "containers/sllv.h"
+
 typedef struct _file_reader_mmap_state_t {
 	char* sol;
 	char* eof;
 	int   fd;
+	char* prev_sol; // Start of the previous record, for sizing the next one
 } file_reader_mmap_state_t;
 
+// For readers when they start a record at sol: the length of the previous record read, as a guess
+// at the length of this one.
+static inline size_t file_reader_mmap_guess_record_length(file_reader_mmap_state_t* pstate) {
+	size_t length = pstate->sol - pstate->prev_sol;
+	pstate->prev_sol = pstate->sol;
+	return length;
+}
+
 file_reader_mmap_state_t* file_reader_mmap_open(char* prepipe, char* file_name);
 void file_reader_mmap_close(file_reader_mmap_state_t* pstate, char* prepipe);
 
+// Splits the unread remainder [sol, eof) of the mapped file into consecutive chunks of roughly
+// the given size, each ending just after an occurrence of the IRS (except possibly the last),
+// for parsing on separate threads. Returns a list of file_reader_mmap_state_t* which the caller
+// should free; the input handle is left at end of file.
+sllv_t* file_reader_mmap_split(file_reader_mmap_state_t* pstate, char* irs, int irslen, long long chunk_size);
+
 void* file_reader_mmap_vopen(void* pvstate, char* prepipe, char* file_name);
 void file_reader_mmap_vclose(void* pvstate, void* pvhandle, char* prepipe);
 
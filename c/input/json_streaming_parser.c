@@ -0,0 +1,660 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include "lib/mlr_globals.h"
+#include "lib/mlrutil.h"
+#include "input/json_parser.h"
+#include "input/json_streaming_parser.h"
+
+#define JSON_STREAMING_PARSER_BUILDER_SIZE 1024
+#define JSON_STREAMING_PARSER_BUFFER_SIZE  (64 * 1024)
+#define JSON_STREAMING_PARSER_MIN_READ     4096
+#define JSON_STREAMING_PARSER_INDEX_BLOCKS 64
+#define BYTE_DESCRIPTION_SIZE 16
+
+static void        json_streaming_parser_reset(json_streaming_parser_t* pparser, char* start, char* end);
+static int         json_streaming_parser_refill(json_streaming_parser_t* pparser, char** ppkeep);
+static int         json_streaming_parser_index_more(json_streaming_parser_t* pparser, char** ppkeep);
+static void        json_streaming_parser_skip_bom(json_streaming_parser_t* pparser);
+static lrec_t*     json_streaming_parser_parse_record(json_streaming_parser_t* pparser);
+static void        json_streaming_parser_parse_object(json_streaming_parser_t* pparser, lrec_t* prec, int depth);
+static char*       json_streaming_parser_find_close_quote(json_streaming_parser_t* pparser, char** pp);
+static char*       json_streaming_parser_parse_string(json_streaming_parser_t* pparser, lrec_t* prec, char** pp);
+static void        json_streaming_parser_append_string(json_streaming_parser_t* pparser, string_builder_t* psb,
+	char** pp);
+static int         json_streaming_parser_unescape(json_streaming_parser_t* pparser, char* quote, char* close,
+	char* dest);
+static unsigned    json_streaming_parser_parse_hex_quad(json_streaming_parser_t* pparser, char* quote, char* p,
+	char* close);
+static char*       json_streaming_parser_parse_scalar(json_streaming_parser_t* pparser, char** pp, char** ppend,
+	json_type_t* ptype);
+static json_type_t json_number_type(char* p, char* end);
+static char*       json_streaming_parser_skip_value(json_streaming_parser_t* pparser, char* p, json_type_t* ptype);
+
+static void json_streaming_parser_fail(json_streaming_parser_t* pparser, char* pos, char* format, ...);
+static void json_streaming_parser_fail_unexpected(json_streaming_parser_t* pparser, char* pos, char* where);
+static void json_streaming_parser_fail_expected(json_streaming_parser_t* pparser, char* what, char* pos);
+static void json_streaming_parser_fail_unmillerable();
+static char* describe_byte(char* pos, char* buffer);
+
+// ----------------------------------------------------------------
+json_streaming_parser_t* json_streaming_parser_alloc(char* flatten_sep, int json_skip_arrays_on_input) {
+	json_streaming_parser_t* pparser = mlr_malloc_or_die(sizeof(json_streaming_parser_t));
+
+	pparser->pread_func    = NULL;
+	pparser->pvread_handle = NULL;
+	pparser->buffer        = NULL;
+	pparser->buffer_size   = 0;
+	pparser->index = mlr_malloc_or_die(JSON_STREAMING_PARSER_INDEX_BLOCKS * JSONSCAN_BLOCK_SIZE * sizeof(unsigned));
+
+	pparser->flatten_sep = flatten_sep;
+	pparser->json_skip_arrays_on_input = json_skip_arrays_on_input;
+	sb_init(&pparser->key_builder, JSON_STREAMING_PARSER_BUILDER_SIZE);
+	json_streaming_parser_reset_in_memory(pparser, NULL, NULL);
+
+	return pparser;
+}
+
+void json_streaming_parser_free(json_streaming_parser_t* pparser) {
+	if (pparser == NULL)
+		return;
+	free(pparser->buffer);
+	free(pparser->index);
+	free(pparser->key_builder.buffer);
+	free(pparser);
+}
+
+// ----------------------------------------------------------------
+void json_streaming_parser_reset_in_memory(json_streaming_parser_t* pparser, char* start, char* end) {
+	json_streaming_parser_reset(pparser, start, end);
+	pparser->at_end_of_input = TRUE;
+	pparser->pread_func      = NULL;
+	pparser->pvread_handle   = NULL;
+}
+
+void json_streaming_parser_reset_streaming(json_streaming_parser_t* pparser,
+	json_streaming_parser_read_func_t* pread_func, void* pvread_handle)
+{
+	if (pparser->buffer == NULL) {
+		pparser->buffer_size = JSON_STREAMING_PARSER_BUFFER_SIZE;
+		pparser->buffer = mlr_malloc_or_die(pparser->buffer_size);
+	}
+	json_streaming_parser_reset(pparser, pparser->buffer, pparser->buffer);
+	pparser->at_end_of_input = FALSE;
+	pparser->pread_func      = pread_func;
+	pparser->pvread_handle   = pvread_handle;
+}
+
+static void json_streaming_parser_reset(json_streaming_parser_t* pparser, char* start, char* end) {
+	pparser->start              = start;
+	pparser->end                = end;
+	pparser->lines_before_start = 0LL;
+	jsonscan_state_init(&pparser->scan_state);
+	pparser->scan_pos           = start;
+	pparser->index_base         = start;
+	pparser->index_count        = 0;
+	pparser->index_pos          = 0;
+	pparser->at_start_of_input  = TRUE;
+	pparser->in_top_level_array = FALSE;
+	pparser->need_comma         = FALSE;
+}
+
+// ----------------------------------------------------------------
+// Returns a pointer to the next structural byte, or NULL at end of input. In streaming mode this may
+// move the unparsed input within the buffer: the input from *ppkeep on, if ppkeep is non-null, is
+// retained and *ppkeep updated to match. Any other pointers into the input are invalidated.
+static inline char* next_structural(json_streaming_parser_t* pparser, char** ppkeep) {
+	if (pparser->index_pos == pparser->index_count) {
+		if (!json_streaming_parser_index_more(pparser, ppkeep))
+			return NULL;
+	}
+	return pparser->index_base + pparser->index[pparser->index_pos++];
+}
+
+// The index is refilled only once exhausted. Only whole blocks are indexed until end of input, at
+// which point the last partial block is padded with whitespace.
+static int json_streaming_parser_index_more(json_streaming_parser_t* pparser, char** ppkeep) {
+	while (TRUE) {
+		long long avail = pparser->end - pparser->scan_pos;
+		if (avail >= JSONSCAN_BLOCK_SIZE) {
+			int nblocks = JSON_STREAMING_PARSER_INDEX_BLOCKS;
+			if (avail / JSONSCAN_BLOCK_SIZE < nblocks)
+				nblocks = avail / JSONSCAN_BLOCK_SIZE;
+			pparser->index_base  = pparser->scan_pos;
+			pparser->index_count = jsonscan_index(pparser->scan_pos, nblocks, &pparser->scan_state,
+				pparser->index);
+			pparser->index_pos   = 0;
+			pparser->scan_pos   += nblocks * JSONSCAN_BLOCK_SIZE;
+		} else if (json_streaming_parser_refill(pparser, ppkeep)) {
+			continue;
+		} else if (avail > 0) {
+			char block[JSONSCAN_BLOCK_SIZE];
+			memcpy(block, pparser->scan_pos, avail);
+			memset(block + avail, ' ', JSONSCAN_BLOCK_SIZE - avail);
+			pparser->index_base  = pparser->scan_pos;
+			pparser->index_count = jsonscan_index(block, 1, &pparser->scan_state, pparser->index);
+			pparser->index_pos   = 0;
+			pparser->scan_pos    = pparser->end;
+		} else {
+			return FALSE;
+		}
+		if (pparser->index_count > 0)
+			return TRUE;
+	}
+}
+
+static long long count_newlines(char* p, char* end) {
+	long long count = 0LL;
+	while ((p = memchr(p, '\n', end - p)) != NULL) {
+		count++;
+		p++;
+	}
+	return count;
+}
+
+// In streaming mode: discards the input before *ppkeep if ppkeep is non-null, else before the scan
+// position, moves the rest to the start of the buffer, and reads more after it. Returns FALSE at
+// end of input.
+static int json_streaming_parser_refill(json_streaming_parser_t* pparser, char** ppkeep) {
+	if (pparser->at_end_of_input)
+		return FALSE;
+
+	char* keep = (ppkeep != NULL) ? *ppkeep : pparser->scan_pos;
+	pparser->lines_before_start += count_newlines(pparser->start, keep);
+	int kept = pparser->end - keep;
+	int scan_offset = pparser->scan_pos - keep;
+	memmove(pparser->buffer, keep, kept);
+	if (pparser->buffer_size - kept < JSON_STREAMING_PARSER_MIN_READ) {
+		pparser->buffer_size *= 2;
+		pparser->buffer = mlr_realloc_or_die(pparser->buffer, pparser->buffer_size);
+	}
+	pparser->start       = pparser->buffer;
+	pparser->end         = pparser->buffer + kept;
+	pparser->scan_pos    = pparser->buffer + scan_offset;
+	pparser->index_base  = pparser->scan_pos;
+	pparser->index_count = 0;
+	pparser->index_pos   = 0;
+	if (ppkeep != NULL)
+		*ppkeep = pparser->buffer;
+
+	int nread = pparser->pread_func(pparser->pvread_handle, pparser->end, pparser->buffer_size - kept);
+	if (nread <= 0) {
+		pparser->at_end_of_input = TRUE;
+		return FALSE;
+	}
+	pparser->end += nread;
+	return TRUE;
+}
+
+// ----------------------------------------------------------------
+lrec_t* json_streaming_parser_next(json_streaming_parser_t* pparser) {
+	if (pparser->at_start_of_input) {
+		pparser->at_start_of_input = FALSE;
+		json_streaming_parser_skip_bom(pparser);
+	}
+
+	while (TRUE) {
+		char* p = next_structural(pparser, NULL);
+
+		if (!pparser->in_top_level_array) {
+			if (p == NULL)
+				return NULL;
+			if (*p == '{')
+				return json_streaming_parser_parse_record(pparser);
+			if (*p == '[') {
+				pparser->in_top_level_array = TRUE;
+				pparser->need_comma = FALSE;
+				continue;
+			}
+			json_type_t type = JSON_NONE;
+			json_streaming_parser_skip_value(pparser, p, &type);
+			fprintf(stderr,
+				"%s: found non-terminal (type %s) at top level. This is valid but unmillerable JSON.\n",
+				MLR_GLOBALS.bargv0, json_describe_type(type));
+			json_streaming_parser_fail_unmillerable();
+
+		} else {
+			if (p != NULL && *p == ']') {
+				pparser->in_top_level_array = FALSE;
+				continue;
+			}
+			if (p != NULL && *p == ',' && pparser->need_comma) {
+				pparser->need_comma = FALSE;
+				continue;
+			}
+			if (pparser->need_comma)
+				json_streaming_parser_fail_expected(pparser, ",", p);
+			if (p != NULL && *p == '{') {
+				pparser->need_comma = TRUE;
+				return json_streaming_parser_parse_record(pparser);
+			}
+			json_type_t type = JSON_NONE;
+			json_streaming_parser_skip_value(pparser, p, &type);
+			fprintf(stderr,
+				"%s: found non-object (type %s) within top-level array. This is valid but unmillerable JSON.\n",
+				MLR_GLOBALS.bargv0, json_describe_type(type));
+			json_streaming_parser_fail_unmillerable();
+		}
+	}
+}
+
+static void json_streaming_parser_skip_bom(json_streaming_parser_t* pparser) {
+	while (pparser->end - pparser->scan_pos < 3 && json_streaming_parser_refill(pparser, NULL))
+		;
+	char* p = pparser->scan_pos;
+	if (p < pparser->end && (unsigned char)*p == 0xEF) {
+		if (pparser->end - p < 3 || (unsigned char)p[1] != 0xBB || (unsigned char)p[2] != 0xBF)
+			json_streaming_parser_fail(pparser, p, "Malformed UTF-8 byte-order mark");
+		pparser->scan_pos += 3;
+	}
+}
+
+// ----------------------------------------------------------------
+// The opening brace has been consumed.
+static lrec_t* json_streaming_parser_parse_record(json_streaming_parser_t* pparser) {
+	lrec_t* prec = lrec_unbacked_alloc();
+	pparser->key_builder.used_length = 0;
+	json_streaming_parser_parse_object(pparser, prec, 0);
+	return prec;
+}
+
+// The opening brace has been consumed. The key builder holds the prefix for the object's keys:
+// empty for the record itself, else the flattened key of the object followed by the flatten
+// separator. Example: for { "a": { "b" : 1, "c" : 2 } } we add "a:b" => "1" and "a:c" => "2" to
+// the record.
+//
+// Keys and values are copied into the record as soon as they have been found, before the next
+// structural is looked for, since in streaming mode that may move the input.
+static void json_streaming_parser_parse_object(json_streaming_parser_t* pparser, lrec_t* prec, int depth) {
+	string_builder_t* pkey_builder = &pparser->key_builder;
+	int prefix_length = pkey_builder->used_length;
+	int need_comma = FALSE;
+
+	char* p = next_structural(pparser, NULL);
+	while (TRUE) {
+		if (p != NULL && *p == '}')
+			break;
+		if (p != NULL && *p == ',' && need_comma) {
+			need_comma = FALSE;
+			p = next_structural(pparser, NULL);
+			continue;
+		}
+		if (p == NULL || *p != '"')
+			json_streaming_parser_fail_unexpected(pparser, p, "in object");
+		if (need_comma)
+			json_streaming_parser_fail_expected(pparser, ",", p);
+
+		// Top-level keys, having no prefix, go straight into the record.
+		char* key = NULL;
+		pkey_builder->used_length = prefix_length;
+		if (depth == 0)
+			key = json_streaming_parser_parse_string(pparser, prec, &p);
+		else
+			json_streaming_parser_append_string(pparser, pkey_builder, &p);
+
+		p = next_structural(pparser, NULL);
+		if (p == NULL || *p != ':')
+			json_streaming_parser_fail_expected(pparser, ":", p);
+
+		p = next_structural(pparser, NULL);
+		if (p != NULL && *p == '{') {
+			if (depth == 0)
+				sb_append_string(pkey_builder, key);
+			sb_append_string(pkey_builder, pparser->flatten_sep);
+			json_streaming_parser_parse_object(pparser, prec, depth + 1);
+			p = next_structural(pparser, NULL);
+
+		} else if (p != NULL && *p == '[') {
+			if (depth == 0) {
+				if (!pparser->json_skip_arrays_on_input) {
+					fprintf(stderr,
+						"%s: found array item within JSON object. This is valid but unmillerable JSON.\n"
+						"Use --json-skip-arrays-on-input to exclude these from input without fataling.\n",
+						MLR_GLOBALS.bargv0);
+					json_streaming_parser_fail_unmillerable();
+				}
+			} else {
+				fprintf(stderr,
+					"%s: found array item within JSON object. This is valid but unmillerable JSON.\n",
+					MLR_GLOBALS.bargv0);
+			}
+			json_type_t type = JSON_NONE;
+			p = json_streaming_parser_skip_value(pparser, p, &type);
+
+		} else {
+			char* value = NULL;
+			if (p != NULL && *p == '"') {
+				value = json_streaming_parser_parse_string(pparser, prec, &p);
+				p = next_structural(pparser, NULL);
+			} else {
+				char* end = NULL;
+				json_type_t type = JSON_NONE;
+				char* next = json_streaming_parser_parse_scalar(pparser, &p, &end, &type);
+				switch (type) {
+				case JSON_NULL:
+					value = "";
+					break;
+				case JSON_BOOLEAN:
+					value = (*p == 't') ? "true" : "false";
+					break;
+				default:
+					value = lrec_alloc_string(prec, end - p + 1);
+					memcpy(value, p, end - p);
+					value[end - p] = 0;
+					break;
+				}
+				p = next;
+			}
+			if (depth > 0) {
+				sb_append_char(pkey_builder, 0);
+				key = lrec_strdup(prec, pkey_builder->buffer);
+			}
+			lrec_put(prec, key, value, NO_FREE);
+		}
+
+		need_comma = TRUE;
+	}
+
+	pkey_builder->used_length = prefix_length;
+}
+
+// ----------------------------------------------------------------
+// *pp points to an opening quote. Returns a pointer to the closing quote; in streaming mode *pp is
+// updated if the input moves. Within a string, the closing quote is the only structural.
+static char* json_streaming_parser_find_close_quote(json_streaming_parser_t* pparser, char** pp) {
+	char* close = next_structural(pparser, pp);
+	if (close == NULL)
+		json_streaming_parser_fail(pparser, NULL, "Unexpected end of input in string");
+	return close;
+}
+
+// *pp points to an opening quote. Returns the string's contents, unescaped, in the record's storage.
+static char* json_streaming_parser_parse_string(json_streaming_parser_t* pparser, lrec_t* prec, char** pp) {
+	char* close = json_streaming_parser_find_close_quote(pparser, pp);
+	char* s = lrec_alloc_string(prec, close - *pp);
+	int length = json_streaming_parser_unescape(pparser, *pp, close, s);
+	s[length] = 0;
+	return s;
+}
+
+// *pp points to an opening quote. Appends the string's contents, unescaped, to the string builder.
+static void json_streaming_parser_append_string(json_streaming_parser_t* pparser, string_builder_t* psb,
+	char** pp)
+{
+	char* close = json_streaming_parser_find_close_quote(pparser, pp);
+	int used_length = psb->used_length;
+	// Makes room for the contents before unescaping over them.
+	sb_append_bytes(psb, *pp + 1, close - *pp - 1);
+	psb->used_length = used_length + json_streaming_parser_unescape(pparser, *pp, close, psb->buffer + used_length);
+}
+
+// Unescapes the contents of the string from the given quote up to close into dest, which must have
+// room for close - quote - 1 bytes, returning the unescaped length. Escapes are never shorter than
+// what they decode to.
+static int json_streaming_parser_unescape(json_streaming_parser_t* pparser, char* quote, char* close,
+	char* dest)
+{
+	char* s = quote + 1;
+	char* r = memchr(s, '\\', close - s);
+	if (r == NULL) {
+		memcpy(dest, s, close - s);
+		return close - s;
+	}
+
+	memcpy(dest, s, r - s);
+	char* w = dest + (r - s);
+	while (r < close) {
+		if (*r != '\\') {
+			*w++ = *r++;
+			continue;
+		}
+		// A backslash just before the closing quote would have escaped it.
+		r++;
+		switch (*r++) {
+		case 'b': *w++ = '\b'; break;
+		case 'f': *w++ = '\f'; break;
+		case 'n': *w++ = '\n'; break;
+		case 'r': *w++ = '\r'; break;
+		case 't': *w++ = '\t'; break;
+		case 'u': {
+			unsigned uchar = json_streaming_parser_parse_hex_quad(pparser, quote, r, close);
+			r += 4;
+			if ((uchar & 0xF800) == 0xD800) {
+				// UTF-16 surrogate pair
+				if (close - r < 2 || r[0] != '\\' || r[1] != 'u')
+					json_streaming_parser_fail(pparser, quote, "Unpaired UTF-16 surrogate in \\u escape");
+				unsigned uchar2 = json_streaming_parser_parse_hex_quad(pparser, quote, r + 2, close);
+				r += 6;
+				uchar = 0x10000 + ((uchar & 0x3FF) << 10) + (uchar2 & 0x3FF);
+			}
+			if (uchar <= 0x7F) {
+				*w++ = uchar;
+			} else if (uchar <= 0x7FF) {
+				*w++ = 0xC0 | (uchar >> 6);
+				*w++ = 0x80 | (uchar & 0x3F);
+			} else if (uchar <= 0xFFFF) {
+				*w++ = 0xE0 | (uchar >> 12);
+				*w++ = 0x80 | ((uchar >> 6) & 0x3F);
+				*w++ = 0x80 | (uchar & 0x3F);
+			} else {
+				*w++ = 0xF0 | (uchar >> 18);
+				*w++ = 0x80 | ((uchar >> 12) & 0x3F);
+				*w++ = 0x80 | ((uchar >> 6) & 0x3F);
+				*w++ = 0x80 | (uchar & 0x3F);
+			}
+			break;
+		}
+		default:
+			*w++ = r[-1];
+			break;
+		}
+	}
+	return w - dest;
+}
+
+// Errors are reported at the string's opening quote.
+static unsigned json_streaming_parser_parse_hex_quad(json_streaming_parser_t* pparser, char* quote, char* p,
+	char* close)
+{
+	unsigned value = 0;
+	for (int i = 0; i < 4; i++, p++) {
+		if (p >= close)
+			json_streaming_parser_fail(pparser, quote, "Unexpected `\"` in \\u escape");
+		int c = (unsigned char)*p;
+		unsigned nybble = 0;
+		if (c >= '0' && c <= '9') {
+			nybble = c - '0';
+		} else if (c >= 'a' && c <= 'f') {
+			nybble = c - 'a' + 10;
+		} else if (c >= 'A' && c <= 'F') {
+			nybble = c - 'A' + 10;
+		} else {
+			char buffer[BYTE_DESCRIPTION_SIZE];
+			json_streaming_parser_fail(pparser, quote, "Unexpected %s in \\u escape", describe_byte(p, buffer));
+		}
+		value = (value << 4) | nybble;
+	}
+	return value;
+}
+
+// ----------------------------------------------------------------
+// *pp points to the start of a number, boolean, or null, or is NULL at end of input. Checks the
+// scalar, setting its type and *ppend to its end. Returns the structural after it, or NULL at end
+// of input; in streaming mode *pp is updated if the input moves.
+static char* json_streaming_parser_parse_scalar(json_streaming_parser_t* pparser, char** pp, char** ppend,
+	json_type_t* ptype)
+{
+	int c = (*pp == NULL) ? EOF : (unsigned char)**pp;
+	if (!isdigit(c) && c != '-' && c != 't' && c != 'f' && c != 'n')
+		json_streaming_parser_fail_unexpected(pparser, *pp, "when seeking value");
+
+	// The scalar runs up to the next structural or whitespace.
+	char* next = next_structural(pparser, pp);
+	char* p = *pp;
+	char* limit = (next != NULL) ? next : pparser->end;
+	char* e = p;
+	while (e < limit && *e != ' ' && *e != '\t' && *e != '\n' && *e != '\r')
+		e++;
+	*ppend = e;
+
+	int length = e - p;
+	if (c == 't' || c == 'f') {
+		if (!(length == 4 && memcmp(p, "true", 4) == 0) && !(length == 5 && memcmp(p, "false", 5) == 0))
+			json_streaming_parser_fail(pparser, p, "Unknown value");
+		*ptype = JSON_BOOLEAN;
+	} else if (c == 'n') {
+		if (!(length == 4 && memcmp(p, "null", 4) == 0))
+			json_streaming_parser_fail(pparser, p, "Unknown value");
+		*ptype = JSON_NULL;
+	} else {
+		*ptype = json_number_type(p, e);
+		if (*ptype == JSON_NONE)
+			json_streaming_parser_fail(pparser, p, "Malformed number `%.*s`", length, p);
+	}
+	return next;
+}
+
+static inline int is_digit_at(char* p, char* end) {
+	return p < end && isdigit((unsigned char)*p);
+}
+
+// Matches [p, end) against -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?, returning JSON_INTEGER
+// or JSON_DOUBLE, or JSON_NONE if it doesn't match.
+static json_type_t json_number_type(char* p, char* end) {
+	json_type_t type = JSON_INTEGER;
+	if (p < end && *p == '-')
+		p++;
+	if (p < end && *p == '0') {
+		p++;
+	} else if (is_digit_at(p, end)) {
+		while (is_digit_at(p, end))
+			p++;
+	} else {
+		return JSON_NONE;
+	}
+	if (p < end && *p == '.') {
+		type = JSON_DOUBLE;
+		p++;
+		if (!is_digit_at(p, end))
+			return JSON_NONE;
+		while (is_digit_at(p, end))
+			p++;
+	}
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		type = JSON_DOUBLE;
+		p++;
+		if (p < end && (*p == '+' || *p == '-'))
+			p++;
+		if (!is_digit_at(p, end))
+			return JSON_NONE;
+		while (is_digit_at(p, end))
+			p++;
+	}
+	return (p == end) ? type : JSON_NONE;
+}
+
+// ----------------------------------------------------------------
+// Parses and discards a value of any type, starting at p, and sets its type. Returns the
+// structural after it, or NULL at end of input. This is for arrays, which are skipped, and for
+// describing unmillerable top-level values.
+static char* json_streaming_parser_skip_value(json_streaming_parser_t* pparser, char* p, json_type_t* ptype) {
+	int need_comma = FALSE;
+
+	if (p != NULL && *p == '{') {
+		p = next_structural(pparser, NULL);
+		while (TRUE) {
+			if (p != NULL && *p == '}') {
+				*ptype = JSON_OBJECT;
+				return next_structural(pparser, NULL);
+			}
+			if (p != NULL && *p == ',' && need_comma) {
+				need_comma = FALSE;
+				p = next_structural(pparser, NULL);
+				continue;
+			}
+			if (p == NULL || *p != '"')
+				json_streaming_parser_fail_unexpected(pparser, p, "in object");
+			if (need_comma)
+				json_streaming_parser_fail_expected(pparser, ",", p);
+			json_streaming_parser_find_close_quote(pparser, NULL);
+			p = next_structural(pparser, NULL);
+			if (p == NULL || *p != ':')
+				json_streaming_parser_fail_expected(pparser, ":", p);
+			json_type_t type = JSON_NONE;
+			p = json_streaming_parser_skip_value(pparser, next_structural(pparser, NULL), &type);
+			need_comma = TRUE;
+		}
+
+	} else if (p != NULL && *p == '[') {
+		p = next_structural(pparser, NULL);
+		while (TRUE) {
+			if (p != NULL && *p == ']') {
+				*ptype = JSON_ARRAY;
+				return next_structural(pparser, NULL);
+			}
+			if (p != NULL && *p == ',' && need_comma) {
+				need_comma = FALSE;
+				p = next_structural(pparser, NULL);
+				continue;
+			}
+			if (need_comma)
+				json_streaming_parser_fail_expected(pparser, ",", p);
+			json_type_t type = JSON_NONE;
+			p = json_streaming_parser_skip_value(pparser, p, &type);
+			need_comma = TRUE;
+		}
+
+	} else if (p != NULL && *p == '"') {
+		json_streaming_parser_find_close_quote(pparser, NULL);
+		*ptype = JSON_STRING;
+		return next_structural(pparser, NULL);
+
+	} else {
+		char* end = NULL;
+		return json_streaming_parser_parse_scalar(pparser, &p, &end, ptype);
+	}
+}
+
+// ----------------------------------------------------------------
+// Line numbers are only needed for error messages, so they're counted only then: lines in input
+// since discarded, plus those before the error position, or before the end of input if pos is
+// NULL.
+static void json_streaming_parser_fail(json_streaming_parser_t* pparser, char* pos, char* format, ...) {
+	char message[JSON_ERROR_MAX];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+	long long line_number = pparser->lines_before_start + 1LL
+		+ count_newlines(pparser->start, (pos != NULL) ? pos : pparser->end);
+	fprintf(stderr, "%s: Unable to parse JSON data: Line %lld: %s\n", MLR_GLOBALS.bargv0, line_number, message);
+	exit(1);
+}
+
+static void json_streaming_parser_fail_unexpected(json_streaming_parser_t* pparser, char* pos, char* where) {
+	char buffer[BYTE_DESCRIPTION_SIZE];
+	json_streaming_parser_fail(pparser, pos, "Unexpected %s %s", describe_byte(pos, buffer), where);
+}
+
+static void json_streaming_parser_fail_expected(json_streaming_parser_t* pparser, char* what, char* pos) {
+	char buffer[BYTE_DESCRIPTION_SIZE];
+	json_streaming_parser_fail(pparser, pos, "Expected %s before %s", what, describe_byte(pos, buffer));
+}
+
+static void json_streaming_parser_fail_unmillerable() {
+	fprintf(stderr, "%s: Unable to parse JSON data.\n", MLR_GLOBALS.bargv0);
+	exit(1);
+}
+
+static char* describe_byte(char* pos, char* buffer) {
+	if (pos == NULL)
+		return "end of input";
+	int c = (unsigned char)*pos;
+	if (isprint(c))
+		snprintf(buffer, BYTE_DESCRIPTION_SIZE, "`%c`", c);
+	else
+		snprintf(buffer, BYTE_DESCRIPTION_SIZE, "`0x%02x`", (unsigned)c);
+	return buffer;
+}
@@ -0,0 +1,89 @@
+// ================================================================
+// Incremental JSON parser for the JSON record-readers. Rather than parsing all the input into a
+// tree and then converting the tree to records, this tokenizes the input as it goes and returns one
+// record at a time: one per top-level object, or per object within a top-level array. Nested
+// objects are flattened into the record on the fly, with keys joined by the flatten separator,
+// e.g. { "a": { "b": 1, "c": 2 } } becomes the record a:b=1,a:c=2. Memory use is therefore
+// proportional to the largest record rather than to the input, and the first record is available
+// as soon as it has been read.
+//
+// Parsing is in two stages, after simdjson: lib/jsonscan.h finds the positions of the brackets,
+// colons, commas, quotes, and scalars in a few thousand bytes of input at a time using SIMD
+// instructions, and the parser here walks those positions without examining the bytes in between,
+// other than to unescape strings and check scalars.
+//
+// Input is either all in memory up front, as for the mmap reader, or read on demand into a buffer
+// owned by the parser, as for the stdio reader; in the latter case only the part of the input not
+// yet parsed is kept. Either way keys and values are copied into the record's own storage (see
+// lrec_strdup), so the input is never modified and need not outlive the records.
+//
+// As with json_parser.c, top-level items may be concatenated, e.g.
+//
+//   { "a" : 1 }
+//   { "b" : 2 }
+//
+// as well as wrapped in an array. Scalars are kept as they appear in the input, so floating-point
+// numbers retain however many decimal places the input has.
+//
+// Default behavior on arrays within records is to fatal; there is a command-line option to skip
+// them. Miller doesn't have an array object in its DSL, only maps, and converting JSON arrays to
+// int-keyed maps poses problems of irreversibility. (Namely, 'mlr --json cat foo.json' when
+// foo.json contains arrays would result in output differing from input.)
+// ================================================================
+
+#ifndef JSON_STREAMING_PARSER_H
+#define JSON_STREAMING_PARSER_H
+
+#include "containers/lrec.h"
+#include "lib/string_builder.h"
+#include "lib/jsonscan.h"
+
+// Should read up to size bytes into buffer, as with read(2), returning the number of bytes read,
+// or 0 at end of input.
+typedef int json_streaming_parser_read_func_t(void* pvhandle, char* buffer, int size);
+
+typedef struct _json_streaming_parser_t {
+	// The input in memory: all of it, or in streaming mode the part not yet parsed.
+	char* start;
+	char* end;
+	int   at_end_of_input;
+	json_streaming_parser_read_func_t* pread_func;
+	void* pvread_handle;
+	char* buffer;
+	int   buffer_size;
+	long long lines_before_start; // For error messages
+
+	// Structural index, from index_base, of the input from the last refill of the index up to
+	// scan_pos.
+	jsonscan_state_t scan_state;
+	char*     scan_pos;
+	char*     index_base;
+	unsigned* index;
+	int       index_count;
+	int       index_pos;
+
+	int at_start_of_input;
+	int in_top_level_array;
+	int need_comma;
+
+	char* flatten_sep;
+	int json_skip_arrays_on_input;
+
+	// Scratch space, reused from one record to the next: the current flattened key.
+	string_builder_t key_builder;
+} json_streaming_parser_t;
+
+json_streaming_parser_t* json_streaming_parser_alloc(char* flatten_sep, int json_skip_arrays_on_input);
+void json_streaming_parser_free(json_streaming_parser_t* pparser);
+
+// Starts on new input, all of which is in [start, end).
+void json_streaming_parser_reset_in_memory(json_streaming_parser_t* pparser, char* start, char* end);
+
+// Starts on new input, to be read using the given function.
+void json_streaming_parser_reset_streaming(json_streaming_parser_t* pparser,
+	json_streaming_parser_read_func_t* pread_func, void* pvread_handle);
+
+// Returns the next record, or NULL at end of input. Malformed or unmillerable input is fatal.
+lrec_t* json_streaming_parser_next(json_streaming_parser_t* pparser);
+
+#endif // JSON_STREAMING_PARSER_H
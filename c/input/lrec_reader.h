@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include "lib/context.h"
 #include "containers/lrec.h"
+#include "containers/sllv.h"
 #include "input/file_reader_mmap.h"
 
 struct _lrec_reader_t; // forward reference for method declarations
@@ -15,6 +16,16 @@ typedef lrec_t* lrec_reader_process_func_t(void* pvstate, void* pvhandle, contex
 typedef void    lrec_reader_sof_func_t(void* pvstate, void* pvhandle);
 typedef void    lrec_reader_free_func_t(struct _lrec_reader_t* preader);
 
+// Optional methods, for parallel parsing of mmapped input files (see stream.c). The split method
+// is called after the start-of-file hook and divides the rest of the file into chunks which can
+// be parsed independently of one another, consuming the handle. It returns a list of opaque chunk
+// handles, each to be freed by the caller using free(), or NULL if the input can't be split, in
+// which case the caller continues reading via the process method as usual. The chunk-process
+// method is then like the process method but takes a chunk handle; it may be called concurrently
+// from multiple threads as long as they operate on different chunks.
+typedef sllv_t* lrec_reader_split_func_t(void* pvstate, void* pvhandle, context_t* pctx, long long chunk_size);
+typedef lrec_t* lrec_reader_process_chunk_func_t(void* pvstate, void* pvchunk, context_t* pctx);
+
 typedef struct _lrec_reader_t {
 	void*                       pvstate;
 	lrec_reader_open_func_t*    popen_func;
@@ -22,6 +33,9 @@ typedef struct _lrec_reader_t {
 	lrec_reader_process_func_t* pprocess_func;
 	lrec_reader_sof_func_t*     psof_func;
 	lrec_reader_free_func_t*    pfree_func; // virtual destructor
+
+	lrec_reader_split_func_t*         psplit_func;         // may be null
+	lrec_reader_process_chunk_func_t* pprocess_chunk_func; // may be null
 } lrec_reader_t;
 
 #endif // LREC_READER_H
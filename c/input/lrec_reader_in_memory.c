@@ -30,6 +30,8 @@ lrec_reader_t* lrec_reader_in_memory_alloc(sllv_t* precords) {
 	plrec_reader->pprocess_func = lrec_reader_in_memory_process;
 	plrec_reader->psof_func     = lrec_reader_in_memory_sof;
 	plrec_reader->pfree_func    = lrec_reader_in_memory_free;
+	plrec_reader->psplit_func         = NULL;
+	plrec_reader->pprocess_chunk_func = NULL;
 
 	return plrec_reader;
 }
@@ -13,6 +13,7 @@
 #include "lib/mlr_globals.h"
 #include "lib/mlrutil.h"
 #include "lib/string_builder.h"
+#include "lib/sepscan.h"
 #include "input/file_reader_mmap.h"
 #include "input/lrec_readers.h"
 #include "input/peek_file_reader.h"
@@ -141,6 +142,8 @@ lrec_reader_t* lrec_reader_mmap_csv_alloc(char* irs, char* ifs, int use_implicit
 	plrec_reader->pprocess_func = lrec_reader_mmap_csv_process;
 	plrec_reader->psof_func     = lrec_reader_mmap_csv_sof;
 	plrec_reader->pfree_func    = lrec_reader_mmap_csv_free;
+	plrec_reader->psplit_func         = NULL;
+	plrec_reader->pprocess_chunk_func = NULL;
 
 	return plrec_reader;
 }
@@ -293,7 +296,9 @@ static int lrec_reader_mmap_csv_get_fields(lrec_reader_mmap_csv_state_t* pstate,
 					record_done = TRUE;
 					break;
 				} else {
-					e++;
+					// Every token in the no-dquote parse trie starts with one of these bytes.
+					e = sepscan_find(e + 1, phandle->eof, pstate->ifs[0], pstate->irs[0], pstate->dquote[0],
+						pstate->dquote[0]);
 				}
 			}
 
@@ -367,9 +372,12 @@ static int lrec_reader_mmap_csv_get_fields(lrec_reader_mmap_csv_state_t* pstate,
 					}
 					e += matchlen;
 				} else {
+					// Every token in the dquote parse trie starts with a dquote.
+					char* next = sepscan_find(e + 1, phandle->eof, pstate->dquote[0], pstate->dquote[0],
+						pstate->dquote[0], pstate->dquote[0]);
 					if (!contiguous)
-						sb_append_char(psb, *e);
-					e++;
+						sb_append_char_range(psb, e, next - 1);
+					e = next;
 				}
 			}
 		}
@@ -382,7 +390,7 @@ static int lrec_reader_mmap_csv_get_fields(lrec_reader_mmap_csv_state_t* pstate,
 // ----------------------------------------------------------------
 static lrec_t* paste_indices_and_data(lrec_reader_mmap_csv_state_t* pstate, rslls_t* pdata_fields, context_t* pctx) {
 	int idx = 0;
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_fields(pdata_fields->length);
 	for (rsllse_t* pd = pdata_fields->phead; idx < pdata_fields->length && pd != NULL; pd = pd->pnext) {
 		idx++;
 		char free_flags = pd->free_flag;
@@ -402,7 +410,7 @@ static lrec_t* paste_header_and_data(lrec_reader_mmap_csv_state_t* pstate, rslls
 			pctx->filename, pstate->ilno);
 		exit(1);
 	}
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_fields(pdata_fields->length);
 	sllse_t* ph  = pstate->pheader_keeper->pkeys->phead;
 	rsllse_t* pd = pdata_fields->phead;
 	for ( ; ph != NULL && pd != NULL; ph = ph->pnext, pd = pd->pnext) {
@@ -9,8 +9,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "lib/mlr_globals.h"
 #include "lib/mlrutil.h"
+#include "lib/sepscan.h"
 #include "containers/slls.h"
 #include "containers/lhmslv.h"
 #include "input/file_reader_mmap.h"
@@ -56,6 +58,13 @@ static void    lrec_reader_mmap_csvlite_free(lrec_reader_t* preader);
 static void    lrec_reader_mmap_csvlite_sof(void* pvstate, void* pvhandle);
 static lrec_t* lrec_reader_mmap_csvlite_process_single_seps(void* pvstate, void* pvhandle, context_t* pctx);
 static lrec_t* lrec_reader_mmap_csvlite_process_multi_seps(void* pvstate, void* pvhandle, context_t* pctx);
+static void    lrec_reader_mmap_csvlite_use_header(lrec_reader_mmap_csvlite_state_t* pstate, slls_t* pheader_fields,
+	context_t* pctx);
+static sllv_t* lrec_reader_mmap_csvlite_split(void* pvstate, void* pvhandle, context_t* pctx, long long chunk_size);
+static int     lrec_reader_mmap_csvlite_has_blank_line(file_reader_mmap_state_t* phandle,
+	lrec_reader_mmap_csvlite_state_t* pstate);
+static lrec_t* lrec_reader_mmap_csvlite_process_chunk_single_seps(void* pvstate, void* pvchunk, context_t* pctx);
+static lrec_t* lrec_reader_mmap_csvlite_process_chunk_multi_seps(void* pvstate, void* pvchunk, context_t* pctx);
 
 static slls_t* lrec_reader_mmap_csvlite_get_header_single_seps(file_reader_mmap_state_t* phandle,
 	lrec_reader_mmap_csvlite_state_t* pstate, context_t* pctx);
@@ -108,14 +117,21 @@ lrec_reader_t* lrec_reader_mmap_csvlite_alloc(char* irs, char* ifs, int allow_re
 		plrec_reader->pprocess_func = (pstate->ifslen == 1)
 			? lrec_reader_mmap_csvlite_process_single_seps
 			: lrec_reader_mmap_csvlite_process_multi_seps;
+		plrec_reader->pprocess_chunk_func = (pstate->ifslen == 1)
+			? lrec_reader_mmap_csvlite_process_chunk_single_seps
+			: lrec_reader_mmap_csvlite_process_chunk_multi_seps;
 	} else {
 		plrec_reader->pprocess_func = (pstate->irslen == 1 && pstate->ifslen == 1)
 			? lrec_reader_mmap_csvlite_process_single_seps
 			: lrec_reader_mmap_csvlite_process_multi_seps;
+		plrec_reader->pprocess_chunk_func = (pstate->irslen == 1 && pstate->ifslen == 1)
+			? lrec_reader_mmap_csvlite_process_chunk_single_seps
+			: lrec_reader_mmap_csvlite_process_chunk_multi_seps;
 	}
 
 	plrec_reader->psof_func     = lrec_reader_mmap_csvlite_sof;
 	plrec_reader->pfree_func    = lrec_reader_mmap_csvlite_free;
+	plrec_reader->psplit_func   = lrec_reader_mmap_csvlite_split;
 
 	return plrec_reader;
 }
@@ -151,24 +167,7 @@ static lrec_t* lrec_reader_mmap_csvlite_process_single_seps(void* pvstate, void*
 			if (pheader_fields == NULL) { // EOF
 				return NULL;
 			}
-
-			for (sllse_t* pe = pheader_fields->phead; pe != NULL; pe = pe->pnext) {
-				if (*pe->value == 0) {
-					fprintf(stderr, "%s: unacceptable empty CSV key at file \"%s\" line %lld.\n",
-						MLR_GLOBALS.bargv0, pctx->filename, pstate->ilno);
-					exit(1);
-				}
-			}
-
-			pstate->pheader_keeper = lhmslv_get(pstate->pheader_keepers, pheader_fields);
-			if (pstate->pheader_keeper == NULL) {
-				pstate->pheader_keeper = header_keeper_alloc(NULL, pheader_fields);
-				lhmslv_put(pstate->pheader_keepers, pheader_fields, pstate->pheader_keeper,
-					NO_FREE); // freed by header-keeper
-			} else { // Re-use the header-keeper in the header cache
-				slls_free(pheader_fields);
-			}
-			pstate->expect_header_line_next = FALSE;
+			lrec_reader_mmap_csvlite_use_header(pstate, pheader_fields, pctx);
 		}
 
 		int end_of_stanza = FALSE;
@@ -197,24 +196,7 @@ static lrec_t* lrec_reader_mmap_csvlite_process_multi_seps(void* pvstate, void*
 			slls_t* pheader_fields = lrec_reader_mmap_csvlite_get_header_multi_seps(phandle, pstate);
 			if (pheader_fields == NULL) // EOF
 				return NULL;
-
-			for (sllse_t* pe = pheader_fields->phead; pe != NULL; pe = pe->pnext) {
-				if (*pe->value == 0) {
-					fprintf(stderr, "%s: unacceptable empty CSV key at file \"%s\" line %lld.\n",
-						MLR_GLOBALS.bargv0, pctx->filename, pstate->ilno);
-					exit(1);
-				}
-			}
-
-			pstate->pheader_keeper = lhmslv_get(pstate->pheader_keepers, pheader_fields);
-			if (pstate->pheader_keeper == NULL) {
-				pstate->pheader_keeper = header_keeper_alloc(NULL, pheader_fields);
-				lhmslv_put(pstate->pheader_keepers, pheader_fields, pstate->pheader_keeper,
-					NO_FREE); // freed by header-keeper
-			} else { // Re-use the header-keeper in the header cache
-				slls_free(pheader_fields);
-			}
-			pstate->expect_header_line_next = FALSE;
+			lrec_reader_mmap_csvlite_use_header(pstate, pheader_fields, pctx);
 		}
 
 		int end_of_stanza = FALSE;
@@ -233,6 +215,106 @@ static lrec_t* lrec_reader_mmap_csvlite_process_multi_seps(void* pvstate, void*
 	}
 }
 
+// ----------------------------------------------------------------
+static void lrec_reader_mmap_csvlite_use_header(lrec_reader_mmap_csvlite_state_t* pstate, slls_t* pheader_fields,
+	context_t* pctx)
+{
+	for (sllse_t* pe = pheader_fields->phead; pe != NULL; pe = pe->pnext) {
+		if (*pe->value == 0) {
+			fprintf(stderr, "%s: unacceptable empty CSV key at file \"%s\" line %lld.\n",
+				MLR_GLOBALS.bargv0, pctx->filename, pstate->ilno);
+			exit(1);
+		}
+	}
+
+	pstate->pheader_keeper = lhmslv_get(pstate->pheader_keepers, pheader_fields);
+	if (pstate->pheader_keeper == NULL) {
+		pstate->pheader_keeper = header_keeper_alloc(NULL, pheader_fields);
+		lhmslv_put(pstate->pheader_keepers, pheader_fields, pstate->pheader_keeper,
+			NO_FREE); // freed by header-keeper
+	} else { // Re-use the header-keeper in the header cache
+		slls_free(pheader_fields);
+	}
+	pstate->expect_header_line_next = FALSE;
+}
+
+// ----------------------------------------------------------------
+// For parallel parsing the header line is read here, serially, after which the data lines are
+// split into chunks which share the now-read-only header keeper. Each chunk gets a private copy of
+// the reader state for line-counting. A schema change (blank line followed by a new header line)
+// can't be handled this way, since the header in effect at the start of a chunk would depend on
+// the chunks before it, so files with blank lines are read serially. Likewise for implicit
+// headers.
+typedef struct _lrec_reader_mmap_csvlite_chunk_t {
+	file_reader_mmap_state_t         handle;
+	lrec_reader_mmap_csvlite_state_t state;
+} lrec_reader_mmap_csvlite_chunk_t;
+
+static sllv_t* lrec_reader_mmap_csvlite_split(void* pvstate, void* pvhandle, context_t* pctx, long long chunk_size) {
+	file_reader_mmap_state_t* phandle = pvhandle;
+	lrec_reader_mmap_csvlite_state_t* pstate = pvstate;
+
+	if (pstate->use_implicit_header || !pstate->expect_header_line_next)
+		return NULL;
+
+	slls_t* pheader_fields = (pstate->irslen == 1 && pstate->ifslen == 1)
+		? lrec_reader_mmap_csvlite_get_header_single_seps(phandle, pstate, pctx)
+		: lrec_reader_mmap_csvlite_get_header_multi_seps(phandle, pstate);
+	lrec_reader_mmap_csvlite_use_header(pstate, pheader_fields, pctx);
+
+	if (lrec_reader_mmap_csvlite_has_blank_line(phandle, pstate))
+		return NULL;
+
+	sllv_t* phandles = file_reader_mmap_split(phandle, pstate->irs, pstate->irslen, chunk_size);
+	sllv_t* pchunks = sllv_alloc();
+	for (sllve_t* pe = phandles->phead; pe != NULL; pe = pe->pnext) {
+		file_reader_mmap_state_t* pchunk_handle = pe->pvvalue;
+		lrec_reader_mmap_csvlite_chunk_t* pchunk = mlr_malloc_or_die(sizeof(lrec_reader_mmap_csvlite_chunk_t));
+		pchunk->handle = *pchunk_handle;
+		pchunk->state = *pstate;
+		sllv_append(pchunks, pchunk);
+		free(pchunk_handle);
+	}
+	sllv_free(phandles);
+	return pchunks;
+}
+
+static int lrec_reader_mmap_csvlite_has_blank_line(file_reader_mmap_state_t* phandle,
+	lrec_reader_mmap_csvlite_state_t* pstate)
+{
+	char* irs  = pstate->irs;
+	int irslen = pstate->irslen;
+	char* p    = phandle->sol;
+	char* eof  = phandle->eof;
+	while (p < eof) {
+		p = memchr(p, irs[0], eof - p);
+		if (p == NULL)
+			return FALSE;
+		if (eof - p >= 2*irslen && memcmp(p, irs, irslen) == 0 && memcmp(p + irslen, irs, irslen) == 0)
+			return TRUE;
+		p++;
+	}
+	return FALSE;
+}
+
+static lrec_t* lrec_reader_mmap_csvlite_process_chunk_single_seps(void* pvstate, void* pvchunk, context_t* pctx) {
+	lrec_reader_mmap_csvlite_chunk_t* pchunk = pvchunk;
+	int end_of_stanza = FALSE;
+	lrec_t* prec = lrec_reader_mmap_csvlite_get_record_single_seps(&pchunk->handle, &pchunk->state, pctx,
+		pchunk->state.pheader_keeper, &end_of_stanza);
+	MLR_INTERNAL_CODING_ERROR_IF(end_of_stanza); // Files with blank lines aren't split
+	return prec;
+}
+
+static lrec_t* lrec_reader_mmap_csvlite_process_chunk_multi_seps(void* pvstate, void* pvchunk, context_t* pctx) {
+	lrec_reader_mmap_csvlite_chunk_t* pchunk = pvchunk;
+	int end_of_stanza = FALSE;
+	lrec_t* prec = lrec_reader_mmap_csvlite_get_record_multi_seps(&pchunk->handle, &pchunk->state, pctx,
+		pchunk->state.pheader_keeper, &end_of_stanza);
+	MLR_INTERNAL_CODING_ERROR_IF(end_of_stanza); // Files with blank lines aren't split
+	return prec;
+}
+
 // ----------------------------------------------------------------
 static slls_t* lrec_reader_mmap_csvlite_get_header_single_seps(file_reader_mmap_state_t* phandle,
 	lrec_reader_mmap_csvlite_state_t* pstate, context_t* pctx)
@@ -284,7 +366,7 @@ static slls_t* lrec_reader_mmap_csvlite_get_header_single_seps(file_reader_mmap_
 			}
 			header_name = p;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs, ifs, ifs, ifs);
 		}
 	}
 	if (allow_repeat_ifs && *header_name == 0) {
@@ -340,7 +422,7 @@ static slls_t* lrec_reader_mmap_csvlite_get_header_multi_seps(file_reader_mmap_s
 			}
 			header_name = p;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs[0], ifs[0], ifs[0], ifs[0]);
 		}
 	}
 	if (allow_repeat_ifs && *header_name == 0) {
@@ -365,7 +447,7 @@ static lrec_t* lrec_reader_mmap_csvlite_get_record_single_seps(file_reader_mmap_
 	char ifs = pstate->ifs[0];
 	int allow_repeat_ifs = pstate->allow_repeat_ifs;
 
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_fields(pheader_keeper->pkeys->length);
 
 	char* line  = phandle->sol;
 
@@ -418,7 +500,7 @@ static lrec_t* lrec_reader_mmap_csvlite_get_record_single_seps(file_reader_mmap_
 			}
 			value = p;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs, ifs, ifs, ifs);
 		}
 	}
 	if (p >= phandle->eof)
@@ -468,7 +550,7 @@ static lrec_t* lrec_reader_mmap_csvlite_get_record_multi_seps(file_reader_mmap_s
 	int   ifslen = pstate->ifslen;
 	int allow_repeat_ifs = pstate->allow_repeat_ifs;
 
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_fields(pheader_keeper->pkeys->length);
 
 	char* line  = phandle->sol;
 
@@ -511,7 +593,7 @@ static lrec_t* lrec_reader_mmap_csvlite_get_record_multi_seps(file_reader_mmap_s
 			}
 			value = p;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs[0], ifs[0], ifs[0], ifs[0]);
 		}
 	}
 	if (p >= phandle->eof)
@@ -560,7 +642,7 @@ static lrec_t* lrec_reader_mmap_csvlite_get_record_single_seps_implicit_header(f
 	char ifs = pstate->ifs[0];
 	int allow_repeat_ifs = pstate->allow_repeat_ifs;
 
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	char* line  = phandle->sol;
 
@@ -607,7 +689,7 @@ static lrec_t* lrec_reader_mmap_csvlite_get_record_single_seps_implicit_header(f
 			}
 			value = p;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs, ifs, ifs, ifs);
 		}
 	}
 	if (p >= phandle->eof)
@@ -646,7 +728,7 @@ static lrec_t* lrec_reader_mmap_csvlite_get_record_multi_seps_implicit_header(fi
 	int   ifslen = pstate->ifslen;
 	int allow_repeat_ifs = pstate->allow_repeat_ifs;
 
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	char* line  = phandle->sol;
 
@@ -684,7 +766,7 @@ static lrec_t* lrec_reader_mmap_csvlite_get_record_multi_seps_implicit_header(fi
 			}
 			value = p;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs[0], ifs[0], ifs[0], ifs[0]);
 		}
 	}
 	if (p >= phandle->eof)
@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include "lib/mlr_globals.h"
 #include "lib/mlrutil.h"
+#include "lib/sepscan.h"
 #include "input/file_reader_mmap.h"
 #include "input/lrec_readers.h"
 
@@ -27,6 +28,7 @@ typedef struct _lrec_reader_mmap_dkvp_state_t {
 
 static void    lrec_reader_mmap_dkvp_free(lrec_reader_t* preader);
 static void    lrec_reader_mmap_dkvp_sof(void* pvstate, void* pvhandle);
+static sllv_t* lrec_reader_mmap_dkvp_split(void* pvstate, void* pvhandle, context_t* pctx, long long chunk_size);
 static lrec_t* lrec_reader_mmap_dkvp_process_single_irs_single_others(void* pvstate, void* pvhandle, context_t* pctx);
 static lrec_t* lrec_reader_mmap_dkvp_process_single_irs_multi_others(void* pvstate, void* pvhandle, context_t* pctx);
 static lrec_t* lrec_reader_mmap_dkvp_process_multi_irs_single_others(void* pvstate, void* pvhandle, context_t* pctx);
@@ -71,6 +73,10 @@ lrec_reader_t* lrec_reader_mmap_dkvp_alloc(char* irs, char* ifs, char* ips, int
 	}
 	plrec_reader->psof_func   = lrec_reader_mmap_dkvp_sof;
 	plrec_reader->pfree_func  = lrec_reader_mmap_dkvp_free;
+	// This reader's state is read-only after construction, so chunks can be parsed concurrently
+	// using the ordinary process method.
+	plrec_reader->psplit_func         = lrec_reader_mmap_dkvp_split;
+	plrec_reader->pprocess_chunk_func = plrec_reader->pprocess_func;
 
 	return plrec_reader;
 }
@@ -84,6 +90,11 @@ static void lrec_reader_mmap_dkvp_free(lrec_reader_t* preader) {
 static void lrec_reader_mmap_dkvp_sof(void* pvstate, void* pvhandle) {
 }
 
+static sllv_t* lrec_reader_mmap_dkvp_split(void* pvstate, void* pvhandle, context_t* pctx, long long chunk_size) {
+	lrec_reader_mmap_dkvp_state_t* pstate = pvstate;
+	return file_reader_mmap_split(pvhandle, pstate->irs, pstate->irslen, chunk_size);
+}
+
 // ----------------------------------------------------------------
 static lrec_t* lrec_reader_mmap_dkvp_process_single_irs_single_others(void* pvstate, void* pvhandle, context_t* pctx) {
 	file_reader_mmap_state_t* phandle = pvhandle;
@@ -129,7 +140,7 @@ static lrec_t* lrec_reader_mmap_dkvp_process_multi_irs_multi_others(void* pvstat
 lrec_t* lrec_parse_mmap_dkvp_single_irs_single_others(file_reader_mmap_state_t *phandle,
 	char irs, char ifs, char ips, int allow_repeat_ifs, int do_auto_line_term, context_t* pctx)
 {
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	char* line  = phandle->sol;
 
@@ -190,7 +201,7 @@ lrec_t* lrec_parse_mmap_dkvp_single_irs_single_others(file_reader_mmap_state_t *
 			value = p;
 			saw_ps = TRUE;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs, ifs, ips, ips);
 		}
 	}
 	if (p >= phandle->eof)
@@ -247,7 +258,7 @@ lrec_t* lrec_parse_mmap_dkvp_single_irs_single_others(file_reader_mmap_state_t *
 lrec_t* lrec_parse_mmap_dkvp_multi_irs_single_others(file_reader_mmap_state_t *phandle,
 	char* irs, char ifs, char ips, int irslen, int allow_repeat_ifs, context_t* pctx)
 {
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	char* line  = phandle->sol;
 
@@ -298,7 +309,7 @@ lrec_t* lrec_parse_mmap_dkvp_multi_irs_single_others(file_reader_mmap_state_t *p
 			value = p;
 			saw_ps = TRUE;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs[0], ifs, ips, ips);
 		}
 	}
 	if (p >= phandle->eof)
@@ -355,7 +366,7 @@ lrec_t* lrec_parse_mmap_dkvp_multi_irs_single_others(file_reader_mmap_state_t *p
 lrec_t* lrec_parse_mmap_dkvp_single_irs_multi_others(file_reader_mmap_state_t *phandle, char irs, char* ifs, char* ips,
 	int ifslen, int ipslen, int allow_repeat_ifs, int do_auto_line_term, context_t* pctx)
 {
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	char* line  = phandle->sol;
 
@@ -416,7 +427,7 @@ lrec_t* lrec_parse_mmap_dkvp_single_irs_multi_others(file_reader_mmap_state_t *p
 			value = p;
 			saw_ps = TRUE;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs, ifs[0], ips[0], ips[0]);
 		}
 	}
 	*p = 0;
@@ -474,7 +485,7 @@ lrec_t* lrec_parse_mmap_dkvp_single_irs_multi_others(file_reader_mmap_state_t *p
 lrec_t* lrec_parse_mmap_dkvp_multi_irs_multi_others(file_reader_mmap_state_t *phandle,
 	char* irs, char* ifs, char* ips, int irslen, int ifslen, int ipslen, int allow_repeat_ifs, context_t* pctx)
 {
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	char* line  = phandle->sol;
 
@@ -525,7 +536,7 @@ lrec_t* lrec_parse_mmap_dkvp_multi_irs_multi_others(file_reader_mmap_state_t *ph
 			value = p;
 			saw_ps = TRUE;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs[0], ifs[0], ips[0], ips[0]);
 		}
 	}
 	if (p >= phandle->eof)
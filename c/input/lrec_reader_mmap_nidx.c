@@ -9,6 +9,7 @@
 
 #include <stdlib.h>
 #include "lib/mlrutil.h"
+#include "lib/sepscan.h"
 #include "input/file_reader_mmap.h"
 #include "input/lrec_readers.h"
 
@@ -23,6 +24,7 @@ typedef struct _lrec_reader_mmap_nidx_state_t {
 
 static void    lrec_reader_mmap_nidx_free(lrec_reader_t* preader);
 static void    lrec_reader_mmap_nidx_sof(void* pvstate, void* pvhandle);
+static sllv_t* lrec_reader_mmap_nidx_split(void* pvstate, void* pvhandle, context_t* pctx, long long chunk_size);
 static lrec_t* lrec_reader_mmap_nidx_process_single_irs_single_ifs(void* pvstate, void* pvhandle, context_t* pctx);
 static lrec_t* lrec_reader_mmap_nidx_process_single_irs_multi_ifs(void* pvstate, void* pvhandle, context_t* pctx);
 static lrec_t* lrec_reader_mmap_nidx_process_multi_irs_single_ifs(void* pvstate, void* pvhandle, context_t* pctx);
@@ -67,6 +69,10 @@ lrec_reader_t* lrec_reader_mmap_nidx_alloc(char* irs, char* ifs, int allow_repea
 
 	plrec_reader->psof_func     = lrec_reader_mmap_nidx_sof;
 	plrec_reader->pfree_func    = lrec_reader_mmap_nidx_free;
+	// This reader's state is read-only after construction, so chunks can be parsed concurrently
+	// using the ordinary process method.
+	plrec_reader->psplit_func         = lrec_reader_mmap_nidx_split;
+	plrec_reader->pprocess_chunk_func = plrec_reader->pprocess_func;
 
 	return plrec_reader;
 }
@@ -80,6 +86,11 @@ static void lrec_reader_mmap_nidx_free(lrec_reader_t* preader) {
 static void lrec_reader_mmap_nidx_sof(void* pvstate, void* pvhandle) {
 }
 
+static sllv_t* lrec_reader_mmap_nidx_split(void* pvstate, void* pvhandle, context_t* pctx, long long chunk_size) {
+	lrec_reader_mmap_nidx_state_t* pstate = pvstate;
+	return file_reader_mmap_split(pvhandle, pstate->irs, pstate->irslen, chunk_size);
+}
+
 // ----------------------------------------------------------------
 static lrec_t* lrec_reader_mmap_nidx_process_single_irs_single_ifs(void* pvstate, void* pvhandle, context_t* pctx) {
 	file_reader_mmap_state_t* phandle = pvhandle;
@@ -125,7 +136,7 @@ static lrec_t* lrec_reader_mmap_nidx_process_multi_irs_multi_ifs(void* pvstate,
 lrec_t* lrec_parse_mmap_nidx_single_irs_single_ifs(file_reader_mmap_state_t *phandle,
 	char irs, char ifs, int allow_repeat_ifs, int do_auto_line_term, context_t* pctx)
 {
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	char* line  = phandle->sol;
 	int idx = 0;
@@ -169,7 +180,7 @@ lrec_t* lrec_parse_mmap_nidx_single_irs_single_ifs(file_reader_mmap_state_t *pha
 			}
 			value = p;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs, ifs, ifs, ifs);
 		}
 	}
 	if (p >= phandle->eof)
@@ -200,7 +211,7 @@ lrec_t* lrec_parse_mmap_nidx_single_irs_single_ifs(file_reader_mmap_state_t *pha
 lrec_t* lrec_parse_mmap_nidx_single_irs_multi_ifs(file_reader_mmap_state_t *phandle,
 	char irs, char* ifs, int ifslen, int allow_repeat_ifs, int do_auto_line_term, context_t* pctx)
 {
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	char* line  = phandle->sol;
 	int idx = 0;
@@ -244,7 +255,7 @@ lrec_t* lrec_parse_mmap_nidx_single_irs_multi_ifs(file_reader_mmap_state_t *phan
 			}
 			value = p;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs, ifs[0], ifs[0], ifs[0]);
 		}
 	}
 	if (p >= phandle->eof)
@@ -275,7 +286,7 @@ lrec_t* lrec_parse_mmap_nidx_single_irs_multi_ifs(file_reader_mmap_state_t *phan
 lrec_t* lrec_parse_mmap_nidx_multi_irs_single_ifs(file_reader_mmap_state_t *phandle,
 	char* irs, char ifs, int irslen, int allow_repeat_ifs)
 {
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	char* line  = phandle->sol;
 	int idx = 0;
@@ -309,7 +320,7 @@ lrec_t* lrec_parse_mmap_nidx_multi_irs_single_ifs(file_reader_mmap_state_t *phan
 			}
 			value = p;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs[0], ifs, ifs, ifs);
 		}
 	}
 	if (p >= phandle->eof)
@@ -340,7 +351,7 @@ lrec_t* lrec_parse_mmap_nidx_multi_irs_single_ifs(file_reader_mmap_state_t *phan
 lrec_t* lrec_parse_mmap_nidx_multi_irs_multi_ifs(file_reader_mmap_state_t *phandle,
 	char* irs, char* ifs, int irslen, int ifslen, int allow_repeat_ifs)
 {
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	char* line  = phandle->sol;
 	int idx = 0;
@@ -374,7 +385,7 @@ lrec_t* lrec_parse_mmap_nidx_multi_irs_multi_ifs(file_reader_mmap_state_t *phand
 			}
 			value = p;
 		} else {
-			p++;
+			p = sepscan_find(p + 1, phandle->eof, irs[0], ifs[0], ifs[0], ifs[0]);
 		}
 	}
 	if (p >= phandle->eof)
@@ -68,6 +68,8 @@ lrec_reader_t* lrec_reader_mmap_xtab_alloc(char* ifs, char* ips, int allow_repea
 
 	plrec_reader->psof_func     = lrec_reader_mmap_xtab_sof;
 	plrec_reader->pfree_func    = lrec_reader_mmap_xtab_free;
+	plrec_reader->psplit_func         = NULL;
+	plrec_reader->pprocess_chunk_func = NULL;
 
 	return plrec_reader;
 }
@@ -153,7 +155,7 @@ lrec_t* lrec_parse_mmap_xtab_single_ifs_single_ips(file_reader_mmap_state_t* pha
 	if (phandle->sol >= phandle->eof)
 		return NULL;
 
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	// Loop over fields, one per line
 	while (TRUE) {
@@ -263,7 +265,7 @@ lrec_t* lrec_parse_mmap_xtab_single_ifs_multi_ips(file_reader_mmap_state_t* phan
 	if (phandle->sol >= phandle->eof)
 		return NULL;
 
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	// Loop over fields, one per line
 	while (TRUE) {
@@ -340,7 +342,7 @@ lrec_t* lrec_parse_mmap_xtab_multi_ifs_single_ips(file_reader_mmap_state_t* phan
 	if (phandle->sol >= phandle->eof)
 		return NULL;
 
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	// Loop over fields, one per line
 	while (TRUE) {
@@ -407,7 +409,7 @@ lrec_t* lrec_parse_mmap_xtab_multi_ifs_multi_ips(file_reader_mmap_state_t* phand
 	if (phandle->sol >= phandle->eof)
 		return NULL;
 
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_line_length(file_reader_mmap_guess_record_length(phandle));
 
 	// Loop over fields, one per line
 	while (TRUE) {
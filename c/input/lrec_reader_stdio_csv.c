@@ -158,6 +158,8 @@ lrec_reader_t* lrec_reader_stdio_csv_alloc(char* irs, char* ifs, int use_implici
 	plrec_reader->pprocess_func = lrec_reader_stdio_csv_process;
 	plrec_reader->psof_func     = lrec_reader_stdio_csv_sof;
 	plrec_reader->pfree_func    = lrec_reader_stdio_csv_free;
+	plrec_reader->psplit_func         = NULL;
+	plrec_reader->pprocess_chunk_func = NULL;
 
 	return plrec_reader;
 }
@@ -401,7 +403,7 @@ static int lrec_reader_stdio_csv_get_fields(lrec_reader_stdio_csv_state_t* pstat
 static lrec_t* paste_indices_and_data(lrec_reader_stdio_csv_state_t* pstate, rslls_t* pdata_fields,
 	context_t* pctx)
 {
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_fields(pdata_fields->length);
 	int idx = 0;
 	for (rsllse_t* pd = pdata_fields->phead; pd != NULL; pd = pd->pnext) {
 		idx++;
@@ -424,7 +426,7 @@ static lrec_t* paste_header_and_data(lrec_reader_stdio_csv_state_t* pstate, rsll
 			pctx->filename, pstate->ilno);
 		exit(1);
 	}
-	lrec_t* prec = lrec_unbacked_alloc();
+	lrec_t* prec = lrec_unbacked_alloc_for_fields(pdata_fields->length);
 	sllse_t* ph = pstate->pheader_keeper->pkeys->phead;
 	rsllse_t* pd = pdata_fields->phead;
 	for ( ; ph != NULL && pd != NULL; ph = ph->pnext, pd = pd->pnext) {
@@ -77,6 +77,8 @@ lrec_reader_t* lrec_reader_stdio_dkvp_alloc(char* irs, char* ifs, char* ips, int
 	}
 	plrec_reader->psof_func     = lrec_reader_stdio_dkvp_sof;
 	plrec_reader->pfree_func    = lrec_reader_stdio_dkvp_free;
+	plrec_reader->psplit_func         = NULL;
+	plrec_reader->pprocess_chunk_func = NULL;
 
 	return plrec_reader;
 }
@@ -65,6 +65,8 @@ lrec_reader_t* lrec_reader_stdio_nidx_alloc(char* irs, char* ifs, int allow_repe
 	}
 	plrec_reader->psof_func     = lrec_reader_stdio_nidx_sof;
 	plrec_reader->pfree_func    = lrec_reader_stdio_nidx_free;
+	plrec_reader->psplit_func         = NULL;
+	plrec_reader->pprocess_chunk_func = NULL;
 
 	return plrec_reader;
 }
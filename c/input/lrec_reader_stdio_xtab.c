@@ -53,6 +53,8 @@ lrec_reader_t* lrec_reader_stdio_xtab_alloc(char* ifs, char* ips, int allow_repe
 	plrec_reader->pprocess_func = lrec_reader_stdio_xtab_process;
 	plrec_reader->psof_func     = lrec_reader_stdio_xtab_sof;
 	plrec_reader->pfree_func    = lrec_reader_stdio_xtab_free;
+	plrec_reader->psplit_func         = NULL;
+	plrec_reader->pprocess_chunk_func = NULL;
 
 	return plrec_reader;
 }
@@ -0,0 +1,230 @@
+#include <stdlib.h>
+#include "lib/sepscan.h"
+#include "lib/jsonscan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define JSONSCAN_X86
+#include <immintrin.h>
+#endif
+
+static int jsonscan_index_resolve(char* p, int nblocks, jsonscan_state_t* pstate, unsigned* pindex);
+
+jsonscan_index_func_t* _jsonscan_index_dispatched = jsonscan_index_resolve;
+
+// ----------------------------------------------------------------
+void jsonscan_state_init(jsonscan_state_t* pstate) {
+	pstate->prev_escaped   = 0ULL;
+	pstate->prev_in_string = 0ULL;
+	pstate->prev_scalar    = 0ULL;
+}
+
+// ----------------------------------------------------------------
+// Given the positions of backslashes in a block, returns the positions of the bytes they escape:
+// those following an odd-length run of backslashes. Runs starting at even positions end at odd
+// positions after an odd number of backslashes, and vice versa, which adding each run's first bit
+// to the run exposes as a carry out of its last bit.
+static inline uint64_t jsonscan_find_escaped(uint64_t backslash, jsonscan_state_t* pstate) {
+	const uint64_t even_bits = 0x5555555555555555ULL;
+	const uint64_t odd_bits = ~even_bits;
+
+	uint64_t start_edges = backslash & ~(backslash << 1);
+	// A run continuing from the previous block effectively starts one position earlier.
+	uint64_t even_start_mask = even_bits ^ pstate->prev_escaped;
+	uint64_t even_starts = start_edges & even_start_mask;
+	uint64_t odd_starts = start_edges & ~even_start_mask;
+
+	uint64_t even_carries = backslash + even_starts;
+	uint64_t odd_carries = backslash + odd_starts;
+	uint64_t overflow = odd_carries < backslash;
+	odd_carries |= pstate->prev_escaped;
+	pstate->prev_escaped = overflow;
+
+	uint64_t even_carry_ends = even_carries & ~backslash;
+	uint64_t odd_carry_ends = odd_carries & ~backslash;
+	return (even_carry_ends & odd_bits) | (odd_carry_ends & even_bits);
+}
+
+// Bit i of the result is the parity of bits 0 through i of x.
+static inline uint64_t jsonscan_prefix_xor(uint64_t x) {
+	x ^= x << 1;
+	x ^= x << 2;
+	x ^= x << 4;
+	x ^= x << 8;
+	x ^= x << 16;
+	x ^= x << 32;
+	return x;
+}
+
+// From the per-byte classification of a block, computes the positions of its structural bytes.
+static inline uint64_t jsonscan_find_structurals(uint64_t quote, uint64_t backslash, uint64_t op,
+	uint64_t whitespace, jsonscan_state_t* pstate)
+{
+	quote &= ~jsonscan_find_escaped(backslash, pstate);
+
+	// Set from each opening quote up to but not including its closing quote.
+	uint64_t in_string = jsonscan_prefix_xor(quote) ^ pstate->prev_in_string;
+	pstate->prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+
+	uint64_t scalar = ~(in_string | quote | op | whitespace);
+	uint64_t scalar_starts = scalar & ~((scalar << 1) | pstate->prev_scalar);
+	pstate->prev_scalar = scalar >> 63;
+
+	return (op & ~in_string) | quote | scalar_starts;
+}
+
+// Structurals are typically every few bytes in JSON, so a loop per set bit would mispredict
+// often. Instead positions are written four at a time, with the loop count depending only on
+// the population count: writes past the last set bit are junk, to be overwritten or ignored.
+#ifdef __GNUC__
+static inline int jsonscan_emit(uint64_t structurals, unsigned base, unsigned* pindex) {
+	int n = __builtin_popcountll(structurals);
+	for (int i = 0; i < n; i += 4) {
+		pindex[i]     = base + __builtin_ctzll(structurals | (1ULL << 63));
+		structurals  &= structurals - 1ULL;
+		pindex[i + 1] = base + __builtin_ctzll(structurals | (1ULL << 63));
+		structurals  &= structurals - 1ULL;
+		pindex[i + 2] = base + __builtin_ctzll(structurals | (1ULL << 63));
+		structurals  &= structurals - 1ULL;
+		pindex[i + 3] = base + __builtin_ctzll(structurals | (1ULL << 63));
+		structurals  &= structurals - 1ULL;
+	}
+	return n;
+}
+#else
+static inline int jsonscan_emit(uint64_t structurals, unsigned base, unsigned* pindex) {
+	int n = 0;
+	for (unsigned i = 0; structurals != 0ULL; i++, structurals >>= 1) {
+		if (structurals & 1ULL)
+			pindex[n++] = base + i;
+	}
+	return n;
+}
+#endif
+
+// ----------------------------------------------------------------
+int jsonscan_index_scalar(char* p, int nblocks, jsonscan_state_t* pstate, unsigned* pindex) {
+	int n = 0;
+	for (int b = 0; b < nblocks; b++) {
+		char* block = p + b * JSONSCAN_BLOCK_SIZE;
+		uint64_t quote = 0ULL, backslash = 0ULL, op = 0ULL, whitespace = 0ULL;
+		for (int i = 0; i < JSONSCAN_BLOCK_SIZE; i++) {
+			uint64_t bit = 1ULL << i;
+			switch (block[i]) {
+			case '"':
+				quote |= bit;
+				break;
+			case '\\':
+				backslash |= bit;
+				break;
+			case '{': case '}': case '[': case ']': case ':': case ',':
+				op |= bit;
+				break;
+			case ' ': case '\t': case '\n': case '\r':
+				whitespace |= bit;
+				break;
+			}
+		}
+		uint64_t structurals = jsonscan_find_structurals(quote, backslash, op, whitespace, pstate);
+		n += jsonscan_emit(structurals, b * JSONSCAN_BLOCK_SIZE, pindex + n);
+	}
+	return n;
+}
+
+// ----------------------------------------------------------------
+#ifdef JSONSCAN_X86
+
+// Braces and brackets are found with one compare each after folding case: '[' | 0x20 is '{' and
+// ']' | 0x20 is '}'.
+int jsonscan_index_sse2(char* p, int nblocks, jsonscan_state_t* pstate, unsigned* pindex) {
+	__m128i vquote     = _mm_set1_epi8('"');
+	__m128i vbackslash = _mm_set1_epi8('\\');
+	__m128i vfold      = _mm_set1_epi8(0x20);
+	__m128i vlbrace    = _mm_set1_epi8('{');
+	__m128i vrbrace    = _mm_set1_epi8('}');
+	__m128i vcolon     = _mm_set1_epi8(':');
+	__m128i vcomma     = _mm_set1_epi8(',');
+	__m128i vspace     = _mm_set1_epi8(' ');
+	__m128i vtab       = _mm_set1_epi8('\t');
+	__m128i vlf        = _mm_set1_epi8('\n');
+	__m128i vcr        = _mm_set1_epi8('\r');
+	int n = 0;
+	for (int b = 0; b < nblocks; b++) {
+		char* block = p + b * JSONSCAN_BLOCK_SIZE;
+		uint64_t quote = 0ULL, backslash = 0ULL, op = 0ULL, whitespace = 0ULL;
+		for (int i = 0; i < JSONSCAN_BLOCK_SIZE; i += 16) {
+			__m128i x = _mm_loadu_si128((const __m128i*)(block + i));
+			__m128i folded = _mm_or_si128(x, vfold);
+			quote |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, vquote)) << i;
+			backslash |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, vbackslash)) << i;
+			__m128i mop = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(folded, vlbrace), _mm_cmpeq_epi8(folded, vrbrace)),
+				_mm_or_si128(_mm_cmpeq_epi8(x, vcolon), _mm_cmpeq_epi8(x, vcomma)));
+			op |= (uint64_t)(unsigned)_mm_movemask_epi8(mop) << i;
+			__m128i mws = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(x, vspace), _mm_cmpeq_epi8(x, vtab)),
+				_mm_or_si128(_mm_cmpeq_epi8(x, vlf), _mm_cmpeq_epi8(x, vcr)));
+			whitespace |= (uint64_t)(unsigned)_mm_movemask_epi8(mws) << i;
+		}
+		uint64_t structurals = jsonscan_find_structurals(quote, backslash, op, whitespace, pstate);
+		n += jsonscan_emit(structurals, b * JSONSCAN_BLOCK_SIZE, pindex + n);
+	}
+	return n;
+}
+
+__attribute__((target("avx2")))
+int jsonscan_index_avx2(char* p, int nblocks, jsonscan_state_t* pstate, unsigned* pindex) {
+	__m256i vquote     = _mm256_set1_epi8('"');
+	__m256i vbackslash = _mm256_set1_epi8('\\');
+	__m256i vfold      = _mm256_set1_epi8(0x20);
+	__m256i vlbrace    = _mm256_set1_epi8('{');
+	__m256i vrbrace    = _mm256_set1_epi8('}');
+	__m256i vcolon     = _mm256_set1_epi8(':');
+	__m256i vcomma     = _mm256_set1_epi8(',');
+	__m256i vspace     = _mm256_set1_epi8(' ');
+	__m256i vtab       = _mm256_set1_epi8('\t');
+	__m256i vlf        = _mm256_set1_epi8('\n');
+	__m256i vcr        = _mm256_set1_epi8('\r');
+	int n = 0;
+	for (int b = 0; b < nblocks; b++) {
+		char* block = p + b * JSONSCAN_BLOCK_SIZE;
+		uint64_t quote = 0ULL, backslash = 0ULL, op = 0ULL, whitespace = 0ULL;
+		for (int i = 0; i < JSONSCAN_BLOCK_SIZE; i += 32) {
+			__m256i x = _mm256_loadu_si256((const __m256i*)(block + i));
+			__m256i folded = _mm256_or_si256(x, vfold);
+			quote |= (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, vquote)) << i;
+			backslash |= (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, vbackslash)) << i;
+			__m256i mop = _mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(folded, vlbrace), _mm256_cmpeq_epi8(folded, vrbrace)),
+				_mm256_or_si256(_mm256_cmpeq_epi8(x, vcolon), _mm256_cmpeq_epi8(x, vcomma)));
+			op |= (uint64_t)(unsigned)_mm256_movemask_epi8(mop) << i;
+			__m256i mws = _mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(x, vspace), _mm256_cmpeq_epi8(x, vtab)),
+				_mm256_or_si256(_mm256_cmpeq_epi8(x, vlf), _mm256_cmpeq_epi8(x, vcr)));
+			whitespace |= (uint64_t)(unsigned)_mm256_movemask_epi8(mws) << i;
+		}
+		uint64_t structurals = jsonscan_find_structurals(quote, backslash, op, whitespace, pstate);
+		n += jsonscan_emit(structurals, b * JSONSCAN_BLOCK_SIZE, pindex + n);
+	}
+	return n;
+}
+
+#else // not JSONSCAN_X86
+
+int jsonscan_index_sse2(char* p, int nblocks, jsonscan_state_t* pstate, unsigned* pindex) {
+	return jsonscan_index_scalar(p, nblocks, pstate, pindex);
+}
+int jsonscan_index_avx2(char* p, int nblocks, jsonscan_state_t* pstate, unsigned* pindex) {
+	return jsonscan_index_scalar(p, nblocks, pstate, pindex);
+}
+
+#endif // JSONSCAN_X86
+
+// ----------------------------------------------------------------
+// As in sepscan.c, the first call picks the widest kernel the CPU supports.
+static int jsonscan_index_resolve(char* p, int nblocks, jsonscan_state_t* pstate, unsigned* pindex) {
+	jsonscan_index_func_t* pfunc = sepscan_have_avx2() ? jsonscan_index_avx2
+		: sepscan_have_sse2() ? jsonscan_index_sse2
+		: jsonscan_index_scalar;
+	__atomic_store_n(&_jsonscan_index_dispatched, pfunc, __ATOMIC_RELAXED);
+	return pfunc(p, nblocks, pstate, pindex);
+}
@@ -0,0 +1,51 @@
+// ================================================================
+// Structural indexing for the JSON reader, after the first stage of simdjson
+// (Langdale and Lemire, "Parsing Gigabytes of JSON per Second"). Given input in
+// 64-byte blocks, finds the positions of the bytes a parser needs to look at:
+// braces, brackets, colons, and commas outside of strings; unescaped double
+// quotes; and the first byte of each run of other non-whitespace bytes outside
+// of strings, i.e. the start of each number, true, false, or null. Everything
+// between consecutive positions is therefore either whitespace or the rest of
+// a string or scalar.
+//
+// Bytes are classified 16 or 32 at a time with SSE2 or AVX2 where available,
+// chosen at runtime as in sepscan.h, with a scalar fallback for other
+// platforms. Escapes and strings spanning bytes, and blocks, are tracked with
+// arithmetic on 64-bit masks.
+// ================================================================
+
+#ifndef JSONSCAN_H
+#define JSONSCAN_H
+
+#include <stdint.h>
+
+#define JSONSCAN_BLOCK_SIZE 64
+
+// Carried from one block to the next.
+typedef struct _jsonscan_state_t {
+	uint64_t prev_escaped;   // 1 if the next block's first byte is escaped by a backslash, else 0
+	uint64_t prev_in_string; // all ones if the next block starts within a string, else 0
+	uint64_t prev_scalar;    // 1 if the previous block ended within a scalar, else 0
+} jsonscan_state_t;
+
+void jsonscan_state_init(jsonscan_state_t* pstate);
+
+// Indexes the nblocks * JSONSCAN_BLOCK_SIZE bytes at p, writing to pindex the offset from p of each
+// structural byte, in order. The index must have room for nblocks * JSONSCAN_BLOCK_SIZE entries.
+// Returns the number of entries written.
+typedef int jsonscan_index_func_t(char* p, int nblocks, jsonscan_state_t* pstate, unsigned* pindex);
+
+// Set on first use; exposed only so the inline wrapper below can call through it. Accessed
+// atomically as in sepscan.h.
+extern jsonscan_index_func_t* _jsonscan_index_dispatched;
+
+static inline int jsonscan_index(char* p, int nblocks, jsonscan_state_t* pstate, unsigned* pindex) {
+	return __atomic_load_n(&_jsonscan_index_dispatched, __ATOMIC_RELAXED)(p, nblocks, pstate, pindex);
+}
+
+// For unit-testing the non-dispatched kernels.
+int jsonscan_index_scalar(char* p, int nblocks, jsonscan_state_t* pstate, unsigned* pindex);
+int jsonscan_index_sse2(char* p, int nblocks, jsonscan_state_t* pstate, unsigned* pindex);
+int jsonscan_index_avx2(char* p, int nblocks, jsonscan_state_t* pstate, unsigned* pindex);
+
+#endif // JSONSCAN_H
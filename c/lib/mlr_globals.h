@@ -4,6 +4,7 @@
 typedef struct _mlr_globals_t {
 	char* bargv0; // basename of argv0
 	char* ofmt;
+	int   nthreads; // from mlr --threads; verbs may use this many worker threads
 } mlr_globals_t;
 extern mlr_globals_t MLR_GLOBALS;
 void mlr_global_init(char* argv0, char* ofmt);
@@ -2,12 +2,21 @@
 #include <string.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <strings.h>
 #include <sys/time.h>
+#include <pthread.h>
 #include "lib/mlrutil.h"
 #include "lib/mlrregex.h"
 #include "lib/mlr_globals.h"
 #include "lib/free_flags.h"
 
+struct _regex_ac_t;
+static void regex_analyze(mlr_regex_t* pregex, char* ere);
+static struct _regex_ac_t* regex_ac_alloc(char* literals, int num_literals, int fold);
+static void regex_ac_free(struct _regex_ac_t* pac);
+static regoff_t regex_ac_find(struct _regex_ac_t* pac, const char* s, int fold, regoff_t* pend);
+static const char* regex_find_folded(const char* s, const char* literal, int literal_length);
+
 // ----------------------------------------------------------------
 // Succeeds or aborts the process. cflag REG_EXTENDED is already included.
 //
@@ -40,19 +49,21 @@
 //
 // as desired.
 
-regex_t* regcomp_or_die(regex_t* pregex, char* regex_string, int cflags) {
+mlr_regex_t* regcomp_or_die(mlr_regex_t* pregex, char* regex_string, int cflags) {
 	cflags |= REG_EXTENDED;
 	char* doubly_backslashed = mlr_alloc_double_backslash(regex_string);
-	int rc = regcomp(pregex, doubly_backslashed, cflags);
-	free(doubly_backslashed);
+	int rc = regcomp(&pregex->regex, doubly_backslashed, cflags);
 	if (rc != 0) {
-		size_t nbytes = regerror(rc, pregex, NULL, 0);
+		size_t nbytes = regerror(rc, &pregex->regex, NULL, 0);
 		char* errbuf = malloc(nbytes);
-		(void)regerror(rc, pregex, errbuf, nbytes);
+		(void)regerror(rc, &pregex->regex, errbuf, nbytes);
 		fprintf(stderr, "%s: could not compile regex \"%s\" : %s\n",
 			MLR_GLOBALS.bargv0, regex_string, errbuf);
 		exit(1);
 	}
+	pregex->cflags = cflags;
+	regex_analyze(pregex, doubly_backslashed);
+	free(doubly_backslashed);
 	return pregex;
 }
 
@@ -60,7 +71,7 @@ regex_t* regcomp_or_die(regex_t* pregex, char* regex_string, int cflags) {
 // If the regex_string is of the form a.*b, compiles it using cflags without REG_ICASE.
 // If the regex_string is of the form "a.*b", compiles a.*b using cflags without REG_ICASE.
 // If the regex_string is of the form "a.*b"i, compiles a.*b using cflags with REG_ICASE.
-regex_t* regcomp_or_die_quoted(regex_t* pregex, char* orig_regex_string, int cflags) {
+mlr_regex_t* regcomp_or_die_quoted(mlr_regex_t* pregex, char* orig_regex_string, int cflags) {
 	cflags |= REG_EXTENDED;
 	if (string_starts_with(orig_regex_string, "\"")) {
 		char* regex_string = mlr_strdup_or_die(orig_regex_string);
@@ -83,30 +94,418 @@ regex_t* regcomp_or_die_quoted(regex_t* pregex, char* orig_regex_string, int cfl
 	return pregex;
 }
 
+void mlr_regfree(mlr_regex_t* pregex) {
+	regfree(&pregex->regex);
+	free(pregex->literal);
+	if (pregex->pac != NULL)
+		regex_ac_free(pregex->pac);
+}
+
+// ----------------------------------------------------------------
+// Compile-time analysis for the regexec-free match paths. Only the ERE syntax which can appear in a
+// plain literal is accepted: ordinary characters, backslash-escaped special characters, ^ at the
+// very start, $ at the very end, and | between non-empty literals when there are no anchors.
+// Anything else (., brackets, parentheses, repetition, other escapes) means regexec.
+
+#define REGEX_MATCH_REGEXEC     0
+#define REGEX_MATCH_SUBSTRING   1 // abc
+#define REGEX_MATCH_PREFIX      2 // ^abc
+#define REGEX_MATCH_SUFFIX      3 // abc$
+#define REGEX_MATCH_EXACT       4 // ^abc$
+#define REGEX_MATCH_ALTERNATION 5 // abc|de|f
+
+// Bounds the automaton's size, which is 1KB per state.
+#define REGEX_AC_MAX_STATES 1024
+
+static void regex_analyze(mlr_regex_t* pregex, char* ere) {
+	pregex->match_kind     = REGEX_MATCH_REGEXEC;
+	pregex->literal        = NULL;
+	pregex->literal_length = 0;
+	pregex->pac            = NULL;
+	if (pregex->cflags & REG_NEWLINE)
+		return;
+
+	int fold = (pregex->cflags & REG_ICASE) != 0;
+	int ere_length = strlen(ere);
+	// The alternatives' literals, each NUL-terminated, one after another.
+	char* literals = mlr_malloc_or_die(ere_length + 1);
+	int   num_literals = 0;
+	int   is_empty_literal = TRUE;
+	int   anchored_start = FALSE;
+	int   anchored_end = FALSE;
+	char* q = literals;
+
+	char* p = ere;
+	if (*p == '^') {
+		anchored_start = TRUE;
+		p++;
+	}
+	for ( ; *p; p++) {
+		char c = *p;
+		if (c == '\\') {
+			p++;
+			if (*p == 0 || strchr(".[]()*+?{}|^$\\", *p) == NULL)
+				goto use_regexec;
+			c = *p;
+		} else if (c == '$' && p[1] == 0) {
+			anchored_end = TRUE;
+			break;
+		} else if (c == '|') {
+			if (is_empty_literal)
+				goto use_regexec;
+			*q++ = 0;
+			num_literals++;
+			is_empty_literal = TRUE;
+			continue;
+		} else if (strchr(".[]()*+?{}^$", c) != NULL) {
+			goto use_regexec;
+		}
+		*q++ = fold ? tolower((unsigned char)c) : c;
+		is_empty_literal = FALSE;
+	}
+	if (is_empty_literal)
+		goto use_regexec;
+	*q++ = 0;
+	num_literals++;
+
+	if (num_literals == 1) {
+		pregex->literal = literals;
+		pregex->literal_length = strlen(literals);
+		pregex->match_kind = anchored_start
+			? (anchored_end ? REGEX_MATCH_EXACT : REGEX_MATCH_PREFIX)
+			: (anchored_end ? REGEX_MATCH_SUFFIX : REGEX_MATCH_SUBSTRING);
+		return;
+	}
+	// In an ERE, anchors bind to the single alternative they're in.
+	if (anchored_start || anchored_end || q - literals - num_literals + 1 > REGEX_AC_MAX_STATES)
+		goto use_regexec;
+	pregex->pac = regex_ac_alloc(literals, num_literals, fold);
+	pregex->match_kind = REGEX_MATCH_ALTERNATION;
+	free(literals);
+	return;
+
+use_regexec:
+	free(literals);
+}
+
+// ----------------------------------------------------------------
+// Aho-Corasick automaton for alternations of literals, with the goto/failure function expanded into
+// a complete transition table so the scan does one table lookup per input byte. Each state records
+// the length of the longest literal which is a suffix of the input consumed so far, which suffices
+// for finding the POSIX leftmost-longest match. While at the root the scan skips, using strcspn,
+// to the next byte which can start a literal.
+
+typedef struct _regex_ac_t {
+	int* transitions; // 256 per state; state 0 is the root
+	int* out_lengths; // longest literal ending at this state, or 0
+	int  max_length;
+	char first_bytes[257]; // bytes which can start a literal, in either case with REG_ICASE
+} regex_ac_t;
+
+// The literals are NUL-terminated, one after another.
+static regex_ac_t* regex_ac_alloc(char* literals, int num_literals, int fold) {
+	int max_states = 1;
+	char* p = literals;
+	for (int i = 0; i < num_literals; i++) {
+		int length = strlen(p);
+		max_states += length;
+		p += length + 1;
+	}
+
+	regex_ac_t* pac = mlr_malloc_or_die(sizeof(regex_ac_t));
+	pac->transitions = mlr_malloc_or_die(max_states * 256 * sizeof(int));
+	pac->out_lengths = mlr_malloc_or_die(max_states * sizeof(int));
+	pac->max_length  = 0;
+	memset(pac->transitions, 0xff, max_states * 256 * sizeof(int)); // all -1
+	memset(pac->out_lengths, 0, max_states * sizeof(int));
+
+	// The trie
+	int num_states = 1;
+	p = literals;
+	for (int i = 0; i < num_literals; i++) {
+		int state = 0;
+		int length = 0;
+		for ( ; *p; p++, length++) {
+			int* pnext = &pac->transitions[state * 256 + (unsigned char)*p];
+			if (*pnext < 0)
+				*pnext = num_states++;
+			state = *pnext;
+		}
+		p++;
+		pac->out_lengths[state] = length;
+		if (length > pac->max_length)
+			pac->max_length = length;
+	}
+
+	// Failure links, breadth-first so each state's link is done before its children's. The
+	// missing transitions are filled in from the failure state's, making a complete table.
+	int* failures = mlr_malloc_or_die(num_states * sizeof(int));
+	int* queue = mlr_malloc_or_die(num_states * sizeof(int));
+	int head = 0, tail = 0;
+	int num_first_bytes = 0;
+	for (int c = 0; c < 256; c++) {
+		int* pnext = &pac->transitions[c];
+		if (*pnext < 0) {
+			*pnext = 0;
+		} else {
+			failures[*pnext] = 0;
+			queue[tail++] = *pnext;
+			pac->first_bytes[num_first_bytes++] = c;
+			if (fold && toupper(c) != c)
+				pac->first_bytes[num_first_bytes++] = toupper(c);
+		}
+	}
+	pac->first_bytes[num_first_bytes] = 0;
+	while (head < tail) {
+		int state = queue[head++];
+		if (pac->out_lengths[state] == 0)
+			pac->out_lengths[state] = pac->out_lengths[failures[state]];
+		for (int c = 0; c < 256; c++) {
+			int* pnext = &pac->transitions[state * 256 + c];
+			int fallback = pac->transitions[failures[state] * 256 + c];
+			if (*pnext < 0) {
+				*pnext = fallback;
+			} else {
+				failures[*pnext] = fallback;
+				queue[tail++] = *pnext;
+			}
+		}
+	}
+	free(queue);
+	free(failures);
+	return pac;
+}
+
+static void regex_ac_free(regex_ac_t* pac) {
+	free(pac->transitions);
+	free(pac->out_lengths);
+	free(pac);
+}
+
+// Finds the leftmost match, and the longest of those starting there. Returns its start, or -1.
+static regoff_t regex_ac_find(regex_ac_t* pac, const char* s, int fold, regoff_t* pend) {
+	regoff_t best_start = -1;
+	regoff_t best_length = 0;
+	int state = 0;
+	for (regoff_t i = 0; s[i]; i++) {
+		// No match ending here or later can start before the one found.
+		if (best_start >= 0 && i - pac->max_length + 1 > best_start)
+			break;
+		if (state == 0) {
+			i += strcspn(&s[i], pac->first_bytes);
+			if (s[i] == 0)
+				break;
+		}
+		unsigned char c = s[i];
+		state = pac->transitions[state * 256 + (fold ? tolower(c) : c)];
+		int length = pac->out_lengths[state];
+		if (length > 0) {
+			regoff_t start = i - length + 1;
+			if (best_start < 0 || start < best_start || (start == best_start && length > best_length)) {
+				best_start = start;
+				best_length = length;
+			}
+		}
+	}
+	*pend = best_start + best_length;
+	return best_start;
+}
+
+// Case-insensitive strstr, with the literal already lowercased.
+static const char* regex_find_folded(const char* s, const char* literal, int literal_length) {
+	for ( ; *s; s++) {
+		if (tolower((unsigned char)*s) == (unsigned char)literal[0] && strncasecmp(s, literal, literal_length) == 0)
+			return s;
+	}
+	return NULL;
+}
+
+// ----------------------------------------------------------------
+#define REGEX_CACHE_CAPACITY    64
+#define REGEX_CACHE_NUM_BUCKETS 128 // power of two
+
+typedef struct _regex_cache_entry_t {
+	char*    regex_string;
+	int      cflags;
+	int      hash;
+	mlr_regex_t regex;
+	struct _regex_cache_entry_t* pnext_in_bucket;
+	struct _regex_cache_entry_t* pprev; // recency list, most recently used at head
+	struct _regex_cache_entry_t* pnext;
+} regex_cache_entry_t;
+
+typedef struct _regex_cache_t {
+	regex_cache_entry_t* buckets[REGEX_CACHE_NUM_BUCKETS];
+	regex_cache_entry_t* phead;
+	regex_cache_entry_t* ptail;
+	int                  num_entries;
+} regex_cache_t;
+
+// The thread-specific key is only for freeing the cache when a worker thread exits.
+static __thread regex_cache_t* pregex_cache = NULL;
+static pthread_key_t  regex_cache_key;
+static pthread_once_t regex_cache_key_once = PTHREAD_ONCE_INIT;
+
+static void regex_cache_free(void* pvcache) {
+	regex_cache_t* pcache = pvcache;
+	regex_cache_entry_t* pe = pcache->phead;
+	while (pe != NULL) {
+		regex_cache_entry_t* pnext = pe->pnext;
+		mlr_regfree(&pe->regex);
+		free(pe->regex_string);
+		free(pe);
+		pe = pnext;
+	}
+	free(pcache);
+}
+
+static void regex_cache_make_key() {
+	pthread_key_create(&regex_cache_key, regex_cache_free);
+}
+
+static void regex_cache_unlink(regex_cache_t* pcache, regex_cache_entry_t* pe) {
+	if (pe->pprev == NULL)
+		pcache->phead = pe->pnext;
+	else
+		pe->pprev->pnext = pe->pnext;
+	if (pe->pnext == NULL)
+		pcache->ptail = pe->pprev;
+	else
+		pe->pnext->pprev = pe->pprev;
+}
+
+static void regex_cache_link_at_head(regex_cache_t* pcache, regex_cache_entry_t* pe) {
+	pe->pprev = NULL;
+	pe->pnext = pcache->phead;
+	if (pcache->phead == NULL)
+		pcache->ptail = pe;
+	else
+		pcache->phead->pprev = pe;
+	pcache->phead = pe;
+}
+
+mlr_regex_t* regcomp_cached_or_die(char* regex_string, int cflags) {
+	regex_cache_t* pcache = pregex_cache;
+	if (pcache == NULL) {
+		pcache = mlr_malloc_or_die(sizeof(regex_cache_t));
+		memset(pcache, 0, sizeof(regex_cache_t));
+		pthread_once(&regex_cache_key_once, regex_cache_make_key);
+		pthread_setspecific(regex_cache_key, pcache);
+		pregex_cache = pcache;
+	}
+
+	int hash = mlr_string_hash_func(regex_string) ^ cflags;
+	regex_cache_entry_t** ppbucket = &pcache->buckets[hash & (REGEX_CACHE_NUM_BUCKETS - 1)];
+	for (regex_cache_entry_t* pe = *ppbucket; pe != NULL; pe = pe->pnext_in_bucket) {
+		if (pe->hash == hash && pe->cflags == cflags && streq(pe->regex_string, regex_string)) {
+			if (pe != pcache->phead) {
+				regex_cache_unlink(pcache, pe);
+				regex_cache_link_at_head(pcache, pe);
+			}
+			return &pe->regex;
+		}
+	}
+
+	regex_cache_entry_t* pe;
+	if (pcache->num_entries < REGEX_CACHE_CAPACITY) {
+		pe = mlr_malloc_or_die(sizeof(regex_cache_entry_t));
+		pcache->num_entries++;
+	} else { // Evict the least recently used
+		pe = pcache->ptail;
+		regex_cache_unlink(pcache, pe);
+		regex_cache_entry_t** pp = &pcache->buckets[pe->hash & (REGEX_CACHE_NUM_BUCKETS - 1)];
+		while (*pp != pe)
+			pp = &(*pp)->pnext_in_bucket;
+		*pp = pe->pnext_in_bucket;
+		mlr_regfree(&pe->regex);
+		free(pe->regex_string);
+	}
+	regcomp_or_die(&pe->regex, regex_string, cflags);
+	pe->regex_string    = mlr_strdup_or_die(regex_string);
+	pe->cflags          = cflags;
+	pe->hash            = hash;
+	pe->pnext_in_bucket = *ppbucket;
+	*ppbucket = pe;
+	regex_cache_link_at_head(pcache, pe);
+	return &pe->regex;
+}
+
 // Returns TRUE for match, FALSE for no match, and aborts the process if
 // regexec returns anything else.
-int regmatch_or_die(const regex_t* pregex, const char* restrict match_string,
+int regmatch_or_die(const mlr_regex_t* pregex, const char* restrict match_string,
 	size_t nmatchmax, regmatch_t pmatch[restrict])
 {
-	int rc = regexec(pregex, match_string, nmatchmax, pmatch, 0);
-	if (rc == 0) {
-		return TRUE;
-	} else if (rc == REG_NOMATCH) {
+	int fold = (pregex->cflags & REG_ICASE) != 0;
+	regoff_t start = -1;
+	regoff_t end = -1;
+	switch (pregex->match_kind) {
+
+	case REGEX_MATCH_REGEXEC: {
+		int rc = regexec(&pregex->regex, match_string, nmatchmax, pmatch, 0);
+		if (rc == 0) {
+			return TRUE;
+		} else if (rc == REG_NOMATCH) {
+			return FALSE;
+		} else {
+			size_t nbytes = regerror(rc, &pregex->regex, NULL, 0);
+			char* errbuf = malloc(nbytes);
+			(void)regerror(rc, &pregex->regex, errbuf, nbytes);
+			printf("regexec failure: %s\n", errbuf);
+			exit(1);
+		}
+	}
+
+	case REGEX_MATCH_SUBSTRING: {
+		const char* p = fold
+			? regex_find_folded(match_string, pregex->literal, pregex->literal_length)
+			: strstr(match_string, pregex->literal);
+		if (p != NULL)
+			start = p - match_string;
+		break;
+	}
+
+	case REGEX_MATCH_PREFIX:
+		if ((fold ? strncasecmp : strncmp)(match_string, pregex->literal, pregex->literal_length) == 0)
+			start = 0;
+		break;
+
+	case REGEX_MATCH_SUFFIX: {
+		regoff_t length = strlen(match_string);
+		if (length >= pregex->literal_length) {
+			const char* p = match_string + length - pregex->literal_length;
+			if ((fold ? strcasecmp : strcmp)(p, pregex->literal) == 0)
+				start = p - match_string;
+		}
+		break;
+	}
+
+	case REGEX_MATCH_EXACT:
+		if ((fold ? strcasecmp : strcmp)(match_string, pregex->literal) == 0)
+			start = 0;
+		break;
+
+	case REGEX_MATCH_ALTERNATION:
+		start = regex_ac_find(pregex->pac, match_string, fold, &end);
+		break;
+	}
+
+	if (start < 0)
 		return FALSE;
-	} else {
-		size_t nbytes = regerror(rc, pregex, NULL, 0);
-		char* errbuf = malloc(nbytes);
-		(void)regerror(rc, pregex, errbuf, nbytes);
-		printf("regexec failure: %s\n", errbuf);
-		exit(1);
+	// As from regexec: there are no capture groups in these patterns.
+	if (!(pregex->cflags & REG_NOSUB) && nmatchmax > 0) {
+		pmatch[0].rm_so = start;
+		pmatch[0].rm_eo = (pregex->match_kind == REGEX_MATCH_ALTERNATION) ? end : start + pregex->literal_length;
+		for (size_t i = 1; i < nmatchmax; i++)
+			pmatch[i].rm_so = pmatch[i].rm_eo = -1;
 	}
+	return TRUE;
 }
 
 // Capture-group example:
 // sed: $ echo '<<abcdefg>>'|sed 's/ab\(.\)d\(..\)g/AYEBEE\1DEE\2GEE/' gives <<AYEBEEcDEEefGEE>>
 // mlr: echo 'x=<<abcdefg>>' | mlr put '$x = sub($x, "ab(.)d(..)g", "AYEBEE\1DEE\2GEE")' x=<<AYEBEEcDEEefGEE>>
 
-char* regex_sub(char* input, regex_t* pregex, string_builder_t* psb, char* replacement,
+char* regex_sub(char* input, mlr_regex_t* pregex, string_builder_t* psb, char* replacement,
 	int* pmatched, int *pall_captured)
 {
 	const size_t nmatchmax = 10; // Capture-groups \1 through \9 supported, along with entire-string match \0
@@ -143,7 +542,7 @@ char* regex_sub(char* input, regex_t* pregex, string_builder_t* psb, char* repla
 	}
 }
 
-char* regex_gsub(char* input, regex_t* pregex, string_builder_t* psb, char* replacement,
+char* regex_gsub(char* input, mlr_regex_t* pregex, string_builder_t* psb, char* replacement,
 	int *pmatched, int* pall_captured, char* pfree_flags)
 {
 	const size_t nmatchmax = 10;
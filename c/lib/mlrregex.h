@@ -10,27 +10,49 @@
 #include "string_builder.h"
 #include "string_array.h"
 
+// A compiled regex. Patterns which are a literal string, optionally anchored by ^ and/or $, or an
+// unanchored alternation of literal strings such as "abc|de|f", are recognized at compile time and
+// matched by substring search, a prefix or suffix compare, or an Aho-Corasick automaton rather than
+// by regexec, with the same results. Other patterns go to regexec.
+typedef struct _mlr_regex_t {
+	regex_t regex;
+	int     cflags;
+	int     match_kind;
+	char*   literal; // for the single-literal kinds; lowercased with REG_ICASE
+	int     literal_length;
+	struct _regex_ac_t* pac; // for alternations of literals
+} mlr_regex_t;
+
 // Succeeds or aborts the process. cflag REG_EXTENDED is already included.
 // Returns its first argument (after compilation).
-regex_t* regcomp_or_die(regex_t* pregex, char* regex_string, int cflags);
+mlr_regex_t* regcomp_or_die(mlr_regex_t* pregex, char* regex_string, int cflags);
 // Always uses cflags with REG_EXTENDED.
 // If the regex_string is of the form a.*b, compiles it using cflags without REG_ICASE.
 // If the regex_string is of the form "a.*b", compiles a.*b using cflags without REG_ICASE.
 // If the regex_string is of the form "a.*b"i, compiles a.*b using cflags with REG_ICASE.
-regex_t* regcomp_or_die_quoted(regex_t* pregex, char* regex_string, int cflags);
+mlr_regex_t* regcomp_or_die_quoted(mlr_regex_t* pregex, char* regex_string, int cflags);
+// Counterpart of regfree.
+void mlr_regfree(mlr_regex_t* pregex);
+
+// For regexes not known until runtime, e.g. sub($x, $y, "z") in the DSL: as regcomp_or_die but
+// looked up in a bounded least-recently-used cache keyed by regex string and cflags, so patterns
+// which vary over a small set are compiled once each rather than once per record. The cache is
+// per-thread. The regex belongs to the cache and may be freed by the calling thread's next call,
+// so it mustn't be kept past then, nor freed by the caller.
+mlr_regex_t* regcomp_cached_or_die(char* regex_string, int cflags);
 
 // Returns TRUE for match, FALSE for no match, and aborts the process if
 // regexec returns anything else.
-int regmatch_or_die(const regex_t* pregex, const char* restrict match_string,
+int regmatch_or_die(const mlr_regex_t* pregex, const char* restrict match_string,
 	size_t nmatchmax, regmatch_t pmatch[restrict]);
 
 // The return value is dynamically allocated even if there is no match, i.e. when output
 // equals input.  The by-reference all-captured flag is true on return if all \1, etc.
 // were satisfiable by parenthesized capture groups.
-char* regex_sub(char* input, regex_t* pregex, string_builder_t* psb, char* replacement,
+char* regex_sub(char* input, mlr_regex_t* pregex, string_builder_t* psb, char* replacement,
 	int* pmatched, int* pall_captured);
 
-char* regex_gsub(char* input, regex_t* pregex, string_builder_t* psb, char* replacement, int* pmatched, int* pall_captured,
+char* regex_gsub(char* input, mlr_regex_t* pregex, string_builder_t* psb, char* replacement, int* pmatched, int* pall_captured,
 	char *pfree_flags);
 
 // The regex library gives us an array of match pointers into the input string. This function strdups them
@@ -2,6 +2,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <math.h>
 #include <sys/stat.h>
 #include "lib/mlrutil.h"
 #include "lib/mlr_globals.h"
@@ -104,27 +105,145 @@ char * mlr_strdup_quoted_or_die(const char *s1) {
 	return s2;
 }
 
+// ----------------------------------------------------------------
+// Number formatting into caller-provided buffers. Integers are written two
+// digits at a time from a table. Doubles are written by hand for Miller's
+// default "%lf" output format (fixed-point, six decimal places) and otherwise
+// via snprintf. The hand-written path reproduces printf exactly: the double's
+// exact binary value is scaled by 10^6 in 128-bit integer arithmetic and then
+// rounded half-to-even, so no floating-point rounding is involved.
+
+static const char format_digit_pairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+int mlr_format_ull(char* buf, unsigned long long value) {
+	char digits[24];
+	char* p = &digits[sizeof(digits)];
+	while (value >= 100) {
+		unsigned idx = (unsigned)(value % 100) * 2;
+		value /= 100;
+		*--p = format_digit_pairs[idx + 1];
+		*--p = format_digit_pairs[idx];
+	}
+	if (value >= 10) {
+		unsigned idx = (unsigned)value * 2;
+		*--p = format_digit_pairs[idx + 1];
+		*--p = format_digit_pairs[idx];
+	} else {
+		*--p = '0' + (char)value;
+	}
+	int len = &digits[sizeof(digits)] - p;
+	memcpy(buf, p, len);
+	buf[len] = 0;
+	return len;
+}
+
+int mlr_format_ll(char* buf, long long value) {
+	if (value < 0) {
+		buf[0] = '-';
+		// Negate as unsigned so that LLONG_MIN is handled.
+		return 1 + mlr_format_ull(&buf[1], -(unsigned long long)value);
+	} else {
+		return mlr_format_ull(buf, (unsigned long long)value);
+	}
+}
+
+static inline int is_default_float_format(char* fmt) {
+	return fmt[0] == '%' && ((fmt[1] == 'l' && fmt[2] == 'f' && fmt[3] == 0) || (fmt[1] == 'f' && fmt[2] == 0));
+}
+
+#ifdef __SIZEOF_INT128__
+// Returns the length, or -1 if the value is out of range for this method.
+static int format_double_fixed6(char* buf, double value) {
+	// Keeps |value| * 10^6 within 64 bits; also rejects inf and nan.
+	if (!(fabs(value) < 1e12))
+		return -1;
+
+	int exponent;
+	double fraction = frexp(fabs(value), &exponent);
+	// Now |value| = mantissa * 2^exponent with mantissa an integer below 2^53.
+	unsigned long long mantissa = (unsigned long long)ldexp(fraction, 53);
+	exponent -= 53;
+
+	unsigned long long scaled; // |value| * 10^6, rounded
+	if (exponent >= 0) {
+		scaled = (mantissa << exponent) * 1000000ULL;
+	} else if (exponent < -100) {
+		scaled = 0ULL; // Below 2^-47: rounds to zero at six places
+	} else {
+		unsigned __int128 product = (unsigned __int128)mantissa * 1000000ULL;
+		int shift = -exponent;
+		unsigned __int128 quotient = product >> shift;
+		unsigned __int128 remainder = product - (quotient << shift);
+		unsigned __int128 half = (unsigned __int128)1 << (shift - 1);
+		if (remainder > half || (remainder == half && (quotient & 1)))
+			quotient++;
+		scaled = (unsigned long long)quotient;
+	}
+
+	char* p = buf;
+	if (signbit(value))
+		*p++ = '-';
+	p += mlr_format_ull(p, scaled / 1000000ULL);
+	*p++ = '.';
+	unsigned frac = (unsigned)(scaled % 1000000ULL);
+	for (int i = 5; i >= 0; i--) {
+		p[i] = '0' + frac % 10;
+		frac /= 10;
+	}
+	p[6] = 0;
+	return p + 6 - buf;
+}
+#endif
+
+// Same return-value semantics as snprintf.
+int mlr_format_double(char* buf, size_t bufsize, double value, char* fmt) {
+#ifdef __SIZEOF_INT128__
+	if (bufsize >= MLR_NUMBER_FORMAT_BUFFER_SIZE && is_default_float_format(fmt)) {
+		int len = format_double_fixed6(buf, value);
+		if (len >= 0)
+			return len;
+	}
+#endif
+	return snprintf(buf, bufsize, fmt, value);
+}
+
 // ----------------------------------------------------------------
 // The caller should free the return value from each of these.
 
 char* mlr_alloc_string_from_double(double value, char* fmt) {
-	int n = snprintf(NULL, 0, fmt, value);
+	char buf[MLR_NUMBER_FORMAT_BUFFER_SIZE];
+	int n = mlr_format_double(buf, sizeof(buf), value, fmt);
 	char* string = mlr_malloc_or_die(n+1);
-	sprintf(string, fmt, value);
+	if (n < sizeof(buf))
+		memcpy(string, buf, n+1);
+	else
+		sprintf(string, fmt, value);
 	return string;
 }
 
 char* mlr_alloc_string_from_ull(unsigned long  long value) {
-	int n = snprintf(NULL, 0, "%llu", value);
+	char buf[MLR_NUMBER_FORMAT_BUFFER_SIZE];
+	int n = mlr_format_ull(buf, value);
 	char* string = mlr_malloc_or_die(n+1);
-	sprintf(string, "%llu", value);
+	memcpy(string, buf, n+1);
 	return string;
 }
 
 char* mlr_alloc_string_from_ll(long  long value) {
-	int n = snprintf(NULL, 0, "%lld", value);
+	char buf[MLR_NUMBER_FORMAT_BUFFER_SIZE];
+	int n = mlr_format_ll(buf, value);
 	char* string = mlr_malloc_or_die(n+1);
-	sprintf(string, "%lld", value);
+	memcpy(string, buf, n+1);
 	return string;
 }
 
@@ -136,10 +255,7 @@ char* mlr_alloc_string_from_ll_and_format(long long value, char* fmt) {
 }
 
 char* mlr_alloc_string_from_int(int value) {
-	int n = snprintf(NULL, 0, "%d", value);
-	char* string = mlr_malloc_or_die(n+1);
-	sprintf(string, "%d", value);
-	return string;
+	return mlr_alloc_string_from_ll(value);
 }
 
 char* mlr_alloc_string_from_char_range(char* start, int num_bytes) {
@@ -166,8 +282,152 @@ double mlr_double_from_string_or_die(char* string) {
 	return d;
 }
 
-// E.g. "300" is a number; "300ms" is not.
-int mlr_try_float_from_string(char* string, double* pval) {
+// ----------------------------------------------------------------
+// Number scanning for type inference. This is called for every field value
+// the DSL, stats1, sort -nf, etc. look at, so it needs to be fast on the common
+// cases: plain decimal ints like "12345", plain decimal floats like "-0.25" or
+// "6.02e23", and non-numbers like "pan" which should be rejected on the first
+// byte. These are handled here by hand, independent of locale.
+//
+// Anything else -- leading whitespace, octal and signed hex, inf/nan, hex
+// floats, more significant digits than fit exactly, extreme exponents, and
+// sscanf corner cases such as "1e" -- is sent to the sscanf-based slow path so
+// that semantics are exactly as before. Floats are only computed here when the
+// mantissa and power of ten are both exactly representable as doubles, in which
+// case the single multiply or divide is correctly rounded.
+
+#define SCAN_NEITHER 0
+#define SCAN_INT     1
+#define SCAN_FLOAT   2
+#define SCAN_SLOW    3
+
+#define SCAN_MAX_DIGITS       18 // Any 18-digit decimal fits in a long long.
+#define SCAN_MAX_EXACT_POW10  22
+#define SCAN_MAX_EXACT_MANTISSA (1ULL << 53)
+
+static const double scan_pow10[SCAN_MAX_EXACT_POW10 + 1] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static int scan_decimal_fast(char* string, long long* pintv, double* pfltv) {
+	char* p = string;
+	int negative = FALSE;
+
+	if (*p == '-') {
+		negative = TRUE;
+		p++;
+	} else if (*p == '+') {
+		p++;
+	}
+
+	char c = *p;
+	if (c >= '0' && c <= '9') {
+		if (c == '0' && ((p[1] >= '0' && p[1] <= '9') || p[1] == 'x' || p[1] == 'X'))
+			return SCAN_SLOW; // Octal, or signed hex
+	} else if (c == '.') {
+		if (p[1] < '0' || p[1] > '9')
+			return SCAN_SLOW;
+	} else if (isspace((unsigned char)c) || c == 'i' || c == 'I' || c == 'n' || c == 'N') {
+		return SCAN_SLOW; // Whitespace, or maybe inf/nan
+	} else {
+		return SCAN_NEITHER;
+	}
+
+	unsigned long long mantissa = 0ULL;
+	int num_digits = 0;
+	for ( ; *p >= '0' && *p <= '9'; p++) {
+		if (num_digits >= SCAN_MAX_DIGITS)
+			return SCAN_SLOW;
+		mantissa = mantissa * 10 + (*p - '0');
+		if (mantissa != 0)
+			num_digits++;
+	}
+
+	if (*p == 0) {
+		// The float value is set as well, for callers wanting "-0" as -0.0.
+		*pintv = negative ? -(long long)mantissa : (long long)mantissa;
+		*pfltv = negative ? -(double)mantissa : (double)mantissa;
+		return SCAN_INT;
+	}
+
+	int exponent = 0;
+	if (*p == '.') {
+		for (p++; *p >= '0' && *p <= '9'; p++) {
+			if (num_digits >= SCAN_MAX_DIGITS)
+				return SCAN_SLOW;
+			mantissa = mantissa * 10 + (*p - '0');
+			if (mantissa != 0)
+				num_digits++;
+			exponent--;
+		}
+	}
+
+	if (*p == 'e' || *p == 'E') {
+		p++;
+		int exponent_negative = FALSE;
+		if (*p == '-') {
+			exponent_negative = TRUE;
+			p++;
+		} else if (*p == '+') {
+			p++;
+		}
+		if (*p < '0' || *p > '9')
+			return SCAN_SLOW;
+		int explicit_exponent = 0;
+		for ( ; *p >= '0' && *p <= '9'; p++) {
+			if (explicit_exponent > 10000)
+				return SCAN_SLOW;
+			explicit_exponent = explicit_exponent * 10 + (*p - '0');
+		}
+		exponent += exponent_negative ? -explicit_exponent : explicit_exponent;
+	}
+
+	if (*p != 0)
+		return SCAN_NEITHER;
+
+	if (mantissa > SCAN_MAX_EXACT_MANTISSA)
+		return SCAN_SLOW;
+	double value = (double)mantissa;
+	if (exponent < 0) {
+		if (exponent < -SCAN_MAX_EXACT_POW10)
+			return SCAN_SLOW;
+		value /= scan_pow10[-exponent];
+	} else {
+		if (exponent > SCAN_MAX_EXACT_POW10)
+			return SCAN_SLOW;
+		value *= scan_pow10[exponent];
+	}
+	*pfltv = negative ? -value : value;
+	return SCAN_FLOAT;
+}
+
+// Unsigned hex such as "0xcafe" is two's-complement: "0xffffffffffffffff" is -1.
+static int scan_hex_fast(char* string, long long* pintv) {
+	unsigned long long value = 0ULL;
+	int num_digits = 0;
+	for (char* p = &string[2]; *p; p++) {
+		char c = *p;
+		int nybble;
+		if (c >= '0' && c <= '9')
+			nybble = c - '0';
+		else if (c >= 'a' && c <= 'f')
+			nybble = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			nybble = c - 'A' + 10;
+		else
+			return SCAN_NEITHER;
+		if (++num_digits > 16)
+			return SCAN_SLOW;
+		value = (value << 4) | nybble;
+	}
+	if (num_digits == 0)
+		return SCAN_SLOW;
+	*pintv = (long long)value;
+	return SCAN_INT;
+}
+
+static int mlr_try_float_from_string_slow(char* string, double* pval) {
 	int num_bytes_scanned;
 	int rc = sscanf(string, "%lf%n", pval, &num_bytes_scanned);
 	if (rc != 1)
@@ -177,17 +437,7 @@ int mlr_try_float_from_string(char* string, double* pval) {
 	return 1;
 }
 
-long long mlr_int_from_string_or_die(char* string) {
-	long long i;
-	if (!mlr_try_int_from_string(string, &i)) {
-		fprintf(stderr, "Couldn't parse \"%s\" as number.\n", string);
-		exit(1);
-	}
-	return i;
-}
-
-// E.g. "300" is a number; "300ms" is not.
-int mlr_try_int_from_string(char* string, long long* pval) {
+static int mlr_try_int_from_string_slow(char* string, long long* pval) {
 	int num_bytes_scanned, rc;
 	// sscanf with %li / %lli doesn't scan correctly when the high bit is set
 	// on hex input; it just returns max signed. So we need to special-case hex
@@ -204,6 +454,70 @@ int mlr_try_int_from_string(char* string, long long* pval) {
 	return 1;
 }
 
+static inline int is_unsigned_hex_prefix(char* string) {
+	return string[0] == '0' && (string[1] == 'x' || string[1] == 'X');
+}
+
+// ----------------------------------------------------------------
+long long mlr_int_from_string_or_die(char* string) {
+	long long i;
+	if (!mlr_try_int_from_string(string, &i)) {
+		fprintf(stderr, "Couldn't parse \"%s\" as number.\n", string);
+		exit(1);
+	}
+	return i;
+}
+
+// E.g. "300" is a number; "300ms" is not.
+int mlr_try_float_from_string(char* string, double* pval) {
+	long long intv;
+	if (!is_unsigned_hex_prefix(string)) {
+		switch (scan_decimal_fast(string, &intv, pval)) {
+		case SCAN_NEITHER: return 0;
+		case SCAN_INT:     return 1;
+		case SCAN_FLOAT:   return 1;
+		}
+	}
+	return mlr_try_float_from_string_slow(string, pval);
+}
+
+// E.g. "300" is a number; "300ms" is not.
+int mlr_try_int_from_string(char* string, long long* pval) {
+	double fltv;
+	int rc = is_unsigned_hex_prefix(string)
+		? scan_hex_fast(string, pval)
+		: scan_decimal_fast(string, pval, &fltv);
+	switch (rc) {
+	case SCAN_NEITHER: return 0;
+	case SCAN_INT:     return 1;
+	case SCAN_FLOAT:   return 0;
+	}
+	return mlr_try_int_from_string_slow(string, pval);
+}
+
+// Same as trying int then float, but scanning the string only once.
+int mlr_try_int_or_float_from_string(char* string, long long* pintv, double* pfltv) {
+	if (is_unsigned_hex_prefix(string)) {
+		switch (scan_hex_fast(string, pintv)) {
+		case SCAN_NEITHER: break;
+		case SCAN_INT:     return MLR_SCANNED_INT;
+		default:
+			if (mlr_try_int_from_string_slow(string, pintv))
+				return MLR_SCANNED_INT;
+			break;
+		}
+	} else {
+		switch (scan_decimal_fast(string, pintv, pfltv)) {
+		case SCAN_NEITHER: return MLR_SCANNED_NEITHER;
+		case SCAN_INT:     return MLR_SCANNED_INT;
+		case SCAN_FLOAT:   return MLR_SCANNED_FLOAT;
+		}
+		if (mlr_try_int_from_string_slow(string, pintv))
+			return MLR_SCANNED_INT;
+	}
+	return mlr_try_float_from_string_slow(string, pfltv) ? MLR_SCANNED_FLOAT : MLR_SCANNED_NEITHER;
+}
+
 // ----------------------------------------------------------------
 static char* low_int_to_string_data[] = {
 	"0",   "1",  "2",  "3",  "4",  "5",  "6",  "7",  "8",  "9",
@@ -92,6 +92,14 @@ static inline char * mlr_strdup_or_die(const char *s1) {
 char * mlr_strdup_quoted_or_die(const char *s1);
 
 // The caller should free the return values from each of these.
+// Formatting into caller-provided buffers. The integer formatters need
+// MLR_NUMBER_FORMAT_BUFFER_SIZE bytes and return the string length.
+// mlr_format_double has snprintf return-value semantics.
+#define MLR_NUMBER_FORMAT_BUFFER_SIZE 64
+int mlr_format_ull(char* buf, unsigned long long value);
+int mlr_format_ll(char* buf, long long value);
+int mlr_format_double(char* buf, size_t bufsize, double value, char* fmt);
+
 char* mlr_alloc_string_from_double(double value, char* fmt);
 char* mlr_alloc_string_from_ull(unsigned long long value);
 char* mlr_alloc_string_from_ll(long long value);
@@ -106,6 +114,11 @@ double mlr_double_from_string_or_die(char* string);
 long long mlr_int_from_string_or_die(char* string);
 int    mlr_try_float_from_string(char* string, double* pval);
 int    mlr_try_int_from_string(char* string, long long* pval);
+// Returns one of the following, with *pintv or *pfltv set accordingly.
+#define MLR_SCANNED_NEITHER 0
+#define MLR_SCANNED_INT     1
+#define MLR_SCANNED_FLOAT   2
+int    mlr_try_int_or_float_from_string(char* string, long long* pintv, double* pfltv);
 
 // For small integers (as of this writing, 0 .. 100) returns a static string representation.
 // For other values, returns a dynamically allocated string representation.
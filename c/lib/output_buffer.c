@@ -0,0 +1,80 @@
+#include <stdlib.h>
+#include "lib/output_buffer.h"
+#include "lib/mlrutil.h"
+
+// ----------------------------------------------------------------
+output_buffer_t* obuf_alloc(size_t alloc_length) {
+	output_buffer_t* pobuf = mlr_malloc_or_die(sizeof(output_buffer_t));
+	obuf_init(pobuf, alloc_length);
+	return pobuf;
+}
+
+void obuf_free(output_buffer_t* pobuf) {
+	if (pobuf == NULL)
+		return;
+	obuf_uninit(pobuf);
+	free(pobuf);
+}
+
+// ----------------------------------------------------------------
+void obuf_init(output_buffer_t* pobuf, size_t alloc_length) {
+	pobuf->buffer        = mlr_malloc_or_die(alloc_length);
+	pobuf->used_length   = 0;
+	pobuf->alloc_length  = alloc_length;
+	pobuf->output_stream = NULL;
+}
+
+void obuf_uninit(output_buffer_t* pobuf) {
+	obuf_flush(pobuf);
+	free(pobuf->buffer);
+	pobuf->buffer = NULL;
+}
+
+// ----------------------------------------------------------------
+void obuf_set_stream(output_buffer_t* pobuf, FILE* output_stream) {
+	if (pobuf->output_stream != output_stream) {
+		obuf_flush(pobuf);
+		pobuf->output_stream = output_stream;
+	}
+}
+
+void obuf_flush(output_buffer_t* pobuf) {
+	if (pobuf->used_length > 0 && pobuf->output_stream != NULL)
+		fwrite(pobuf->buffer, 1, pobuf->used_length, pobuf->output_stream);
+	pobuf->used_length = 0;
+}
+
+// Strings too long to fit in what's left of the buffer: drain, then either
+// copy in or, if the string alone would fill the buffer, write it through.
+void _obuf_write_slow(output_buffer_t* pobuf, char* s, size_t len) {
+	obuf_flush(pobuf);
+	if (len >= pobuf->alloc_length) {
+		fwrite(s, 1, len, pobuf->output_stream);
+	} else {
+		memcpy(pobuf->buffer, s, len);
+		pobuf->used_length = len;
+	}
+}
+
+// ----------------------------------------------------------------
+void obuf_putc_repeated(output_buffer_t* pobuf, char c, int n) {
+	while (n > 0) {
+		if (pobuf->used_length >= pobuf->alloc_length)
+			obuf_flush(pobuf);
+		size_t avail = pobuf->alloc_length - pobuf->used_length;
+		size_t chunk = (size_t)n < avail ? (size_t)n : avail;
+		memset(&pobuf->buffer[pobuf->used_length], c, chunk);
+		pobuf->used_length += chunk;
+		n -= chunk;
+	}
+}
+
+void obuf_puts_repeated(output_buffer_t* pobuf, char* s, int n) {
+	size_t len = strlen(s);
+	if (len == 1) {
+		obuf_putc_repeated(pobuf, s[0], n);
+		return;
+	}
+	for (int i = 0; i < n; i++)
+		obuf_write(pobuf, s, len);
+}
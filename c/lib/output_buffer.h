@@ -0,0 +1,66 @@
+// ================================================================
+// Output buffer for the record writers. Writers append keys, separators, and
+// values with memcpy into a user-space buffer, which is handed to the
+// underlying FILE* with a single fwrite when it fills and again when the writer
+// is done with a record. This replaces one locked stdio call per token with one
+// per record.
+//
+// The FILE* remains the sink, so output from writers interleaves correctly with
+// anything else written to the same stream (DSL print/dump, tee -p, etc.) as
+// long as the buffer is flushed before the writer returns. Large drains go
+// straight through to write(2) since stdio doesn't re-buffer writes bigger
+// than its own buffer.
+// ================================================================
+
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <stdio.h>
+#include <string.h>
+
+#define OBUF_DEFAULT_ALLOC_LENGTH 16384
+
+typedef struct _output_buffer_t {
+	char*  buffer;
+	size_t used_length;
+	size_t alloc_length;
+	FILE*  output_stream;
+} output_buffer_t;
+
+output_buffer_t* obuf_alloc(size_t alloc_length);
+void obuf_free(output_buffer_t* pobuf);
+void obuf_init(output_buffer_t* pobuf, size_t alloc_length);
+void obuf_uninit(output_buffer_t* pobuf);
+
+// Drains any buffered output to the current stream (if one is set) and directs
+// subsequent output to the given one.
+void obuf_set_stream(output_buffer_t* pobuf, FILE* output_stream);
+// Hands buffered output to the FILE*. Does not fflush the FILE* itself.
+void obuf_flush(output_buffer_t* pobuf);
+void _obuf_write_slow(output_buffer_t* pobuf, char* s, size_t len); // private method
+
+static inline void obuf_putc(output_buffer_t* pobuf, char c) {
+	if (pobuf->used_length >= pobuf->alloc_length)
+		obuf_flush(pobuf);
+	pobuf->buffer[pobuf->used_length++] = c;
+}
+
+static inline void obuf_write(output_buffer_t* pobuf, char* s, size_t len) {
+	if (pobuf->used_length + len > pobuf->alloc_length) {
+		_obuf_write_slow(pobuf, s, len);
+	} else {
+		memcpy(&pobuf->buffer[pobuf->used_length], s, len);
+		pobuf->used_length += len;
+	}
+}
+
+static inline void obuf_puts(output_buffer_t* pobuf, char* s) {
+	obuf_write(pobuf, s, strlen(s));
+}
+
+// For padding: writes c n times (n <= 0 is a no-op).
+void obuf_putc_repeated(output_buffer_t* pobuf, char c, int n);
+// For padding with multi-character separators: writes s n times.
+void obuf_puts_repeated(output_buffer_t* pobuf, char* s, int n);
+
+#endif // OUTPUT_BUFFER_H
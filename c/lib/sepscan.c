@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include "lib/sepscan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define SEPSCAN_X86
+#include <immintrin.h>
+#endif
+
+static char* sepscan_find_resolve(char* p, char* end, char a, char b, char c, char d);
+
+sepscan_func_t* _sepscan_find_wide = sepscan_find_resolve;
+
+// ----------------------------------------------------------------
+char* sepscan_find_scalar(char* p, char* end, char a, char b, char c, char d) {
+	for ( ; p < end; p++) {
+		char x = *p;
+		if (x == a || x == b || x == c || x == d || x == 0)
+			return p;
+	}
+	return end;
+}
+
+// ----------------------------------------------------------------
+#ifdef SEPSCAN_X86
+
+int sepscan_have_sse2(void) {
+	return 1; // Part of the x86-64 baseline, and required by __SSE2__ above
+}
+
+char* sepscan_find_sse2(char* p, char* end, char a, char b, char c, char d) {
+	__m128i va = _mm_set1_epi8(a);
+	__m128i vb = _mm_set1_epi8(b);
+	__m128i vc = _mm_set1_epi8(c);
+	__m128i vd = _mm_set1_epi8(d);
+	__m128i vz = _mm_setzero_si128();
+	for ( ; end - p >= 16; p += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i*)p);
+		__m128i m = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)),
+			_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, vc), _mm_cmpeq_epi8(x, vd)), _mm_cmpeq_epi8(x, vz)));
+		int mask = _mm_movemask_epi8(m);
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+	}
+	return sepscan_find_scalar(p, end, a, b, c, d);
+}
+
+int sepscan_have_avx2(void) {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+
+__attribute__((target("avx2")))
+char* sepscan_find_avx2(char* p, char* end, char a, char b, char c, char d) {
+	__m256i va = _mm256_set1_epi8(a);
+	__m256i vb = _mm256_set1_epi8(b);
+	__m256i vc = _mm256_set1_epi8(c);
+	__m256i vd = _mm256_set1_epi8(d);
+	__m256i vz = _mm256_setzero_si256();
+	for ( ; end - p >= 32; p += 32) {
+		__m256i x = _mm256_loadu_si256((const __m256i*)p);
+		__m256i m = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(x, va), _mm256_cmpeq_epi8(x, vb)),
+			_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, vc), _mm256_cmpeq_epi8(x, vd)),
+				_mm256_cmpeq_epi8(x, vz)));
+		unsigned mask = (unsigned)_mm256_movemask_epi8(m);
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+	}
+	return sepscan_find_sse2(p, end, a, b, c, d);
+}
+
+#else // not SEPSCAN_X86
+
+int sepscan_have_sse2(void) {
+	return 0;
+}
+int sepscan_have_avx2(void) {
+	return 0;
+}
+char* sepscan_find_sse2(char* p, char* end, char a, char b, char c, char d) {
+	return sepscan_find_scalar(p, end, a, b, c, d);
+}
+char* sepscan_find_avx2(char* p, char* end, char a, char b, char c, char d) {
+	return sepscan_find_scalar(p, end, a, b, c, d);
+}
+
+#endif // SEPSCAN_X86
+
+// ----------------------------------------------------------------
+// The first call picks the widest kernel the CPU supports. Concurrent first
+// calls from multiple parser threads all store the same value, so an atomic
+// store suffices and there is no need to lock.
+static char* sepscan_find_resolve(char* p, char* end, char a, char b, char c, char d) {
+	sepscan_func_t* pfunc = sepscan_have_avx2() ? sepscan_find_avx2
+		: sepscan_have_sse2() ? sepscan_find_sse2
+		: sepscan_find_scalar;
+	__atomic_store_n(&_sepscan_find_wide, pfunc, __ATOMIC_RELAXED);
+	return pfunc(p, end, a, b, c, d);
+}
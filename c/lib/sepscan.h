@@ -0,0 +1,42 @@
+// ================================================================
+// Separator scanning for the mmap record readers. Given up to four
+// single-byte separators (e.g. IRS, IFS, IPS, and double quote), finds the
+// next occurrence of any of them -- or of a NUL byte, at which the readers
+// also stop -- looking at 16 or 32 bytes at a time with SSE2 or AVX2 where
+// available. The vector width is chosen at runtime from the CPU's
+// capabilities; there is a scalar fallback for other platforms.
+//
+// Callers wanting fewer than four separators should repeat one of them.
+// ================================================================
+
+#ifndef SEPSCAN_H
+#define SEPSCAN_H
+
+typedef char* sepscan_func_t(char* p, char* end, char a, char b, char c, char d);
+
+// Set on first use; exposed only so the inline wrapper below can call through it. Accessed
+// atomically since parser threads may make their first calls at once.
+extern sepscan_func_t* _sepscan_find_wide;
+
+// Returns a pointer to the first byte in [p, end) which is a, b, c, d, or
+// NUL; returns end if there is none. Never reads at or past end.
+//
+// Fields are often only a few bytes long, so the first few bytes are checked
+// inline before going wide.
+static inline char* sepscan_find(char* p, char* end, char a, char b, char c, char d) {
+	for (int i = 0; i < 4 && p < end; i++, p++) {
+		char x = *p;
+		if (x == a || x == b || x == c || x == d || x == 0)
+			return p;
+	}
+	return (p < end) ? __atomic_load_n(&_sepscan_find_wide, __ATOMIC_RELAXED)(p, end, a, b, c, d) : end;
+}
+
+// For unit-testing the non-dispatched kernels.
+char* sepscan_find_scalar(char* p, char* end, char a, char b, char c, char d);
+char* sepscan_find_sse2(char* p, char* end, char a, char b, char c, char d);
+char* sepscan_find_avx2(char* p, char* end, char a, char b, char c, char d);
+int   sepscan_have_sse2(void);
+int   sepscan_have_avx2(void);
+
+#endif // SEPSCAN_H
@@ -1,6 +1,8 @@
 #ifndef STRING_BUILDER_H
 #define STRING_BUILDER_H
 
+#include <string.h>
+
 typedef struct _string_builder_t {
 	int used_length;
 	int alloc_length;
@@ -28,6 +30,12 @@ static inline void sb_append_char_range(string_builder_t* psb, char* b, char* e)
 	while (p <= e)
 		sb_append_char(psb, *(p++));
 }
+static inline void sb_append_bytes(string_builder_t* psb, char* s, int length) {
+	while (psb->used_length + length > psb->alloc_length)
+		_sb_enlarge(psb);
+	memcpy(psb->buffer + psb->used_length, s, length);
+	psb->used_length += length;
+}
 
 void  sb_append_string(string_builder_t* psb, char* s);
 int   sb_is_empty(string_builder_t* psb);
@@ -17,12 +17,41 @@ struct _mapper_t; // forward reference for method declarations
 // Returns linked list of records (lrec_t*).
 typedef sllv_t* mapper_process_func_t(lrec_t* pinrec, context_t* pctx, void* pvstate);
 
+// At end of stream, a mapper with more output than it should hold in memory at once (e.g. sort
+// with --max-memory) may end its returned list with MAPPER_MORE_OUTPUT rather than with null.
+// That part of the output is passed down the chain, then the mapper is called again with null
+// input for the next part, and so on until it ends a list with null as usual.
+extern lrec_t mapper_more_output_marker;
+#define MAPPER_MORE_OUTPUT (&mapper_more_output_marker)
+
 typedef void mapper_free_func_t(struct _mapper_t* pmapper, context_t* pctx);
 
+// For mappers which pass each record on unchanged or drop it, with no other effect (e.g. mlr
+// filter --batch): decides for a batch of records at once which are to be kept. Records with
+// verdict MAPPER_SELECT_KEEP go on to the rest of the chain as they are, and those with verdict
+// MAPPER_SELECT_UNDECIDED go through pprocess_func as usual. The stream does this where it has
+// records in hand in batches of at most MAPPER_SELECT_BATCH_SIZE, so each can still go down the
+// chain with its own context.
+#define MAPPER_SELECT_DROP       0
+#define MAPPER_SELECT_KEEP       1
+#define MAPPER_SELECT_UNDECIDED  2
+#define MAPPER_SELECT_BATCH_SIZE 1024
+typedef void mapper_select_batch_func_t(lrec_t** precords, int num_records, char* pverdicts, void* pvstate);
+
+// For mappers which can map a batch of records at once (e.g. join -u spreading them over worker
+// threads): sets pout_recs[i] to the output for precords[i], as pprocess_func would return it.
+// With mlr --threads the stream calls this instead of pprocess_func for the first mapper after
+// any stateless ones, a batch of at most MAPPER_SELECT_BATCH_SIZE records at a time, and passes
+// each record's output down the rest of the chain with that record's context. The end-of-stream
+// null still goes through pprocess_func.
+typedef void mapper_process_batch_func_t(lrec_t** precords, int num_records, sllv_t** pout_recs, void* pvstate);
+
 typedef struct _mapper_t {
 	void* pvstate;
 	mapper_process_func_t* pprocess_func;
 	mapper_free_func_t*    pfree_func; // virtual destructor
+	mapper_select_batch_func_t*  pselect_batch_func;  // null for most mappers
+	mapper_process_batch_func_t* pprocess_batch_func; // null for most mappers
 } mapper_t;
 
 // ----------------------------------------------------------------
@@ -32,11 +61,29 @@ typedef void mapper_usage_func_t(FILE* o, char* argv0, char* verb);
 typedef      mapper_t* mapper_parse_cli_func_t(int* pargi, int argc, char** argv,
 	cli_reader_opts_t* pmain_reader_opts, cli_writer_opts_t* pmain_writer_opts);
 
+// A mapper is stateless if it maps each input record to at most one output record, depending
+// only on that record and the context, with no other side effects (such as writing to stdout)
+// and nothing emitted at end of stream. With mlr --threads, separate instances of stateless
+// mappers at the start of the then-chain are run on different records in parallel. This is a
+// function of the constructed mapper rather than a flag on the setup since e.g. cat is stateless
+// but cat -n isn't.
+typedef int mapper_is_stateless_func_t(mapper_t* pmapper);
+
+// For fusing e.g. 'sort -nr x then head -n 10' so that the sort need keep only ten records. The
+// first returns n if only a mapper's first n input records can affect its output (e.g. head
+// without -g), else -1. The second tells a mapper that only the first n records of its output
+// will be used.
+typedef long long mapper_get_input_limit_func_t(mapper_t* pmapper);
+typedef void      mapper_set_output_limit_func_t(mapper_t* pmapper, long long limit);
+
 typedef struct _mapper_setup_t {
 	char*                    verb;
 	mapper_usage_func_t*     pusage_func;
 	mapper_parse_cli_func_t* pparse_func;
 	int                      ignores_input; // most don't; data-generators like seqgen do
+	mapper_is_stateless_func_t* pis_stateless_func; // null for verbs which are never stateless
+	mapper_get_input_limit_func_t*  pget_input_limit_func;  // null if never limited
+	mapper_set_output_limit_func_t* pset_output_limit_func; // null if of no use
 } mapper_setup_t;
 
 #endif // MAPPER_H
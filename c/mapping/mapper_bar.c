@@ -169,6 +169,8 @@ static mapper_t* mapper_bar_alloc(ap_state_t* pargp, string_array_t* pfield_name
 		: mapper_bar_process_no_auto;
 	pmapper->pvstate    = (void*)pstate;
 	pmapper->pfree_func = mapper_bar_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -78,6 +78,8 @@ static mapper_t* mapper_bootstrap_alloc(int nout, ap_state_t* pargp) {
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_bootstrap_process;
 	pmapper->pfree_func    = mapper_bootstrap_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
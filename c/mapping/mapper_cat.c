@@ -21,6 +21,7 @@ static mapper_t* mapper_cat_parse_cli(int* pargi, int argc, char** argv,
 static mapper_t* mapper_cat_alloc(ap_state_t* pargp, int do_counters, char* counter_field_name,
 	slls_t* pgroup_by_field_names);
 static void      mapper_cat_free(mapper_t* pmapper, context_t* _);
+static int       mapper_cat_is_stateless(mapper_t* pmapper);
 static sllv_t*   mapper_cat_process(lrec_t* pinrec, context_t* pctx, void* pvstate);
 static sllv_t*   mapper_catn_process_ungrouped(lrec_t* pinrec, context_t* pctx, void* pvstate);
 static sllv_t*   mapper_catn_process_grouped(lrec_t* pinrec, context_t* pctx, void* pvstate);
@@ -31,6 +32,7 @@ mapper_setup_t mapper_cat_setup = {
 	.pusage_func = mapper_cat_usage,
 	.pparse_func = mapper_cat_parse_cli,
 	.ignores_input = FALSE,
+	.pis_stateless_func = mapper_cat_is_stateless,
 };
 
 // ----------------------------------------------------------------
@@ -105,6 +107,8 @@ static mapper_t* mapper_cat_alloc(ap_state_t* pargp, int do_counters, char* coun
 	}
 
 	pmapper->pfree_func           = mapper_cat_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 	return pmapper;
 }
 static void mapper_cat_free(mapper_t* pmapper, context_t* _) {
@@ -119,6 +123,11 @@ static void mapper_cat_free(mapper_t* pmapper, context_t* _) {
 	free(pmapper);
 }
 
+// Record-counters are per-stream state.
+static int mapper_cat_is_stateless(mapper_t* pmapper) {
+	return pmapper->pprocess_func == mapper_cat_process;
+}
+
 // ----------------------------------------------------------------
 static sllv_t* mapper_cat_process(lrec_t* pinrec, context_t* pctx, void* pvstate) {
 	if (pinrec != NULL)
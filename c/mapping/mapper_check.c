@@ -42,6 +42,8 @@ static mapper_t* mapper_check_alloc() {
 	pmapper->pvstate       = NULL;
 	pmapper->pprocess_func = mapper_check_process;
 	pmapper->pfree_func    = mapper_check_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 	return pmapper;
 }
 static void mapper_check_free(mapper_t* pmapper, context_t* _) {
@@ -11,7 +11,7 @@ typedef struct _mapper_cut_state_t {
 	ap_state_t* pargp;
 	slls_t*  pfield_name_list;
 	hss_t*   pfield_name_set;
-	regex_t* regexes;
+	mlr_regex_t* regexes;
 	int      nregex;
 	int      do_arg_order;
 	int      do_complement;
@@ -32,6 +32,7 @@ mapper_setup_t mapper_cut_setup = {
 	.pusage_func = mapper_cut_usage,
 	.pparse_func = mapper_cut_parse_cli,
 	.ignores_input = FALSE,
+	.pis_stateless_func = mapper_is_always_stateless,
 };
 
 // ----------------------------------------------------------------
@@ -104,7 +105,7 @@ static mapper_t* mapper_cut_alloc(ap_state_t* pargp, slls_t* pfield_name_list,
 		pstate->pfield_name_list   = NULL;
 		pstate->pfield_name_set    = NULL;
 		pstate->nregex = pfield_name_list->length;
-		pstate->regexes = mlr_malloc_or_die(pstate->nregex * sizeof(regex_t));
+		pstate->regexes = mlr_malloc_or_die(pstate->nregex * sizeof(mlr_regex_t));
 		int i = 0;
 		for (sllse_t* pe = pfield_name_list->phead; pe != NULL; pe = pe->pnext, i++) {
 			// Let them type in a.*b if they want, or "a.*b", or "a.*b"i.
@@ -119,6 +120,8 @@ static mapper_t* mapper_cut_alloc(ap_state_t* pargp, slls_t* pfield_name_list,
 
 	pmapper->pvstate       = (void*)pstate;
 	pmapper->pfree_func    = mapper_cut_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -128,7 +131,7 @@ static void mapper_cut_free(mapper_t* pmapper, context_t* _) {
 	slls_free(pstate->pfield_name_list);
 	hss_free(pstate->pfield_name_set);
 	for (int i = 0; i < pstate->nregex; i++)
-		regfree(&pstate->regexes[i]);
+		mlr_regfree(&pstate->regexes[i]);
 	free(pstate->regexes);
 	ap_free(pstate->pargp);
 	free(pstate);
@@ -84,6 +84,8 @@ static mapper_t* mapper_decimate_alloc(ap_state_t* pargp, slls_t* pgroup_by_fiel
 	pmapper->pvstate        = pstate;
 	pmapper->pprocess_func  = mapper_decimate_process;
 	pmapper->pfree_func     = mapper_decimate_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
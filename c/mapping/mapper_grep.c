@@ -10,7 +10,7 @@
 typedef struct _mapper_grep_state_t {
 	ap_state_t* pargp;
 	int exclude;
-	regex_t regex;
+	mlr_regex_t regex;
 	cli_writer_opts_t* pwriter_opts;
 } mapper_grep_state_t;
 
@@ -28,6 +28,7 @@ mapper_setup_t mapper_grep_setup = {
 	.pusage_func = mapper_grep_usage,
 	.pparse_func = mapper_grep_parse_cli,
 	.ignores_input = FALSE,
+	.pis_stateless_func = mapper_is_always_stateless,
 };
 
 // ----------------------------------------------------------------
@@ -101,11 +102,13 @@ static mapper_t* mapper_grep_alloc(ap_state_t* pargp, char* regex_string, int ex
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_grep_process;
 	pmapper->pfree_func    = mapper_grep_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 	return pmapper;
 }
 static void mapper_grep_free(mapper_t* pmapper, context_t* _) {
 	mapper_grep_state_t* pstate = pmapper->pvstate;
-	regfree(&pstate->regex);
+	mlr_regfree(&pstate->regex);
 	ap_free(pstate->pargp);
 	free(pstate);
 	free(pmapper);
@@ -56,6 +56,8 @@ static mapper_t* mapper_group_like_alloc() {
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_group_like_process;
 	pmapper->pfree_func    = mapper_group_like_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -21,7 +21,7 @@ typedef enum _criterion_t {
 typedef struct _mapper_having_fields_state_t {
 	slls_t* pfield_names;
 	hss_t*  pfield_name_set;
-	regex_t regex;
+	mlr_regex_t regex;
 } mapper_having_fields_state_t;
 
 static void      mapper_having_fields_usage(FILE* o, char* argv0, char* verb);
@@ -166,6 +166,8 @@ static mapper_t* mapper_having_fields_alloc(slls_t* pfield_names, char* regex_st
 		else if (criterion == HAVING_NO_FIELDS_MATCHING)
 			pmapper->pprocess_func = mapper_having_no_fields_matching_process;
 		pmapper->pfree_func = mapper_having_fields_free;
+		pmapper->pselect_batch_func = NULL;
+		pmapper->pprocess_batch_func = NULL;
 
 	} else {
 		pstate->pfield_names    = pfield_names;
@@ -181,6 +183,8 @@ static mapper_t* mapper_having_fields_alloc(slls_t* pfield_names, char* regex_st
 		else if (criterion == HAVING_FIELDS_AT_MOST)
 			pmapper->pprocess_func = mapper_having_fields_at_most_process;
 		pmapper->pfree_func = mapper_having_fields_free;
+		pmapper->pselect_batch_func = NULL;
+		pmapper->pprocess_batch_func = NULL;
 	}
 
 	return pmapper;
@@ -192,7 +196,7 @@ static void mapper_having_fields_free(mapper_t* pmapper, context_t* _) {
 		slls_free(pstate->pfield_names);
 	if (pstate->pfield_name_set != NULL)
 		hss_free(pstate->pfield_name_set);
-	regfree(&pstate->regex);
+	mlr_regfree(&pstate->regex);
 	free(pstate);
 	free(pmapper);
 }
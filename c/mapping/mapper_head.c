@@ -25,6 +25,7 @@ static mapper_t* mapper_head_alloc(ap_state_t* pargp, slls_t* pgroup_by_field_na
 static void      mapper_head_free(mapper_t* pmapper, context_t* _);
 static sllv_t*   mapper_head_process_unkeyed(lrec_t* pinrec, context_t* pctx, void* pvstate);
 static sllv_t*   mapper_head_process_keyed(lrec_t* pinrec, context_t* pctx, void* pvstate);
+static long long mapper_head_get_input_limit(mapper_t* pmapper);
 
 // ----------------------------------------------------------------
 mapper_setup_t mapper_head_setup = {
@@ -32,6 +33,7 @@ mapper_setup_t mapper_head_setup = {
 	.pusage_func = mapper_head_usage,
 	.pparse_func = mapper_head_parse_cli,
 	.ignores_input = FALSE,
+	.pget_input_limit_func = mapper_head_get_input_limit,
 };
 
 // ----------------------------------------------------------------
@@ -81,6 +83,8 @@ static mapper_t* mapper_head_alloc(ap_state_t* pargp, slls_t* pgroup_by_field_na
 		? mapper_head_process_unkeyed
 		: mapper_head_process_keyed;
 	pmapper->pfree_func     = mapper_head_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -100,6 +104,12 @@ static void mapper_head_free(mapper_t* pmapper, context_t* _) {
 	free(pmapper);
 }
 
+// ----------------------------------------------------------------
+static long long mapper_head_get_input_limit(mapper_t* pmapper) {
+	mapper_head_state_t* pstate = pmapper->pvstate;
+	return (pstate->pgroup_by_field_names->length == 0) ? pstate->head_count : -1LL;
+}
+
 // ----------------------------------------------------------------
 static sllv_t* mapper_head_process_unkeyed(lrec_t* pinrec, context_t* pctx, void* pvstate) {
 	mapper_head_state_t* pstate = pvstate;
@@ -1,3 +1,5 @@
+#include <pthread.h>
+#include <string.h>
 #include "lib/mlr_globals.h"
 #include "lib/mlrutil.h"
 #include "containers/lrec.h"
@@ -5,9 +7,61 @@
 #include "containers/lhmslv.h"
 #include "containers/mixutil.h"
 #include "containers/join_bucket_keeper.h"
+#include "containers/lrec_spill.h"
+#include "containers/join_index.h"
+#include "containers/batch_queue.h"
 #include "mapping/mappers.h"
 #include "input/lrec_readers.h"
 
+// ----------------------------------------------------------------
+// With -u and --max-memory, once the left-file records held pass that size (approximately), the
+// join becomes a partitioned hash join: the left records, and then the right records as they
+// arrive, are written to one of JOIN_NUM_PARTITIONS temporary files per side according to a hash
+// of their join-field values. Matching records thus land in same-numbered partitions. At end of
+// stream each left partition in turn is loaded into a hash map and its right partition is
+// streamed against it. A left partition which is itself too big is split likewise, along with its
+// right partition, using a different hash, up to JOIN_MAX_PARTITION_LEVEL times; past that (e.g.
+// a single join-field value having too many records) it is loaded regardless.
+//
+// Pairing semantics, and --np/--ul/--ur, are as without --max-memory but the output is grouped by
+// partition rather than in right-file order. Right records lacking the join fields are emitted
+// (with --ur) as they arrive; left records lacking them (with --ul) come at the very end.
+
+#define JOIN_NUM_PARTITIONS      16
+#define JOIN_MAX_PARTITION_LEVEL 3
+#define JOIN_OUTPUT_BATCH_SIZE   500
+#define JOIN_BUCKET_OVERHEAD     128
+
+typedef struct _join_partition_t {
+	FILE* pleft_file;
+	FILE* pright_file;
+	int   level;
+} join_partition_t;
+
+// ----------------------------------------------------------------
+// With -u and mlr --threads n for n > 1, once the left records are in memory (or in an index) the
+// right records are probed against them on n threads. The stream hands over right records a batch
+// at a time (see mapper_process_batch_func_t); each batch is cut into n slices, one for each of
+// n - 1 worker threads and one for the calling thread. Each right record's output is returned
+// separately so that it goes down the chain with that record's own NR, FNR, and FILENAME. The left
+// buckets are shared read-only, except that was_paired is only ever set, atomically. This isn't
+// done once spilled past --max-memory.
+
+typedef struct _join_probe_slice_t {
+	lrec_t** pright_records;
+	int      length;
+	sllv_t** pout_recs; // one list per right record
+} join_probe_slice_t;
+
+struct _mapper_join_state_t;
+typedef struct _join_probe_worker_t {
+	struct _mapper_join_state_t* pstate;
+	join_probe_slice_t slice;
+	batch_queue_t* pin_queue;
+	batch_queue_t* pout_queue;
+	pthread_t      thread;
+} join_probe_worker_t;
+
 // ----------------------------------------------------------------
 typedef struct _mapper_join_opts_t {
 	char*    left_prefix;
@@ -26,6 +80,12 @@ typedef struct _mapper_join_opts_t {
 	char*    prepipe;
 	char*    left_file_name;
 
+	long long max_memory; // zero for unbounded
+	char*    tmpdir;
+
+	char*    build_index_file_name;
+	char*    use_index_file_name;
+
 	// These allow the joiner to have its own different format/delimiter for
 	// the left-file:
 	cli_reader_opts_t reader_opts;
@@ -45,6 +105,23 @@ typedef struct _mapper_join_state_t {
 	lhmslv_t* pleft_buckets_by_join_field_values;
 	sllv_t*   pleft_unpaired_records;
 
+	// For unsorted input past --max-memory
+	long long         left_memory_used;
+	join_partition_t* ptop_partitions; // non-null once spilled
+	sllv_t*           ppending_partitions;
+	join_partition_t* pcurrent_partition;
+	FILE*             pleft_unpaired_file;
+
+	// For unsorted input with --use-index. Bucket records are instantiated on first pairing.
+	join_index_t*     pjoin_index;
+	sllv_t**          pindex_bucket_records;
+	char*             index_bucket_was_paired;
+	long long         index_emit_position; // for --ul at end of stream
+
+	// For unsorted input with mlr --threads
+	int                  num_probe_workers; // -1 until the first right batch is seen; 0 for serial probing
+	join_probe_worker_t* pprobe_workers;
+
 } mapper_join_state_t;
 
 // ----------------------------------------------------------------
@@ -54,10 +131,31 @@ static mapper_t* mapper_join_parse_cli(int* pargi, int argc, char** argv,
 static mapper_t* mapper_join_alloc(mapper_join_opts_t* popts);
 static void mapper_join_free(mapper_t* pmapper, context_t* _);
 static void ingest_left_file(mapper_join_state_t* pstate);
+static int join_bucket_map_add(lhmslv_t* pbuckets, slls_t* pleft_field_values, lrec_t* pleft_rec);
+static void join_bucket_map_free(lhmslv_t* pbuckets);
+static void mapper_join_pair_unsorted(mapper_join_state_t* pstate, lrec_t* pright_rec, sllv_t* pout_recs);
+static void mapper_join_spill_left(mapper_join_state_t* pstate);
+static sllv_t* mapper_join_emit_spilled(mapper_join_state_t* pstate);
+static void mapper_join_open_index(mapper_join_state_t* pstate);
+static void mapper_join_pair_indexed(mapper_join_state_t* pstate, slls_t* pright_field_values, lrec_t* pright_rec,
+	sllv_t* pout_recs);
+static sllv_t* mapper_join_emit_indexed(mapper_join_state_t* pstate);
+static sllv_t* mapper_join_index_bucket_records(mapper_join_state_t* pstate, long long bucket_index);
+static void mapper_join_start_probe_workers(mapper_join_state_t* pstate);
+static void* mapper_join_probe_worker_thread(void* pvarg);
+static void mapper_join_stop_probe_workers(mapper_join_state_t* pstate);
+static int mapper_join_load_partition(mapper_join_state_t* pstate, join_partition_t* ppartition);
+static join_partition_t* join_partitions_alloc(char* tmpdir, int level);
+static void join_partition_free(join_partition_t* ppartition);
+static int join_partition_index(slls_t* pfield_values, int level);
+static void join_partition_write(mapper_join_state_t* pstate, join_partition_t* ppartitions, lrec_t* pleft_rec);
 static void mapper_join_form_pairs(sllv_t* pleft_records, lrec_t* pright_rec, mapper_join_state_t* pstate,
 	sllv_t* pout_recs);
 static sllv_t* mapper_join_process_sorted(lrec_t* pright_rec, context_t* pctx, void* pvstate);
 static sllv_t* mapper_join_process_unsorted(lrec_t* pright_rec, context_t* pctx, void* pvstate);
+static void mapper_join_prepare_unsorted(mapper_join_state_t* pstate);
+static void mapper_join_process_unsorted_batch(lrec_t** pright_records, int num_records, sllv_t** pout_recs,
+	void* pvstate);
 
 mapper_setup_t mapper_join_setup = {
 	.verb = "join",
@@ -91,10 +189,25 @@ static void mapper_join_usage(FILE* o, char* argv0, char* verb) {
 	fprintf(o, "               be loaded into memory. Without -u, records must be sorted\n");
 	fprintf(o, "               lexically by their join-field names, else not all records will\n");
 	fprintf(o, "               be paired.\n");
+	fprintf(o, "  --max-memory {size} With -u, hold about this much of the left file in memory\n");
+	fprintf(o, "               at most, hash-partitioning both inputs into temporary files\n");
+	fprintf(o, "               past that. Output is then grouped by partition. Size is in\n");
+	fprintf(o, "               bytes, with optional k, m, or g suffix.\n");
+	fprintf(o, "  --tmpdir {dir} Directory for the temporary files. Default $TMPDIR else /tmp.\n");
+	fprintf(o, "  --build-index {index file name} Implies -u. Also write an index of the left\n");
+	fprintf(o, "               file for use by later joins with --use-index.\n");
+	fprintf(o, "  --use-index {index file name} Implies -u. Instead of reading the left file,\n");
+	fprintf(o, "               look up its records in an index made by --build-index with the\n");
+	fprintf(o, "               same -f, -l, and left-file format options. It is an error if the\n");
+	fprintf(o, "               left file has changed since.\n");
 	fprintf(o, "  --prepipe {command} As in main input options; see %s --help for details.\n",
 		MLR_GLOBALS.bargv0);
 	fprintf(o, "               If you wish to use a prepipe command for the main input as well\n");
 	fprintf(o, "               as here, it must be specified there as well as here.\n");
+	fprintf(o, "With -u and %s --threads n for n > 1, right records are paired with the left\n",
+		argv0);
+	fprintf(o, "records on n threads in parallel (except past --max-memory), with output in the\n");
+	fprintf(o, "same order as otherwise.\n");
 	fprintf(o, "File-format options default to those for the right file names on the Miller\n");
 	fprintf(o, "argument list, but may be overridden for the left file as follows. Please see\n");
 	fprintf(o, "the main \"%s --help\" for more information on syntax for these arguments.\n", argv0);
@@ -134,6 +247,10 @@ static mapper_t* mapper_join_parse_cli(int* pargi, int argc, char** argv,
 	popts->emit_left_unpairables               = FALSE;
 	popts->emit_right_unpairables              = FALSE;
 	popts->allow_unsorted_input                = FALSE;
+	popts->max_memory                          = 0LL;
+	popts->tmpdir                              = lrec_spill_default_tmpdir();
+	popts->build_index_file_name               = NULL;
+	popts->use_index_file_name                 = NULL;
 
 	int argi = *pargi;
 	char* verb = argv[argi++];
@@ -221,6 +338,44 @@ static mapper_t* mapper_join_parse_cli(int* pargi, int argc, char** argv,
 			popts->allow_unsorted_input = TRUE;
 			argi += 1;
 
+		} else if (streq(argv[argi], "--max-memory")) {
+			if ((argc - argi) < 2) {
+				mapper_join_usage(stderr, argv[0], verb);
+				return NULL;
+			}
+			popts->max_memory = lrec_spill_parse_memory_size(argv[argi+1]);
+			if (popts->max_memory <= 0LL) {
+				mapper_join_usage(stderr, argv[0], verb);
+				return NULL;
+			}
+			argi += 2;
+
+		} else if (streq(argv[argi], "--tmpdir")) {
+			if ((argc - argi) < 2) {
+				mapper_join_usage(stderr, argv[0], verb);
+				return NULL;
+			}
+			popts->tmpdir = argv[argi+1];
+			argi += 2;
+
+		} else if (streq(argv[argi], "--build-index")) {
+			if ((argc - argi) < 2) {
+				mapper_join_usage(stderr, argv[0], verb);
+				return NULL;
+			}
+			popts->build_index_file_name = argv[argi+1];
+			popts->allow_unsorted_input = TRUE;
+			argi += 2;
+
+		} else if (streq(argv[argi], "--use-index")) {
+			if ((argc - argi) < 2) {
+				mapper_join_usage(stderr, argv[0], verb);
+				return NULL;
+			}
+			popts->use_index_file_name = argv[argi+1];
+			popts->allow_unsorted_input = TRUE;
+			argi += 2;
+
 		} else {
 			mapper_join_usage(stderr, argv[0], verb);
 			return NULL;
@@ -230,6 +385,10 @@ static mapper_t* mapper_join_parse_cli(int* pargi, int argc, char** argv,
 
 	cli_merge_reader_opts(&popts->reader_opts, pmain_reader_opts);
 
+	// The index is of the entire left file, and lookups in it need no memory bound.
+	if (popts->build_index_file_name != NULL || popts->use_index_file_name != NULL)
+		popts->max_memory = 0LL;
+
 	// popen is a stdio construct, not an mmap construct, and it can't be supported here.
 	if (popts->prepipe != NULL)
 		popts->reader_opts.use_mmap_for_read = FALSE;
@@ -240,6 +399,12 @@ static mapper_t* mapper_join_parse_cli(int* pargi, int argc, char** argv,
 		return NULL;
 	}
 
+	if (popts->build_index_file_name != NULL && popts->use_index_file_name != NULL) {
+		fprintf(stderr, "%s %s: --build-index and --use-index are mutually exclusive.\n",
+			MLR_GLOBALS.bargv0, verb);
+		return NULL;
+	}
+
 	if (!popts->emit_pairables && !popts->emit_left_unpairables && !popts->emit_right_unpairables) {
 		fprintf(stderr, "%s %s: all emit flags are unset; no output is possible.\n",
 			MLR_GLOBALS.bargv0, verb);
@@ -289,14 +454,28 @@ static mapper_t* mapper_join_alloc(mapper_join_opts_t* popts) {
 
 	pstate->pleft_buckets_by_join_field_values = NULL;
 	pstate->pleft_unpaired_records             = NULL;
+	pstate->left_memory_used                   = 0LL;
+	pstate->ptop_partitions                    = NULL;
+	pstate->ppending_partitions                = NULL;
+	pstate->pcurrent_partition                 = NULL;
+	pstate->pleft_unpaired_file                = NULL;
+	pstate->pjoin_index                        = NULL;
+	pstate->pindex_bucket_records              = NULL;
+	pstate->index_bucket_was_paired            = NULL;
+	pstate->index_emit_position                = 0LL;
+	pstate->num_probe_workers                  = -1;
+	pstate->pprobe_workers                     = NULL;
 
 	pmapper->pvstate = (void*)pstate;
 	if (popts->allow_unsorted_input) {
 		pmapper->pprocess_func = mapper_join_process_unsorted;
+		pmapper->pprocess_batch_func = mapper_join_process_unsorted_batch;
 	} else {
 		pmapper->pprocess_func = mapper_join_process_sorted;
+		pmapper->pprocess_batch_func = NULL;
 	}
 	pmapper->pfree_func = mapper_join_free;
+	pmapper->pselect_batch_func = NULL;
 
 	return pmapper;
 }
@@ -305,17 +484,43 @@ static mapper_t* mapper_join_alloc(mapper_join_opts_t* popts) {
 static void mapper_join_free(mapper_t* pmapper, context_t* _) {
 	mapper_join_state_t* pstate = pmapper->pvstate;
 
-	if (pstate->pleft_buckets_by_join_field_values != NULL) {
-		for (lhmslve_t* pe = pstate->pleft_buckets_by_join_field_values->phead; pe != NULL; pe = pe->pnext) {
-			join_bucket_t* pbucket = pe->pvvalue;
-			slls_free(pbucket->pleft_field_values);
-			if (pbucket->precords)
-				while (pbucket->precords->phead)
-					lrec_free(sllv_pop(pbucket->precords));
-			sllv_free(pbucket->precords);
-			free(pbucket);
+	if (pstate->num_probe_workers > 0) // end of stream was never seen
+		mapper_join_stop_probe_workers(pstate);
+
+	if (pstate->pleft_buckets_by_join_field_values != NULL)
+		join_bucket_map_free(pstate->pleft_buckets_by_join_field_values);
+
+	// Left over if the mapper is freed before the end of its output, e.g. on error.
+	if (pstate->ptop_partitions != NULL) {
+		if (pstate->ppending_partitions == NULL) {
+			for (int i = 0; i < JOIN_NUM_PARTITIONS; i++) {
+				fclose(pstate->ptop_partitions[i].pleft_file);
+				fclose(pstate->ptop_partitions[i].pright_file);
+			}
+		} else {
+			while (pstate->ppending_partitions->phead)
+				join_partition_free(sllv_pop(pstate->ppending_partitions));
+			sllv_free(pstate->ppending_partitions);
+			if (pstate->pcurrent_partition != NULL)
+				join_partition_free(pstate->pcurrent_partition);
 		}
-		lhmslv_free(pstate->pleft_buckets_by_join_field_values);
+		free(pstate->ptop_partitions);
+	}
+	if (pstate->pleft_unpaired_file != NULL)
+		fclose(pstate->pleft_unpaired_file);
+
+	if (pstate->pjoin_index != NULL) {
+		for (long long i = 0; i < pstate->pjoin_index->num_buckets; i++) {
+			sllv_t* precords = pstate->pindex_bucket_records[i];
+			if (precords != NULL) {
+				while (precords->phead)
+					lrec_free(sllv_pop(precords));
+				sllv_free(precords);
+			}
+		}
+		free(pstate->pindex_bucket_records);
+		free(pstate->index_bucket_was_paired);
+		join_index_free(pstate->pjoin_index);
 	}
 
 	// The void-star payload, which is lrec_t*'s, should have been sllv_transferred out.
@@ -405,13 +610,15 @@ static sllv_t* mapper_join_process_sorted(lrec_t* pright_rec, context_t* pctx, v
 static sllv_t* mapper_join_process_unsorted(lrec_t* pright_rec, context_t* pctx, void* pvstate) {
 	mapper_join_state_t* pstate = (mapper_join_state_t*)pvstate;
 
-	if (pstate->pleft_unpaired_records == NULL) // First call
-		pstate->pleft_unpaired_records = sllv_alloc();
+	mapper_join_prepare_unsorted(pstate);
+	if (pright_rec == NULL && pstate->num_probe_workers > 0)
+		mapper_join_stop_probe_workers(pstate);
 
-	// This can't be done in the CLI-parser since it requires information which
-	// isn't known until after the CLI-parser is called.
-	if (pstate->pleft_buckets_by_join_field_values == NULL) // First call
-		ingest_left_file(pstate);
+	if (pright_rec == NULL && pstate->pjoin_index != NULL)
+		return mapper_join_emit_indexed(pstate);
+
+	if (pright_rec == NULL && pstate->ptop_partitions != NULL)
+		return mapper_join_emit_spilled(pstate);
 
 	if (pright_rec == NULL) { // End of input record stream
 		if (pstate->popts->emit_left_unpairables) {
@@ -436,34 +643,114 @@ static sllv_t* mapper_join_process_unsorted(lrec_t* pright_rec, context_t* pctx,
 		}
 	}
 
+	sllv_t* pout_recs = sllv_alloc();
+	mapper_join_pair_unsorted(pstate, pright_rec, pout_recs);
+	return pout_recs;
+}
+
+// ----------------------------------------------------------------
+static void mapper_join_prepare_unsorted(mapper_join_state_t* pstate) {
+	if (pstate->pleft_unpaired_records == NULL) // First call
+		pstate->pleft_unpaired_records = sllv_alloc();
+
+	// This can't be done in the CLI-parser since it requires information which
+	// isn't known until after the CLI-parser is called.
+	if (pstate->pleft_buckets_by_join_field_values == NULL) { // First call
+		if (pstate->popts->use_index_file_name != NULL) {
+			mapper_join_open_index(pstate);
+		} else {
+			ingest_left_file(pstate);
+			if (pstate->popts->build_index_file_name != NULL) {
+				join_index_write(pstate->popts->build_index_file_name, pstate->popts->left_file_name,
+					&pstate->popts->reader_opts, pstate->popts->pleft_join_field_names,
+					pstate->pleft_buckets_by_join_field_values, pstate->pleft_unpaired_records);
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+// With mlr --threads, right records come here rather than to mapper_join_process_unsorted.
+static void mapper_join_process_unsorted_batch(lrec_t** pright_records, int num_records, sllv_t** pout_recs,
+	void* pvstate)
+{
+	mapper_join_state_t* pstate = (mapper_join_state_t*)pvstate;
+
+	mapper_join_prepare_unsorted(pstate);
+	if (pstate->num_probe_workers < 0)
+		mapper_join_start_probe_workers(pstate);
+
+	if (pstate->num_probe_workers == 0) {
+		for (int i = 0; i < num_records; i++) {
+			pout_recs[i] = sllv_alloc();
+			mapper_join_pair_unsorted(pstate, pright_records[i], pout_recs[i]);
+		}
+		return;
+	}
+
+	// The last slice is probed on this thread while the workers do theirs.
+	int num_workers = pstate->num_probe_workers;
+	int slice_length = (num_records + num_workers) / (num_workers + 1);
+	for (int i = 0; i < num_workers; i++) {
+		join_probe_worker_t* pworker = &pstate->pprobe_workers[i];
+		int start = i * slice_length;
+		int end = start + slice_length < num_records ? start + slice_length : num_records;
+		pworker->slice.pright_records = &pright_records[start];
+		pworker->slice.pout_recs      = &pout_recs[start];
+		pworker->slice.length         = start < end ? end - start : 0;
+		if (pworker->slice.length > 0)
+			batch_queue_put(pworker->pin_queue, &pworker->slice);
+	}
+	for (int i = num_workers * slice_length; i < num_records; i++) {
+		pout_recs[i] = sllv_alloc();
+		mapper_join_pair_unsorted(pstate, pright_records[i], pout_recs[i]);
+	}
+	for (int i = 0; i < num_workers; i++) {
+		join_probe_worker_t* pworker = &pstate->pprobe_workers[i];
+		if (pworker->slice.length > 0)
+			(void)batch_queue_get(pworker->pout_queue);
+	}
+}
+
+// ----------------------------------------------------------------
+// Pairs a right record with the left records in memory, or in the spilled case partitions it.
+// The right record is either transferred to the output or freed.
+static void mapper_join_pair_unsorted(mapper_join_state_t* pstate, lrec_t* pright_rec, sllv_t* pout_recs) {
 	slls_t* pright_field_values = mlr_reference_selected_values_from_record(pright_rec, pstate->popts->pright_join_field_names);
 	if (pright_field_values != NULL) {
+		if (pstate->ptop_partitions != NULL && pstate->pcurrent_partition == NULL) { // Still ingesting
+			join_partition_t* ppartition = &pstate->ptop_partitions[join_partition_index(pright_field_values, 0)];
+			lrec_spill_write(ppartition->pright_file, pright_rec);
+			slls_free(pright_field_values);
+			lrec_free(pright_rec);
+			return;
+		}
+		if (pstate->pjoin_index != NULL) {
+			mapper_join_pair_indexed(pstate, pright_field_values, pright_rec, pout_recs);
+			slls_free(pright_field_values);
+			return;
+		}
 		join_bucket_t* pleft_bucket = lhmslv_get(pstate->pleft_buckets_by_join_field_values, pright_field_values);
 		slls_free(pright_field_values);
 		if (pleft_bucket == NULL) {
 			if (pstate->popts->emit_right_unpairables) {
-				return sllv_single(pright_rec);
+				sllv_append(pout_recs, pright_rec);
 			} else {
 				lrec_free(pright_rec);
-				return NULL;
 			}
 		} else if (pstate->popts->emit_pairables) {
-			sllv_t* pout_recs = sllv_alloc();
-			pleft_bucket->was_paired = TRUE;
+			__atomic_store_n(&pleft_bucket->was_paired, TRUE, __ATOMIC_RELAXED);
 			mapper_join_form_pairs(pleft_bucket->precords, pright_rec, pstate, pout_recs);
 			lrec_free(pright_rec);
-			return pout_recs;
 		} else {
-			pleft_bucket->was_paired = TRUE;
+			__atomic_store_n(&pleft_bucket->was_paired, TRUE, __ATOMIC_RELAXED);
 			lrec_free(pright_rec);
-			return NULL;
 		}
 	} else {
 		if (pstate->popts->emit_right_unpairables) {
-			return sllv_single(pright_rec);
+			sllv_append(pout_recs, pright_rec);
 		} else {
 			lrec_free(pright_rec);
-			return NULL;
 		}
 	}
 }
@@ -552,29 +839,378 @@ static void ingest_left_file(mapper_join_state_t* pstate) {
 		if (pleft_rec == NULL)
 			break;
 
+		if (pstate->ptop_partitions != NULL) {
+			join_partition_write(pstate, pstate->ptop_partitions, pleft_rec);
+			continue;
+		}
+
 		slls_t* pleft_field_values = mlr_reference_selected_values_from_record(pleft_rec,
 			pstate->popts->pleft_join_field_names);
 		if (pleft_field_values != NULL) {
-			join_bucket_t* pbucket = lhmslv_get(pstate->pleft_buckets_by_join_field_values, pleft_field_values);
-			if (pbucket == NULL) { // New key-field-value: new bucket and hash-map entry
-				slls_t* pkey_field_values_copy = slls_copy(pleft_field_values);
-				join_bucket_t* pbucket = mlr_malloc_or_die(sizeof(join_bucket_t));
-				pbucket->precords = sllv_alloc();
-				pbucket->was_paired = FALSE;
-				pbucket->pleft_field_values = slls_copy(pleft_field_values);
-				lhmslv_put(pstate->pleft_buckets_by_join_field_values, pkey_field_values_copy, pbucket,
-					FREE_ENTRY_KEY);
-				sllv_append(pbucket->precords, pleft_rec);
-			} else { // Previously seen key-field-value: append record to bucket
-				sllv_append(pbucket->precords, pleft_rec);
-			}
+			int is_new_bucket = join_bucket_map_add(pstate->pleft_buckets_by_join_field_values,
+				pleft_field_values, pleft_rec);
+			if (popts->max_memory > 0LL)
+				pstate->left_memory_used += lrec_memory_size(pleft_rec) + (is_new_bucket ? JOIN_BUCKET_OVERHEAD : 0);
 			slls_free(pleft_field_values);
 		} else {
 			sllv_append(pstate->pleft_unpaired_records, pleft_rec);
+			if (popts->max_memory > 0LL)
+				pstate->left_memory_used += lrec_memory_size(pleft_rec);
 		}
+
+		if (popts->max_memory > 0LL && pstate->left_memory_used > popts->max_memory)
+			mapper_join_spill_left(pstate);
 	}
 
 	plrec_reader->pclose_func(plrec_reader->pvstate, pvhandle, pstate->popts->prepipe);
 
 	plrec_reader->pfree_func(plrec_reader);
 }
+
+// ----------------------------------------------------------------
+// The bucket map is left empty, to mark the left input as having been handled.
+static void mapper_join_open_index(mapper_join_state_t* pstate) {
+	mapper_join_opts_t* popts = pstate->popts;
+	pstate->pleft_buckets_by_join_field_values = lhmslv_alloc();
+	pstate->pjoin_index = join_index_open(popts->use_index_file_name, popts->left_file_name,
+		&popts->reader_opts, popts->pleft_join_field_names);
+	long long num_buckets = pstate->pjoin_index->num_buckets;
+	pstate->pindex_bucket_records = mlr_malloc_or_die((num_buckets + 1) * sizeof(sllv_t*));
+	memset(pstate->pindex_bucket_records, 0, (num_buckets + 1) * sizeof(sllv_t*));
+	pstate->index_bucket_was_paired = mlr_malloc_or_die(num_buckets + 1);
+	memset(pstate->index_bucket_was_paired, 0, num_buckets + 1);
+}
+
+// As mapper_join_pair_unsorted but with the left records looked up in the index.
+static void mapper_join_pair_indexed(mapper_join_state_t* pstate, slls_t* pright_field_values, lrec_t* pright_rec,
+	sllv_t* pout_recs)
+{
+	long long bucket_index = join_index_find(pstate->pjoin_index, pright_field_values);
+	if (bucket_index < 0LL) {
+		if (pstate->popts->emit_right_unpairables) {
+			sllv_append(pout_recs, pright_rec);
+		} else {
+			lrec_free(pright_rec);
+		}
+		return;
+	}
+
+	__atomic_store_n(&pstate->index_bucket_was_paired[bucket_index], TRUE, __ATOMIC_RELAXED);
+	if (pstate->popts->emit_pairables) {
+		mapper_join_form_pairs(mapper_join_index_bucket_records(pstate, bucket_index), pright_rec, pstate,
+			pout_recs);
+	}
+	lrec_free(pright_rec);
+}
+
+// With probe workers, two of them may instantiate the same bucket at once; the first to store its
+// records wins and the other's are freed.
+static sllv_t* mapper_join_index_bucket_records(mapper_join_state_t* pstate, long long bucket_index) {
+	sllv_t** ppcached = &pstate->pindex_bucket_records[bucket_index];
+	sllv_t* precords = __atomic_load_n(ppcached, __ATOMIC_ACQUIRE);
+	if (precords != NULL)
+		return precords;
+
+	sllv_t* pnew_records = join_index_bucket_records(pstate->pjoin_index, bucket_index);
+	// Wide records build their field-lookup index on first lookup, so do that before they're shared.
+	char* first_field_name = pstate->popts->pleft_join_field_names->phead->value;
+	for (sllve_t* pe = pnew_records->phead; pe != NULL; pe = pe->pnext)
+		(void)lrec_get(pe->pvvalue, first_field_name);
+
+	if (__atomic_compare_exchange_n(ppcached, &precords, pnew_records, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+		return pnew_records;
+	while (pnew_records->phead)
+		lrec_free(sllv_pop(pnew_records));
+	sllv_free(pnew_records);
+	return precords;
+}
+
+// With --ul, emits the records of the never-paired buckets, then the left records lacking the
+// join fields, a batch at a time.
+static sllv_t* mapper_join_emit_indexed(mapper_join_state_t* pstate) {
+	join_index_t* pindex = pstate->pjoin_index;
+	sllv_t* pout_recs = sllv_alloc();
+	if (pstate->popts->emit_left_unpairables) {
+		while (pstate->index_emit_position < pindex->num_buckets) {
+			long long bucket_index = pstate->index_emit_position++;
+			if (!pstate->index_bucket_was_paired[bucket_index]) {
+				sllv_t* precords = join_index_bucket_records(pindex, bucket_index);
+				sllv_transfer(pout_recs, precords);
+				sllv_free(precords);
+				if (pout_recs->length >= JOIN_OUTPUT_BATCH_SIZE) {
+					sllv_append(pout_recs, MAPPER_MORE_OUTPUT);
+					return pout_recs;
+				}
+			}
+		}
+		sllv_t* precords = join_index_unpaired_records(pindex);
+		sllv_transfer(pout_recs, precords);
+		sllv_free(precords);
+	}
+	sllv_append(pout_recs, NULL);
+	return pout_recs;
+}
+
+// ----------------------------------------------------------------
+// The left records were already looked up by their join fields at ingest, so any wide ones have
+// built their field-lookup index and lookups from the workers don't modify them.
+static void mapper_join_start_probe_workers(mapper_join_state_t* pstate) {
+	pstate->num_probe_workers = 0;
+	if (MLR_GLOBALS.nthreads < 2 || pstate->ptop_partitions != NULL)
+		return;
+
+	pstate->num_probe_workers = MLR_GLOBALS.nthreads - 1; // Plus the calling thread
+	pstate->pprobe_workers = mlr_malloc_or_die(pstate->num_probe_workers * sizeof(join_probe_worker_t));
+	for (int i = 0; i < pstate->num_probe_workers; i++) {
+		join_probe_worker_t* pworker = &pstate->pprobe_workers[i];
+		pworker->pstate     = pstate;
+		pworker->pin_queue  = batch_queue_alloc(1);
+		pworker->pout_queue = batch_queue_alloc(1);
+		int rc = pthread_create(&pworker->thread, NULL, mapper_join_probe_worker_thread, pworker);
+		if (rc != 0) {
+			fprintf(stderr, "%s: could not create thread: %s\n", MLR_GLOBALS.bargv0, strerror(rc));
+			exit(1);
+		}
+	}
+}
+
+static void* mapper_join_probe_worker_thread(void* pvarg) {
+	join_probe_worker_t* pworker = pvarg;
+	join_probe_slice_t* pslice;
+	while ((pslice = batch_queue_get(pworker->pin_queue)) != NULL) {
+		for (int i = 0; i < pslice->length; i++) {
+			pslice->pout_recs[i] = sllv_alloc();
+			mapper_join_pair_unsorted(pworker->pstate, pslice->pright_records[i], pslice->pout_recs[i]);
+		}
+		batch_queue_put(pworker->pout_queue, pslice);
+	}
+	return NULL;
+}
+
+static void mapper_join_stop_probe_workers(mapper_join_state_t* pstate) {
+	for (int i = 0; i < pstate->num_probe_workers; i++) {
+		join_probe_worker_t* pworker = &pstate->pprobe_workers[i];
+		batch_queue_close(pworker->pin_queue);
+		pthread_join(pworker->thread, NULL);
+		batch_queue_free(pworker->pin_queue);
+		batch_queue_free(pworker->pout_queue);
+	}
+	free(pstate->pprobe_workers);
+	pstate->pprobe_workers = NULL;
+	pstate->num_probe_workers = 0;
+}
+
+// ----------------------------------------------------------------
+// Returns TRUE if a new bucket was made for the record.
+static int join_bucket_map_add(lhmslv_t* pbuckets, slls_t* pleft_field_values, lrec_t* pleft_rec) {
+	join_bucket_t* pbucket = lhmslv_get(pbuckets, pleft_field_values);
+	if (pbucket == NULL) { // New key-field-value: new bucket and hash-map entry
+		slls_t* pkey_field_values_copy = slls_copy(pleft_field_values);
+		pbucket = mlr_malloc_or_die(sizeof(join_bucket_t));
+		pbucket->precords = sllv_alloc();
+		pbucket->was_paired = FALSE;
+		pbucket->pleft_field_values = slls_copy(pleft_field_values);
+		lhmslv_put(pbuckets, pkey_field_values_copy, pbucket, FREE_ENTRY_KEY);
+		sllv_append(pbucket->precords, pleft_rec);
+		return TRUE;
+	} else { // Previously seen key-field-value: append record to bucket
+		sllv_append(pbucket->precords, pleft_rec);
+		return FALSE;
+	}
+}
+
+static void join_bucket_map_free(lhmslv_t* pbuckets) {
+	for (lhmslve_t* pe = pbuckets->phead; pe != NULL; pe = pe->pnext) {
+		join_bucket_t* pbucket = pe->pvvalue;
+		slls_free(pbucket->pleft_field_values);
+		if (pbucket->precords)
+			while (pbucket->precords->phead)
+				lrec_free(sllv_pop(pbucket->precords));
+		sllv_free(pbucket->precords);
+		free(pbucket);
+	}
+	lhmslv_free(pbuckets);
+}
+
+// ----------------------------------------------------------------
+// Called once the left records held pass --max-memory: moves them all out to the top-level
+// partition files, after which the rest of the left file goes straight there.
+static void mapper_join_spill_left(mapper_join_state_t* pstate) {
+	pstate->ptop_partitions = join_partitions_alloc(pstate->popts->tmpdir, 0);
+
+	lhmslv_t* pbuckets = pstate->pleft_buckets_by_join_field_values;
+	for (lhmslve_t* pe = pbuckets->phead; pe != NULL; pe = pe->pnext) {
+		join_bucket_t* pbucket = pe->pvvalue;
+		join_partition_t* ppartition = &pstate->ptop_partitions[join_partition_index(pbucket->pleft_field_values, 0)];
+		for (sllve_t* pf = pbucket->precords->phead; pf != NULL; pf = pf->pnext)
+			lrec_spill_write(ppartition->pleft_file, pf->pvvalue);
+	}
+	join_bucket_map_free(pbuckets);
+	pstate->pleft_buckets_by_join_field_values = lhmslv_alloc();
+
+	while (pstate->pleft_unpaired_records->phead)
+		join_partition_write(pstate, pstate->ptop_partitions, sllv_pop(pstate->pleft_unpaired_records));
+	pstate->left_memory_used = 0LL;
+}
+
+// Writes a left record to its partition, or if it lacks the join fields, to the unpaired file if
+// it is to be emitted. The record is freed.
+static void join_partition_write(mapper_join_state_t* pstate, join_partition_t* ppartitions, lrec_t* pleft_rec) {
+	slls_t* pleft_field_values = mlr_reference_selected_values_from_record(pleft_rec,
+		pstate->popts->pleft_join_field_names);
+	if (pleft_field_values != NULL) {
+		join_partition_t* ppartition = &ppartitions[join_partition_index(pleft_field_values, ppartitions->level)];
+		lrec_spill_write(ppartition->pleft_file, pleft_rec);
+		slls_free(pleft_field_values);
+	} else if (pstate->popts->emit_left_unpairables) {
+		if (pstate->pleft_unpaired_file == NULL)
+			pstate->pleft_unpaired_file = lrec_spill_file_open_or_die(pstate->popts->tmpdir);
+		lrec_spill_write(pstate->pleft_unpaired_file, pleft_rec);
+	}
+	lrec_free(pleft_rec);
+}
+
+// ----------------------------------------------------------------
+// End of stream with spilled input: each call joins up to about JOIN_OUTPUT_BATCH_SIZE records'
+// worth, ending the list with MAPPER_MORE_OUTPUT until all partitions are done.
+static sllv_t* mapper_join_emit_spilled(mapper_join_state_t* pstate) {
+	if (pstate->ppending_partitions == NULL) { // First call
+		pstate->ppending_partitions = sllv_alloc();
+		for (int i = 0; i < JOIN_NUM_PARTITIONS; i++) {
+			join_partition_t* ppartition = mlr_malloc_or_die(sizeof(join_partition_t));
+			*ppartition = pstate->ptop_partitions[i];
+			sllv_append(pstate->ppending_partitions, ppartition);
+		}
+		if (pstate->pleft_unpaired_file != NULL)
+			lrec_spill_file_rewind_or_die(pstate->pleft_unpaired_file);
+	}
+
+	sllv_t* pout_recs = sllv_alloc();
+	while (pout_recs->length < JOIN_OUTPUT_BATCH_SIZE) {
+		join_partition_t* ppartition = pstate->pcurrent_partition;
+
+		if (ppartition == NULL) {
+			ppartition = sllv_pop(pstate->ppending_partitions);
+			if (ppartition != NULL) {
+				if (mapper_join_load_partition(pstate, ppartition))
+					pstate->pcurrent_partition = ppartition;
+				continue;
+			}
+			// All partitions are done; last come the left records lacking the join fields.
+			lrec_t* pleft_rec = NULL;
+			if (pstate->pleft_unpaired_file != NULL)
+				pleft_rec = lrec_spill_read(pstate->pleft_unpaired_file);
+			if (pleft_rec == NULL) {
+				sllv_append(pout_recs, NULL);
+				return pout_recs;
+			}
+			sllv_append(pout_recs, pleft_rec);
+			continue;
+		}
+
+		lrec_t* pright_rec = lrec_spill_read(ppartition->pright_file);
+		if (pright_rec != NULL) {
+			mapper_join_pair_unsorted(pstate, pright_rec, pout_recs);
+			continue;
+		}
+
+		// This partition is done.
+		lhmslv_t* pbuckets = pstate->pleft_buckets_by_join_field_values;
+		if (pstate->popts->emit_left_unpairables) {
+			for (lhmslve_t* pe = pbuckets->phead; pe != NULL; pe = pe->pnext) {
+				join_bucket_t* pbucket = pe->pvvalue;
+				if (!pbucket->was_paired)
+					sllv_transfer(pout_recs, pbucket->precords);
+			}
+		}
+		join_bucket_map_free(pbuckets);
+		pstate->pleft_buckets_by_join_field_values = lhmslv_alloc();
+		join_partition_free(ppartition);
+		pstate->pcurrent_partition = NULL;
+	}
+	sllv_append(pout_recs, MAPPER_MORE_OUTPUT);
+	return pout_recs;
+}
+
+// Loads the partition's left records into the bucket map, ready for its right records to be
+// streamed against them. If they don't fit in memory, the partition is instead split into
+// sub-partitions which are queued in its place, and FALSE is returned.
+static int mapper_join_load_partition(mapper_join_state_t* pstate, join_partition_t* ppartition) {
+	mapper_join_opts_t* popts = pstate->popts;
+	lhmslv_t* pbuckets = pstate->pleft_buckets_by_join_field_values;
+	long long memory_used = 0LL;
+
+	lrec_spill_file_rewind_or_die(ppartition->pleft_file);
+	lrec_spill_file_rewind_or_die(ppartition->pright_file);
+
+	lrec_t* pleft_rec;
+	while ((pleft_rec = lrec_spill_read(ppartition->pleft_file)) != NULL) {
+		slls_t* pleft_field_values = mlr_reference_selected_values_from_record(pleft_rec,
+			popts->pleft_join_field_names);
+		memory_used += lrec_memory_size(pleft_rec);
+		if (join_bucket_map_add(pbuckets, pleft_field_values, pleft_rec))
+			memory_used += JOIN_BUCKET_OVERHEAD;
+		slls_free(pleft_field_values);
+		if (memory_used > popts->max_memory && ppartition->level < JOIN_MAX_PARTITION_LEVEL)
+			break;
+	}
+	if (pleft_rec == NULL)
+		return TRUE;
+
+	join_partition_t* psubpartitions = join_partitions_alloc(popts->tmpdir, ppartition->level + 1);
+	for (lhmslve_t* pe = pbuckets->phead; pe != NULL; pe = pe->pnext) {
+		join_bucket_t* pbucket = pe->pvvalue;
+		join_partition_t* psub = &psubpartitions[join_partition_index(pbucket->pleft_field_values, psubpartitions->level)];
+		for (sllve_t* pf = pbucket->precords->phead; pf != NULL; pf = pf->pnext)
+			lrec_spill_write(psub->pleft_file, pf->pvvalue);
+	}
+	join_bucket_map_free(pbuckets);
+	pstate->pleft_buckets_by_join_field_values = lhmslv_alloc();
+	while ((pleft_rec = lrec_spill_read(ppartition->pleft_file)) != NULL)
+		join_partition_write(pstate, psubpartitions, pleft_rec);
+
+	lrec_t* pright_rec;
+	while ((pright_rec = lrec_spill_read(ppartition->pright_file)) != NULL) {
+		slls_t* pright_field_values = mlr_reference_selected_values_from_record(pright_rec,
+			popts->pright_join_field_names);
+		join_partition_t* psub = &psubpartitions[join_partition_index(pright_field_values, psubpartitions->level)];
+		lrec_spill_write(psub->pright_file, pright_rec);
+		slls_free(pright_field_values);
+		lrec_free(pright_rec);
+	}
+	join_partition_free(ppartition);
+
+	for (int i = JOIN_NUM_PARTITIONS - 1; i >= 0; i--) {
+		join_partition_t* psub = mlr_malloc_or_die(sizeof(join_partition_t));
+		*psub = psubpartitions[i];
+		sllv_push(pstate->ppending_partitions, psub);
+	}
+	free(psubpartitions);
+	return FALSE;
+}
+
+// ----------------------------------------------------------------
+static join_partition_t* join_partitions_alloc(char* tmpdir, int level) {
+	join_partition_t* ppartitions = mlr_malloc_or_die(JOIN_NUM_PARTITIONS * sizeof(join_partition_t));
+	for (int i = 0; i < JOIN_NUM_PARTITIONS; i++) {
+		ppartitions[i].pleft_file  = lrec_spill_file_open_or_die(tmpdir);
+		ppartitions[i].pright_file = lrec_spill_file_open_or_die(tmpdir);
+		ppartitions[i].level       = level;
+	}
+	return ppartitions;
+}
+
+static void join_partition_free(join_partition_t* ppartition) {
+	fclose(ppartition->pleft_file);
+	fclose(ppartition->pright_file);
+	free(ppartition);
+}
+
+// The level is mixed in so that a partition which is split goes to all its sub-partitions.
+static int join_partition_index(slls_t* pfield_values, int level) {
+	unsigned long long h = (unsigned)slls_hash_func(pfield_values) + level * 0x9e3779b97f4a7c15ULL;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return h % JOIN_NUM_PARTITIONS;
+}
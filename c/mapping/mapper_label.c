@@ -20,6 +20,7 @@ mapper_setup_t mapper_label_setup = {
 	.pusage_func = mapper_label_usage,
 	.pparse_func = mapper_label_parse_cli,
 	.ignores_input = FALSE,
+	.pis_stateless_func = mapper_is_always_stateless,
 };
 
 // ----------------------------------------------------------------
@@ -59,6 +60,8 @@ static mapper_t* mapper_label_alloc(slls_t* pnames) {
 	pmapper->pvstate       = (void*)pstate;
 	pmapper->pprocess_func = mapper_label_process;
 	pmapper->pfree_func    = mapper_label_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
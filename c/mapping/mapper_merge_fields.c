@@ -225,7 +225,7 @@ static mapper_t* mapper_merge_fields_alloc(slls_t* paccumulator_names, merge_by_
 	pstate->pvalue_field_regexes = sllv_alloc();
 	for (sllse_t* pa = pvalue_field_names->phead; pa != NULL; pa = pa->pnext) {
 		char* value_field_name = pa->value;
-		regex_t* pvalue_field_regex = mlr_malloc_or_die(sizeof(regex_t));
+		mlr_regex_t* pvalue_field_regex = mlr_malloc_or_die(sizeof(mlr_regex_t));
 		regcomp_or_die(pvalue_field_regex, value_field_name, 0);
 		sllv_append(pstate->pvalue_field_regexes, pvalue_field_regex);
 	}
@@ -240,6 +240,8 @@ static mapper_t* mapper_merge_fields_alloc(slls_t* paccumulator_names, merge_by_
 		(do_which == MERGE_BY_NAME_REGEX) ? mapper_merge_fields_process_by_name_regex :
 		mapper_merge_fields_process_by_collapsing;
 	pmapper->pfree_func = mapper_merge_fields_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -249,8 +251,8 @@ static void mapper_merge_fields_free(mapper_t* pmapper, context_t* _) {
 	slls_free(pstate->paccumulator_names);
 	slls_free(pstate->pvalue_field_names);
 	for (sllve_t* pa = pstate->pvalue_field_regexes->phead; pa != NULL; pa = pa->pnext) {
-		regex_t* pvalue_field_regex = pa->pvvalue;
-		regfree(pvalue_field_regex);
+		mlr_regex_t* pvalue_field_regex = pa->pvvalue;
+		mlr_regfree(pvalue_field_regex);
 		free(pvalue_field_regex);
 	}
 	sllv_free(pstate->pvalue_field_regexes);
@@ -354,7 +356,7 @@ static sllv_t* mapper_merge_fields_process_by_name_regex(lrec_t* pinrec, context
 		char* field_name = pb->key;
 		int matched = FALSE;
 		for (sllve_t* pc = pstate->pvalue_field_regexes->phead; pc != NULL && !matched; pc = pc->pnext) {
-			regex_t* pvalue_field_regex = pc->pvvalue;
+			mlr_regex_t* pvalue_field_regex = pc->pvvalue;
 			matched = regmatch_or_die(pvalue_field_regex, field_name, 0, NULL);
 			if (matched) {
 				char* value_field_sval = lrec_get(pinrec, field_name);
@@ -444,7 +446,7 @@ static sllv_t* mapper_merge_fields_process_by_collapsing(lrec_t* pinrec, context
 		char* field_name = pa->key;
 		int matched = FALSE;
 		for (sllve_t* pb = pstate->pvalue_field_regexes->phead; pb != NULL && !matched; pb = pb->pnext) {
-			regex_t* pvalue_field_regex = pb->pvvalue;
+			mlr_regex_t* pvalue_field_regex = pb->pvvalue;
 			char* short_name = regex_sub(field_name, pvalue_field_regex, pstate->psb, "", &matched, NULL);
 			if (matched) {
 				lhmsv_t* in_acc_map_for_short_name = lhmsv_get(short_names_to_in_acc_maps, short_name);
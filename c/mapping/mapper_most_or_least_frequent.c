@@ -144,6 +144,8 @@ static mapper_t* mapper_most_or_least_frequent_alloc(ap_state_t* pargp, slls_t*
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_most_or_least_frequent_process;
 	pmapper->pfree_func    = mapper_most_or_least_frequent_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -43,6 +43,8 @@ static mapper_t* mapper_nothing_alloc(ap_state_t* pargp, int do_counters, char*
 	pmapper->pvstate       = NULL;
 	pmapper->pprocess_func = mapper_nothing_process;
 	pmapper->pfree_func    = mapper_nothing_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 	return pmapper;
 }
 static void mapper_nothing_free(mapper_t* pmapper, context_t* _) {
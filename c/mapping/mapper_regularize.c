@@ -50,6 +50,8 @@ static mapper_t* mapper_regularize_alloc() {
 	pmapper->pvstate       = (void*)pstate;
 	pmapper->pprocess_func = mapper_regularize_process;
 	pmapper->pfree_func    = mapper_regularize_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
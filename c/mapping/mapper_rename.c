@@ -9,7 +9,7 @@
 #define RENAME_SB_ALLOC_LENGTH 16
 
 typedef struct _regex_pair_t {
-	regex_t regex;
+	mlr_regex_t regex;
 	char*   replacement;
 } regex_pair_t;
 
@@ -35,6 +35,7 @@ mapper_setup_t mapper_rename_setup = {
 	.pusage_func = mapper_rename_usage,
 	.pparse_func = mapper_rename_parse_cli,
 	.ignores_input = FALSE,
+	.pis_stateless_func = mapper_is_always_stateless,
 };
 
 // ----------------------------------------------------------------
@@ -134,6 +135,8 @@ static mapper_t* mapper_rename_alloc(ap_state_t* pargp, lhmss_t* pold_to_new, in
 		pstate->do_gsub        = FALSE;
 	}
 	pmapper->pfree_func = mapper_rename_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	pmapper->pvstate = (void*)pstate;
 	return pmapper;
@@ -145,7 +148,7 @@ static void mapper_rename_free(mapper_t* pmapper, context_t* _) {
 	if (pstate->pregex_pairs != NULL) {
 		for (sllve_t* pe = pstate->pregex_pairs->phead; pe != NULL; pe = pe->pnext) {
 			regex_pair_t* ppair = pe->pvvalue;
-			regfree(&ppair->regex);
+			mlr_regfree(&ppair->regex);
 			// replacement is in pthe old_to_new list, already freed
 			free(ppair);
 		}
@@ -181,7 +184,7 @@ static sllv_t* mapper_rename_regex_process(lrec_t* pinrec, context_t* pctx, void
 
 		for (sllve_t* pe = pstate->pregex_pairs->phead; pe != NULL; pe = pe->pnext) {
 			regex_pair_t* ppair = pe->pvvalue;
-			regex_t* pregex = &ppair->regex;
+			mlr_regex_t* pregex = &ppair->regex;
 			char* replacement = ppair->replacement;
 			for (lrece_t* pf = pinrec->phead; pf != NULL; pf = pf->pnext) {
 				int matched = FALSE;
@@ -79,6 +79,8 @@ static mapper_t* mapper_reorder_alloc(ap_state_t* pargp, slls_t* pfield_name_lis
 	pmapper->pvstate       = (void*)pstate;
 	pmapper->pprocess_func = mapper_reorder_process;
 	pmapper->pfree_func    = mapper_reorder_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -115,6 +115,8 @@ static mapper_t* mapper_repeat_alloc(ap_state_t* pargp, long long repeat_count,
 		pmapper->pprocess_func  = mapper_repeat_process_nop;
 
 	pmapper->pfree_func     = mapper_repeat_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
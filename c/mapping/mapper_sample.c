@@ -96,6 +96,8 @@ static mapper_t* mapper_sample_alloc(ap_state_t* pargp, slls_t* pgroup_by_field_
 	pmapper->pvstate              = pstate;
 	pmapper->pprocess_func        = mapper_sample_process;
 	pmapper->pfree_func           = mapper_sample_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
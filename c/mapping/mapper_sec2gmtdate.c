@@ -22,6 +22,7 @@ mapper_setup_t mapper_sec2gmtdate_setup = {
 	.pusage_func = mapper_sec2gmtdate_usage,
 	.pparse_func = mapper_sec2gmtdate_parse_cli,
 	.ignores_input = FALSE,
+	.pis_stateless_func = mapper_is_always_stateless,
 };
 
 // ----------------------------------------------------------------
@@ -62,6 +63,8 @@ static mapper_t* mapper_sec2gmtdate_alloc(slls_t* pfield_names)
 	pmapper->pprocess_func = mapper_sec2gmtdate_process;
 	pmapper->pvstate       = (void*)pstate;
 	pmapper->pfree_func    = mapper_sec2gmtdate_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -104,6 +104,8 @@ static mapper_t* mapper_seqgen_alloc(ap_state_t* pargp, char* field_name, mv_t s
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_seqgen_process;
 	pmapper->pfree_func    = mapper_seqgen_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -68,6 +68,8 @@ static mapper_t* mapper_shuffle_alloc(ap_state_t* pargp) {
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_shuffle_process;
 	pmapper->pfree_func    = mapper_shuffle_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -8,6 +8,7 @@
 #include "containers/slls.h"
 #include "containers/lhmslv.h"
 #include "containers/mixutil.h"
+#include "containers/lrec_spill.h"
 #include "mapping/mappers.h"
 
 // ================================================================
@@ -24,36 +25,67 @@
 //   pairs ["red","1"], and so on -- we keep a linked list of all the records
 //   having those sort-key values, in the order encountered.
 //
-// * For each of those unique sort-key-value combinations, we also parse the
-//   numerical fields at this point into an array of union-string-double.
-//   E.g. the list ["red", "1.0"] maps to the array ["red", 1.0].
+// * For each of those unique sort-key-value combinations, we also encode the
+//   values into a single normalized byte string which memcmp puts in the
+//   desired order (see encode_sort_key). E.g. the list ["red", "1.0"] maps to
+//   the bytes of "red", a NUL, and eight bytes encoding 1.0.
 //
-// * The pairing of parsed-value array the linked list of same-key-value records
+// * The pairing of normalized key and the linked list of same-key-value records
 //   is called a *bucket*. E.g the records
 //     {"a":"red","b":"circle","x":"1.0","y":"3.9"}
 //     {"a":"red","b":"square","x":"1.0","z":"5.7", "q":"even"}
 //   would both land in the ["red","1.0"] bucket.
 //
 // * Buckets are retained in a hash map: the key is the string-list of the form
-//   ["red","1.0"] and the value is the pairing of parsed-value array ["red",1.0]
-//   ane linked list of records.
+//   ["red","1.0"] and the value is the pairing of normalized key and linked
+//   list of records.
 //
 // * Once all the input records are ingested into this hash map, we copy the
-//   bucket-pointers into an array and sort it: this being the pairing of
-//   parsed-value array and linked list of records. The comparator callback for
-//   the sort walks through the parsed-value arrays one slot at a time,
-//   looking at the first difference, e.g. if one has "a"="red" and the other
-//   has "a"="blue". If the first field matches then the sort moves to the
-//   second field, and so on.
+//   bucket-pointers into an array, each alongside the first eight bytes of its
+//   normalized key as an integer, and merge-sort that. Most comparisons are
+//   decided by the integers alone; ties fall back to memcmp of the rest of the
+//   keys. The merge sort is stable, so buckets which compare equal are emitted
+//   in the order they were first seen.
 //
 // * Recall in particular that string keys ["a":"red","x":"1"] and
 //   ["a":"red","x":"1.0"] map to different buckets, but will sort equally.
 //
+// * With --max-memory, once the records held pass that size (approximately) they
+//   are sorted as above and spilled to a temporary file as a *run*, and ingestion
+//   continues with an empty hash map. At end of stream the last run is spilled
+//   likewise and the runs are merged using a heap keyed on each run's next
+//   record. Ties go to the earlier run, which keeps the sort stable. One
+//   difference: records whose keys are different strings but sort equally,
+//   e.g. x=1 and x=1.0 with -nf, are grouped by string only within each run;
+//   across runs they come in run order. Grouping them across all runs would
+//   mean remembering every distinct key, which would defeat the memory bound.
+//   The merged output is emitted in batches (see MAPPER_MORE_OUTPUT) rather than all at
+//   once. If there are too many runs to have them all open at once, they're
+//   merged into a single run during ingestion. Records missing sort keys are
+//   spilled to a file of their own. If the input never fills the memory bound,
+//   nothing is spilled and the sort is the same as without --max-memory.
+//
+// * With a limit on the number of output records (--limit, or when followed by
+//   head -n without -g), only that many records are kept, in a max-heap keyed
+//   on normalized key, then on when its sort-key values were first seen, then
+//   on arrival order -- so ties come out grouped as buckets would be. A record
+//   enters the heap only if it sorts before the worst one already there, which
+//   it then replaces. First-seen positions are remembered only for the values
+//   of records kept: a record whose values were seen before but are no longer
+//   in the heap can't sort before the worst one kept, so can't enter it
+//   anyway. At end of stream the heap is sorted in place. Memory use is then proportional to
+//   the limit, not to the input. Records missing sort keys are likewise kept up
+//   to the limit.
+//
 // ================================================================
 
 #define SORT_NUMERIC    0x80
 #define SORT_DESCENDING 0x40
 
+#define SORT_MAX_RUNS_OPEN     128
+#define SORT_OUTPUT_BATCH_SIZE 500
+#define SORT_BUCKET_OVERHEAD   128
+
 typedef struct _mapper_sort_state_t {
 	// Input parameters
 	slls_t* pkey_field_names; // Fields to sort on
@@ -62,21 +94,59 @@ typedef struct _mapper_sort_state_t {
 	// Sort state: buckets of like records.
 	lhmslv_t* pbuckets_by_key_field_values;
 	sllv_t*   precords_missing_sort_keys;
+	// External-sort state: see the overview.
+	long long max_memory; // Zero for unbounded
+	char*     tmpdir;
+	long long memory_used;
+	sllv_t*   pruns;      // of sort_run_t*, in input order
+	FILE*     pmissing_sort_keys_file;
+	struct _sort_run_t** merge_heap;
+	int       merge_heap_size;
+	int       merging;
+	// Top-k state: see the overview.
+	long long limit; // -1 for unlimited
+	struct _sort_kept_t* kept_heap;
+	long long kept_count;
+	long long kept_alloc_count;
+	long long num_keyed_records_seen;
+	lhmslv_t* pkept_first_seen; // Sort-key values of kept records, to long long* first-seen positions
+	unsigned char* scratch_sort_key;
+	int       scratch_sort_key_alloc_length;
 } mapper_sort_state_t;
 
-// Each sort key is string or number; use union to save space.
-typedef struct _typed_sort_key_t {
-	union {
-		char*  s;
-		double d;
-	} u;
-} typed_sort_key_t;
-
 typedef struct _sort_bucket_t {
-	typed_sort_key_t* typed_sort_keys;
-	sllv_t*           precords;
+	unsigned char* sort_key; // Normalized; null for group-by
+	int            sort_key_length;
+	sllv_t*        precords;
 } sort_bucket_t;
 
+// What's actually sorted: the first eight bytes of the bucket's normalized key, big-endian and
+// zero-padded, so that most comparisons don't need to follow the bucket pointer.
+typedef struct _sort_entry_t {
+	unsigned long long prefix;
+	sort_bucket_t*     pbucket;
+} sort_entry_t;
+
+// A sorted run spilled to a temporary file, along with its next record when merging.
+typedef struct _sort_run_t {
+	FILE*          fp;
+	int            index; // Position in input order, for stability
+	lrec_t*        prec;  // Null when exhausted
+	unsigned char* sort_key;
+	int            sort_key_length;
+	int            sort_key_alloc_length;
+} sort_run_t;
+
+// A record retained in top-k mode.
+typedef struct _sort_kept_t {
+	unsigned char* sort_key;
+	int            sort_key_length;
+	int            sort_key_alloc_length;
+	long long      first_seen; // seqno of the first record with the same sort-key values
+	long long      seqno;      // For stability
+	lrec_t*        prec;
+} sort_kept_t;
+
 // ----------------------------------------------------------------
 static void      mapper_sort_usage(FILE* o, char* argv0, char* verb);
 static mapper_t* mapper_sort_parse_cli(int* pargi, int argc, char** argv,
@@ -84,19 +154,35 @@ static mapper_t* mapper_sort_parse_cli(int* pargi, int argc, char** argv,
 static void      mapper_group_by_usage(FILE* o, char* argv0, char* verb);
 static mapper_t* mapper_group_by_parse_cli(int* pargi, int argc, char** argv,
 	cli_reader_opts_t* _, cli_writer_opts_t* __);
-static mapper_t* mapper_sort_alloc(slls_t* pkey_field_names, int* sort_params, int do_sort);
+static mapper_t* mapper_sort_alloc(slls_t* pkey_field_names, int* sort_params, int do_sort,
+	long long max_memory, char* tmpdir);
 static void      mapper_sort_free(mapper_t* pmapper, context_t* _);
 static sllv_t*   mapper_sort_process(lrec_t* pinrec, context_t* pctx, void* pvstate);
-
-static typed_sort_key_t* parse_sort_keys(slls_t* pkey_field_values, int* sort_params, context_t* pctx);
-
-// qsort is non-reentrant but qsort_r isn't portable. But since Miller is
-// single-threaded, even if we've got one sort chained to another, only one is
-// active at a time. We adopt the convention that we set the sort params
-// right before the sort.
-static int* pcmp_sort_params  = NULL;
-static int  cmp_params_length = 0;
-static int pbucket_comparator(const void* pva, const void* pvb);
+static sllv_t*   mapper_sort_emit_merged(mapper_sort_state_t* pstate, context_t* pctx);
+static void      mapper_sort_set_output_limit(mapper_t* pmapper, long long limit);
+static void      mapper_sort_keep_top(mapper_sort_state_t* pstate, lrec_t* pinrec, context_t* pctx);
+static sllv_t*   mapper_sort_emit_top(mapper_sort_state_t* pstate);
+static void      sort_kept_heap_sift_down(sort_kept_t* heap, long long i, long long n);
+static long long* mapper_sort_kept_first_seen(mapper_sort_state_t* pstate, slls_t* pkey_field_values);
+static void      mapper_sort_remember_first_seen(mapper_sort_state_t* pstate, slls_t* pkey_field_values,
+	long long first_seen);
+static void      mapper_sort_forget_evicted_first_seen(mapper_sort_state_t* pstate);
+static sort_bucket_t** mapper_sort_sorted_buckets(mapper_sort_state_t* pstate, int* pnum_buckets);
+
+static void      mapper_sort_spill_run(mapper_sort_state_t* pstate, context_t* pctx);
+static void      mapper_sort_merge_runs_to_one(mapper_sort_state_t* pstate, context_t* pctx);
+static void      mapper_sort_merge_start(mapper_sort_state_t* pstate, context_t* pctx);
+static lrec_t*   mapper_sort_merge_next(mapper_sort_state_t* pstate, context_t* pctx);
+static sort_run_t* sort_run_alloc(mapper_sort_state_t* pstate);
+static void      sort_run_advance(mapper_sort_state_t* pstate, sort_run_t* prun, context_t* pctx);
+static void      sort_run_free(sort_run_t* prun);
+static int       sort_run_less(mapper_sort_state_t* pstate, sort_run_t* pa, sort_run_t* pb);
+
+
+static int  sort_key_length(slls_t* pkey_field_values, int* sort_params);
+static void encode_sort_key(unsigned char* sort_key, slls_t* pkey_field_values, int* sort_params, context_t* pctx);
+static inline int sort_key_compare(unsigned char* a, int alength, unsigned char* b, int blength);
+static void sort_entries(sort_entry_t* entries, int n);
 
 // ----------------------------------------------------------------
 mapper_setup_t mapper_sort_setup = {
@@ -104,6 +190,7 @@ mapper_setup_t mapper_sort_setup = {
 	.pusage_func = mapper_sort_usage,
 	.pparse_func = mapper_sort_parse_cli,
 	.ignores_input = FALSE,
+	.pset_output_limit_func = mapper_sort_set_output_limit,
 };
 
 mapper_setup_t mapper_group_by_setup = {
@@ -122,6 +209,17 @@ static void mapper_sort_usage(FILE* o, char* argv0, char* verb) {
 	fprintf(o, "  -nf {comma-separated field names}  Numerical ascending; nulls sort last\n");
 	fprintf(o, "  -r  {comma-separated field names}  Lexical descending\n");
 	fprintf(o, "  -nr {comma-separated field names}  Numerical descending; nulls sort first\n");
+	fprintf(o, "  --max-memory {size}  Hold about this much input in memory at most, spilling sorted\n");
+	fprintf(o, "                       runs to temporary files to be merged at end of stream.\n");
+	fprintf(o, "                       Size is in bytes, with optional k, m, or g suffix.\n");
+	fprintf(o, "                       If anything is spilled, records with numerically equal\n");
+	fprintf(o, "                       values written differently, such as 1 and 1.0, are grouped\n");
+	fprintf(o, "                       by how they're written only within each run, so they may\n");
+	fprintf(o, "                       come out interleaved.\n");
+	fprintf(o, "  --tmpdir {dir}       Directory for the temporary files. Default $TMPDIR else /tmp.\n");
+	fprintf(o, "  --limit {n}          Output only the first n records, holding only that many in\n");
+	fprintf(o, "                       memory. This is automatic when sort is followed by head -n\n");
+	fprintf(o, "                       without -g.\n");
 	fprintf(o, "Sorts records primarily by the first specified field, secondarily by the second\n");
 	fprintf(o, "field, and so on.  (Any records not having all specified sort keys will appear\n");
 	fprintf(o, "at the end of the output, in the order they were encountered, regardless of the\n");
@@ -132,6 +230,10 @@ static void mapper_sort_usage(FILE* o, char* argv0, char* verb) {
 	fprintf(o, "  %s %s -f a,b -nr x,y,z\n", argv0, verb);
 	fprintf(o, "which is the same as:\n");
 	fprintf(o, "  %s %s -f a -f b -nr x -nr y -nr z\n", argv0, verb);
+	fprintf(o, "Example for the ten records with highest x:\n");
+	fprintf(o, "  %s %s -nr x --limit 10\n", argv0, verb);
+	fprintf(o, "Example for input larger than memory:\n");
+	fprintf(o, "  %s %s --max-memory 8g -f a -nr x\n", argv0, verb);
 }
 
 static mapper_t* mapper_sort_parse_cli(int* pargi, int argc, char** argv,
@@ -145,6 +247,9 @@ static mapper_t* mapper_sort_parse_cli(int* pargi, int argc, char** argv,
 	*pargi += 1;
 	slls_t* pnames = slls_alloc();
 	slls_t* pflags = slls_alloc();
+	long long max_memory = 0LL;
+	long long limit = -1LL;
+	char* tmpdir = lrec_spill_default_tmpdir();
 
 	while ((argc - *pargi) >= 1 && argv[*pargi][0] == '-') {
 		if ((argc - *pargi) < 2)
@@ -153,6 +258,24 @@ static mapper_t* mapper_sort_parse_cli(int* pargi, int argc, char** argv,
 		char* value = argv[*pargi+1];
 		*pargi += 2;
 
+		if (streq(flag, "--max-memory")) {
+			max_memory = lrec_spill_parse_memory_size(value);
+			if (max_memory <= 0LL) {
+				mapper_sort_usage(stderr, argv[0], verb);
+				return NULL;
+			}
+			continue;
+		} else if (streq(flag, "--tmpdir")) {
+			tmpdir = value;
+			continue;
+		} else if (streq(flag, "--limit")) {
+			if (!mlr_try_int_from_string(value, &limit) || limit < 0LL) {
+				mapper_sort_usage(stderr, argv[0], verb);
+				return NULL;
+			}
+			continue;
+		}
+
 		if (streq(flag, "-f")) {
 		} else if (streq(flag, "-n")) {
 		} else if (streq(flag, "-nf")) {
@@ -190,7 +313,10 @@ static mapper_t* mapper_sort_parse_cli(int* pargi, int argc, char** argv,
 	}
 	slls_free(pflags);
 
-	return mapper_sort_alloc(pnames, opt_array, TRUE);
+	mapper_t* pmapper = mapper_sort_alloc(pnames, opt_array, TRUE, max_memory, tmpdir);
+	if (limit >= 0LL)
+		mapper_sort_set_output_limit(pmapper, limit);
+	return pmapper;
 }
 
 // ----------------------------------------------------------------
@@ -213,11 +339,13 @@ static mapper_t* mapper_group_by_parse_cli(int* pargi, int argc, char** argv,
 		opt_array[i] = 0;
 
 	*pargi += 2;
-	return mapper_sort_alloc(pnames, opt_array, FALSE);
+	return mapper_sort_alloc(pnames, opt_array, FALSE, 0LL, NULL);
 }
 
 // ----------------------------------------------------------------
-static mapper_t* mapper_sort_alloc(slls_t* pkey_field_names, int* sort_params, int do_sort) {
+static mapper_t* mapper_sort_alloc(slls_t* pkey_field_names, int* sort_params, int do_sort,
+	long long max_memory, char* tmpdir)
+{
 	mapper_t* pmapper = mlr_malloc_or_die(sizeof(mapper_t));
 
 	mapper_sort_state_t* pstate = mlr_malloc_or_die(sizeof(mapper_sort_state_t));
@@ -227,10 +355,28 @@ static mapper_t* mapper_sort_alloc(slls_t* pkey_field_names, int* sort_params, i
 	pstate->pbuckets_by_key_field_values = lhmslv_alloc();
 	pstate->precords_missing_sort_keys   = sllv_alloc();
 	pstate->do_sort                      = do_sort;
+	pstate->max_memory                   = max_memory;
+	pstate->tmpdir                       = tmpdir;
+	pstate->memory_used                  = 0LL;
+	pstate->pruns                        = sllv_alloc();
+	pstate->pmissing_sort_keys_file      = NULL;
+	pstate->merge_heap                   = NULL;
+	pstate->merge_heap_size              = 0;
+	pstate->merging                      = FALSE;
+	pstate->limit                        = -1LL;
+	pstate->kept_heap                    = NULL;
+	pstate->kept_count                   = 0LL;
+	pstate->kept_alloc_count             = 0LL;
+	pstate->num_keyed_records_seen       = 0LL;
+	pstate->pkept_first_seen             = NULL;
+	pstate->scratch_sort_key             = NULL;
+	pstate->scratch_sort_key_alloc_length = 0;
 
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_sort_process;
 	pmapper->pfree_func    = mapper_sort_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -243,12 +389,29 @@ static void mapper_sort_free(mapper_t* pmapper, context_t* _) {
 	// lhmslv_free will free the hashmap keys; we need to free the void-star hashmap values.
 	for (lhmslve_t* pa = pstate->pbuckets_by_key_field_values->phead; pa != NULL; pa = pa->pnext) {
 		sort_bucket_t* pbucket = pa->pvvalue;
-		free(pbucket->typed_sort_keys);
+		free(pbucket->sort_key);
 		free(pbucket);
 		// precords freed in emitter
 	}
 	lhmslv_free(pstate->pbuckets_by_key_field_values);
 	sllv_free(pstate->precords_missing_sort_keys);
+	for (sllve_t* pe = pstate->pruns->phead; pe != NULL; pe = pe->pnext)
+		sort_run_free(pe->pvvalue);
+	sllv_free(pstate->pruns);
+	free(pstate->merge_heap);
+	for (long long i = 0; i < pstate->kept_count; i++) {
+		lrec_free(pstate->kept_heap[i].prec);
+		free(pstate->kept_heap[i].sort_key);
+	}
+	free(pstate->kept_heap);
+	if (pstate->pkept_first_seen != NULL) {
+		for (lhmslve_t* pe = pstate->pkept_first_seen->phead; pe != NULL; pe = pe->pnext)
+			free(pe->pvvalue);
+		lhmslv_free(pstate->pkept_first_seen);
+	}
+	free(pstate->scratch_sort_key);
+	if (pstate->pmissing_sort_keys_file != NULL)
+		fclose(pstate->pmissing_sort_keys_file);
 	free(pstate->sort_params);
 	free(pstate);
 	free(pmapper);
@@ -257,8 +420,13 @@ static void mapper_sort_free(mapper_t* pmapper, context_t* _) {
 // ----------------------------------------------------------------
 static sllv_t* mapper_sort_process(lrec_t* pinrec, context_t* pctx, void* pvstate) {
 	mapper_sort_state_t* pstate = pvstate;
-	if (pinrec != NULL) {
+	if (pinrec != NULL && pstate->limit >= 0LL) {
+		mapper_sort_keep_top(pstate, pinrec, pctx);
+		return NULL;
+	} else if (pinrec != NULL) {
 		// Consume another input record.
+		if (pstate->max_memory > 0LL)
+			pstate->memory_used += lrec_memory_size(pinrec) + sizeof(sllve_t);
 		slls_t* pkey_field_values = mlr_reference_selected_values_from_record(pinrec, pstate->pkey_field_names);
 		if (pkey_field_values == NULL) {
 			sllv_append(pstate->precords_missing_sort_keys, pinrec);
@@ -267,16 +435,26 @@ static sllv_t* mapper_sort_process(lrec_t* pinrec, context_t* pctx, void* pvstat
 			if (pbucket == NULL) { // New key-field-value: new bucket and hash-map entry
 				slls_t* pkey_field_values_copy = slls_copy(pkey_field_values);
 				sort_bucket_t* pbucket = mlr_malloc_or_die(sizeof(sort_bucket_t));
-				pbucket->typed_sort_keys = parse_sort_keys(pkey_field_values_copy, pstate->sort_params, pctx);
+				if (pstate->do_sort) {
+					pbucket->sort_key_length = sort_key_length(pkey_field_values, pstate->sort_params);
+					pbucket->sort_key = mlr_malloc_or_die(pbucket->sort_key_length);
+					encode_sort_key(pbucket->sort_key, pkey_field_values, pstate->sort_params, pctx);
+				} else {
+					pbucket->sort_key_length = 0;
+					pbucket->sort_key = NULL;
+				}
 				pbucket->precords = sllv_alloc();
 				sllv_append(pbucket->precords, pinrec);
 				lhmslv_put(pstate->pbuckets_by_key_field_values, pkey_field_values_copy, pbucket,
 					FREE_ENTRY_KEY);
+				pstate->memory_used += SORT_BUCKET_OVERHEAD + pbucket->sort_key_length;
 			} else { // Previously seen key-field-value: append record to bucket
 				sllv_append(pbucket->precords, pinrec);
 			}
 			slls_free(pkey_field_values);
 		}
+		if (pstate->max_memory > 0LL && pstate->memory_used >= pstate->max_memory)
+			mapper_sort_spill_run(pstate, pctx);
 		return NULL;
 	} else if (!pstate->do_sort) {
 		// End of input stream: do output for group-by
@@ -289,28 +467,20 @@ static sllv_t* mapper_sort_process(lrec_t* pinrec, context_t* pctx, void* pvstat
 		sllv_transfer(poutput, pstate->precords_missing_sort_keys);
 		sllv_append(poutput, NULL);
 		return poutput;
+	} else if (pstate->limit >= 0LL) {
+		// End of input stream: sort what's been kept
+		return mapper_sort_emit_top(pstate);
+	} else if (pstate->merging || pstate->pruns->length > 0 || pstate->pmissing_sort_keys_file != NULL) {
+		// End of input stream, having spilled runs: merge them
+		return mapper_sort_emit_merged(pstate, pctx);
 	} else {
 		// End of input stream: sort bucket labels
-		int num_buckets = pstate->pbuckets_by_key_field_values->num_occupied;
-		sort_bucket_t** pbucket_array = mlr_malloc_or_die(num_buckets * sizeof(sort_bucket_t*));
-
-		// Copy bucket-pointers to an array for qsort
-		int i = 0;
-		for (lhmslve_t* pe = pstate->pbuckets_by_key_field_values->phead; pe != NULL; pe = pe->pnext, i++) {
-			pbucket_array[i] = pe->pvvalue;
-		}
-
-		pcmp_sort_params  = pstate->sort_params;
-		cmp_params_length = pstate->pkey_field_names->length;
-
-		qsort(pbucket_array, num_buckets, sizeof(sort_bucket_t*), pbucket_comparator);
-
-		pcmp_sort_params  = NULL;
-		cmp_params_length = 0;
+		int num_buckets = 0;
+		sort_bucket_t** pbucket_array = mapper_sort_sorted_buckets(pstate, &num_buckets);
 
 		// Emit each bucket's record
 		sllv_t* poutput = sllv_alloc();
-		for (i = 0; i < num_buckets; i++) {
+		for (int i = 0; i < num_buckets; i++) {
 			sllv_t* plist = pbucket_array[i]->precords;
 			sllv_transfer(poutput, plist);
 			sllv_free(plist);
@@ -322,54 +492,506 @@ static sllv_t* mapper_sort_process(lrec_t* pinrec, context_t* pctx, void* pvstat
 	}
 }
 
-static int pbucket_comparator(const void* pva, const void* pvb) {
-	// We are sorting an array of sort_bucket_t*.
-	const sort_bucket_t** pba = (const sort_bucket_t**)pva;
-	const sort_bucket_t** pbb = (const sort_bucket_t**)pvb;
-	typed_sort_key_t* akeys = (*pba)->typed_sort_keys;
-	typed_sort_key_t* bkeys = (*pbb)->typed_sort_keys;
-	for (int i = 0; i < cmp_params_length; i++) {
-		int sort_param = pcmp_sort_params[i];
-		if (sort_param & SORT_NUMERIC) {
-			double a = akeys[i].u.d;
-			double b = bkeys[i].u.d;
-			if (isnan(a)) { // null input value
-				if (!isnan(b)) {
-					return (sort_param & SORT_DESCENDING) ? -1 : 1;
-				}
-			} else if (isnan(b)) {
-					return (sort_param & SORT_DESCENDING) ? 1 : -1;
-			} else {
-				double d = a - b;
-				int s = (d < 0) ? -1 : (d > 0) ? 1 : 0;
-				if (s != 0)
-					return (sort_param & SORT_DESCENDING) ? -s : s;
-			}
-		} else {
-			int s = strcmp(akeys[i].u.s, bkeys[i].u.s);
-			if (s != 0)
-				return (sort_param & SORT_DESCENDING) ? -s : s;
+// Called repeatedly at end of stream, returning the next batch of merged output each time.
+static sllv_t* mapper_sort_emit_merged(mapper_sort_state_t* pstate, context_t* pctx) {
+	if (!pstate->merging) {
+		mapper_sort_spill_run(pstate, pctx);
+		mapper_sort_merge_start(pstate, pctx);
+		if (pstate->pmissing_sort_keys_file != NULL)
+			lrec_spill_file_rewind_or_die(pstate->pmissing_sort_keys_file);
+		pstate->merging = TRUE;
+	}
+
+	sllv_t* poutput = sllv_alloc();
+	while (poutput->length < SORT_OUTPUT_BATCH_SIZE) {
+		lrec_t* prec = mapper_sort_merge_next(pstate, pctx);
+		if (prec == NULL && pstate->pmissing_sort_keys_file != NULL)
+			prec = lrec_spill_read(pstate->pmissing_sort_keys_file);
+		if (prec == NULL) {
+			sllv_append(poutput, NULL); // Signal end of output-record stream.
+			return poutput;
+		}
+		sllv_append(poutput, prec);
+	}
+	sllv_append(poutput, MAPPER_MORE_OUTPUT);
+	return poutput;
+}
+
+// Big-endian, so that integer order is memcmp order.
+static inline unsigned long long sort_key_prefix(unsigned char* sort_key, int sort_key_length) {
+	unsigned long long prefix = 0ULL;
+	for (int i = 0; i < 8; i++)
+		prefix = (prefix << 8) | ((i < sort_key_length) ? sort_key[i] : 0);
+	return prefix;
+}
+
+// ----------------------------------------------------------------
+// Top-k mode. With more than one limit (e.g. sort --limit 5 then head -n 10), the least applies.
+static void mapper_sort_set_output_limit(mapper_t* pmapper, long long limit) {
+	mapper_sort_state_t* pstate = pmapper->pvstate;
+	if (pstate->limit < 0LL || limit < pstate->limit)
+		pstate->limit = limit;
+}
+
+static inline int sort_kept_greater(sort_kept_t* pa, sort_kept_t* pb) {
+	int s = sort_key_compare(pa->sort_key, pa->sort_key_length, pb->sort_key, pb->sort_key_length);
+	if (s != 0)
+		return s > 0;
+	if (pa->first_seen != pb->first_seen)
+		return pa->first_seen > pb->first_seen;
+	return pa->seqno > pb->seqno;
+}
+
+static void mapper_sort_keep_top(mapper_sort_state_t* pstate, lrec_t* pinrec, context_t* pctx) {
+	slls_t* pkey_field_values = mlr_reference_selected_values_from_record(pinrec, pstate->pkey_field_names);
+	if (pkey_field_values == NULL) {
+		if (pstate->precords_missing_sort_keys->length < pstate->limit)
+			sllv_append(pstate->precords_missing_sort_keys, pinrec);
+		else
+			lrec_free(pinrec);
+		return;
+	}
+
+	// Encode the key into scratch space first: most records don't make the cut.
+	sort_kept_t candidate;
+	candidate.sort_key_length = sort_key_length(pkey_field_values, pstate->sort_params);
+	if (candidate.sort_key_length > pstate->scratch_sort_key_alloc_length) {
+		pstate->scratch_sort_key_alloc_length = 2 * candidate.sort_key_length;
+		pstate->scratch_sort_key = mlr_realloc_or_die(pstate->scratch_sort_key,
+			pstate->scratch_sort_key_alloc_length);
+	}
+	candidate.sort_key              = pstate->scratch_sort_key;
+	candidate.sort_key_alloc_length = pstate->scratch_sort_key_alloc_length;
+	candidate.seqno                 = pstate->num_keyed_records_seen++;
+	candidate.prec                  = pinrec;
+	encode_sort_key(candidate.sort_key, pkey_field_values, pstate->sort_params, pctx);
+
+	sort_kept_t* heap = pstate->kept_heap;
+	int is_full = pstate->kept_count >= pstate->limit;
+	if (is_full && (pstate->kept_count == 0LL || sort_key_compare(candidate.sort_key, candidate.sort_key_length,
+		heap[0].sort_key, heap[0].sort_key_length) > 0))
+	{
+		// The usual case for most records: no need to look up their first-seen position.
+		slls_free(pkey_field_values);
+		lrec_free(pinrec);
+		return;
+	}
+	long long* pfirst_seen = mapper_sort_kept_first_seen(pstate, pkey_field_values);
+	candidate.first_seen = (pfirst_seen != NULL) ? *pfirst_seen : candidate.seqno;
+	if (is_full && !sort_kept_greater(&heap[0], &candidate)) {
+		slls_free(pkey_field_values);
+		lrec_free(pinrec);
+		return;
+	}
+	if (pfirst_seen == NULL)
+		mapper_sort_remember_first_seen(pstate, pkey_field_values, candidate.first_seen);
+	slls_free(pkey_field_values);
+
+	if (!is_full) {
+		if (pstate->kept_count == pstate->kept_alloc_count) {
+			pstate->kept_alloc_count = (pstate->kept_alloc_count == 0LL) ? 16LL : 2LL * pstate->kept_alloc_count;
+			if (pstate->kept_alloc_count > pstate->limit)
+				pstate->kept_alloc_count = pstate->limit;
+			heap = pstate->kept_heap = mlr_realloc_or_die(heap, pstate->kept_alloc_count * sizeof(sort_kept_t));
+		}
+		// The kept entry takes over the scratch buffer.
+		pstate->scratch_sort_key = NULL;
+		pstate->scratch_sort_key_alloc_length = 0;
+		// Sift up
+		long long i = pstate->kept_count++;
+		while (i > 0 && sort_kept_greater(&candidate, &heap[(i-1)/2])) {
+			heap[i] = heap[(i-1)/2];
+			i = (i-1)/2;
 		}
+		heap[i] = candidate;
+	} else {
+		// Evict the worst kept record; its key buffer becomes the scratch space.
+		lrec_free(heap[0].prec);
+		pstate->scratch_sort_key = heap[0].sort_key;
+		pstate->scratch_sort_key_alloc_length = heap[0].sort_key_alloc_length;
+		heap[0] = candidate;
+		sort_kept_heap_sift_down(heap, 0, pstate->kept_count);
+		mapper_sort_forget_evicted_first_seen(pstate);
+	}
+}
+
+// Returns null if no kept record has these sort-key values.
+static long long* mapper_sort_kept_first_seen(mapper_sort_state_t* pstate, slls_t* pkey_field_values) {
+	if (pstate->pkept_first_seen == NULL)
+		return NULL;
+	return lhmslv_get(pstate->pkept_first_seen, pkey_field_values);
+}
+
+static void mapper_sort_remember_first_seen(mapper_sort_state_t* pstate, slls_t* pkey_field_values,
+	long long first_seen)
+{
+	if (pstate->pkept_first_seen == NULL)
+		pstate->pkept_first_seen = lhmslv_alloc();
+	long long* pfirst_seen = mlr_malloc_or_die(sizeof(long long));
+	*pfirst_seen = first_seen;
+	lhmslv_put(pstate->pkept_first_seen, slls_copy(pkey_field_values), pfirst_seen, FREE_ENTRY_KEY);
+}
+
+// The map isn't pruned on each eviction. Rather, once it's grown to twice the size of the heap, it's
+// rebuilt from the records still kept.
+static void mapper_sort_forget_evicted_first_seen(mapper_sort_state_t* pstate) {
+	if (lhmslv_size(pstate->pkept_first_seen) < 2 * pstate->kept_count + 16)
+		return;
+	for (lhmslve_t* pe = pstate->pkept_first_seen->phead; pe != NULL; pe = pe->pnext)
+		free(pe->pvvalue);
+	lhmslv_free(pstate->pkept_first_seen);
+	pstate->pkept_first_seen = NULL;
+	for (long long i = 0; i < pstate->kept_count; i++) {
+		slls_t* pkey_field_values = mlr_reference_selected_values_from_record(pstate->kept_heap[i].prec,
+			pstate->pkey_field_names);
+		if (mapper_sort_kept_first_seen(pstate, pkey_field_values) == NULL)
+			mapper_sort_remember_first_seen(pstate, pkey_field_values, pstate->kept_heap[i].first_seen);
+		slls_free(pkey_field_values);
+	}
+}
+
+static void sort_kept_heap_sift_down(sort_kept_t* heap, long long i, long long n) {
+	sort_kept_t entry = heap[i];
+	while (TRUE) {
+		long long c = 2*i + 1;
+		if (c >= n)
+			break;
+		if (c + 1 < n && sort_kept_greater(&heap[c+1], &heap[c]))
+			c++;
+		if (!sort_kept_greater(&heap[c], &entry))
+			break;
+		heap[i] = heap[c];
+		i = c;
+	}
+	heap[i] = entry;
+}
+
+// Heapsorts the kept records into ascending order, then emits them followed by as many of the
+// records missing sort keys as the limit leaves room for.
+static sllv_t* mapper_sort_emit_top(mapper_sort_state_t* pstate) {
+	sort_kept_t* heap = pstate->kept_heap;
+	for (long long n = pstate->kept_count - 1; n > 0; n--) {
+		sort_kept_t max = heap[0];
+		heap[0] = heap[n];
+		heap[n] = max;
+		sort_kept_heap_sift_down(heap, 0, n);
+	}
+
+	sllv_t* poutput = sllv_alloc();
+	for (long long i = 0; i < pstate->kept_count; i++) {
+		sllv_append(poutput, heap[i].prec);
+		free(heap[i].sort_key);
+	}
+	pstate->kept_count = 0LL;
+
+	lrec_t* prec;
+	while ((prec = sllv_pop(pstate->precords_missing_sort_keys)) != NULL) {
+		if (poutput->length < pstate->limit)
+			sllv_append(poutput, prec);
+		else
+			lrec_free(prec);
+	}
+	sllv_append(poutput, NULL); // Signal end of output-record stream.
+	return poutput;
+}
+
+// ----------------------------------------------------------------
+// Returns the bucket pointers in sort order. The caller should free the array.
+static sort_bucket_t** mapper_sort_sorted_buckets(mapper_sort_state_t* pstate, int* pnum_buckets) {
+	int num_buckets = pstate->pbuckets_by_key_field_values->num_occupied;
+	sort_entry_t* entries = mlr_malloc_or_die(num_buckets * sizeof(sort_entry_t));
+
+	int i = 0;
+	for (lhmslve_t* pe = pstate->pbuckets_by_key_field_values->phead; pe != NULL; pe = pe->pnext, i++) {
+		sort_bucket_t* pbucket = pe->pvvalue;
+		entries[i].prefix  = sort_key_prefix(pbucket->sort_key, pbucket->sort_key_length);
+		entries[i].pbucket = pbucket;
 	}
-	return 0;
+
+	sort_entries(entries, num_buckets);
+
+	sort_bucket_t** pbucket_array = mlr_malloc_or_die(num_buckets * sizeof(sort_bucket_t*));
+	for (i = 0; i < num_buckets; i++)
+		pbucket_array[i] = entries[i].pbucket;
+	free(entries);
+
+	*pnum_buckets = num_buckets;
+	return pbucket_array;
+}
+
+// ----------------------------------------------------------------
+// Normalized sort keys are the concatenation of an encoding of each sort-key field:
+//
+// * Lexical: the value's bytes and a terminating NUL. Values don't contain NUL, so a value sorts
+//   before longer ones it's a prefix of, as with strcmp.
+//
+// * Numeric: the IEEE-754 bits of the value, big-endian, with the sign bit flipped for
+//   non-negatives and all bits flipped for negatives, so that byte order is numeric order.
+//   Empty values are taken as NaN, which encodes above +inf, so sorts last. -0 is taken as 0.
+//   NaNs are all taken as the same positive NaN.
+//
+// * For descending sort the field's bytes are all inverted.
+//
+// Each field's encoding is prefix-free, so a byte-by-byte comparison of two keys is decided within
+// the first field which differs.
+
+static int sort_key_length(slls_t* pkey_field_values, int* sort_params) {
+	int length = 0;
+	int i = 0;
+	for (sllse_t* pe = pkey_field_values->phead; pe != NULL; pe = pe->pnext, i++)
+		length += (sort_params[i] & SORT_NUMERIC) ? sizeof(double) : strlen(pe->value) + 1;
+	return length;
 }
 
-// E.g. parse the list ["red","1.0"] into the array ["red",1.0].
-static typed_sort_key_t* parse_sort_keys(slls_t* pkey_field_values, int* sort_params, context_t* pctx) {
-	typed_sort_key_t* typed_sort_keys = mlr_malloc_or_die(pkey_field_values->length * sizeof(typed_sort_key_t));
+static void encode_sort_key(unsigned char* sort_key, slls_t* pkey_field_values, int* sort_params, context_t* pctx) {
+	unsigned char* p = sort_key;
 	int i = 0;
 	for (sllse_t* pe = pkey_field_values->phead; pe != NULL; pe = pe->pnext, i++) {
+		unsigned char* pfield = p;
 		if (sort_params[i] & SORT_NUMERIC) {
+			double d;
 			if (*pe->value == 0) { // null input value
-				typed_sort_keys[i].u.d = nan("");
-			} else if (!mlr_try_float_from_string(pe->value, &typed_sort_keys[i].u.d)) {
+				d = nan("");
+			} else if (!mlr_try_float_from_string(pe->value, &d)) {
 				fprintf(stderr, "%s: couldn't parse \"%s\" as number in file \"%s\" record %lld.\n",
 					MLR_GLOBALS.bargv0, pe->value, pctx->filename, pctx->fnr);
 				exit(1);
 			}
+			if (isnan(d))
+				d = nan("");
+			else if (d == 0.0)
+				d = 0.0;
+			unsigned long long u;
+			memcpy(&u, &d, sizeof(u));
+			u = (u >> 63) ? ~u : (u | 0x8000000000000000ULL);
+			for (int j = 7; j >= 0; j--)
+				*p++ = (u >> (8*j)) & 0xff;
 		} else {
-			typed_sort_keys[i].u.s = pe->value;
+			int n = strlen(pe->value) + 1;
+			memcpy(p, pe->value, n);
+			p += n;
+		}
+		if (sort_params[i] & SORT_DESCENDING) {
+			for (unsigned char* q = pfield; q < p; q++)
+				*q = ~*q;
+		}
+	}
+}
+
+static inline int sort_key_compare(unsigned char* a, int alength, unsigned char* b, int blength) {
+	int s = memcmp(a, b, (alength < blength) ? alength : blength);
+	return (s != 0) ? s : alength - blength;
+}
+
+// ----------------------------------------------------------------
+static inline int sort_entry_compare(sort_entry_t* pa, sort_entry_t* pb) {
+	if (pa->prefix != pb->prefix)
+		return (pa->prefix < pb->prefix) ? -1 : 1;
+	sort_bucket_t* pba = pa->pbucket;
+	sort_bucket_t* pbb = pb->pbucket;
+	if (pba->sort_key_length <= 8 || pbb->sort_key_length <= 8)
+		return pba->sort_key_length - pbb->sort_key_length;
+	return sort_key_compare(pba->sort_key + 8, pba->sort_key_length - 8, pbb->sort_key + 8, pbb->sort_key_length - 8);
+}
+
+// Stable: insertion sort on short runs, then bottom-up merges back and forth between the array and
+// a scratch copy.
+#define SORT_INSERTION_RUN_LENGTH 16
+static void sort_entries(sort_entry_t* entries, int n) {
+	for (int lo = 0; lo < n; lo += SORT_INSERTION_RUN_LENGTH) {
+		int hi = (lo + SORT_INSERTION_RUN_LENGTH < n) ? lo + SORT_INSERTION_RUN_LENGTH : n;
+		for (int i = lo + 1; i < hi; i++) {
+			sort_entry_t entry = entries[i];
+			int j = i;
+			for ( ; j > lo && sort_entry_compare(&entry, &entries[j-1]) < 0; j--)
+				entries[j] = entries[j-1];
+			entries[j] = entry;
+		}
+	}
+	if (n <= SORT_INSERTION_RUN_LENGTH)
+		return;
+
+	sort_entry_t* scratch = mlr_malloc_or_die(n * sizeof(sort_entry_t));
+	sort_entry_t* src = entries;
+	sort_entry_t* dst = scratch;
+	for (int width = SORT_INSERTION_RUN_LENGTH; width < n; width *= 2) {
+		for (int lo = 0; lo < n; lo += 2*width) {
+			int mid = (lo + width < n) ? lo + width : n;
+			int hi  = (lo + 2*width < n) ? lo + 2*width : n;
+			int i = lo, j = mid, k = lo;
+			while (i < mid && j < hi)
+				dst[k++] = (sort_entry_compare(&src[j], &src[i]) < 0) ? src[j++] : src[i++];
+			while (i < mid)
+				dst[k++] = src[i++];
+			while (j < hi)
+				dst[k++] = src[j++];
+		}
+		sort_entry_t* tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+	if (src != entries)
+		memcpy(entries, src, n * sizeof(sort_entry_t));
+	free(scratch);
+}
+
+// ----------------------------------------------------------------
+// Sorts the buckets held in memory and writes their records out as a new run, then does
+// likewise (unsorted) for the records missing sort keys.
+static void mapper_sort_spill_run(mapper_sort_state_t* pstate, context_t* pctx) {
+	int num_buckets = 0;
+	sort_bucket_t** pbucket_array = mapper_sort_sorted_buckets(pstate, &num_buckets);
+	if (num_buckets > 0) {
+		sort_run_t* prun = sort_run_alloc(pstate);
+		for (int i = 0; i < num_buckets; i++) {
+			sllv_t* plist = pbucket_array[i]->precords;
+			for (sllve_t* pe = plist->phead; pe != NULL; pe = pe->pnext) {
+				lrec_spill_write(prun->fp, pe->pvvalue);
+				lrec_free(pe->pvvalue);
+			}
+			sllv_free(plist);
+		}
+		sllv_append(pstate->pruns, prun);
+	}
+	free(pbucket_array);
+
+	for (lhmslve_t* pe = pstate->pbuckets_by_key_field_values->phead; pe != NULL; pe = pe->pnext) {
+		sort_bucket_t* pbucket = pe->pvvalue;
+		free(pbucket->sort_key);
+		free(pbucket);
+	}
+	lhmslv_free(pstate->pbuckets_by_key_field_values);
+	pstate->pbuckets_by_key_field_values = lhmslv_alloc();
+
+	if (pstate->precords_missing_sort_keys->length > 0) {
+		if (pstate->pmissing_sort_keys_file == NULL)
+			pstate->pmissing_sort_keys_file = lrec_spill_file_open_or_die(pstate->tmpdir);
+		for (sllve_t* pe = pstate->precords_missing_sort_keys->phead; pe != NULL; pe = pe->pnext) {
+			lrec_spill_write(pstate->pmissing_sort_keys_file, pe->pvvalue);
+			lrec_free(pe->pvvalue);
+		}
+		sllv_free(pstate->precords_missing_sort_keys);
+		pstate->precords_missing_sort_keys = sllv_alloc();
+	}
+
+	pstate->memory_used = 0LL;
+
+	if (pstate->pruns->length >= SORT_MAX_RUNS_OPEN)
+		mapper_sort_merge_runs_to_one(pstate, pctx);
+}
+
+// Keeps the number of open files bounded. The merged run takes the place of the ones it was
+// merged from, ahead of any later runs, so stability is preserved.
+static void mapper_sort_merge_runs_to_one(mapper_sort_state_t* pstate, context_t* pctx) {
+	sort_run_t* pmerged = sort_run_alloc(pstate);
+	mapper_sort_merge_start(pstate, pctx);
+	lrec_t* prec;
+	while ((prec = mapper_sort_merge_next(pstate, pctx)) != NULL) {
+		lrec_spill_write(pmerged->fp, prec);
+		lrec_free(prec);
+	}
+	for (sllve_t* pe = pstate->pruns->phead; pe != NULL; pe = pe->pnext)
+		sort_run_free(pe->pvvalue);
+	sllv_free(pstate->pruns);
+	pstate->pruns = sllv_alloc();
+	sllv_append(pstate->pruns, pmerged);
+}
+
+// ----------------------------------------------------------------
+// The merge heap is a binary min-heap of the runs not yet exhausted, ordered by their next records.
+
+static void mapper_sort_merge_start(mapper_sort_state_t* pstate, context_t* pctx) {
+	free(pstate->merge_heap);
+	pstate->merge_heap = mlr_malloc_or_die(pstate->pruns->length * sizeof(sort_run_t*));
+	pstate->merge_heap_size = 0;
+
+	int index = 0;
+	for (sllve_t* pe = pstate->pruns->phead; pe != NULL; pe = pe->pnext, index++) {
+		sort_run_t* prun = pe->pvvalue;
+		prun->index = index;
+		lrec_spill_file_rewind_or_die(prun->fp);
+		sort_run_advance(pstate, prun, pctx);
+		if (prun->prec == NULL)
+			continue;
+		// Sift up
+		int i = pstate->merge_heap_size++;
+		while (i > 0 && sort_run_less(pstate, prun, pstate->merge_heap[(i-1)/2])) {
+			pstate->merge_heap[i] = pstate->merge_heap[(i-1)/2];
+			i = (i-1)/2;
+		}
+		pstate->merge_heap[i] = prun;
+	}
+}
+
+// Returns null when all runs are exhausted.
+static lrec_t* mapper_sort_merge_next(mapper_sort_state_t* pstate, context_t* pctx) {
+	if (pstate->merge_heap_size == 0)
+		return NULL;
+
+	sort_run_t* prun = pstate->merge_heap[0];
+	lrec_t* prec = prun->prec;
+	sort_run_advance(pstate, prun, pctx);
+	if (prun->prec == NULL) {
+		prun = pstate->merge_heap[--pstate->merge_heap_size];
+		if (pstate->merge_heap_size == 0)
+			return prec;
+	}
+
+	// Sift down
+	int n = pstate->merge_heap_size;
+	int i = 0;
+	while (TRUE) {
+		int c = 2*i + 1;
+		if (c >= n)
+			break;
+		if (c + 1 < n && sort_run_less(pstate, pstate->merge_heap[c+1], pstate->merge_heap[c]))
+			c++;
+		if (!sort_run_less(pstate, pstate->merge_heap[c], prun))
+			break;
+		pstate->merge_heap[i] = pstate->merge_heap[c];
+		i = c;
+	}
+	pstate->merge_heap[i] = prun;
+	return prec;
+}
+
+// Ties go to the earlier run.
+static int sort_run_less(mapper_sort_state_t* pstate, sort_run_t* pa, sort_run_t* pb) {
+	int s = sort_key_compare(pa->sort_key, pa->sort_key_length, pb->sort_key, pb->sort_key_length);
+	return (s != 0) ? (s < 0) : (pa->index < pb->index);
+}
+
+// ----------------------------------------------------------------
+static sort_run_t* sort_run_alloc(mapper_sort_state_t* pstate) {
+	sort_run_t* prun = mlr_malloc_or_die(sizeof(sort_run_t));
+	prun->fp                    = lrec_spill_file_open_or_die(pstate->tmpdir);
+	prun->index                 = 0;
+	prun->prec                  = NULL;
+	prun->sort_key              = NULL;
+	prun->sort_key_length       = 0;
+	prun->sort_key_alloc_length = 0;
+	return prun;
+}
+
+static void sort_run_free(sort_run_t* prun) {
+	if (prun->prec != NULL)
+		lrec_free(prun->prec);
+	fclose(prun->fp);
+	free(prun->sort_key);
+	free(prun);
+}
+
+// Reads the run's next record and encodes its sort key.
+static void sort_run_advance(mapper_sort_state_t* pstate, sort_run_t* prun, context_t* pctx) {
+	prun->prec = lrec_spill_read(prun->fp);
+	if (prun->prec != NULL) {
+		slls_t* pkey_field_values = mlr_reference_selected_values_from_record(prun->prec, pstate->pkey_field_names);
+		prun->sort_key_length = sort_key_length(pkey_field_values, pstate->sort_params);
+		if (prun->sort_key_length > prun->sort_key_alloc_length) {
+			prun->sort_key_alloc_length = 2 * prun->sort_key_length;
+			prun->sort_key = mlr_realloc_or_die(prun->sort_key, prun->sort_key_alloc_length);
 		}
+		encode_sort_key(prun->sort_key, pkey_field_values, pstate->sort_params, pctx);
+		slls_free(pkey_field_values);
 	}
-	return typed_sort_keys;
 }
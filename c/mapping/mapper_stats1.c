@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "lib/mlrutil.h"
 #include "lib/mlr_globals.h"
 #include "cli/argparse.h"
@@ -11,22 +12,52 @@
 #include "containers/lhmsv.h"
 #include "containers/mixutil.h"
 #include "containers/mlrval.h"
+#include "containers/batch_queue.h"
 #include "mapping/mappers.h"
 #include "mapping/stats1_accumulators.h"
 
 static char* fake_acc_name_for_setups = "__setup_done__";
 
+#define STATS1_BATCH_SIZE     500
+#define STATS1_QUEUE_CAPACITY 16
+
 // ----------------------------------------------------------------
+// With mlr --threads n for n > 1, non-iterative stats1 ingests on n worker threads, each with its own
+// groups map. With -g, records are hash-partitioned by group-by values so each group lives on exactly one
+// worker and is ingested in record order; the workers' groups are then emitted in first-seen order. Without
+// -g, batches are dealt round-robin to the workers and the partial accumulators are merged at end of stream.
+
+typedef struct _stats1_batch_t {
+	lrec_t**   precords;
+	long long* seqnos; // one-up record numbers, for restoring first-seen group order
+	int        length;
+} stats1_batch_t;
+
+struct _mapper_stats1_state_t;
+typedef struct _mapper_stats1_worker_t {
+	struct _mapper_stats1_state_t* pstate; // private groups map; parameters shared with the dispatcher
+	batch_queue_t*  pqueue;
+	stats1_batch_t* pbatch;         // being filled by the dispatcher
+	long long*      first_seqnos;   // indexed by group position in pstate->groups
+	int             first_seqnos_capacity;
+	pthread_t       thread;
+} mapper_stats1_worker_t;
+
 typedef struct _mapper_stats1_state_t {
 	ap_state_t* pargp;
 	slls_t*         paccumulator_names;
 	string_array_t* pvalue_field_names;     // parameter
-	string_array_t* pvalue_field_values;    // scratch space used per-record
+	lrece_t**       pvalue_field_entries;   // scratch space used per-record
 	slls_t*         pgroup_by_field_names;  // parameter
 	lhmslv_t*       groups;
 	int             do_iterative_stats;
 	int             allow_int_float;
 	int             do_interpolated_percentiles;
+
+	int             num_workers; // -1 until the first record is seen; 0 for serial ingest
+	mapper_stats1_worker_t* pworkers;
+	int             next_worker; // for round-robin when there is no group-by
+	long long       num_dispatched;
 } mapper_stats1_state_t;
 
 static void      mapper_stats1_usage(FILE* o, char* argv0, char* verb);
@@ -35,9 +66,12 @@ static mapper_t* mapper_stats1_parse_cli(int* pargi, int argc, char** argv,
 static mapper_t* mapper_stats1_alloc(ap_state_t* pargp, slls_t* paccumulator_names, string_array_t* pvalue_field_names,
 	slls_t* pgroup_by_field_names, int do_iterative_stats, int allow_int_float, int do_interpolated_percentiles);
 static void      mapper_stats1_free(mapper_t* pmapper, context_t* _);
+static void      mapper_stats1_free_groups(lhmslv_t* groups);
 static sllv_t*   mapper_stats1_process(lrec_t* pinrec, context_t* pctx, void* pvstate);
 static void      mapper_stats1_ingest(lrec_t* pinrec, mapper_stats1_state_t* pstate);
 static sllv_t*   mapper_stats1_emit_all(mapper_stats1_state_t* pstate);
+static lrec_t*   mapper_stats1_emit_group(mapper_stats1_state_t* pstate, slls_t* pgroup_by_field_values,
+	lhmsv_t* pgroup_to_acc_field);
 static lrec_t*   mapper_stats1_emit(mapper_stats1_state_t* pstate, lrec_t* poutrec,
 	char* value_field_name, lhmsv_t* acc_field_to_acc_state_out);
 
@@ -46,6 +80,13 @@ typedef struct _acc_map_pair_t {
 	lhmsv_t* pout;
 } acc_map_pair_t;
 
+static void      stats1_batch_free(stats1_batch_t* pbatch);
+static void      mapper_stats1_start_workers(mapper_stats1_state_t* pstate);
+static sllv_t*   mapper_stats1_process_partitioned(lrec_t* pinrec, mapper_stats1_state_t* pstate);
+static void*     mapper_stats1_worker_thread(void* pvarg);
+static sllv_t*   mapper_stats1_emit_partitioned(mapper_stats1_state_t* pstate);
+static void      mapper_stats1_merge_group(lhmsv_t* pinto, lhmsv_t* pfrom);
+
 // ----------------------------------------------------------------
 mapper_setup_t mapper_stats1_setup = {
 	.verb        = "stats1",
@@ -82,6 +123,9 @@ static void mapper_stats1_usage(FILE* o, char* argv0, char* verb) {
 	fprintf(o, "* count and mode allow text input; the rest require numeric input.\n");
 	fprintf(o, "  In particular, 1 and 1.0 are distinct text for count and mode.\n");
 	fprintf(o, "* When there are mode ties, the first-encountered datum wins.\n");
+	fprintf(o, "* With %s --threads, stats are computed on multiple threads unless -s is given.\n", argv0);
+	fprintf(o, "  Without -g, sums of non-integer values may then differ from single-threaded\n");
+	fprintf(o, "  output in the last decimal place.\n");
 }
 
 static mapper_t* mapper_stats1_parse_cli(int* pargi, int argc, char** argv,
@@ -130,15 +174,21 @@ static mapper_t* mapper_stats1_alloc(ap_state_t* pargp, slls_t* paccumulator_nam
 	pstate->paccumulator_names          = paccumulator_names;
 	pstate->pvalue_field_names          = pvalue_field_names;
 	pstate->pgroup_by_field_names       = pgroup_by_field_names;
-	pstate->pvalue_field_values         = string_array_alloc(pvalue_field_names->length);
+	pstate->pvalue_field_entries        = mlr_malloc_or_die(pvalue_field_names->length * sizeof(lrece_t*));
 	pstate->groups                      = lhmslv_alloc();
 	pstate->do_iterative_stats          = do_iterative_stats;
 	pstate->allow_int_float             = allow_int_float;
 	pstate->do_interpolated_percentiles = do_interpolated_percentiles;
+	pstate->num_workers                 = -1;
+	pstate->pworkers                    = NULL;
+	pstate->next_worker                 = 0;
+	pstate->num_dispatched              = 0LL;
 
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_stats1_process;
 	pmapper->pfree_func    = mapper_stats1_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -147,12 +197,32 @@ static void mapper_stats1_free(mapper_t* pmapper, context_t* _) {
 	mapper_stats1_state_t* pstate = pmapper->pvstate;
 	slls_free(pstate->paccumulator_names);
 	string_array_free(pstate->pvalue_field_names);
-	string_array_free(pstate->pvalue_field_values);
+	free(pstate->pvalue_field_entries);
 	slls_free(pstate->pgroup_by_field_names);
+	mapper_stats1_free_groups(pstate->groups);
+	for (int i = 0; i < pstate->num_workers; i++) {
+		mapper_stats1_worker_t* pworker = &pstate->pworkers[i];
+		if (pworker->pbatch != NULL) { // end of stream was never seen
+			stats1_batch_free(pworker->pbatch);
+			batch_queue_close(pworker->pqueue);
+			pthread_join(pworker->thread, NULL);
+		}
+		batch_queue_free(pworker->pqueue);
+		free(pworker->pstate->pvalue_field_entries);
+		mapper_stats1_free_groups(pworker->pstate->groups);
+		free(pworker->pstate);
+		free(pworker->first_seqnos);
+	}
+	free(pstate->pworkers);
+	ap_free(pstate->pargp);
+	free(pstate);
+	free(pmapper);
+}
 
+static void mapper_stats1_free_groups(lhmslv_t* groups) {
 	// lhmslv_free and lhmsv_free will free the hashmap keys; we need to free
 	// the void-star hashmap values.
-	for (lhmslve_t* pa = pstate->groups->phead; pa != NULL; pa = pa->pnext) {
+	for (lhmslve_t* pa = groups->phead; pa != NULL; pa = pa->pnext) {
 		lhmsv_t* pgroup_to_acc_field = pa->pvvalue;
 		for (lhmsve_t* pb = pgroup_to_acc_field->phead; pb != NULL; pb = pb->pnext) {
 			acc_map_pair_t* pacc_field_to_acc_states = pb->pvvalue;
@@ -170,10 +240,7 @@ static void mapper_stats1_free(mapper_t* pmapper, context_t* _) {
 		}
 		lhmsv_free(pgroup_to_acc_field);
 	}
-	lhmslv_free(pstate->groups);
-	ap_free(pstate->pargp);
-	free(pstate);
-	free(pmapper);
+	lhmslv_free(groups);
 }
 
 // ================================================================
@@ -224,6 +291,13 @@ static void mapper_stats1_free(mapper_t* pmapper, context_t* _) {
 // In the non-iterative case, produce output only at the end of the input stream.
 static sllv_t* mapper_stats1_process(lrec_t* pinrec, context_t* pctx, void* pvstate) {
 	mapper_stats1_state_t* pstate = pvstate;
+	// This is done on first use rather than at alloc since verbs are parsed before the main options are
+	// all in effect.
+	if (pstate->num_workers < 0)
+		mapper_stats1_start_workers(pstate);
+	if (pstate->num_workers > 0)
+		return mapper_stats1_process_partitioned(pinrec, pstate);
+
 	if (pinrec != NULL) {
 		mapper_stats1_ingest(pinrec, pstate);
 		if (pstate->do_iterative_stats) {
@@ -247,7 +321,7 @@ static void mapper_stats1_ingest(lrec_t* pinrec, mapper_stats1_state_t* pstate)
 	// population on that, but retain full-population requirement on group-by.
 	// E.g. if accumulating stats of x,y on a,b then skip record with x,y,a but
 	// process record with x,a,b.
-	mlr_reference_values_from_record_into_string_array(pinrec, pstate->pvalue_field_names, pstate->pvalue_field_values);
+	mlr_reference_entries_from_record_into_array(pinrec, pstate->pvalue_field_names, pstate->pvalue_field_entries);
 	slls_t* pgroup_by_field_values = mlr_reference_selected_values_from_record(pinrec, pstate->pgroup_by_field_names);
 
 	if (pgroup_by_field_values == NULL) {
@@ -266,7 +340,8 @@ static void mapper_stats1_ingest(lrec_t* pinrec, mapper_stats1_state_t* pstate)
 	int n = pstate->pvalue_field_names->length;
 	for (int i = 0; i < n; i++) {
 		char* value_field_name = pstate->pvalue_field_names->strings[i];
-		char* value_field_sval = pstate->pvalue_field_values->strings[i];
+		lrece_t* pvalue_field_entry = pstate->pvalue_field_entries[i];
+		char* value_field_sval = (pvalue_field_entry == NULL) ? NULL : pvalue_field_entry->value;
 
 		// For percentiles there is one unique accumulator given (for example) five distinct
 		// names p0,p25,p50,p75,p100.  The input accumulators are unique: only one
@@ -315,7 +390,7 @@ static void mapper_stats1_ingest(lrec_t* pinrec, mapper_stats1_state_t* pstate)
 
 			if (pstats1_acc->pdingest_func != NULL) {
 				if (!have_dval) {
-					value_field_dval = mlr_double_from_string_or_die(value_field_sval);
+					value_field_dval = mlr_double_from_entry_or_die(pvalue_field_entry);
 					have_dval = TRUE;
 				}
 				pstats1_acc->pdingest_func(pstats1_acc->pvstate, value_field_dval);
@@ -323,8 +398,8 @@ static void mapper_stats1_ingest(lrec_t* pinrec, mapper_stats1_state_t* pstate)
 			if (pstats1_acc->pningest_func != NULL) {
 				if (!have_nval) {
 					value_field_nval = pstate->allow_int_float
-						? mv_scan_number_or_die(value_field_sval)
-						: mv_from_float(mlr_double_from_string_or_die(value_field_sval));
+						? mv_scan_entry_number_or_die(pvalue_field_entry)
+						: mv_from_float(mlr_double_from_entry_or_die(pvalue_field_entry));
 					have_nval = TRUE;
 				}
 				pstats1_acc->pningest_func(pstats1_acc->pvstate, &value_field_nval);
@@ -346,31 +421,35 @@ static sllv_t* mapper_stats1_emit_all(mapper_stats1_state_t* pstate) {
 	sllv_t* poutrecs = sllv_alloc();
 
 	for (lhmslve_t* pa = pstate->groups->phead; pa != NULL; pa = pa->pnext) {
-		slls_t* pgroup_by_field_values = pa->key;
-		lrec_t* poutrec = lrec_unbacked_alloc();
-
-		// Add in a=s,b=t fields:
-		sllse_t* pb = pstate->pgroup_by_field_names->phead;
-		sllse_t* pc =         pgroup_by_field_values->phead;
-		for ( ; pb != NULL && pc != NULL; pb = pb->pnext, pc = pc->pnext) {
-			lrec_put(poutrec, pb->value, pc->value, NO_FREE);
-		}
-
-		// Add in fields such as x_sum=#, y_count=#, etc.:
-		lhmsv_t* pgroup_to_acc_field = pa->pvvalue;
-		// for "x", "y"
-		for (lhmsve_t* pd = pgroup_to_acc_field->phead; pd != NULL; pd = pd->pnext) {
-			char* value_field_name = pd->key;
-			acc_map_pair_t* pacc_field_to_acc_states = pd->pvvalue;
-			lhmsv_t* acc_field_to_acc_state_out = pacc_field_to_acc_states->pout;
-			mapper_stats1_emit(pstate, poutrec, value_field_name, acc_field_to_acc_state_out);
-		}
-		sllv_append(poutrecs, poutrec);
+		sllv_append(poutrecs, mapper_stats1_emit_group(pstate, pa->key, pa->pvvalue));
 	}
 	sllv_append(poutrecs, NULL);
 	return poutrecs;
 }
 
+static lrec_t* mapper_stats1_emit_group(mapper_stats1_state_t* pstate, slls_t* pgroup_by_field_values,
+	lhmsv_t* pgroup_to_acc_field)
+{
+	lrec_t* poutrec = lrec_unbacked_alloc();
+
+	// Add in a=s,b=t fields:
+	sllse_t* pb = pstate->pgroup_by_field_names->phead;
+	sllse_t* pc =         pgroup_by_field_values->phead;
+	for ( ; pb != NULL && pc != NULL; pb = pb->pnext, pc = pc->pnext) {
+		lrec_put(poutrec, pb->value, pc->value, NO_FREE);
+	}
+
+	// Add in fields such as x_sum=#, y_count=#, etc.:
+	// for "x", "y"
+	for (lhmsve_t* pd = pgroup_to_acc_field->phead; pd != NULL; pd = pd->pnext) {
+		char* value_field_name = pd->key;
+		acc_map_pair_t* pacc_field_to_acc_states = pd->pvvalue;
+		lhmsv_t* acc_field_to_acc_state_out = pacc_field_to_acc_states->pout;
+		mapper_stats1_emit(pstate, poutrec, value_field_name, acc_field_to_acc_state_out);
+	}
+	return poutrec;
+}
+
 // ----------------------------------------------------------------
 static lrec_t* mapper_stats1_emit(mapper_stats1_state_t* pstate, lrec_t* poutrec,
 	char* value_field_name, lhmsv_t* acc_field_to_acc_state_out)
@@ -386,3 +465,196 @@ static lrec_t* mapper_stats1_emit(mapper_stats1_state_t* pstate, lrec_t* poutrec
 	}
 	return poutrec;
 }
+
+// ================================================================
+// Multi-threaded ingest
+
+static stats1_batch_t* stats1_batch_alloc() {
+	stats1_batch_t* pbatch = mlr_malloc_or_die(sizeof(stats1_batch_t));
+	pbatch->precords = mlr_malloc_or_die(STATS1_BATCH_SIZE * sizeof(lrec_t*));
+	pbatch->seqnos   = mlr_malloc_or_die(STATS1_BATCH_SIZE * sizeof(long long));
+	pbatch->length   = 0;
+	return pbatch;
+}
+
+static void stats1_batch_free(stats1_batch_t* pbatch) {
+	free(pbatch->precords);
+	free(pbatch->seqnos);
+	free(pbatch);
+}
+
+// ----------------------------------------------------------------
+static void mapper_stats1_start_workers(mapper_stats1_state_t* pstate) {
+	pstate->num_workers = 0;
+	if (MLR_GLOBALS.nthreads < 2 || pstate->do_iterative_stats)
+		return;
+	// Without group-by there is only one group, so the work can only be divided by merging partial results.
+	if (pstate->pgroup_by_field_names->length == 0 && !are_stats1_accs_mergeable(pstate->paccumulator_names))
+		return;
+
+	pstate->num_workers = MLR_GLOBALS.nthreads;
+	pstate->pworkers = mlr_malloc_or_die(pstate->num_workers * sizeof(mapper_stats1_worker_t));
+	for (int i = 0; i < pstate->num_workers; i++) {
+		mapper_stats1_worker_t* pworker = &pstate->pworkers[i];
+		pworker->pstate = mlr_malloc_or_die(sizeof(mapper_stats1_state_t));
+		*pworker->pstate = *pstate;
+		pworker->pstate->pargp               = NULL;
+		pworker->pstate->pvalue_field_entries = mlr_malloc_or_die(pstate->pvalue_field_names->length * sizeof(lrece_t*));
+		pworker->pstate->groups              = lhmslv_alloc();
+		pworker->pstate->num_workers         = 0;
+		pworker->pstate->pworkers            = NULL;
+		pworker->pqueue                = batch_queue_alloc(STATS1_QUEUE_CAPACITY);
+		pworker->pbatch                = stats1_batch_alloc();
+		pworker->first_seqnos_capacity = 64;
+		pworker->first_seqnos          = mlr_malloc_or_die(pworker->first_seqnos_capacity * sizeof(long long));
+		int rc = pthread_create(&pworker->thread, NULL, mapper_stats1_worker_thread, pworker);
+		if (rc != 0) {
+			fprintf(stderr, "%s: could not create thread: %s\n", MLR_GLOBALS.bargv0, strerror(rc));
+			exit(1);
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+static sllv_t* mapper_stats1_process_partitioned(lrec_t* pinrec, mapper_stats1_state_t* pstate) {
+	if (pinrec == NULL) { // end of record stream
+		for (int i = 0; i < pstate->num_workers; i++) {
+			mapper_stats1_worker_t* pworker = &pstate->pworkers[i];
+			if (pworker->pbatch->length > 0)
+				batch_queue_put(pworker->pqueue, pworker->pbatch);
+			else
+				stats1_batch_free(pworker->pbatch);
+			pworker->pbatch = NULL;
+			batch_queue_close(pworker->pqueue);
+		}
+		for (int i = 0; i < pstate->num_workers; i++)
+			pthread_join(pstate->pworkers[i].thread, NULL);
+		return mapper_stats1_emit_partitioned(pstate);
+	}
+
+	int worker_index;
+	if (pstate->pgroup_by_field_names->length == 0) {
+		worker_index = pstate->next_worker;
+	} else {
+		slls_t* pgroup_by_field_values = mlr_reference_selected_values_from_record(pinrec,
+			pstate->pgroup_by_field_names);
+		if (pgroup_by_field_values == NULL) {
+			lrec_free(pinrec);
+			return NULL;
+		}
+		// Mix the bits since the workers' own hashmaps index by the same hash function.
+		unsigned int hash = (unsigned int)slls_hash_func(pgroup_by_field_values) * 2654435761U;
+		worker_index = (hash >> 16) % pstate->num_workers;
+		slls_free(pgroup_by_field_values);
+	}
+
+	mapper_stats1_worker_t* pworker = &pstate->pworkers[worker_index];
+	stats1_batch_t* pbatch = pworker->pbatch;
+	pbatch->precords[pbatch->length] = pinrec;
+	pbatch->seqnos[pbatch->length]   = pstate->num_dispatched++;
+	pbatch->length++;
+	if (pbatch->length == STATS1_BATCH_SIZE) {
+		batch_queue_put(pworker->pqueue, pbatch);
+		pworker->pbatch = stats1_batch_alloc();
+		pstate->next_worker = (pstate->next_worker + 1) % pstate->num_workers;
+	}
+	return NULL;
+}
+
+// ----------------------------------------------------------------
+static void* mapper_stats1_worker_thread(void* pvarg) {
+	mapper_stats1_worker_t* pworker = pvarg;
+	lhmslv_t* groups = pworker->pstate->groups;
+	stats1_batch_t* pbatch;
+	while ((pbatch = batch_queue_get(pworker->pqueue)) != NULL) {
+		for (int i = 0; i < pbatch->length; i++) {
+			int num_groups = groups->num_occupied;
+			mapper_stats1_ingest(pbatch->precords[i], pworker->pstate);
+			if (groups->num_occupied > num_groups) {
+				if (num_groups >= pworker->first_seqnos_capacity) {
+					pworker->first_seqnos_capacity *= 2;
+					pworker->first_seqnos = mlr_realloc_or_die(pworker->first_seqnos,
+						pworker->first_seqnos_capacity * sizeof(long long));
+				}
+				pworker->first_seqnos[num_groups] = pbatch->seqnos[i];
+			}
+			lrec_free(pbatch->precords[i]);
+		}
+		stats1_batch_free(pbatch);
+	}
+	return NULL;
+}
+
+// ----------------------------------------------------------------
+// Each worker's groups are in first-seen order for that worker, so a k-way merge on first-seen record
+// number gives the same output order as single-threaded ingest.
+static sllv_t* mapper_stats1_emit_partitioned(mapper_stats1_state_t* pstate) {
+	sllv_t* poutrecs = sllv_alloc();
+	int n = pstate->num_workers;
+
+	if (pstate->pgroup_by_field_names->length == 0) {
+		lhmslve_t* pinto = NULL;
+		for (int i = 0; i < n; i++) {
+			lhmslve_t* pfrom = pstate->pworkers[i].pstate->groups->phead;
+			if (pfrom == NULL)
+				continue;
+			if (pinto == NULL)
+				pinto = pfrom;
+			else
+				mapper_stats1_merge_group(pinto->pvvalue, pfrom->pvvalue);
+		}
+		if (pinto != NULL)
+			sllv_append(poutrecs, mapper_stats1_emit_group(pstate, pinto->key, pinto->pvvalue));
+		sllv_append(poutrecs, NULL);
+		return poutrecs;
+	}
+
+	lhmslve_t** pcursors = mlr_malloc_or_die(n * sizeof(lhmslve_t*));
+	int* positions = mlr_malloc_or_die(n * sizeof(int));
+	for (int i = 0; i < n; i++) {
+		pcursors[i] = pstate->pworkers[i].pstate->groups->phead;
+		positions[i] = 0;
+	}
+	while (TRUE) {
+		int argmin = -1;
+		for (int i = 0; i < n; i++) {
+			if (pcursors[i] == NULL)
+				continue;
+			if (argmin < 0 || pstate->pworkers[i].first_seqnos[positions[i]]
+				< pstate->pworkers[argmin].first_seqnos[positions[argmin]])
+			{
+				argmin = i;
+			}
+		}
+		if (argmin < 0)
+			break;
+		lhmslve_t* pa = pcursors[argmin];
+		sllv_append(poutrecs, mapper_stats1_emit_group(pstate, pa->key, pa->pvvalue));
+		pcursors[argmin] = pa->pnext;
+		positions[argmin]++;
+	}
+	free(pcursors);
+	free(positions);
+	sllv_append(poutrecs, NULL);
+	return poutrecs;
+}
+
+// ----------------------------------------------------------------
+// Every record ingested into a group sets up accumulators for all the value fields, so the two groups have
+// the same value-field names and accumulator names.
+static void mapper_stats1_merge_group(lhmsv_t* pinto, lhmsv_t* pfrom) {
+	for (lhmsve_t* pd = pfrom->phead; pd != NULL; pd = pd->pnext) {
+		acc_map_pair_t* pinto_pair = lhmsv_get(pinto, pd->key);
+		acc_map_pair_t* pfrom_pair = pd->pvvalue;
+		MLR_INTERNAL_CODING_ERROR_IF(pinto_pair == NULL);
+		// Percentile accumulators appear once in the input map but possibly several times in the output map.
+		for (lhmsve_t* pe = pfrom_pair->pin->phead; pe != NULL; pe = pe->pnext) {
+			if (streq(pe->key, fake_acc_name_for_setups))
+				continue;
+			stats1_acc_t* pinto_acc = lhmsv_get(pinto_pair->pin, pe->key);
+			stats1_acc_t* pfrom_acc = pe->pvvalue;
+			MLR_INTERNAL_CODING_ERROR_IF(pinto_acc == NULL);
+			pinto_acc->pmerge_func(pinto_acc->pvstate, pfrom_acc->pvstate);
+		}
+	}
+}
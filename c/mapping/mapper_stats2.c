@@ -197,6 +197,8 @@ static mapper_t* mapper_stats2_alloc(ap_state_t* pargp, slls_t* paccumulator_nam
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_stats2_process;
 	pmapper->pfree_func    = mapper_stats2_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
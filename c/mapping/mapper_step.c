@@ -41,7 +41,7 @@ typedef struct _mapper_step_state_t {
 	ap_state_t*     pargp;
 	slls_t*         pstepper_names;
 	string_array_t* pvalue_field_names;    // parameter
-	string_array_t* pvalue_field_values;   // scratch space used per-record
+	lrece_t**       pvalue_field_entries;  // scratch space used per-record
 	slls_t*         pgroup_by_field_names; // parameter
 	lhmslv_t*       groups;
 	int             allow_int_float;
@@ -202,7 +202,7 @@ static mapper_t* mapper_step_alloc(ap_state_t* pargp, slls_t* pstepper_names, st
 	pstate->pargp                 = pargp;
 	pstate->pstepper_names        = pstepper_names;
 	pstate->pvalue_field_names    = pvalue_field_names;
-	pstate->pvalue_field_values   = string_array_alloc(pvalue_field_names->length);
+	pstate->pvalue_field_entries  = mlr_malloc_or_die(pvalue_field_names->length * sizeof(lrece_t*));
 	pstate->pgroup_by_field_names = pgroup_by_field_names;
 	pstate->groups                = lhmslv_alloc();
 	pstate->allow_int_float       = allow_int_float;
@@ -212,6 +212,8 @@ static mapper_t* mapper_step_alloc(ap_state_t* pargp, slls_t* pstepper_names, st
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_step_process;
 	pmapper->pfree_func    = mapper_step_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -220,7 +222,7 @@ static void mapper_step_free(mapper_t* pmapper, context_t* _) {
 	mapper_step_state_t* pstate = pmapper->pvstate;
 	slls_free(pstate->pstepper_names);
 	string_array_free(pstate->pvalue_field_names);
-	string_array_free(pstate->pvalue_field_values);
+	free(pstate->pvalue_field_entries);
 	slls_free(pstate->pgroup_by_field_names);
 	slls_free(pstate->pstring_alphas);
 	slls_free(pstate->pewma_suffixes);
@@ -252,7 +254,7 @@ static sllv_t* mapper_step_process(lrec_t* pinrec, context_t* pctx, void* pvstat
 		return sllv_single(NULL);
 
 	// ["s", "t"]
-	mlr_reference_values_from_record_into_string_array(pinrec, pstate->pvalue_field_names, pstate->pvalue_field_values);
+	mlr_reference_entries_from_record_into_array(pinrec, pstate->pvalue_field_names, pstate->pvalue_field_entries);
 	slls_t* pgroup_by_field_values = mlr_reference_selected_values_from_record(pinrec, pstate->pgroup_by_field_names);
 
 	if (pgroup_by_field_values == NULL) {
@@ -271,7 +273,8 @@ static sllv_t* mapper_step_process(lrec_t* pinrec, context_t* pctx, void* pvstat
 	int n = pstate->pvalue_field_names->length;
 	for (int i = 0; i < n; i++) {
 		char* value_field_name = pstate->pvalue_field_names->strings[i];
-		char* value_field_sval = pstate->pvalue_field_values->strings[i];
+		lrece_t* pvalue_field_entry = pstate->pvalue_field_entries[i];
+		char* value_field_sval = (pvalue_field_entry == NULL) ? NULL : pvalue_field_entry->value;
 		if (value_field_sval == NULL) // Key not present
 			continue;
 
@@ -310,7 +313,7 @@ static sllv_t* mapper_step_process(lrec_t* pinrec, context_t* pctx, void* pvstat
 
 				if (pstep->pdprocess_func != NULL) {
 					if (!have_dval) {
-						value_field_dval = mlr_double_from_string_or_die(value_field_sval);
+						value_field_dval = mlr_double_from_entry_or_die(pvalue_field_entry);
 						have_dval = TRUE;
 					}
 					pstep->pdprocess_func(pstep->pvstate, value_field_dval, pinrec);
@@ -319,8 +322,8 @@ static sllv_t* mapper_step_process(lrec_t* pinrec, context_t* pctx, void* pvstat
 				if (pstep->pnprocess_func != NULL) {
 					if (!have_nval) {
 						value_field_nval = pstate->allow_int_float
-							? mv_scan_number_or_die(value_field_sval)
-							: mv_from_float(mlr_double_from_string_or_die(value_field_sval));
+							? mv_scan_entry_number_or_die(pvalue_field_entry)
+							: mv_from_float(mlr_double_from_entry_or_die(pvalue_field_entry));
 						have_nval = TRUE;
 					}
 					pstep->pnprocess_func(pstep->pvstate, &value_field_nval, pinrec);
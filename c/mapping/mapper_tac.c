@@ -50,6 +50,8 @@ static mapper_t* mapper_tac_alloc() {
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_tac_process;
 	pmapper->pfree_func    = mapper_tac_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -75,6 +75,8 @@ static mapper_t* mapper_tail_alloc(ap_state_t* pargp, slls_t* pgroup_by_field_na
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_tail_process;
 	pmapper->pfree_func    = mapper_tail_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -125,6 +125,8 @@ static mapper_t* mapper_tee_alloc(int do_append, int flush_every_record,
 	pmapper->pvstate           = pstate;
 	pmapper->pprocess_func     = mapper_tee_process;
 	pmapper->pfree_func        = mapper_tee_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 	return pmapper;
 }
 static void mapper_tee_free(mapper_t* pmapper, context_t* pctx) {
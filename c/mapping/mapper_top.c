@@ -127,6 +127,8 @@ static mapper_t* mapper_top_alloc(ap_state_t* pargp, slls_t* pvalue_field_names,
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_top_process;
 	pmapper->pfree_func    = mapper_top_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
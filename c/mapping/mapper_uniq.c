@@ -154,6 +154,8 @@ static mapper_t* mapper_uniq_alloc(ap_state_t* pargp, slls_t* pgroup_by_field_na
 	else
 		pmapper->pprocess_func = mapper_uniq_process_no_counts;
 	pmapper->pfree_func = mapper_uniq_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
@@ -79,6 +79,8 @@ static mapper_t* mapper_unsparsify_alloc(ap_state_t* pargp, char* filler) {
 	pmapper->pvstate       = pstate;
 	pmapper->pprocess_func = mapper_unsparsify_process;
 	pmapper->pfree_func    = mapper_unsparsify_free;
+	pmapper->pselect_batch_func = NULL;
+	pmapper->pprocess_batch_func = NULL;
 
 	return pmapper;
 }
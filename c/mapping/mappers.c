@@ -3,6 +3,9 @@
 #include "lib/mlrutil.h"
 #include "mapping/mappers.h"
 
+// Only its address is used.
+lrec_t mapper_more_output_marker;
+
 // ----------------------------------------------------------------
 void mapper_chain_free(sllv_t* pmapper_chain, context_t* pctx) {
 	for (sllve_t* pe = pmapper_chain->phead; pe != NULL; pe = pe->pnext) {
@@ -11,3 +14,8 @@ void mapper_chain_free(sllv_t* pmapper_chain, context_t* pctx) {
 	}
 	sllv_free(pmapper_chain);
 }
+
+// ----------------------------------------------------------------
+int mapper_is_always_stateless(mapper_t* pmapper) {
+	return TRUE;
+}
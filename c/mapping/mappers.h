@@ -50,4 +50,7 @@ extern mapper_setup_t mapper_unsparsify_setup;
 // Construction is in mlrcli.c.
 void mapper_chain_free(sllv_t* pmapper_chain, context_t* pctx);
 
+// For the pis_stateless_func of verbs which are stateless regardless of their options.
+int mapper_is_always_stateless(mapper_t* pmapper);
+
 #endif // MAPPERS_H
@@ -86,6 +86,21 @@ int is_percentile_acc_name(char* stats1_acc_name) {
 	return TRUE;
 }
 
+int are_stats1_accs_mergeable(slls_t* paccumulator_names) {
+	for (sllse_t* pe = paccumulator_names->phead; pe != NULL; pe = pe->pnext) {
+		if (is_percentile_acc_name(pe->value))
+			continue;
+		stats1_acc_t* pstats1_acc = make_stats1_acc("", pe->value, TRUE, FALSE);
+		if (pstats1_acc == NULL)
+			continue; // Reported as an error at first ingest.
+		int is_mergeable = pstats1_acc->pmerge_func != NULL;
+		pstats1_acc->pfree_func(pstats1_acc);
+		if (!is_mergeable)
+			return FALSE;
+	}
+	return TRUE;
+}
+
 // ----------------------------------------------------------------
 typedef struct _stats1_count_state_t {
 	mv_t counter;
@@ -107,6 +122,11 @@ static void stats1_count_emit(void* pvstate, char* value_field_name, char* stats
 		lrec_put(poutrec, pstate->output_field_name, mv_alloc_format_val(&pstate->counter),
 			FREE_ENTRY_VALUE);
 }
+static void stats1_count_merge(void* pvstate_into, void* pvstate_from) {
+	stats1_count_state_t* pinto = pvstate_into;
+	stats1_count_state_t* pfrom = pvstate_from;
+	pinto->counter = x_xx_plus_func(&pinto->counter, &pfrom->counter);
+}
 static void stats1_count_free(stats1_acc_t* pstats1_acc) {
 	stats1_count_state_t* pstate = pstats1_acc->pvstate;
 	free(pstate->output_field_name);
@@ -128,6 +148,7 @@ stats1_acc_t* stats1_count_alloc(char* value_field_name, char* stats1_acc_name,
 	pstats1_acc->psingest_func   = stats1_count_singest;
 	pstats1_acc->pemit_func      = stats1_count_emit;
 	pstats1_acc->pfree_func      = stats1_count_free;
+	pstats1_acc->pmerge_func     = stats1_count_merge;
 	return pstats1_acc;
 }
 
@@ -184,6 +205,7 @@ stats1_acc_t* stats1_mode_alloc(char* value_field_name, char* stats1_acc_name, i
 	pstats1_acc->psingest_func  = stats1_mode_singest;
 	pstats1_acc->pemit_func     = stats1_mode_emit;
 	pstats1_acc->pfree_func     = stats1_mode_free;
+	pstats1_acc->pmerge_func    = NULL;
 	return pstats1_acc;
 }
 
@@ -206,6 +228,11 @@ static void stats1_sum_emit(void* pvstate, char* value_field_name, char* stats1_
 		lrec_put(poutrec, pstate->output_field_name, mv_alloc_format_val(&pstate->sum),
 			FREE_ENTRY_VALUE);
 }
+static void stats1_sum_merge(void* pvstate_into, void* pvstate_from) {
+	stats1_sum_state_t* pinto = pvstate_into;
+	stats1_sum_state_t* pfrom = pvstate_from;
+	pinto->sum = x_xx_plus_func(&pinto->sum, &pfrom->sum);
+}
 static void stats1_sum_free(stats1_acc_t* pstats1_acc) {
 	stats1_sum_state_t* pstate = pstats1_acc->pvstate;
 	free(pstate->output_field_name);
@@ -227,6 +254,7 @@ stats1_acc_t* stats1_sum_alloc(char* value_field_name, char* stats1_acc_name, in
 	pstats1_acc->psingest_func = NULL;
 	pstats1_acc->pemit_func    = stats1_sum_emit;
 	pstats1_acc->pfree_func    = stats1_sum_free;
+	pstats1_acc->pmerge_func   = stats1_sum_merge;
 	return pstats1_acc;
 }
 
@@ -257,6 +285,12 @@ static void stats1_mean_emit(void* pvstate, char* value_field_name, char* stats1
 			lrec_put(poutrec, pstate->output_field_name, val, FREE_ENTRY_VALUE);
 	}
 }
+static void stats1_mean_merge(void* pvstate_into, void* pvstate_from) {
+	stats1_mean_state_t* pinto = pvstate_into;
+	stats1_mean_state_t* pfrom = pvstate_from;
+	pinto->sum   += pfrom->sum;
+	pinto->count += pfrom->count;
+}
 static void stats1_mean_free(stats1_acc_t* pstats1_acc) {
 	stats1_mean_state_t* pstate = pstats1_acc->pvstate;
 	free(pstate->output_field_name);
@@ -278,6 +312,7 @@ stats1_acc_t* stats1_mean_alloc(char* value_field_name, char* stats1_acc_name, i
 	pstats1_acc->psingest_func  = NULL;
 	pstats1_acc->pemit_func     = stats1_mean_emit;
 	pstats1_acc->pfree_func     = stats1_mean_free;
+	pstats1_acc->pmerge_func    = stats1_mean_merge;
 	return pstats1_acc;
 }
 
@@ -316,6 +351,13 @@ static void stats1_stddev_var_meaneb_emit(void* pvstate, char* value_field_name,
 			lrec_put(poutrec, pstate->output_field_name, val, FREE_ENTRY_VALUE);
 	}
 }
+static void stats1_stddev_var_meaneb_merge(void* pvstate_into, void* pvstate_from) {
+	stats1_stddev_var_meaneb_state_t* pinto = pvstate_into;
+	stats1_stddev_var_meaneb_state_t* pfrom = pvstate_from;
+	pinto->count += pfrom->count;
+	pinto->sumx  += pfrom->sumx;
+	pinto->sumx2 += pfrom->sumx2;
+}
 static void stats1_stddev_var_meaneb_free(stats1_acc_t* pstats1_acc) {
 	stats1_stddev_var_meaneb_state_t* pstate = pstats1_acc->pvstate;
 	free(pstate->output_field_name);
@@ -338,6 +380,7 @@ stats1_acc_t* stats1_stddev_var_meaneb_alloc(char* value_field_name, char* stats
 	pstats1_acc->psingest_func = NULL;
 	pstats1_acc->pemit_func    = stats1_stddev_var_meaneb_emit;
 	pstats1_acc->pfree_func    = stats1_stddev_var_meaneb_free;
+	pstats1_acc->pmerge_func   = stats1_stddev_var_meaneb_merge;
 	return pstats1_acc;
 }
 stats1_acc_t* stats1_stddev_alloc(char* value_field_name, char* stats1_acc_name, int allow_int_float,
@@ -388,6 +431,14 @@ static void stats1_skewness_emit(void* pvstate, char* value_field_name, char* st
 			lrec_put(poutrec, pstate->output_field_name, val, FREE_ENTRY_VALUE);
 	}
 }
+static void stats1_skewness_merge(void* pvstate_into, void* pvstate_from) {
+	stats1_skewness_state_t* pinto = pvstate_into;
+	stats1_skewness_state_t* pfrom = pvstate_from;
+	pinto->count += pfrom->count;
+	pinto->sumx  += pfrom->sumx;
+	pinto->sumx2 += pfrom->sumx2;
+	pinto->sumx3 += pfrom->sumx3;
+}
 static void stats1_skewness_free(stats1_acc_t* pstats1_acc) {
 	stats1_skewness_state_t* pstate = pstats1_acc->pvstate;
 	free(pstate->output_field_name);
@@ -412,6 +463,7 @@ stats1_acc_t* stats1_skewness_alloc(char* value_field_name, char* stats1_acc_nam
 	pstats1_acc->psingest_func = NULL;
 	pstats1_acc->pemit_func    = stats1_skewness_emit;
 	pstats1_acc->pfree_func    = stats1_skewness_free;
+	pstats1_acc->pmerge_func   = stats1_skewness_merge;
 	return pstats1_acc;
 }
 
@@ -449,6 +501,15 @@ static void stats1_kurtosis_emit(void* pvstate, char* value_field_name, char* st
 			lrec_put(poutrec, pstate->output_field_name, val, FREE_ENTRY_VALUE);
 	}
 }
+static void stats1_kurtosis_merge(void* pvstate_into, void* pvstate_from) {
+	stats1_kurtosis_state_t* pinto = pvstate_into;
+	stats1_kurtosis_state_t* pfrom = pvstate_from;
+	pinto->count += pfrom->count;
+	pinto->sumx  += pfrom->sumx;
+	pinto->sumx2 += pfrom->sumx2;
+	pinto->sumx3 += pfrom->sumx3;
+	pinto->sumx4 += pfrom->sumx4;
+}
 static void stats1_kurtosis_free(stats1_acc_t* pstats1_acc) {
 	stats1_kurtosis_state_t* pstate = pstats1_acc->pvstate;
 	free(pstate->output_field_name);
@@ -472,6 +533,7 @@ stats1_acc_t* stats1_kurtosis_alloc(char* value_field_name, char* stats1_acc_nam
 	pstats1_acc->psingest_func = NULL;
 	pstats1_acc->pemit_func    = stats1_kurtosis_emit;
 	pstats1_acc->pfree_func    = stats1_kurtosis_free;
+	pstats1_acc->pmerge_func   = stats1_kurtosis_merge;
 	return pstats1_acc;
 }
 
@@ -500,6 +562,11 @@ static void stats1_min_emit(void* pvstate, char* value_field_name, char* stats1_
 				FREE_ENTRY_VALUE);
 	}
 }
+static void stats1_min_merge(void* pvstate_into, void* pvstate_from) {
+	stats1_min_state_t* pinto = pvstate_into;
+	stats1_min_state_t* pfrom = pvstate_from;
+	pinto->min = x_xx_min_func(&pinto->min, &pfrom->min);
+}
 static void stats1_min_free(stats1_acc_t* pstats1_acc) {
 	stats1_min_state_t* pstate = pstats1_acc->pvstate;
 	free(pstate->output_field_name);
@@ -520,6 +587,7 @@ stats1_acc_t* stats1_min_alloc(char* value_field_name, char* stats1_acc_name, in
 	pstats1_acc->psingest_func = NULL;
 	pstats1_acc->pemit_func    = stats1_min_emit;
 	pstats1_acc->pfree_func    = stats1_min_free;
+	pstats1_acc->pmerge_func   = stats1_min_merge;
 	return pstats1_acc;
 }
 
@@ -548,6 +616,11 @@ static void stats1_max_emit(void* pvstate, char* value_field_name, char* stats1_
 				FREE_ENTRY_VALUE);
 	}
 }
+static void stats1_max_merge(void* pvstate_into, void* pvstate_from) {
+	stats1_max_state_t* pinto = pvstate_into;
+	stats1_max_state_t* pfrom = pvstate_from;
+	pinto->max = x_xx_max_func(&pinto->max, &pfrom->max);
+}
 static void stats1_max_free(stats1_acc_t* pstats1_acc) {
 	stats1_max_state_t* pstate = pstats1_acc->pvstate;
 	free(pstate->output_field_name);
@@ -568,6 +641,7 @@ stats1_acc_t* stats1_max_alloc(char* value_field_name, char* stats1_acc_name, in
 	pstats1_acc->psingest_func = NULL;
 	pstats1_acc->pemit_func    = stats1_max_emit;
 	pstats1_acc->pfree_func    = stats1_max_free;
+	pstats1_acc->pmerge_func   = stats1_max_merge;
 	return pstats1_acc;
 }
 
@@ -605,6 +679,12 @@ static void stats1_percentile_emit(void* pvstate, char* value_field_name, char*
 	lrec_put(poutrec, mlr_strdup_or_die(output_field_name), s, FREE_ENTRY_KEY|FREE_ENTRY_VALUE);
 }
 
+static void stats1_percentile_merge(void* pvstate_into, void* pvstate_from) {
+	stats1_percentile_state_t* pinto = pvstate_into;
+	stats1_percentile_state_t* pfrom = pvstate_from;
+	percentile_keeper_merge(pinto->ppercentile_keeper, pfrom->ppercentile_keeper);
+}
+
 static void stats1_percentile_free(stats1_acc_t* pstats1_acc) {
 	stats1_percentile_state_t* pstate = pstats1_acc->pvstate;
 	pstate->reference_count--;
@@ -633,6 +713,7 @@ stats1_acc_t* stats1_percentile_alloc(char* value_field_name, char* stats1_acc_n
 	pstats1_acc->psingest_func  = NULL;
 	pstats1_acc->pemit_func     = stats1_percentile_emit;
 	pstats1_acc->pfree_func     = stats1_percentile_free;
+	pstats1_acc->pmerge_func    = stats1_percentile_merge;
 	return pstats1_acc;
 }
 void stats1_percentile_reuse(stats1_acc_t* pstats1_acc) {
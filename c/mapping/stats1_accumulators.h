@@ -31,6 +31,10 @@ typedef void stats1_singest_func_t(void* pvstate, char*  val);
 // after the accumulator is freed.
 typedef void stats1_emit_func_t(void* pvstate, char* value_field_name, char* stats1_acc_name, int copy_data, lrec_t* poutrec);
 typedef void stats1_free_func_t(struct _stats1_acc_t* pstats1_acc);
+// Folds the state of another accumulator of the same type (and same field/accumulator names) into
+// this one, as if its data had been ingested here after this one's own. Used for combining partial
+// results from worker threads. The other accumulator is left unchanged.
+typedef void stats1_merge_func_t(void* pvstate_into, void* pvstate_from);
 
 typedef struct _stats1_acc_t {
 	void* pvstate;
@@ -39,6 +43,7 @@ typedef struct _stats1_acc_t {
 	stats1_singest_func_t* psingest_func;
 	stats1_emit_func_t*    pemit_func;
 	stats1_free_func_t*    pfree_func; // virtual destructor
+	stats1_merge_func_t*   pmerge_func; // null for accumulators whose output depends on ingest order
 } stats1_acc_t;
 
 typedef stats1_acc_t* stats1_alloc_func_t(char* value_field_name, char* stats1_acc_name, int allow_int_float,
@@ -82,6 +87,9 @@ stats1_acc_t* make_stats1_acc(
 
 int is_percentile_acc_name(char* stats1_acc_name);
 
+// True if all the named accumulators have merge methods.
+int are_stats1_accs_mergeable(slls_t* paccumulator_names);
+
 // ----------------------------------------------------------------
 // Lookups for all but percentiles, which are a special case.
 typedef struct _stats1_acc_lookup_t {
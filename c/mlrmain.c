@@ -25,6 +25,7 @@ int main(int argc, char** argv) {
 	sllv_t* pmapper_list = NULL;
 	cli_opts_t* popts = parse_command_line(argc, argv, &pmapper_list);
 	mlr_global_init(argv[0], popts->ofmt);
+	MLR_GLOBALS.nthreads = popts->nthreads;
 
 	context_t ctx;
 	context_init_from_opts(&ctx, popts);
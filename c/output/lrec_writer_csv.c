@@ -2,17 +2,18 @@
 #include "cli/quoting.h"
 #include "lib/mlrutil.h"
 #include "lib/mlr_globals.h"
+#include "lib/output_buffer.h"
 #include "containers/mixutil.h"
 #include "output/lrec_writers.h"
 
-typedef void       quoted_output_func_t(FILE* fp,char*s,char*ors,char*ofs, int orslen,int ofslen, char quote_flags);
-static  void      quote_all_output_func(FILE* fp,char*s,char*ors,char*ofs, int orslen,int ofslen, char quote_flags);
-static  void     quote_none_output_func(FILE* fp,char*s,char*ors,char*ofs, int orslen,int ofslen, char quote_flags);
-static  void  quote_minimal_output_func(FILE* fp,char*s,char*ors,char*ofs, int orslen,int ofslen, char quote_flags);
-static  void  quote_minimal_auto_output_func(FILE* fp,char*s,char*ors,char*ofs, int orslen,int ofslen, char qf);
-static  void  quote_numeric_output_func(FILE* fp,char*s,char*ors,char*ofs, int orslen,int ofslen, char quote_flags);
-static  void quote_original_output_func(FILE* fp,char*s,char*ors,char*ofs, int orslen,int ofslen, char quote_flags);
-static void quote_string(FILE* fp, char* string);
+typedef void       quoted_output_func_t(output_buffer_t* pobuf,char*s,char*ors,char*ofs, int orslen,int ofslen, char quote_flags);
+static  void      quote_all_output_func(output_buffer_t* pobuf,char*s,char*ors,char*ofs, int orslen,int ofslen, char quote_flags);
+static  void     quote_none_output_func(output_buffer_t* pobuf,char*s,char*ors,char*ofs, int orslen,int ofslen, char quote_flags);
+static  void  quote_minimal_output_func(output_buffer_t* pobuf,char*s,char*ors,char*ofs, int orslen,int ofslen, char quote_flags);
+static  void  quote_minimal_auto_output_func(output_buffer_t* pobuf,char*s,char*ors,char*ofs, int orslen,int ofslen, char qf);
+static  void  quote_numeric_output_func(output_buffer_t* pobuf,char*s,char*ors,char*ofs, int orslen,int ofslen, char quote_flags);
+static  void quote_original_output_func(output_buffer_t* pobuf,char*s,char*ors,char*ofs, int orslen,int ofslen, char quote_flags);
+static void quote_string(output_buffer_t* pobuf, char* string);
 
 typedef struct _lrec_writer_csv_state_t {
 	int   onr;
@@ -24,6 +25,7 @@ typedef struct _lrec_writer_csv_state_t {
 	long long num_header_lines_output;
 	slls_t* plast_header_output;
 	int headerless_csv_output;
+	output_buffer_t* pobuf;
 } lrec_writer_csv_state_t;
 
 // ----------------------------------------------------------------
@@ -43,6 +45,7 @@ lrec_writer_t* lrec_writer_csv_alloc(char* ors, char* ofs, quoting_t oquoting, i
 	pstate->orslen = strlen(pstate->ors);
 	pstate->ofslen = strlen(pstate->ofs);
 	pstate->headerless_csv_output = headerless_csv_output;
+	pstate->pobuf = obuf_alloc(OBUF_DEFAULT_ALLOC_LENGTH);
 
 	switch(oquoting) {
 	case QUOTE_ALL:      pstate->pquoted_output_func = quote_all_output_func;      break;
@@ -74,6 +77,7 @@ lrec_writer_t* lrec_writer_csv_alloc(char* ors, char* ofs, quoting_t oquoting, i
 static void lrec_writer_csv_free(lrec_writer_t* pwriter, context_t* pctx) {
 	lrec_writer_csv_state_t* pstate = pwriter->pvstate;
 	slls_free(pstate->plast_header_output);
+	obuf_free(pstate->pobuf);
 	free(pstate);
 	free(pwriter);
 }
@@ -92,6 +96,8 @@ static void lrec_writer_csv_process(void* pvstate, FILE* output_stream, lrec_t*
 	if (prec == NULL)
 		return;
 	lrec_writer_csv_state_t* pstate = pvstate;
+	output_buffer_t* pobuf = pstate->pobuf;
+	obuf_set_stream(pobuf, output_stream);
 	char *ofs = pstate->ofs;
 	int orslen = strlen(ors);
 
@@ -100,7 +106,7 @@ static void lrec_writer_csv_process(void* pvstate, FILE* output_stream, lrec_t*
 			slls_free(pstate->plast_header_output);
 			pstate->plast_header_output = NULL;
 			if (pstate->num_header_lines_output > 0LL)
-				fputs(ors, output_stream);
+				obuf_puts(pobuf, ors);
 		}
 	}
 
@@ -109,12 +115,12 @@ static void lrec_writer_csv_process(void* pvstate, FILE* output_stream, lrec_t*
 		if (!pstate->headerless_csv_output) {
 			for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
 				if (nf > 0)
-					fputs(ofs, output_stream);
-				pstate->pquoted_output_func(output_stream, pe->key, pstate->ors, pstate->ofs,
+					obuf_puts(pobuf, ofs);
+				pstate->pquoted_output_func(pobuf, pe->key, pstate->ors, pstate->ofs,
 					orslen, pstate->ofslen, 0);
 				nf++;
 			}
-			fputs(ors, output_stream);
+			obuf_puts(pobuf, ors);
 		}
 		pstate->plast_header_output = mlr_copy_keys_from_record(prec);
 		pstate->num_header_lines_output++;
@@ -123,12 +129,13 @@ static void lrec_writer_csv_process(void* pvstate, FILE* output_stream, lrec_t*
 	int nf = 0;
 	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
 		if (nf > 0)
-			fputs(ofs, output_stream);
-		pstate->pquoted_output_func(output_stream, pe->value, pstate->ors, pstate->ofs,
+			obuf_puts(pobuf, ofs);
+		pstate->pquoted_output_func(pobuf, pe->value, pstate->ors, pstate->ofs,
 			orslen, pstate->ofslen, pe->quote_flags);
 		nf++;
 	}
-	fputs(ors, output_stream);
+	obuf_puts(pobuf, ors);
+	obuf_flush(pobuf);
 	pstate->onr++;
 
 	// See ../README.md for memory-management conventions
@@ -136,20 +143,20 @@ static void lrec_writer_csv_process(void* pvstate, FILE* output_stream, lrec_t*
 }
 
 // ----------------------------------------------------------------
-static void quote_all_output_func(FILE* fp, char* string, char* ors, char* ofs, int orslen, int ofslen,
-	char quote_flags)
+static void quote_all_output_func(output_buffer_t* pobuf, char* string, char* ors, char* ofs, int orslen,
+	int ofslen, char quote_flags)
 {
-	quote_string(fp, string);
+	quote_string(pobuf, string);
 }
 
-static void quote_none_output_func(FILE* fp, char* string, char* ors, char* ofs, int orslen, int ofslen,
-	char quote_flags)
+static void quote_none_output_func(output_buffer_t* pobuf, char* string, char* ors, char* ofs, int orslen,
+	int ofslen, char quote_flags)
 {
-	fputs(string, fp);
+	obuf_puts(pobuf, string);
 }
 
-static void quote_minimal_output_func(FILE* fp, char* string, char* ors, char* ofs, int orslen, int ofslen,
-	char quote_flags)
+static void quote_minimal_output_func(output_buffer_t* pobuf, char* string, char* ors, char* ofs, int orslen,
+	int ofslen, char quote_flags)
 {
 	int output_quotes = FALSE;
 	for (char* p = string; *p; p++) {
@@ -163,14 +170,14 @@ static void quote_minimal_output_func(FILE* fp, char* string, char* ors, char* o
 		}
 	}
 	if (output_quotes) {
-		quote_string(fp, string);
+		quote_string(pobuf, string);
 	} else {
-		fputs(string, fp);
+		obuf_puts(pobuf, string);
 	}
 }
 
-static void quote_minimal_auto_output_func(FILE* fp, char* string, char* _, char* ofs, int __, int ofslen,
-	char quote_flags)
+static void quote_minimal_auto_output_func(output_buffer_t* pobuf, char* string, char* _, char* ofs, int __,
+	int ofslen, char quote_flags)
 {
 	int output_quotes = FALSE;
 	for (char* p = string; *p; p++) {
@@ -184,41 +191,41 @@ static void quote_minimal_auto_output_func(FILE* fp, char* string, char* _, char
 		}
 	}
 	if (output_quotes) {
-		quote_string(fp, string);
+		quote_string(pobuf, string);
 	} else {
-		fputs(string, fp);
+		obuf_puts(pobuf, string);
 	}
 }
 
-static void quote_numeric_output_func(FILE* fp, char* string, char* ors, char* ofs, int orslen, int ofslen,
-	char quote_flags)
+static void quote_numeric_output_func(output_buffer_t* pobuf, char* string, char* ors, char* ofs, int orslen,
+	int ofslen, char quote_flags)
 {
 	double temp;
 	if (mlr_try_float_from_string(string, &temp)) {
-		quote_string(fp, string);
+		quote_string(pobuf, string);
 	} else {
-		fputs(string, fp);
+		obuf_puts(pobuf, string);
 	}
 }
 
-static void quote_original_output_func(FILE* fp, char* string, char* ors, char* ofs, int orslen, int ofslen,
-	char quote_flags)
+static void quote_original_output_func(output_buffer_t* pobuf, char* string, char* ors, char* ofs, int orslen,
+	int ofslen, char quote_flags)
 {
 	if (quote_flags & FIELD_QUOTED_ON_INPUT) {
-		quote_string(fp, string);
+		quote_string(pobuf, string);
 	} else {
-		fputs(string, fp);
+		obuf_puts(pobuf, string);
 	}
 }
 
 // ----------------------------------------------------------------
-static void quote_string(FILE* fp, char* string) {
-	fputc('"', fp);
+static void quote_string(output_buffer_t* pobuf, char* string) {
+	obuf_putc(pobuf, '"');
 	for (char* p = string; *p; p++) {
 		if (*p == '"')
-			fputs("\"\"", fp);
+			obuf_write(pobuf, "\"\"", 2);
 		else
-			fputc(*p, fp);
+			obuf_putc(pobuf, *p);
 	}
-	fputc('"', fp);
+	obuf_putc(pobuf, '"');
 }
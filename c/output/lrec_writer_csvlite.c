@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include "containers/mixutil.h"
 #include "lib/mlrutil.h"
+#include "lib/output_buffer.h"
 #include "output/lrec_writers.h"
 
 typedef struct _lrec_writer_csvlite_state_t {
@@ -9,6 +10,7 @@ typedef struct _lrec_writer_csvlite_state_t {
 	char* ofs;
 	long long num_header_lines_output;
 	slls_t* plast_header_output;
+	output_buffer_t* pobuf;
 	int headerless_csv_output;
 } lrec_writer_csvlite_state_t;
 
@@ -27,6 +29,7 @@ lrec_writer_t* lrec_writer_csvlite_alloc(char* ors, char* ofs, int headerless_cs
 	pstate->ofs                     = ofs;
 	pstate->num_header_lines_output = 0LL;
 	pstate->plast_header_output     = NULL;
+	pstate->pobuf                   = obuf_alloc(OBUF_DEFAULT_ALLOC_LENGTH);
 	pstate->headerless_csv_output   = headerless_csv_output;
 
 	plrec_writer->pvstate       = (void*)pstate;
@@ -41,6 +44,7 @@ lrec_writer_t* lrec_writer_csvlite_alloc(char* ors, char* ofs, int headerless_cs
 static void lrec_writer_csvlite_free(lrec_writer_t* pwriter, context_t* pctx) {
 	lrec_writer_csvlite_state_t* pstate = pwriter->pvstate;
 	slls_free(pstate->plast_header_output);
+	obuf_free(pstate->pobuf);
 	free(pstate);
 	free(pwriter);
 }
@@ -60,6 +64,8 @@ static void lrec_writer_csvlite_process(void* pvstate, FILE* output_stream, lrec
 	if (prec == NULL)
 		return;
 	lrec_writer_csvlite_state_t* pstate = pvstate;
+	output_buffer_t* pobuf = pstate->pobuf;
+	obuf_set_stream(pobuf, output_stream);
 	char* ofs = pstate->ofs;
 
 	if (pstate->plast_header_output != NULL) {
@@ -67,7 +73,7 @@ static void lrec_writer_csvlite_process(void* pvstate, FILE* output_stream, lrec
 			slls_free(pstate->plast_header_output);
 			pstate->plast_header_output = NULL;
 			if (pstate->num_header_lines_output > 0LL)
-				fputs(ors, output_stream);
+				obuf_puts(pobuf, ors);
 		}
 	}
 
@@ -76,11 +82,11 @@ static void lrec_writer_csvlite_process(void* pvstate, FILE* output_stream, lrec
 			int nf = 0;
 			for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
 				if (nf > 0)
-					fputs(ofs, output_stream);
-				fputs(pe->key, output_stream);
+					obuf_puts(pobuf, ofs);
+				obuf_puts(pobuf, pe->key);
 				nf++;
 			}
-			fputs(ors, output_stream);
+			obuf_puts(pobuf, ors);
 		}
 		pstate->plast_header_output = mlr_copy_keys_from_record(prec);
 		pstate->num_header_lines_output++;
@@ -89,11 +95,12 @@ static void lrec_writer_csvlite_process(void* pvstate, FILE* output_stream, lrec
 	int nf = 0;
 	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
 		if (nf > 0)
-			fputs(ofs, output_stream);
-		fputs(pe->value, output_stream);
+			obuf_puts(pobuf, ofs);
+		obuf_puts(pobuf, pe->value);
 		nf++;
 	}
-	fputs(ors, output_stream);
+	obuf_puts(pobuf, ors);
+	obuf_flush(pobuf);
 	pstate->onr++;
 
 	lrec_free(prec); // end of baton-pass
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "lib/mlrutil.h"
+#include "lib/output_buffer.h"
 #include "containers/mlhmmv.h"
 #include "output/lrec_writers.h"
 
@@ -16,6 +17,7 @@ typedef struct _lrec_writer_json_state_t {
 	char* after_records_at_end_of_stream1;
 	char* line_term;
 	int stack_vertically;
+	output_buffer_t* pobuf;
 
 } lrec_writer_json_state_t;
 
@@ -52,6 +54,7 @@ lrec_writer_t* lrec_writer_json_alloc(int stack_vertically, int wrap_json_output
 	pstate->after_records_at_end_of_stream1       = wrap_json_output_in_outer_list ? "]" : "";
 	pstate->line_term                             = line_term;
 	pstate->stack_vertically                      = stack_vertically;
+	pstate->pobuf                                 = obuf_alloc(OBUF_DEFAULT_ALLOC_LENGTH);
 
 	plrec_writer->pvstate = (void*)pstate;
 	if (streq(line_term, "auto")) {
@@ -69,7 +72,9 @@ lrec_writer_t* lrec_writer_json_alloc(int stack_vertically, int wrap_json_output
 }
 
 static void lrec_writer_json_free(lrec_writer_t* pwriter, context_t* pctx) {
-	free(pwriter->pvstate);
+	lrec_writer_json_state_t* pstate = pwriter->pvstate;
+	obuf_free(pstate->pobuf);
+	free(pstate);
 	free(pwriter);
 }
 
@@ -104,12 +109,14 @@ static void lrec_writer_json_process(void* pvstate, FILE* output_stream, lrec_t*
 	char* before_or_after_records, char* line_term)
 {
 	lrec_writer_json_state_t* pstate = pvstate;
+	output_buffer_t* pobuf = pstate->pobuf;
+	obuf_set_stream(pobuf, output_stream);
 	if (prec != NULL) { // not end of record stream
 		if (pstate->counter++ == 0) {
-			fputs(pstate->before_records_at_start_of_stream1, output_stream);
-			fputs(before_or_after_records, output_stream);
+			obuf_puts(pobuf, pstate->before_records_at_start_of_stream1);
+			obuf_puts(pobuf, before_or_after_records);
 		} else {
-			fputs(pstate->between_records_after_start_of_stream, output_stream);
+			obuf_puts(pobuf, pstate->between_records_after_start_of_stream);
 		}
 
 		// Use the mlhmmv printer since it naturally handles Miller-to-JSON key deconcatenation:
@@ -136,18 +143,19 @@ static void lrec_writer_json_process(void* pvstate, FILE* output_stream, lrec_t*
 		}
 
 		if (pstate->stack_vertically)
-			mlhmmv_root_print_json_stacked(pmap, pstate->json_quote_int_keys, pstate->json_quote_non_string_values,
-				pstate->line_indent, line_term, output_stream);
+			mlhmmv_root_print_json_stacked_obuf(pmap, pstate->json_quote_int_keys,
+				pstate->json_quote_non_string_values, pstate->line_indent, line_term, pobuf);
 		else
-			mlhmmv_root_print_json_single_lines(pmap, pstate->json_quote_int_keys,
-				pstate->json_quote_non_string_values, line_term, output_stream);
+			mlhmmv_root_print_json_single_lines_obuf(pmap, pstate->json_quote_int_keys,
+				pstate->json_quote_non_string_values, line_term, pobuf);
 
 		mlhmmv_root_free(pmap);
 
 		lrec_free(prec); // end of baton-pass
 
 	} else { // end of record stream
-		fputs(pstate->after_records_at_end_of_stream1, output_stream);
-		fputs(before_or_after_records, output_stream);
+		obuf_puts(pobuf, pstate->after_records_at_end_of_stream1);
+		obuf_puts(pobuf, before_or_after_records);
 	}
+	obuf_flush(pobuf);
 }
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include "containers/mixutil.h"
 #include "lib/mlrutil.h"
+#include "lib/output_buffer.h"
 #include "output/lrec_writers.h"
 
 typedef struct _lrec_writer_markdown_state_t {
@@ -8,6 +9,7 @@ typedef struct _lrec_writer_markdown_state_t {
 	char* ors;
 	long long num_header_lines_output;
 	slls_t* plast_header_output;
+	output_buffer_t* pobuf;
 } lrec_writer_markdown_state_t;
 
 static void lrec_writer_markdown_free(lrec_writer_t* pwriter, context_t* pctx);
@@ -24,6 +26,7 @@ lrec_writer_t* lrec_writer_markdown_alloc(char* ors) {
 	pstate->ors                     = ors;
 	pstate->num_header_lines_output = 0LL;
 	pstate->plast_header_output     = NULL;
+	pstate->pobuf                   = obuf_alloc(OBUF_DEFAULT_ALLOC_LENGTH);
 
 	plrec_writer->pvstate       = (void*)pstate;
 	plrec_writer->pprocess_func = streq(ors, "auto")
@@ -37,6 +40,7 @@ lrec_writer_t* lrec_writer_markdown_alloc(char* ors) {
 static void lrec_writer_markdown_free(lrec_writer_t* pwriter, context_t* pctx) {
 	lrec_writer_markdown_state_t* pstate = pwriter->pvstate;
 	slls_free(pstate->plast_header_output);
+	obuf_free(pstate->pobuf);
 	free(pstate);
 	free(pwriter);
 }
@@ -58,42 +62,45 @@ static void lrec_writer_markdown_process(void* pvstate, FILE* output_stream, lre
 	if (prec == NULL)
 		return;
 	lrec_writer_markdown_state_t* pstate = pvstate;
+	output_buffer_t* pobuf = pstate->pobuf;
+	obuf_set_stream(pobuf, output_stream);
 
 	if (pstate->plast_header_output != NULL) {
 		if (!lrec_keys_equal_list(prec, pstate->plast_header_output)) {
 			slls_free(pstate->plast_header_output);
 			pstate->plast_header_output = NULL;
 			if (pstate->num_header_lines_output > 0LL)
-				fputs(ors, output_stream);
+				obuf_puts(pobuf, ors);
 		}
 	}
 
 	if (pstate->plast_header_output == NULL) {
-		fputc('|', output_stream);
+		obuf_putc(pobuf, '|');
 		for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
-			fputc(' ', output_stream);
-			fputs(pe->key, output_stream);
-			fputs(" |", output_stream);
+			obuf_putc(pobuf, ' ');
+			obuf_puts(pobuf, pe->key);
+			obuf_puts(pobuf, " |");
 		}
-		fputs(ors, output_stream);
+		obuf_puts(pobuf, ors);
 
-		fputc('|', output_stream);
+		obuf_putc(pobuf, '|');
 		for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
-			fputs(" --- |", output_stream);
+			obuf_puts(pobuf, " --- |");
 		}
-		fputs(ors, output_stream);
+		obuf_puts(pobuf, ors);
 
 		pstate->plast_header_output = mlr_copy_keys_from_record(prec);
 		pstate->num_header_lines_output++;
 	}
 
-	fputc('|', output_stream);
+	obuf_putc(pobuf, '|');
 	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
-		fputc(' ', output_stream);
-		fputs(pe->value, output_stream);
-		fputs(" |", output_stream);
+		obuf_putc(pobuf, ' ');
+		obuf_puts(pobuf, pe->value);
+		obuf_puts(pobuf, " |");
 	}
-	fputs(ors, output_stream);
+	obuf_puts(pobuf, ors);
+	obuf_flush(pobuf);
 	pstate->onr++;
 
 	lrec_free(prec); // end of baton-pass
@@ -1,10 +1,12 @@
 #include <stdlib.h>
 #include "lib/mlrutil.h"
+#include "lib/output_buffer.h"
 #include "output/lrec_writers.h"
 
 typedef struct _lrec_writer_nidx_state_t {
 	char* ors;
 	char* ofs;
+	output_buffer_t* pobuf;
 } lrec_writer_nidx_state_t;
 
 static void lrec_writer_nidx_free(lrec_writer_t* pwriter, context_t* pctx);
@@ -19,6 +21,7 @@ lrec_writer_t* lrec_writer_nidx_alloc(char* ors, char* ofs) {
 	lrec_writer_nidx_state_t* pstate = mlr_malloc_or_die(sizeof(lrec_writer_nidx_state_t));
 	pstate->ors = ors;
 	pstate->ofs = ofs;
+	pstate->pobuf = obuf_alloc(OBUF_DEFAULT_ALLOC_LENGTH);
 
 	plrec_writer->pvstate       = (void*)pstate;
 	plrec_writer->pprocess_func = streq(ors, "auto")
@@ -30,7 +33,9 @@ lrec_writer_t* lrec_writer_nidx_alloc(char* ors, char* ofs) {
 }
 
 static void lrec_writer_nidx_free(lrec_writer_t* pwriter, context_t* pctx) {
-	free(pwriter->pvstate);
+	lrec_writer_nidx_state_t* pstate = pwriter->pvstate;
+	obuf_free(pstate->pobuf);
+	free(pstate);
 	free(pwriter);
 }
 
@@ -49,14 +54,17 @@ static void lrec_writer_nidx_process(void* pvstate, FILE* output_stream, lrec_t*
 		return;
 	lrec_writer_nidx_state_t* pstate = pvstate;
 	char* ofs = pstate->ofs;
+	output_buffer_t* pobuf = pstate->pobuf;
+	obuf_set_stream(pobuf, output_stream);
 
 	int nf = 0;
 	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
 		if (nf > 0)
-			fputs(ofs, output_stream);
-		fputs(pe->value, output_stream);
+			obuf_puts(pobuf, ofs);
+		obuf_puts(pobuf, pe->value);
 		nf++;
 	}
-	fputs(ors, output_stream);
+	obuf_puts(pobuf, ors);
+	obuf_flush(pobuf);
 	lrec_free(prec); // end of baton-pass
 }
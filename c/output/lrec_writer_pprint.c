@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "lib/mlrutil.h"
+#include "lib/output_buffer.h"
 #include "containers/sllv.h"
 #include "containers/slls.h"
 #include "containers/mixutil.h"
@@ -14,15 +15,16 @@ typedef struct _lrec_writer_pprint_state_t {
 	char*      ors;
 	char       ofs;
 	int        barred;
+	output_buffer_t* pobuf;
 } lrec_writer_pprint_state_t;
 
 static void lrec_writer_pprint_free(lrec_writer_t* pwriter, context_t* pctx);
 static void lrec_writer_pprint_process(void* pvstate, FILE* output_stream, lrec_t* prec, char* ors);
 static void lrec_writer_pprint_process_auto_ors(void* pvstate, FILE* output_stream, lrec_t* prec, context_t* pctx);
 static void lrec_writer_pprint_process_nonauto_ors(void* pvstate, FILE* output_stream, lrec_t* prec, context_t* pctx);
-static void print_and_free_record_list(sllv_t* precords, FILE* output_stream, char* ors, char ofs,
+static void print_and_free_record_list(sllv_t* precords, output_buffer_t* pobuf, char* ors, char ofs,
 	int right_align);
-static void print_and_free_record_list_barred(sllv_t* precords, FILE* output_stream, char* ors, char ofs,
+static void print_and_free_record_list_barred(sllv_t* precords, output_buffer_t* pobuf, char* ors, char ofs,
 	int right_align);
 
 // ----------------------------------------------------------------
@@ -37,6 +39,7 @@ lrec_writer_t* lrec_writer_pprint_alloc(char* ors, char ofs, int right_align, in
 	pstate->right_align        = right_align;
 	pstate->barred             = barred;
 	pstate->num_blocks_written = 0LL;
+	pstate->pobuf              = obuf_alloc(OBUF_DEFAULT_ALLOC_LENGTH);
 
 	plrec_writer->pvstate       = pstate;
 	plrec_writer->pprocess_func = streq(ors, "auto")
@@ -57,6 +60,7 @@ static void lrec_writer_pprint_free(lrec_writer_t* pwriter, context_t* pctx) {
 		slls_free(pstate->pprev_keys);
 		pstate->pprev_keys = NULL;
 	}
+	obuf_free(pstate->pobuf);
 	free(pstate);
 	free(pwriter);
 }
@@ -85,19 +89,22 @@ static void lrec_writer_pprint_process(void* pvstate, FILE* output_stream, lrec_
 	}
 
 	if (drain) {
+		output_buffer_t* pobuf = pstate->pobuf;
+		obuf_set_stream(pobuf, output_stream);
 		if (pstate->num_blocks_written > 0LL) // separate blocks with empty line
-			fputs(ors, output_stream);
+			obuf_puts(pobuf, ors);
 		if (pstate->barred) {
-			print_and_free_record_list_barred(pstate->precords, output_stream, ors, pstate->ofs,
+			print_and_free_record_list_barred(pstate->precords, pobuf, ors, pstate->ofs,
 				pstate->right_align);
 		} else {
-			print_and_free_record_list(pstate->precords, output_stream, ors, pstate->ofs,
+			print_and_free_record_list(pstate->precords, pobuf, ors, pstate->ofs,
 				pstate->right_align);
 		}
 		if (pstate->pprev_keys != NULL) {
 			slls_free(pstate->pprev_keys);
 			pstate->pprev_keys = NULL;
 		}
+		obuf_flush(pobuf);
 		pstate->precords = sllv_alloc();
 		pstate->num_blocks_written++;
 	}
@@ -109,7 +116,7 @@ static void lrec_writer_pprint_process(void* pvstate, FILE* output_stream, lrec_
 }
 
 // ----------------------------------------------------------------
-static void print_and_free_record_list(sllv_t* precords, FILE* output_stream, char* ors, char ofs,
+static void print_and_free_record_list(sllv_t* precords, output_buffer_t* pobuf, char* ors, char ofs,
 	int right_align)
 {
 	if (precords->length == 0) {
@@ -141,53 +148,49 @@ static void print_and_free_record_list(sllv_t* precords, FILE* output_stream, ch
 			j = 0;
 			for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext, j++) {
 				if (j > 0) {
-					fputc(ofs, output_stream);
+					obuf_putc(pobuf, ofs);
 				}
 				if (!right_align) {
 					if (pe->pnext == NULL) {
-						fprintf(output_stream, "%s", pe->key);
+						obuf_puts(pobuf, pe->key);
 					} else {
 						// "%-*s" fprintf format isn't correct for non-ASCII UTF-8
-						fprintf(output_stream, "%s", pe->key);
+						obuf_puts(pobuf, pe->key);
 						int d = max_widths[j] - strlen_for_utf8_display(pe->key);
-						for (int i = 0; i < d; i++)
-							fputc(ofs, output_stream);
+						obuf_putc_repeated(pobuf, ofs, d);
 					}
 				} else {
 					int d = max_widths[j] - strlen_for_utf8_display(pe->key);
-					for (int i = 0; i < d; i++)
-						fputc(ofs, output_stream);
-					fprintf(output_stream, "%s", pe->key);
+					obuf_putc_repeated(pobuf, ofs, d);
+					obuf_puts(pobuf, pe->key);
 				}
 			}
-			fputs(ors, output_stream);
+			obuf_puts(pobuf, ors);
 		}
 
 		j = 0;
 		for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext, j++) {
 			if (j > 0) {
-				fputc(ofs, output_stream);
+				obuf_putc(pobuf, ofs);
 			}
 			char* value = pe->value;
 			if (*value == 0) // empty string
 				value = "-";
 			if (!right_align) {
 				if (pe->pnext == NULL) {
-					fprintf(output_stream, "%s", value);
+					obuf_puts(pobuf, value);
 				} else {
-					fprintf(output_stream, "%s", value);
+					obuf_puts(pobuf, value);
 					int d = max_widths[j] - strlen_for_utf8_display(value);
-					for (int i = 0; i < d; i++)
-						fputc(ofs, output_stream);
+					obuf_putc_repeated(pobuf, ofs, d);
 				}
 			} else {
 				int d = max_widths[j] - strlen_for_utf8_display(value);
-				for (int i = 0; i < d; i++)
-					fputc(ofs, output_stream);
-				fprintf(output_stream, "%s", value);
+				obuf_putc_repeated(pobuf, ofs, d);
+				obuf_puts(pobuf, value);
 			}
 		}
-		fputs(ors, output_stream);
+		obuf_puts(pobuf, ors);
 
 		lrec_free(prec); // end of baton-pass
 	}
@@ -197,7 +200,7 @@ static void print_and_free_record_list(sllv_t* precords, FILE* output_stream, ch
 }
 
 // ----------------------------------------------------------------
-static void print_and_free_record_list_barred(sllv_t* precords, FILE* output_stream, char* ors, char ofs,
+static void print_and_free_record_list_barred(sllv_t* precords, output_buffer_t* pobuf, char* ors, char ofs,
 	int right_align)
 {
 	if (precords->length == 0) {
@@ -228,106 +231,99 @@ static void print_and_free_record_list_barred(sllv_t* precords, FILE* output_str
 		if (onr == 0) {
 
 			j = 0;
-			fputc('+', output_stream);
-			fputc('-', output_stream);
+			obuf_putc(pobuf, '+');
+			obuf_putc(pobuf, '-');
 			for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext, j++) {
 				if (j > 0) {
-					fputc('-', output_stream);
+					obuf_putc(pobuf, '-');
 				}
 				int d = max_widths[j];
-				for (int i = 0; i < d; i++)
-					fputc('-', output_stream);
-				fputc('-', output_stream);
-				fputc('+', output_stream);
+				obuf_putc_repeated(pobuf, '-', d);
+				obuf_putc(pobuf, '-');
+				obuf_putc(pobuf, '+');
 			}
-			fputs(ors, output_stream);
+			obuf_puts(pobuf, ors);
 
 			j = 0;
-			fputc('|', output_stream);
-			fputc(ofs, output_stream);
+			obuf_putc(pobuf, '|');
+			obuf_putc(pobuf, ofs);
 			for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext, j++) {
 				if (j > 0) {
-					fputc(ofs, output_stream);
+					obuf_putc(pobuf, ofs);
 				}
 				if (!right_align) {
 					// "%-*s" fprintf format isn't correct for non-ASCII UTF-8
-					fprintf(output_stream, "%s", pe->key);
+					obuf_puts(pobuf, pe->key);
 					int d = max_widths[j] - strlen_for_utf8_display(pe->key);
-					for (int i = 0; i < d; i++)
-						fputc(ofs, output_stream);
-					fputc(ofs, output_stream);
-					fputc('|', output_stream);
+					obuf_putc_repeated(pobuf, ofs, d);
+					obuf_putc(pobuf, ofs);
+					obuf_putc(pobuf, '|');
 				} else {
 					int d = max_widths[j] - strlen_for_utf8_display(pe->key);
-					for (int i = 0; i < d; i++)
-						fputc(ofs, output_stream);
-					fprintf(output_stream, "%s", pe->key);
-					fputc(ofs, output_stream);
-					fputc('|', output_stream);
+					obuf_putc_repeated(pobuf, ofs, d);
+					obuf_puts(pobuf, pe->key);
+					obuf_putc(pobuf, ofs);
+					obuf_putc(pobuf, '|');
 				}
 			}
-			fputs(ors, output_stream);
+			obuf_puts(pobuf, ors);
 
 			j = 0;
-			fputc('+', output_stream);
-			fputc('-', output_stream);
+			obuf_putc(pobuf, '+');
+			obuf_putc(pobuf, '-');
 			for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext, j++) {
 				if (j > 0) {
-					fputc('-', output_stream);
+					obuf_putc(pobuf, '-');
 				}
 				int d = max_widths[j];
-				for (int i = 0; i < d; i++)
-					fputc('-', output_stream);
-				fputc('-', output_stream);
-				fputc('+', output_stream);
+				obuf_putc_repeated(pobuf, '-', d);
+				obuf_putc(pobuf, '-');
+				obuf_putc(pobuf, '+');
 			}
-			fputs(ors, output_stream);
+			obuf_puts(pobuf, ors);
 
 		}
 
 		j = 0;
-		fputc('|', output_stream);
-		fputc(ofs, output_stream);
+		obuf_putc(pobuf, '|');
+		obuf_putc(pobuf, ofs);
 		for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext, j++) {
 			if (j > 0) {
-				fputc(ofs, output_stream);
+				obuf_putc(pobuf, ofs);
 			}
 			char* value = pe->value;
 			if (*value == 0) // empty string
 				value = "-";
 			if (!right_align) {
-				fprintf(output_stream, "%s", value);
+				obuf_puts(pobuf, value);
 				int d = max_widths[j] - strlen_for_utf8_display(value);
-				for (int i = 0; i < d; i++)
-					fputc(ofs, output_stream);
-				fputc(ofs, output_stream);
-				fputc('|', output_stream);
+				obuf_putc_repeated(pobuf, ofs, d);
+				obuf_putc(pobuf, ofs);
+				obuf_putc(pobuf, '|');
 			} else {
 				int d = max_widths[j] - strlen_for_utf8_display(value);
-				for (int i = 0; i < d; i++)
-					fputc(ofs, output_stream);
-				fprintf(output_stream, "%s", value);
-				fputc(ofs, output_stream);
-				fputc('|', output_stream);
+				obuf_putc_repeated(pobuf, ofs, d);
+				obuf_puts(pobuf, value);
+				obuf_putc(pobuf, ofs);
+				obuf_putc(pobuf, '|');
 			}
 		}
-		fputs(ors, output_stream);
+		obuf_puts(pobuf, ors);
 
 		if (pnode->pnext == NULL) {
 			j = 0;
-			fputc('+', output_stream);
-			fputc('-', output_stream);
+			obuf_putc(pobuf, '+');
+			obuf_putc(pobuf, '-');
 			for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext, j++) {
 				if (j > 0) {
-					fputc('-', output_stream);
+					obuf_putc(pobuf, '-');
 				}
 				int d = max_widths[j];
-				for (int i = 0; i < d; i++)
-					fputc('-', output_stream);
-				fputc('-', output_stream);
-				fputc('+', output_stream);
+				obuf_putc_repeated(pobuf, '-', d);
+				obuf_putc(pobuf, '-');
+				obuf_putc(pobuf, '+');
 			}
-			fputs(ors, output_stream);
+			obuf_puts(pobuf, ors);
 		}
 
 		lrec_free(prec); // end of baton-pass
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "lib/mlrutil.h"
+#include "lib/output_buffer.h"
 #include "output/lrec_writers.h"
 
 // ----------------------------------------------------------------
@@ -25,6 +26,7 @@ typedef struct _lrec_writer_xtab_state_t {
 	int   opslen;
 	long long record_count;
 	int   right_justify_value;
+	output_buffer_t* pobuf;
 } lrec_writer_xtab_state_t;
 
 static void lrec_writer_xtab_free(lrec_writer_t* pwriter, context_t* pctx);
@@ -45,6 +47,7 @@ lrec_writer_t* lrec_writer_xtab_alloc(char* ofs, char* ops, int right_justify_va
 	pstate->opslen       = strlen(ops);
 	pstate->record_count = 0LL;
 	pstate->right_justify_value = right_justify_value;
+	pstate->pobuf        = obuf_alloc(OBUF_DEFAULT_ALLOC_LENGTH);
 
 	plrec_writer->pvstate = pstate;
 	if (pstate->opslen == 1) {
@@ -62,7 +65,9 @@ lrec_writer_t* lrec_writer_xtab_alloc(char* ofs, char* ops, int right_justify_va
 }
 
 static void lrec_writer_xtab_free(lrec_writer_t* pwriter, context_t* pctx) {
-	free(pwriter->pvstate);
+	lrec_writer_xtab_state_t* pstate = pwriter->pvstate;
+	obuf_free(pstate->pobuf);
+	free(pstate);
 	free(pwriter);
 }
 
@@ -80,8 +85,11 @@ static void lrec_writer_xtab_process_aligned(void* pvstate, FILE* output_stream,
 	if (prec == NULL)
 		return;
 	lrec_writer_xtab_state_t* pstate = pvstate;
+	output_buffer_t* pobuf = pstate->pobuf;
+	obuf_set_stream(pobuf, output_stream);
+
 	if (pstate->record_count > 0LL)
-		fputs(ofs, output_stream);
+		obuf_puts(pobuf, ofs);
 	pstate->record_count++;
 
 	int max_key_width = 1;
@@ -97,18 +105,19 @@ static void lrec_writer_xtab_process_aligned(void* pvstate, FILE* output_stream,
 
 	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
 		// "%-*s" fprintf format isn't correct for non-ASCII UTF-8
-		fprintf(output_stream, "%s", pe->key);
+		obuf_puts(pobuf, pe->key);
 		int d = max_key_width - strlen_for_utf8_display(pe->key);
-		for (int i = 0; i < d; i++)
-			fputs(pstate->ops, output_stream);
+		obuf_puts_repeated(pobuf, pstate->ops, d);
 
 		if (pstate->right_justify_value) {
 			int d = max_value_width - strlen_for_utf8_display(pe->value);
-			for (int i = 0; i < d; i++)
-				fputs(pstate->ops, output_stream);
+			obuf_puts_repeated(pobuf, pstate->ops, d);
 		}
-		fprintf(output_stream, "%s%s%s", pstate->ops, pe->value, ofs);
+		obuf_puts(pobuf, pstate->ops);
+		obuf_puts(pobuf, pe->value);
+		obuf_puts(pobuf, ofs);
 	}
+	obuf_flush(pobuf);
 	lrec_free(prec); // end of baton-pass
 }
 
@@ -126,13 +135,20 @@ static void lrec_writer_xtab_process_unaligned(void* pvstate, FILE* output_strea
 	if (prec == NULL)
 		return;
 	lrec_writer_xtab_state_t* pstate = pvstate;
+	output_buffer_t* pobuf = pstate->pobuf;
+	obuf_set_stream(pobuf, output_stream);
+
 	if (pstate->record_count > 0LL)
-		fputs(ofs, output_stream);
+		obuf_puts(pobuf, ofs);
 	pstate->record_count++;
 
 	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
 		// "%-*s" fprintf format isn't correct for non-ASCII UTF-8
-		fprintf(output_stream, "%s%s%s%s", pe->key, pstate->ops, pe->value, ofs);
+		obuf_puts(pobuf, pe->key);
+		obuf_puts(pobuf, pstate->ops);
+		obuf_puts(pobuf, pe->value);
+		obuf_puts(pobuf, ofs);
 	}
+	obuf_flush(pobuf);
 	lrec_free(prec); // end of baton-pass
 }
@@ -1,11 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "lib/mlrutil.h"
 #include "lib/mlr_globals.h"
 #include "containers/lrec.h"
 #include "containers/sllv.h"
+#include "containers/batch_queue.h"
 #include "input/lrec_readers.h"
 #include "mapping/mappers.h"
 #include "output/lrec_writers.h"
@@ -17,11 +19,22 @@ static int do_file_chained(char* filename, context_t* pctx,
 	lrec_reader_t* plrec_reader, sllv_t* pmapper_list, lrec_writer_t* plrec_writer, FILE* output_stream,
 	cli_opts_t* popts);
 
+static int do_stream_chained_threaded(context_t* pctx, slls_t* pfilenames,
+	lrec_reader_t* plrec_reader, sllv_t* pmapper_list, lrec_writer_t* plrec_writer, FILE* output_stream,
+	cli_opts_t* popts);
+
 static sllv_t* chain_map(lrec_t* pinrec, context_t* pctx, sllve_t* pmapper_list_head);
 
+typedef void output_flush_func_t(sllv_t* poutrecs, context_t* pctx, void* pvsink);
+static void chain_map_end_of_stream(lrec_t* pinrec, context_t* pctx, sllve_t* pmapper_list_head,
+	sllv_t* poutrecs, output_flush_func_t* pflush_func, void* pvsink);
+
 static void drive_lrec(lrec_t* pinrec, context_t* pctx, sllve_t* pmapper_list_head, lrec_writer_t* plrec_writer,
 	FILE* output_stream);
 
+static int do_file_chained_selecting(void* pvhandle, context_t* pctx, lrec_reader_t* plrec_reader,
+	sllv_t* pmapper_list, lrec_writer_t* plrec_writer, FILE* output_stream, cli_opts_t* popts);
+
 typedef void progress_indicator_t(context_t* pctx, long long nr_progress_mod);
 static void null_progress_indicator(context_t* pctx, long long nr_progress_mod);
 static void stderr_progress_indicator(context_t* pctx, long long nr_progress_mod);
@@ -62,9 +75,8 @@ static int do_stream_chained_in_place(context_t* pctx, cli_opts_t* popts) {
 		lrec_reader_t* plrec_reader = lrec_reader_alloc_or_die(&popts->reader_opts);
 		lrec_writer_t* plrec_writer = lrec_writer_alloc_or_die(&popts->writer_opts);
 
-		int argi = popts->mapper_argb;
-		int unused;
-		sllv_t* pmapper_list = cli_parse_mappers(popts->argv, &argi, popts->argc, popts, &unused);
+		char** argv_copy = NULL;
+		sllv_t* pmapper_list = cli_reparse_mappers(popts, &argv_copy);
 		MLR_INTERNAL_CODING_ERROR_IF(pmapper_list->length < 1); // Should not have been allowed by the CLI parser.
 
 		char* filename = pe->value;
@@ -77,23 +89,31 @@ static int do_stream_chained_in_place(context_t* pctx, cli_opts_t* popts) {
 			exit(1);
 		}
 
-		pctx->filenum++;
-		pctx->filename = filename;
-		pctx->fnr = 0;
+		if (popts->nthreads > 1) {
+			slls_t* pfilenames = slls_single_no_free(filename);
+			ok = do_stream_chained_threaded(pctx, pfilenames, plrec_reader, pmapper_list, plrec_writer,
+				output_stream, popts) && ok;
+			slls_free(pfilenames);
+			pctx->force_eof = FALSE;
+		} else {
+			pctx->filenum++;
+			pctx->filename = filename;
+			pctx->fnr = 0;
 
-		ok = do_file_chained(filename, pctx, plrec_reader, pmapper_list, plrec_writer,
-			output_stream, popts) && ok;
+			ok = do_file_chained(filename, pctx, plrec_reader, pmapper_list, plrec_writer,
+				output_stream, popts) && ok;
 
-		// For in-place mode, there's no breaking from the loop over input files. Just an early
-		// return from the mapper chain, which has already just happened.
-		if (pctx->force_eof == TRUE) // e.g. mlr head
-			pctx->force_eof = FALSE;
+			// For in-place mode, there's no breaking from the loop over input files. Just an early
+			// return from the mapper chain, which has already just happened.
+			if (pctx->force_eof == TRUE) // e.g. mlr head
+				pctx->force_eof = FALSE;
 
-		// Mappers and writers receive end-of-stream notifications via null input record.
-		// Do that, now that data from the input file have been exhausted.
-		drive_lrec(NULL, pctx, pmapper_list->phead, plrec_writer, output_stream);
-		// Drain the pretty-printer.
-		plrec_writer->pprocess_func(plrec_writer->pvstate, output_stream, NULL, pctx);
+			// Mappers and writers receive end-of-stream notifications via null input record.
+			// Do that, now that data from the input file have been exhausted.
+			drive_lrec(NULL, pctx, pmapper_list->phead, plrec_writer, output_stream);
+			// Drain the pretty-printer.
+			plrec_writer->pprocess_func(plrec_writer->pvstate, output_stream, NULL, pctx);
+		}
 
 		fclose(output_stream);
 		int rc = rename(tempname, filename);
@@ -109,6 +129,7 @@ static int do_stream_chained_in_place(context_t* pctx, cli_opts_t* popts) {
 		plrec_writer->pfree_func(plrec_writer, pctx);
 
 		mapper_chain_free(pmapper_list, pctx);
+		cli_argv_copy_free(popts, argv_copy);
 	}
 
 	return ok;
@@ -124,6 +145,14 @@ static int do_stream_chained_to_stdout(context_t* pctx, sllv_t* pmapper_list, cl
 	MLR_INTERNAL_CODING_ERROR_IF(pmapper_list->length < 1); // Should not have been allowed by the CLI parser.
 
 	int ok = 1;
+	if (popts->nthreads > 1) {
+		ok = do_stream_chained_threaded(pctx, popts->filenames, plrec_reader, pmapper_list, plrec_writer,
+			output_stream, popts);
+		plrec_reader->pfree_func(plrec_reader);
+		plrec_writer->pfree_func(plrec_writer, pctx);
+		return ok;
+	}
+
 	if (popts->filenames == NULL) {
 		// No input at all
 	} else if (popts->filenames->length == 0) {
@@ -173,6 +202,13 @@ static int do_file_chained(char* filename, context_t* pctx,
 	// Start-of-file hook, e.g. expecting CSV headers on input.
 	plrec_reader->psof_func(plrec_reader->pvstate, pvhandle);
 
+	mapper_t* pfirst_mapper = pmapper_list->phead->pvvalue;
+	if (pfirst_mapper->pselect_batch_func != NULL) {
+		do_file_chained_selecting(pvhandle, pctx, plrec_reader, pmapper_list, plrec_writer, output_stream, popts);
+		plrec_reader->pclose_func(plrec_reader->pvstate, pvhandle, popts->reader_opts.prepipe);
+		return 1;
+	}
+
 	while (1) {
 		lrec_t* pinrec = plrec_reader->pprocess_func(plrec_reader->pvstate, pvhandle, pctx);
 		if (pinrec == NULL)
@@ -194,9 +230,102 @@ static int do_file_chained(char* filename, context_t* pctx,
 }
 
 // ----------------------------------------------------------------
+// As the loop in do_file_chained, when the first mapper can select records a batch at a time
+// (see mapper_select_batch_func_t). Records are read a batch ahead; each one's NR and FNR are
+// saved, and restored when it goes down the chain, so the rest of the chain sees the same context
+// as when reading one record at a time.
+
+static int do_file_chained_selecting(void* pvhandle, context_t* pctx, lrec_reader_t* plrec_reader,
+	sllv_t* pmapper_list, lrec_writer_t* plrec_writer, FILE* output_stream, cli_opts_t* popts)
+{
+	progress_indicator_t* pindicator = popts->nr_progress_mod == 0LL
+		? null_progress_indicator
+		: stderr_progress_indicator;
+	mapper_t* pfirst_mapper = pmapper_list->phead->pvvalue;
+	sllve_t* prest = pmapper_list->phead->pnext;
+
+	lrec_t**   precords = mlr_malloc_or_die(MAPPER_SELECT_BATCH_SIZE * sizeof(lrec_t*));
+	long long* pnrs     = mlr_malloc_or_die(MAPPER_SELECT_BATCH_SIZE * sizeof(long long));
+	long long* pfnrs    = mlr_malloc_or_die(MAPPER_SELECT_BATCH_SIZE * sizeof(long long));
+	char*      pverdicts = mlr_malloc_or_die(MAPPER_SELECT_BATCH_SIZE);
+
+	int at_eof = FALSE;
+	while (!at_eof && !pctx->force_eof) {
+		int num_records = 0;
+		while (num_records < MAPPER_SELECT_BATCH_SIZE) {
+			lrec_t* pinrec = plrec_reader->pprocess_func(plrec_reader->pvstate, pvhandle, pctx);
+			if (pinrec == NULL) {
+				at_eof = TRUE;
+				break;
+			}
+			pctx->nr++;
+			pctx->fnr++;
+			pindicator(pctx, popts->nr_progress_mod);
+			precords[num_records] = pinrec;
+			pnrs[num_records]     = pctx->nr;
+			pfnrs[num_records]    = pctx->fnr;
+			num_records++;
+		}
+		if (num_records == 0)
+			break;
+
+		pfirst_mapper->pselect_batch_func(precords, num_records, pverdicts, pfirst_mapper->pvstate);
+
+		long long read_nr  = pctx->nr;
+		long long read_fnr = pctx->fnr;
+		for (int i = 0; i < num_records; i++) {
+			if (pctx->force_eof || pverdicts[i] == MAPPER_SELECT_DROP) { // force_eof e.g. mlr head
+				lrec_free(precords[i]);
+				continue;
+			}
+			pctx->nr  = pnrs[i];
+			pctx->fnr = pfnrs[i];
+			if (pverdicts[i] == MAPPER_SELECT_UNDECIDED)
+				drive_lrec(precords[i], pctx, pmapper_list->phead, plrec_writer, output_stream);
+			else if (prest != NULL)
+				drive_lrec(precords[i], pctx, prest, plrec_writer, output_stream);
+			else // writer frees records
+				plrec_writer->pprocess_func(plrec_writer->pvstate, output_stream, precords[i], pctx);
+		}
+		if (!pctx->force_eof) { // else NR and FNR stay at the record which ended the stream
+			pctx->nr  = read_nr;
+			pctx->fnr = read_fnr;
+		}
+	}
+
+	free(precords);
+	free(pnrs);
+	free(pfnrs);
+	free(pverdicts);
+	return 1;
+}
+
+// ----------------------------------------------------------------
+typedef struct _writer_sink_t {
+	lrec_writer_t* plrec_writer;
+	FILE*          output_stream;
+} writer_sink_t;
+
+static void writer_flush_func(sllv_t* poutrecs, context_t* pctx, void* pvsink) {
+	writer_sink_t* psink = pvsink;
+	while (poutrecs->length > 0) { // writer frees records
+		lrec_t* poutrec = sllv_pop(poutrecs);
+		psink->plrec_writer->pprocess_func(psink->plrec_writer->pvstate, psink->output_stream, poutrec, pctx);
+	}
+}
+
 static void drive_lrec(lrec_t* pinrec, context_t* pctx, sllve_t* pmapper_list_head, lrec_writer_t* plrec_writer,
 	FILE* output_stream)
 {
+	if (pinrec == NULL) {
+		writer_sink_t sink = { .plrec_writer = plrec_writer, .output_stream = output_stream };
+		sllv_t* outrecs = sllv_alloc();
+		chain_map_end_of_stream(NULL, pctx, pmapper_list_head, outrecs, writer_flush_func, &sink);
+		writer_flush_func(outrecs, pctx, &sink);
+		sllv_free(outrecs);
+		return;
+	}
+
 	sllv_t* outrecs = chain_map(pinrec, pctx, pmapper_list_head);
 	if (outrecs != NULL) {
 		for (sllve_t* pe = outrecs->phead; pe != NULL; pe = pe->pnext) {
@@ -236,6 +365,654 @@ static sllv_t* chain_map(lrec_t* pinrec, context_t* pctx, sllve_t* pmapper_list_
 	}
 }
 
+// ----------------------------------------------------------------
+// As chain_map, but for the end-of-stream null record and whatever the mappers emit in response
+// to it. Output is accumulated in poutrecs. When a mapper emits its output in parts (see
+// MAPPER_MORE_OUTPUT), each part is run through the rest of the chain and flushed before the next
+// is asked for, so that the whole never needs to be in memory at once.
+
+static void chain_map_end_of_stream(lrec_t* pinrec, context_t* pctx, sllve_t* pmapper_list_head,
+	sllv_t* poutrecs, output_flush_func_t* pflush_func, void* pvsink)
+{
+	mapper_t* pmapper = pmapper_list_head->pvvalue;
+	while (TRUE) {
+		sllv_t* outrecs = pmapper->pprocess_func(pinrec, pctx, pmapper->pvstate);
+		if (outrecs == NULL)
+			return;
+		int more = FALSE;
+		for (sllve_t* pe = outrecs->phead; pe != NULL; pe = pe->pnext) {
+			lrec_t* poutrec = pe->pvvalue;
+			if (poutrec == MAPPER_MORE_OUTPUT)
+				more = TRUE;
+			else if (pmapper_list_head->pnext != NULL)
+				chain_map_end_of_stream(poutrec, pctx, pmapper_list_head->pnext, poutrecs, pflush_func, pvsink);
+			else if (poutrec != NULL)
+				sllv_append(poutrecs, poutrec);
+		}
+		sllv_free(outrecs);
+		if (!more)
+			return;
+		pflush_func(poutrecs, pctx, pvsink);
+	}
+}
+
+// ================================================================
+// Threaded mode (mlr --threads n with n > 1): the record reader, the mapper
+// chain, and the record writer run as three pipeline stages, each on its own
+// thread, connected by bounded queues of record batches. The mapper chain runs
+// on the calling thread; the reader and writer get threads of their own.
+//
+// Each batch carries a copy of the context (NR, FNR, FILENAME, etc.) as of just
+// before its first record, so the mapper chain sees the same per-record context
+// as in the single-threaded case. Every input file produces at least one batch,
+// possibly empty, so that FILENAME/FILENUM advance for empty files as well.
+//
+// Batches are consumed in the order produced, so record order is preserved. End
+// of stream is signaled by closing the queues, after which the mapper chain and
+// the writer receive their usual null-record notifications.
+//
+// Early exit (e.g. mlr head) is signaled from the mapper stage back to the
+// reader stage via a stop flag. Records already read past that point are
+// discarded without being mapped, as in the single-threaded case.
+//
+// Readers which can split their input (mmapped DKVP, NIDX, and CSV-lite) have
+// each file cut into chunks at record-separator boundaries. The chunks are
+// parsed by a pool of n parse threads, chunk i going to thread i mod n, each of
+// which has its own output queue. The reader thread then acts as sequencer:
+// it takes batches from the parse threads' queues in chunk order and assigns
+// NR and FNR, so record order and numbering are the same as when reading
+// serially.
+//
+// Likewise, if the then-chain starts with one or more stateless mappers (see
+// mapper_is_stateless_func_t), n map threads each get their own instances of
+// those, and batch i from the reader goes to map thread i mod n. The rest of the
+// chain, on the calling thread, takes the map threads' output batches in the
+// same round-robin order. Records dropped by the stateless mappers (e.g. by
+// filter) are kept as null placeholders so that the rest of the chain sees the
+// same NR and FNR for each record as in the single-threaded case.
+// ================================================================
+
+#define PIPELINE_BATCH_SIZE     500
+#define PIPELINE_QUEUE_CAPACITY 16
+#define PIPELINE_CHUNK_SIZE     (1LL << 20)
+
+#if PIPELINE_BATCH_SIZE > MAPPER_SELECT_BATCH_SIZE
+#error "Pipeline stages pass whole batches to mapper batch functions."
+#endif
+
+typedef struct _record_batch_t {
+	sllv_t*   precords;
+	context_t ctx;
+	int       is_end_of_chunk; // For the parse-thread queues
+} record_batch_t;
+
+typedef struct _pipeline_reader_state_t {
+	slls_t*         pfilenames; // Null for no input; empty for standard input
+	lrec_reader_t*  plrec_reader;
+	context_t       ctx;
+	cli_opts_t*     popts;
+	batch_queue_t** poutput_queues; // Round-robin
+	int             num_output_queues;
+	long long       num_batches_output;
+	int*            pstop;
+} pipeline_reader_state_t;
+
+typedef struct _pipeline_parser_state_t {
+	lrec_reader_t* plrec_reader;
+	sllv_t*        pchunks;
+	int            parser_index;
+	int            num_parsers;
+	context_t      ctx;
+	batch_queue_t* poutput_queue;
+	int*           pstop;
+} pipeline_parser_state_t;
+
+typedef struct _pipeline_mapper_state_t {
+	sllv_t*        pmapper_list; // This thread's instances of the stateless prefix of the chain
+	char**         argv_copy;    // What they were parsed from
+	batch_queue_t* pinput_queue;
+	batch_queue_t* poutput_queue;
+	int*           pstop;
+} pipeline_mapper_state_t;
+
+typedef struct _pipeline_writer_state_t {
+	lrec_writer_t* plrec_writer;
+	FILE*          output_stream;
+	context_t      ctx;
+	batch_queue_t* pinput_queue;
+} pipeline_writer_state_t;
+
+static record_batch_t* record_batch_alloc(context_t* pctx);
+static void record_batch_free(record_batch_t* pbatch);
+static void* pipeline_reader_thread(void* pvstate);
+static void pipeline_reader_put(pipeline_reader_state_t* pstate, record_batch_t* pbatch);
+static void pipeline_read_file(char* filename, char* display_name, pipeline_reader_state_t* pstate);
+static void pipeline_read_chunks(sllv_t* pchunks, pipeline_reader_state_t* pstate,
+	progress_indicator_t* pindicator);
+static void* pipeline_parser_thread(void* pvstate);
+static void* pipeline_stateless_mapper_thread(void* pvstate);
+static void pipeline_map_batches(context_t* pctx, sllv_t* pmapper_list, sllve_t* pfirst_mapper_node,
+	batch_queue_t** pinput_queues, int num_input_queues, batch_queue_t* poutput_queue, int* pstop);
+static void pipeline_map_batch_at_once(record_batch_t* pinbatch, context_t* pctx, sllve_t* pmapper_node,
+	record_batch_t* poutbatch);
+static void batch_queue_flush_func(sllv_t* poutrecs, context_t* pctx, void* pvsink);
+static void* pipeline_writer_thread(void* pvstate);
+static void pipeline_thread_create_or_die(pthread_t* pthread, void* (*pfunc)(void*), void* pvstate);
+
+// ----------------------------------------------------------------
+static int do_stream_chained_threaded(context_t* pctx, slls_t* pfilenames,
+	lrec_reader_t* plrec_reader, sllv_t* pmapper_list, lrec_writer_t* plrec_writer, FILE* output_stream,
+	cli_opts_t* popts)
+{
+	int stop = FALSE;
+	int num_stateless_mappers = popts->num_stateless_mappers;
+	int num_map_threads = num_stateless_mappers > 0 ? popts->nthreads : 0;
+	int num_reader_queues = num_map_threads > 0 ? num_map_threads : 1;
+
+	batch_queue_t** preader_queues = mlr_malloc_or_die(num_reader_queues * sizeof(batch_queue_t*));
+	for (int i = 0; i < num_reader_queues; i++)
+		preader_queues[i] = batch_queue_alloc(PIPELINE_QUEUE_CAPACITY);
+	batch_queue_t* pwriter_queue = batch_queue_alloc(PIPELINE_QUEUE_CAPACITY);
+
+	pipeline_reader_state_t reader_state = {
+		.pfilenames         = pfilenames,
+		.plrec_reader       = plrec_reader,
+		.ctx                = *pctx,
+		.popts              = popts,
+		.poutput_queues     = preader_queues,
+		.num_output_queues  = num_reader_queues,
+		.num_batches_output = 0LL,
+		.pstop              = &stop,
+	};
+	pipeline_writer_state_t writer_state = {
+		.plrec_writer  = plrec_writer,
+		.output_stream = output_stream,
+		.ctx           = *pctx,
+		.pinput_queue  = pwriter_queue,
+	};
+
+	pthread_t reader_thread;
+	pthread_t writer_thread;
+	pipeline_thread_create_or_die(&reader_thread, pipeline_reader_thread, &reader_state);
+	pipeline_thread_create_or_die(&writer_thread, pipeline_writer_thread, &writer_state);
+
+	// The calling thread runs the mapper chain, or what's left of it after the stateless prefix.
+	sllve_t* pfirst_mapper_node = pmapper_list->phead;
+	batch_queue_t** pmap_input_queues = preader_queues;
+	pthread_t* map_threads = NULL;
+	pipeline_mapper_state_t* map_states = NULL;
+	if (num_map_threads > 0) {
+		for (int i = 0; i < num_stateless_mappers; i++)
+			pfirst_mapper_node = pfirst_mapper_node->pnext;
+		pmap_input_queues = mlr_malloc_or_die(num_map_threads * sizeof(batch_queue_t*));
+		map_threads = mlr_malloc_or_die(num_map_threads * sizeof(pthread_t));
+		map_states = mlr_malloc_or_die(num_map_threads * sizeof(pipeline_mapper_state_t));
+		for (int i = 0; i < num_map_threads; i++) {
+			pmap_input_queues[i] = batch_queue_alloc(PIPELINE_QUEUE_CAPACITY);
+			char** argv_copy = NULL;
+			sllv_t* pstateless_mapper_list = cli_parse_stateless_mappers(popts, &argv_copy);
+			map_states[i] = (pipeline_mapper_state_t) {
+				.pmapper_list  = pstateless_mapper_list,
+				.argv_copy     = argv_copy,
+				.pinput_queue  = preader_queues[i],
+				.poutput_queue = pmap_input_queues[i],
+				.pstop         = &stop,
+			};
+			pipeline_thread_create_or_die(&map_threads[i], pipeline_stateless_mapper_thread, &map_states[i]);
+		}
+	}
+
+	pipeline_map_batches(pctx, pmapper_list, pfirst_mapper_node, pmap_input_queues, num_reader_queues,
+		pwriter_queue, &stop);
+
+	pthread_join(reader_thread, NULL);
+	pthread_join(writer_thread, NULL);
+	if (num_map_threads > 0) {
+		for (int i = 0; i < num_map_threads; i++) {
+			pthread_join(map_threads[i], NULL);
+			mapper_chain_free(map_states[i].pmapper_list, pctx);
+			cli_argv_copy_free(popts, map_states[i].argv_copy);
+			batch_queue_free(pmap_input_queues[i]);
+		}
+		free(map_states);
+		free(map_threads);
+		free(pmap_input_queues);
+	}
+
+	for (int i = 0; i < num_reader_queues; i++)
+		batch_queue_free(preader_queues[i]);
+	free(preader_queues);
+	batch_queue_free(pwriter_queue);
+	return 1;
+}
+
+// ----------------------------------------------------------------
+static record_batch_t* record_batch_alloc(context_t* pctx) {
+	record_batch_t* pbatch = mlr_malloc_or_die(sizeof(record_batch_t));
+	pbatch->precords = sllv_alloc();
+	pbatch->ctx = *pctx;
+	pbatch->is_end_of_chunk = FALSE;
+	return pbatch;
+}
+
+// Frees the list but not the records, which have been passed along to the next stage.
+static void record_batch_free(record_batch_t* pbatch) {
+	sllv_free(pbatch->precords);
+	free(pbatch);
+}
+
+// ----------------------------------------------------------------
+static void* pipeline_reader_thread(void* pvstate) {
+	pipeline_reader_state_t* pstate = pvstate;
+
+	if (pstate->pfilenames == NULL) {
+		// No input at all
+	} else if (pstate->pfilenames->length == 0) {
+		// Zero file names means read from standard input
+		pipeline_read_file("-", "(stdin)", pstate);
+	} else {
+		for (sllse_t* pe = pstate->pfilenames->phead; pe != NULL; pe = pe->pnext) {
+			if (__atomic_load_n(pstate->pstop, __ATOMIC_ACQUIRE)) // e.g. mlr head
+				break;
+			pipeline_read_file(pe->value, pe->value, pstate);
+		}
+	}
+
+	for (int i = 0; i < pstate->num_output_queues; i++)
+		batch_queue_close(pstate->poutput_queues[i]);
+	return NULL;
+}
+
+static void pipeline_reader_put(pipeline_reader_state_t* pstate, record_batch_t* pbatch) {
+	batch_queue_put(pstate->poutput_queues[pstate->num_batches_output % pstate->num_output_queues], pbatch);
+	pstate->num_batches_output++;
+}
+
+static void pipeline_read_file(char* filename, char* display_name, pipeline_reader_state_t* pstate) {
+	context_t* pctx = &pstate->ctx;
+	lrec_reader_t* plrec_reader = pstate->plrec_reader;
+	cli_opts_t* popts = pstate->popts;
+
+	pctx->filenum++;
+	pctx->filename = display_name;
+	pctx->fnr = 0;
+
+	void* pvhandle = plrec_reader->popen_func(plrec_reader->pvstate, popts->reader_opts.prepipe, filename);
+	progress_indicator_t* pindicator = popts->nr_progress_mod == 0LL
+		? null_progress_indicator
+		: stderr_progress_indicator;
+
+	// Start-of-file hook, e.g. expecting CSV headers on input.
+	plrec_reader->psof_func(plrec_reader->pvstate, pvhandle);
+
+	if (plrec_reader->psplit_func != NULL) {
+		sllv_t* pchunks = plrec_reader->psplit_func(plrec_reader->pvstate, pvhandle, pctx, PIPELINE_CHUNK_SIZE);
+		if (pchunks != NULL) {
+			pipeline_read_chunks(pchunks, pstate, pindicator);
+			sllv_free(pchunks);
+			plrec_reader->pclose_func(plrec_reader->pvstate, pvhandle, popts->reader_opts.prepipe);
+			return;
+		}
+	}
+
+	record_batch_t* pbatch = record_batch_alloc(pctx);
+	while (1) {
+		lrec_t* pinrec = plrec_reader->pprocess_func(plrec_reader->pvstate, pvhandle, pctx);
+		if (pinrec == NULL)
+			break;
+		if (__atomic_load_n(pstate->pstop, __ATOMIC_ACQUIRE)) { // e.g. mlr head
+			lrec_free(pinrec);
+			break;
+		}
+		pctx->nr++;
+		pctx->fnr++;
+
+		pindicator(pctx, popts->nr_progress_mod);
+
+		sllv_append(pbatch->precords, pinrec);
+		if (pbatch->precords->length >= PIPELINE_BATCH_SIZE) {
+			// The reader may have autodetected the line terminator while reading this batch.
+			pbatch->ctx.auto_line_term = pctx->auto_line_term;
+			pbatch->ctx.auto_line_term_detected = pctx->auto_line_term_detected;
+			pipeline_reader_put(pstate, pbatch);
+			pbatch = record_batch_alloc(pctx);
+		}
+	}
+	pbatch->ctx.auto_line_term = pctx->auto_line_term;
+	pbatch->ctx.auto_line_term_detected = pctx->auto_line_term_detected;
+	pipeline_reader_put(pstate, pbatch);
+
+	plrec_reader->pclose_func(plrec_reader->pvstate, pvhandle, popts->reader_opts.prepipe);
+}
+
+// ----------------------------------------------------------------
+static void pipeline_read_chunks(sllv_t* pchunks, pipeline_reader_state_t* pstate,
+	progress_indicator_t* pindicator)
+{
+	context_t* pctx = &pstate->ctx;
+	int num_parsers = pstate->popts->nthreads;
+	pthread_t* parser_threads = mlr_malloc_or_die(num_parsers * sizeof(pthread_t));
+	pipeline_parser_state_t* parser_states = mlr_malloc_or_die(num_parsers * sizeof(pipeline_parser_state_t));
+
+	for (int i = 0; i < num_parsers; i++) {
+		parser_states[i] = (pipeline_parser_state_t) {
+			.plrec_reader  = pstate->plrec_reader,
+			.pchunks       = pchunks,
+			.parser_index  = i,
+			.num_parsers   = num_parsers,
+			.ctx           = *pctx,
+			.poutput_queue = batch_queue_alloc(PIPELINE_QUEUE_CAPACITY),
+			.pstop         = pstate->pstop,
+		};
+		pipeline_thread_create_or_die(&parser_threads[i], pipeline_parser_thread, &parser_states[i]);
+	}
+
+	// Each parse thread ends each of its chunks with an end-of-chunk batch, even when
+	// stopping early, so the chunk count tells us how many of those to wait for.
+	for (long long chunk_index = 0; chunk_index < pchunks->length; ) {
+		record_batch_t* pbatch = batch_queue_get(parser_states[chunk_index % num_parsers].poutput_queue);
+		MLR_INTERNAL_CODING_ERROR_IF(pbatch == NULL);
+		if (pbatch->is_end_of_chunk)
+			chunk_index++;
+
+		// Parse threads may autodetect the line terminator; the first chunk to see it wins.
+		if (pbatch->ctx.auto_line_term_detected)
+			context_set_autodetected_line_term(pctx, pbatch->ctx.auto_line_term);
+
+		if (pbatch->precords->length == 0) {
+			record_batch_free(pbatch);
+			continue;
+		}
+		if (__atomic_load_n(pstate->pstop, __ATOMIC_ACQUIRE)) { // e.g. mlr head
+			for (sllve_t* pe = pbatch->precords->phead; pe != NULL; pe = pe->pnext)
+				lrec_free(pe->pvvalue);
+			record_batch_free(pbatch);
+			continue;
+		}
+
+		pbatch->ctx = *pctx;
+		pbatch->is_end_of_chunk = FALSE;
+		for (sllve_t* pe = pbatch->precords->phead; pe != NULL; pe = pe->pnext) {
+			pctx->nr++;
+			pctx->fnr++;
+			pindicator(pctx, pstate->popts->nr_progress_mod);
+		}
+		pipeline_reader_put(pstate, pbatch);
+	}
+
+	// As in the serial case, every file ends with a batch (here always empty) so
+	// that FILENAME/FILENUM advance for files with no records.
+	pipeline_reader_put(pstate, record_batch_alloc(pctx));
+
+	for (int i = 0; i < num_parsers; i++) {
+		pthread_join(parser_threads[i], NULL);
+		batch_queue_free(parser_states[i].poutput_queue);
+	}
+	free(parser_states);
+	free(parser_threads);
+}
+
+// ----------------------------------------------------------------
+// Parses every num_parsers'th chunk, starting at parser_index. NR and FNR aren't known here;
+// they're assigned by the sequencer in pipeline_read_chunks.
+static void* pipeline_parser_thread(void* pvstate) {
+	pipeline_parser_state_t* pstate = pvstate;
+	lrec_reader_t* plrec_reader = pstate->plrec_reader;
+
+	long long chunk_index = 0;
+	for (sllve_t* pe = pstate->pchunks->phead; pe != NULL; pe = pe->pnext, chunk_index++) {
+		if (chunk_index % pstate->num_parsers != pstate->parser_index)
+			continue;
+		void* pvchunk = pe->pvvalue;
+
+		record_batch_t* pbatch = record_batch_alloc(&pstate->ctx);
+		while (!__atomic_load_n(pstate->pstop, __ATOMIC_ACQUIRE)) { // e.g. mlr head
+			lrec_t* pinrec = plrec_reader->pprocess_chunk_func(plrec_reader->pvstate, pvchunk, &pstate->ctx);
+			if (pinrec == NULL)
+				break;
+			sllv_append(pbatch->precords, pinrec);
+			if (pbatch->precords->length >= PIPELINE_BATCH_SIZE) {
+				pbatch->ctx = pstate->ctx;
+				batch_queue_put(pstate->poutput_queue, pbatch);
+				pbatch = record_batch_alloc(&pstate->ctx);
+			}
+		}
+		pbatch->ctx = pstate->ctx;
+		pbatch->is_end_of_chunk = TRUE;
+		batch_queue_put(pstate->poutput_queue, pbatch);
+
+		free(pvchunk);
+	}
+	return NULL;
+}
+
+// ----------------------------------------------------------------
+// Each output batch has one entry per input record: the mapped record, or null if the
+// record was dropped.
+static void* pipeline_stateless_mapper_thread(void* pvstate) {
+	pipeline_mapper_state_t* pstate = pvstate;
+	// For a first mapper which selects records a batch at a time (see mapper_select_batch_func_t).
+	mapper_t* pfirst_mapper = pstate->pmapper_list->phead->pvvalue;
+	lrec_t** precords = NULL;
+	char* pverdicts = NULL;
+	if (pfirst_mapper->pselect_batch_func != NULL) {
+		precords  = mlr_malloc_or_die(PIPELINE_BATCH_SIZE * sizeof(lrec_t*));
+		pverdicts = mlr_malloc_or_die(PIPELINE_BATCH_SIZE);
+	}
+
+	record_batch_t* pinbatch;
+	while ((pinbatch = batch_queue_get(pstate->pinput_queue)) != NULL) {
+		context_t ctx = pinbatch->ctx;
+		record_batch_t* poutbatch = record_batch_alloc(&ctx);
+		if (__atomic_load_n(pstate->pstop, __ATOMIC_ACQUIRE)) { // e.g. mlr head later in the chain
+			for (sllve_t* pe = pinbatch->precords->phead; pe != NULL; pe = pe->pnext)
+				lrec_free(pe->pvvalue);
+		} else {
+			if (pfirst_mapper->pselect_batch_func != NULL) {
+				int num_records = 0;
+				for (sllve_t* pe = pinbatch->precords->phead; pe != NULL; pe = pe->pnext)
+					precords[num_records++] = pe->pvvalue;
+				pfirst_mapper->pselect_batch_func(precords, num_records, pverdicts, pfirst_mapper->pvstate);
+			}
+			int i = 0;
+			for (sllve_t* pe = pinbatch->precords->phead; pe != NULL; pe = pe->pnext, i++) {
+				ctx.nr++;
+				ctx.fnr++;
+				lrec_t* poutrec = NULL;
+				sllve_t* pmapper_node = pstate->pmapper_list->phead;
+				if (pfirst_mapper->pselect_batch_func != NULL && pverdicts[i] != MAPPER_SELECT_UNDECIDED) {
+					if (pverdicts[i] == MAPPER_SELECT_DROP) {
+						lrec_free(pe->pvvalue);
+						sllv_append(poutbatch->precords, NULL);
+						continue;
+					}
+					pmapper_node = pmapper_node->pnext;
+					if (pmapper_node == NULL) {
+						sllv_append(poutbatch->precords, pe->pvvalue);
+						continue;
+					}
+				}
+				sllv_t* poutrecs = chain_map(pe->pvvalue, &ctx, pmapper_node);
+				if (poutrecs != NULL) {
+					MLR_INTERNAL_CODING_ERROR_IF(poutrecs->length > 1);
+					if (poutrecs->length == 1)
+						poutrec = poutrecs->phead->pvvalue;
+					sllv_free(poutrecs);
+				}
+				sllv_append(poutbatch->precords, poutrec);
+			}
+		}
+		record_batch_free(pinbatch);
+		batch_queue_put(pstate->poutput_queue, poutbatch);
+	}
+
+	free(precords);
+	free(pverdicts);
+	batch_queue_close(pstate->poutput_queue);
+	return NULL;
+}
+
+// ----------------------------------------------------------------
+// Records are run through the mapper chain from pfirst_mapper_node on, with null records
+// being placeholders for ones dropped earlier in the chain by the stateless-mapper threads.
+// The end-of-stream notification goes through the full chain.
+static void pipeline_map_batches(context_t* pctx, sllv_t* pmapper_list, sllve_t* pfirst_mapper_node,
+	batch_queue_t** pinput_queues, int num_input_queues, batch_queue_t* poutput_queue, int* pstop)
+{
+	mapper_t* pbatch_mapper = pfirst_mapper_node == NULL ? NULL : pfirst_mapper_node->pvvalue;
+	if (pbatch_mapper != NULL && pbatch_mapper->pprocess_batch_func == NULL)
+		pbatch_mapper = NULL;
+
+	record_batch_t* pinbatch;
+	long long batch_index = 0LL;
+	while ((pinbatch = batch_queue_get(pinput_queues[batch_index++ % num_input_queues])) != NULL) {
+		if (pctx->force_eof) { // e.g. mlr head; discard the rest of the reader's read-ahead
+			for (sllve_t* pe = pinbatch->precords->phead; pe != NULL; pe = pe->pnext)
+				lrec_free(pe->pvvalue);
+			record_batch_free(pinbatch);
+			continue;
+		}
+
+		pctx->nr                      = pinbatch->ctx.nr;
+		pctx->fnr                     = pinbatch->ctx.fnr;
+		pctx->filenum                 = pinbatch->ctx.filenum;
+		pctx->filename                = pinbatch->ctx.filename;
+		pctx->auto_line_term          = pinbatch->ctx.auto_line_term;
+		pctx->auto_line_term_detected = pinbatch->ctx.auto_line_term_detected;
+
+		record_batch_t* poutbatch = record_batch_alloc(pctx);
+		if (pbatch_mapper != NULL)
+			pipeline_map_batch_at_once(pinbatch, pctx, pfirst_mapper_node, poutbatch);
+		else for (sllve_t* pe = pinbatch->precords->phead; pe != NULL; pe = pe->pnext) {
+			lrec_t* pinrec = pe->pvvalue;
+			if (pctx->force_eof) {
+				lrec_free(pinrec);
+				continue;
+			}
+			pctx->nr++;
+			pctx->fnr++;
+			if (pinrec == NULL)
+				continue;
+			if (pfirst_mapper_node == NULL) { // The whole chain is stateless
+				sllv_append(poutbatch->precords, pinrec);
+				continue;
+			}
+			sllv_t* poutrecs = chain_map(pinrec, pctx, pfirst_mapper_node);
+			if (poutrecs != NULL) {
+				for (sllve_t* pf = poutrecs->phead; pf != NULL; pf = pf->pnext)
+					if (pf->pvvalue != NULL)
+						sllv_append(poutbatch->precords, pf->pvvalue);
+				sllv_free(poutrecs);
+			}
+		}
+		record_batch_free(pinbatch);
+
+		if (pctx->force_eof)
+			__atomic_store_n(pstop, TRUE, __ATOMIC_RELEASE);
+
+		batch_queue_put(poutput_queue, poutbatch);
+	}
+
+	// Mappers and writers receive end-of-stream notifications via null input record.
+	// Do that, now that data from all input file(s) have been exhausted.
+	sllv_t* poutrecs = sllv_alloc();
+	chain_map_end_of_stream(NULL, pctx, pmapper_list->phead, poutrecs, batch_queue_flush_func, poutput_queue);
+	batch_queue_flush_func(poutrecs, pctx, poutput_queue);
+	sllv_free(poutrecs);
+	batch_queue_close(poutput_queue);
+}
+
+// As the loop in pipeline_map_batches, when the first mapper there can map a batch of records at
+// once (see mapper_process_batch_func_t). Each record's NR and FNR are saved, and restored when
+// its output goes down the rest of the chain. A batch is all from one file, so FILENAME and
+// FILENUM are the same throughout.
+static void pipeline_map_batch_at_once(record_batch_t* pinbatch, context_t* pctx, sllve_t* pmapper_node,
+	record_batch_t* poutbatch)
+{
+	mapper_t* pmapper = pmapper_node->pvvalue;
+	lrec_t*    precords[PIPELINE_BATCH_SIZE];
+	long long  pnrs[PIPELINE_BATCH_SIZE];
+	long long  pfnrs[PIPELINE_BATCH_SIZE];
+	sllv_t*    pout_recs[PIPELINE_BATCH_SIZE];
+	int num_records = 0;
+	for (sllve_t* pe = pinbatch->precords->phead; pe != NULL; pe = pe->pnext) {
+		pctx->nr++;
+		pctx->fnr++;
+		if (pe->pvvalue == NULL)
+			continue;
+		precords[num_records] = pe->pvvalue;
+		pnrs[num_records]     = pctx->nr;
+		pfnrs[num_records]    = pctx->fnr;
+		num_records++;
+	}
+	if (num_records > 0)
+		pmapper->pprocess_batch_func(precords, num_records, pout_recs, pmapper->pvstate);
+
+	long long read_nr  = pctx->nr;
+	long long read_fnr = pctx->fnr;
+	for (int i = 0; i < num_records; i++) {
+		if (!pctx->force_eof) { // else NR and FNR stay at the record which ended the stream
+			pctx->nr  = pnrs[i];
+			pctx->fnr = pfnrs[i];
+		}
+		for (sllve_t* pe = pout_recs[i]->phead; pe != NULL; pe = pe->pnext) {
+			lrec_t* poutrec = pe->pvvalue;
+			if (pctx->force_eof) { // e.g. mlr head
+				lrec_free(poutrec);
+			} else if (pmapper_node->pnext == NULL) {
+				sllv_append(poutbatch->precords, poutrec);
+			} else {
+				sllv_t* pnextrecs = chain_map(poutrec, pctx, pmapper_node->pnext);
+				if (pnextrecs != NULL) {
+					for (sllve_t* pf = pnextrecs->phead; pf != NULL; pf = pf->pnext)
+						if (pf->pvvalue != NULL)
+							sllv_append(poutbatch->precords, pf->pvvalue);
+					sllv_free(pnextrecs);
+				}
+			}
+		}
+		sllv_free(pout_recs[i]);
+	}
+	if (!pctx->force_eof) {
+		pctx->nr  = read_nr;
+		pctx->fnr = read_fnr;
+	}
+}
+
+static void batch_queue_flush_func(sllv_t* poutrecs, context_t* pctx, void* pvsink) {
+	record_batch_t* poutbatch = record_batch_alloc(pctx);
+	sllv_transfer(poutbatch->precords, poutrecs);
+	batch_queue_put(pvsink, poutbatch);
+}
+
+// ----------------------------------------------------------------
+static void* pipeline_writer_thread(void* pvstate) {
+	pipeline_writer_state_t* pstate = pvstate;
+	lrec_writer_t* plrec_writer = pstate->plrec_writer;
+
+	record_batch_t* pbatch;
+	while ((pbatch = batch_queue_get(pstate->pinput_queue)) != NULL) {
+		pstate->ctx = pbatch->ctx;
+		// Writer frees records (sllv void-star payload)
+		for (sllve_t* pe = pbatch->precords->phead; pe != NULL; pe = pe->pnext)
+			plrec_writer->pprocess_func(plrec_writer->pvstate, pstate->output_stream, pe->pvvalue, &pstate->ctx);
+		record_batch_free(pbatch);
+	}
+
+	// Drain the pretty-printer.
+	plrec_writer->pprocess_func(plrec_writer->pvstate, pstate->output_stream, NULL, &pstate->ctx);
+	return NULL;
+}
+
+// ----------------------------------------------------------------
+static void pipeline_thread_create_or_die(pthread_t* pthread, void* (*pfunc)(void*), void* pvstate) {
+	int rc = pthread_create(pthread, NULL, pfunc, pvstate);
+	if (rc != 0) {
+		fprintf(stderr, "%s: could not create thread: %s\n", MLR_GLOBALS.bargv0, strerror(rc));
+		exit(1);
+	}
+}
+
 // ----------------------------------------------------------------
 static void stderr_progress_indicator(context_t* pctx, long long nr_progress_mod) {
 	long long remainder = pctx->nr % nr_progress_mod;
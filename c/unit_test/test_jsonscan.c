@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <string.h>
+#include "lib/minunit.h"
+#include "lib/mlr_globals.h"
+#include "lib/mlrutil.h"
+#include "lib/mtrand.h"
+#include "lib/sepscan.h"
+#include "lib/jsonscan.h"
+
+int tests_run         = 0;
+int tests_failed      = 0;
+int assertions_run    = 0;
+int assertions_failed = 0;
+
+#define MAX_BLOCKS 4
+#define MAX_SIZE (MAX_BLOCKS * JSONSCAN_BLOCK_SIZE)
+
+// ----------------------------------------------------------------
+// Byte-at-a-time statement of what the kernels compute. Escapes are tracked outside strings as
+// well as within them, as the kernels do: a backslash there is malformed JSON anyway.
+static int reference_index(char* p, int size, unsigned* pindex) {
+	int n = 0;
+	int in_string = FALSE, escaped = FALSE, in_scalar = FALSE;
+	for (int i = 0; i < size; i++) {
+		char c = p[i];
+		int was_escaped = escaped;
+		escaped = (c == '\\') && !was_escaped;
+		if (c == '"' && !was_escaped) {
+			pindex[n++] = i;
+			in_string = !in_string;
+			in_scalar = FALSE;
+		} else if (in_string) {
+			in_scalar = FALSE;
+		} else if (strchr("{}[]:,", c) != NULL && c != 0) {
+			pindex[n++] = i;
+			in_scalar = FALSE;
+		} else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+			in_scalar = FALSE;
+		} else {
+			if (!in_scalar)
+				pindex[n++] = i;
+			in_scalar = TRUE;
+		}
+	}
+	return n;
+}
+
+// Runs the kernel over the whole buffer at once, and then a block at a time, and compares both
+// against the reference.
+static int check_kernel_on(jsonscan_index_func_t* pfunc, char* p, int nblocks) {
+	unsigned expected[MAX_SIZE];
+	unsigned actual[MAX_SIZE];
+	int nexpected = reference_index(p, nblocks * JSONSCAN_BLOCK_SIZE, expected);
+
+	jsonscan_state_t state;
+	jsonscan_state_init(&state);
+	int nactual = pfunc(p, nblocks, &state, actual);
+	if (nactual != nexpected || memcmp(actual, expected, nexpected * sizeof(unsigned)) != 0)
+		return FALSE;
+
+	jsonscan_state_init(&state);
+	nactual = 0;
+	for (int b = 0; b < nblocks; b++) {
+		int m = pfunc(p + b * JSONSCAN_BLOCK_SIZE, 1, &state, &actual[nactual]);
+		for (int i = 0; i < m; i++)
+			actual[nactual + i] += b * JSONSCAN_BLOCK_SIZE;
+		nactual += m;
+	}
+	if (nactual != nexpected || memcmp(actual, expected, nexpected * sizeof(unsigned)) != 0)
+		return FALSE;
+
+	return TRUE;
+}
+
+// Random input from an alphabet heavy in quotes and backslashes, so that escapes and strings
+// often straddle vector-width and block boundaries.
+static int check_kernel(jsonscan_index_func_t* pfunc) {
+	char* alphabet = "\"\"\\\\\\{}[]:, \n\tax1-\x80\xff";
+	int alphabet_length = strlen(alphabet);
+	char buf[MAX_SIZE];
+	mtrand_init(1);
+	for (int trial = 0; trial < 2000; trial++) {
+		int nblocks = 1 + trial % MAX_BLOCKS;
+		for (int i = 0; i < nblocks * JSONSCAN_BLOCK_SIZE; i++)
+			buf[i] = alphabet[get_mtrand_int32() % alphabet_length];
+		if (!check_kernel_on(pfunc, buf, nblocks))
+			return FALSE;
+	}
+
+	// Runs of backslashes of various lengths, starting at every offset up to past a block boundary.
+	for (int start = 1; start <= 2 * JSONSCAN_BLOCK_SIZE; start++) {
+		for (int length = 1; length <= JSONSCAN_BLOCK_SIZE + 8; length++) {
+			memset(buf, 'x', sizeof(buf));
+			buf[0] = '"';
+			memset(&buf[start], '\\', length);
+			buf[start + length] = '"';
+			buf[start + length + 2] = '"';
+			if (!check_kernel_on(pfunc, buf, MAX_BLOCKS))
+				return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static char * test_kernels() {
+	mu_assert_lf(check_kernel(jsonscan_index_scalar));
+	if (sepscan_have_sse2())
+		mu_assert_lf(check_kernel(jsonscan_index_sse2));
+	if (sepscan_have_avx2())
+		mu_assert_lf(check_kernel(jsonscan_index_avx2));
+	return 0;
+}
+
+// ----------------------------------------------------------------
+static char * test_index() {
+	char buf[JSONSCAN_BLOCK_SIZE];
+	char* s = "{\"a\\\"{\":[-12, true],\"b\":\"\\\\\"}";
+	memset(buf, ' ', sizeof(buf));
+	memcpy(buf, s, strlen(s));
+
+	unsigned index[JSONSCAN_BLOCK_SIZE];
+	unsigned expected[] = { 0, 1, 6, 7, 8, 9, 12, 14, 18, 19, 20, 22, 23, 24, 27, 28 };
+	int nexpected = sizeof(expected) / sizeof(expected[0]);
+	jsonscan_state_t state;
+	jsonscan_state_init(&state);
+	mu_assert_lf(jsonscan_index(buf, 1, &state, index) == nexpected);
+	mu_assert_lf(memcmp(index, expected, sizeof(expected)) == 0);
+	return 0;
+}
+
+// ================================================================
+static char * all_tests() {
+	mu_run_test(test_kernels);
+	mu_run_test(test_index);
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	mlr_global_init(argv[0], NULL);
+	printf("TEST_JSONSCAN ENTER\n");
+	char *result = all_tests();
+	printf("\n");
+	if (result != 0) {
+		printf("Not all unit tests passed\n");
+	}
+	else {
+		printf("TEST_JSONSCAN: ALL UNIT TESTS PASSED\n");
+	}
+	printf("Tests      passed: %d of %d\n", tests_run - tests_failed, tests_run);
+	printf("Assertions passed: %d of %d\n", assertions_run - assertions_failed, assertions_run);
+
+	return result != 0;
+}
@@ -6,6 +6,7 @@
 #include "containers/lrec.h"
 #include "containers/sllv.h"
 #include "input/lrec_readers.h"
+#include "input/json_streaming_parser.h"
 
 int tests_run         = 0;
 int tests_failed      = 0;
@@ -401,6 +402,225 @@ static char* test_lrec_put_after() {
 	return NULL;
 }
 
+// ----------------------------------------------------------------
+// Enough fields, and a long enough value, to spill past the record's first arena chunk.
+static char* test_lrec_arena() {
+	char key[32];
+	char big[10000];
+	memset(big, 'x', sizeof(big) - 1);
+	big[sizeof(big) - 1] = 0;
+
+	lrec_t* prec = lrec_unbacked_alloc();
+	for (int i = 0; i < 500; i++) {
+		sprintf(key, "k%d", i);
+		lrec_put(prec, lrec_strdup(prec, key), lrec_strdup(prec, key), NO_FREE);
+	}
+	lrec_put(prec, "big", lrec_strdup(prec, big), NO_FREE);
+	lrec_put(prec, "owned", mlr_strdup_or_die("v"), FREE_ENTRY_VALUE);
+	mu_assert_lf(prec->field_count == 502);
+	mu_assert_lf(streq(lrec_get(prec, "k0"), "k0"));
+	mu_assert_lf(streq(lrec_get(prec, "k499"), "k499"));
+	mu_assert_lf(streq(lrec_get(prec, "big"), big));
+	mu_assert_lf(streq(lrec_get(prec, "owned"), "v"));
+
+	// Removed entries are reused by later puts.
+	lrece_t* pe = NULL;
+	lrec_get_ext(prec, "k7", &pe);
+	lrec_remove(prec, "k7");
+	lrec_put(prec, "new", "1", NO_FREE);
+	mu_assert_lf(prec->ptail == pe);
+	mu_assert_lf(prec->field_count == 502);
+
+	lrec_t* pcopy = lrec_copy(prec);
+	lrec_clear(prec);
+	mu_assert_lf(prec->field_count == 0);
+	lrec_put(prec, "a", "1", NO_FREE);
+	mu_assert_lf(streq(lrec_get(prec, "a"), "1"));
+	lrec_free(prec);
+
+	mu_assert_lf(pcopy->field_count == 502);
+	mu_assert_lf(streq(lrec_get(pcopy, "big"), big));
+	mu_assert_lf(streq(lrec_get(pcopy, "new"), "1"));
+	lrec_free(pcopy);
+
+	return NULL;
+}
+
+// ----------------------------------------------------------------
+// Small records are held in small chunks, since verbs such as tac retain every one.
+static char* test_lrec_arena_small_records() {
+	lrec_t* prec = lrec_unbacked_alloc_for_fields(5);
+	lrec_put(prec, "a", "pan", NO_FREE);
+	lrec_put(prec, "b", "wye", NO_FREE);
+	lrec_put(prec, "i", "1", NO_FREE);
+	lrec_put(prec, "x", "0.3467901443380824", NO_FREE);
+	lrec_put(prec, "y", "0.7268028627434533", NO_FREE);
+	mu_assert_lf(lrec_memory_size(prec) < 512);
+	lrec_t* pcopy = lrec_copy(prec);
+	mu_assert_lf(lrec_memory_size(pcopy) < 1024);
+	lrec_free(pcopy);
+	lrec_free(prec);
+
+	prec = lrec_unbacked_alloc_for_line_length(strlen("a=pan,b=wye,i=1,x=0.3467901443380824,y=0.7268028627434533"));
+	lrec_put(prec, "a", "pan", NO_FREE);
+	lrec_put(prec, "b", "wye", NO_FREE);
+	lrec_put(prec, "i", "1", NO_FREE);
+	lrec_put(prec, "x", "0.3467901443380824", NO_FREE);
+	lrec_put(prec, "y", "0.7268028627434533", NO_FREE);
+	mu_assert_lf(lrec_memory_size(prec) < 512);
+	lrec_free(prec);
+
+	prec = lrec_unbacked_alloc();
+	lrec_put(prec, "a", "1", NO_FREE);
+	mu_assert_lf(lrec_memory_size(prec) < 512);
+	lrec_free(prec);
+
+	return NULL;
+}
+
+// ----------------------------------------------------------------
+// Every field in the list must be findable, and the index must have exactly as many entries.
+static int lrec_index_is_consistent(lrec_t* prec) {
+	for (lrece_t* pe = prec->phead; pe != NULL; pe = pe->pnext) {
+		lrece_t* pf = NULL;
+		lrec_get_ext(prec, pe->key, &pf);
+		if (pf != pe)
+			return FALSE;
+	}
+	if (prec->pindex != NULL) {
+		int count = 0;
+		for (unsigned i = 0; i <= prec->index_mask; i++)
+			if (prec->pindex[i] != NULL)
+				count++;
+		if (count != prec->field_count)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static char* test_lrec_wide_index() {
+	char key[32];
+	lrec_t* prec = lrec_unbacked_alloc();
+	for (int i = 0; i < 300; i++) {
+		sprintf(key, "k%d", i);
+		lrec_put(prec, lrec_strdup(prec, key), lrec_strdup(prec, key), NO_FREE);
+	}
+	mu_assert_lf(prec->field_count == 300);
+	mu_assert_lf(prec->pindex != NULL);
+	mu_assert_lf(streq(lrec_get(prec, "k0"), "k0"));
+	mu_assert_lf(streq(lrec_get(prec, "k299"), "k299"));
+	mu_assert_lf(lrec_get(prec, "k300") == NULL);
+	mu_assert_lf(lrec_index_is_consistent(prec));
+
+	for (int i = 0; i < 300; i += 3) {
+		sprintf(key, "k%d", i);
+		lrec_remove(prec, key);
+	}
+	mu_assert_lf(prec->field_count == 200);
+	mu_assert_lf(lrec_get(prec, "k0") == NULL);
+	mu_assert_lf(streq(lrec_get(prec, "k1"), "k1"));
+	mu_assert_lf(lrec_index_is_consistent(prec));
+
+	lrec_rename(prec, "k1", "renamed", FALSE);
+	lrec_rename(prec, "k2", "k4", FALSE);
+	lrec_rename(prec, "k5", "k5", FALSE);
+	mu_assert_lf(lrec_get(prec, "k1") == NULL);
+	mu_assert_lf(streq(lrec_get(prec, "renamed"), "k1"));
+	mu_assert_lf(streq(lrec_get(prec, "k4"), "k2"));
+	mu_assert_lf(streq(lrec_get(prec, "k5"), "k5"));
+	mu_assert_lf(prec->field_count == 199);
+	mu_assert_lf(lrec_index_is_consistent(prec));
+
+	lrec_move_to_head(prec, "k299");
+	lrec_move_to_tail(prec, "renamed");
+	lrec_prepend(prec, "first", "1", NO_FREE);
+	lrece_t* pe = NULL;
+	lrec_get_ext(prec, "k100", &pe);
+	lrec_put_after(prec, pe, "after", "2", NO_FREE);
+	mu_assert_lf(streq(prec->phead->key, "first"));
+	mu_assert_lf(streq(prec->ptail->key, "renamed"));
+	mu_assert_lf(streq(pe->pnext->key, "after"));
+	mu_assert_lf(lrec_index_is_consistent(prec));
+
+	for (pe = prec->phead; pe != NULL; ) {
+		lrece_t* pnext = pe->pnext;
+		if (pe->key[0] == 'k')
+			lrec_unlink_and_free(prec, pe);
+		pe = pnext;
+	}
+	mu_assert_lf(prec->field_count == 3);
+	mu_assert_lf(streq(lrec_get(prec, "after"), "2"));
+	mu_assert_lf(lrec_get(prec, "k4") == NULL);
+	mu_assert_lf(lrec_index_is_consistent(prec));
+
+	lrec_free(prec);
+	return NULL;
+}
+
+// ----------------------------------------------------------------
+// Feeds the JSON parser one byte per read, so that every token straddles a refill.
+typedef struct _byte_at_a_time_t {
+	char* p;
+	char* end;
+} byte_at_a_time_t;
+
+static int byte_at_a_time_read(void* pvhandle, char* buffer, int size) {
+	byte_at_a_time_t* phandle = pvhandle;
+	if (phandle->p == phandle->end)
+		return 0;
+	*buffer = *phandle->p++;
+	return 1;
+}
+
+static char* test_lrec_json_streaming() {
+	char* input =
+		"\xef\xbb\xbf[ { \"a\": 1, \"b\": { \"x\": \"p\\u00e9\\ud83d\\ude00\", \"y\": { \"z\": -1.5e+3 } } },\n"
+		"  { \"a\": true, \"c\": null, \"a\": false } ]\n"
+		"{\"s\":\"tab\\there\\\"\",\"t\":[1,{\"u\":[]}]}{}";
+
+	for (int streaming = 0; streaming <= 1; streaming++) {
+		json_streaming_parser_t* pparser = json_streaming_parser_alloc(":", TRUE);
+		byte_at_a_time_t handle = { input, input + strlen(input) };
+		if (streaming)
+			json_streaming_parser_reset_streaming(pparser, byte_at_a_time_read, &handle);
+		else
+			json_streaming_parser_reset_in_memory(pparser, handle.p, handle.end);
+
+		lrec_t* prec = json_streaming_parser_next(pparser);
+		mu_assert_lf(prec != NULL);
+		mu_assert_lf(prec->field_count == 3);
+		mu_assert_lf(streq(lrec_get(prec, "a"), "1"));
+		mu_assert_lf(streq(lrec_get(prec, "b:x"), "p\xc3\xa9\xf0\x9f\x98\x80"));
+		mu_assert_lf(streq(lrec_get(prec, "b:y:z"), "-1.5e+3"));
+		lrec_free(prec);
+
+		prec = json_streaming_parser_next(pparser);
+		mu_assert_lf(prec != NULL);
+		mu_assert_lf(prec->field_count == 2);
+		mu_assert_lf(streq(prec->phead->key, "a"));
+		mu_assert_lf(streq(lrec_get(prec, "a"), "false"));
+		mu_assert_lf(streq(lrec_get(prec, "c"), ""));
+		lrec_free(prec);
+
+		prec = json_streaming_parser_next(pparser);
+		mu_assert_lf(prec != NULL);
+		mu_assert_lf(prec->field_count == 1);
+		mu_assert_lf(streq(lrec_get(prec, "s"), "tab\there\""));
+		lrec_free(prec);
+
+		prec = json_streaming_parser_next(pparser);
+		mu_assert_lf(prec != NULL);
+		mu_assert_lf(prec->field_count == 0);
+		lrec_free(prec);
+
+		mu_assert_lf(json_streaming_parser_next(pparser) == NULL);
+		mu_assert_lf(json_streaming_parser_next(pparser) == NULL);
+		json_streaming_parser_free(pparser);
+	}
+
+	return NULL;
+}
+
 // ================================================================
 static char * run_all_tests() {
 	mu_run_test(test_lrec_unbacked_api);
@@ -410,6 +630,10 @@ static char * run_all_tests() {
 	mu_run_test(test_lrec_csv_api_disjoint_allocs);
 	mu_run_test(test_lrec_xtab_api);
 	mu_run_test(test_lrec_put_after);
+	mu_run_test(test_lrec_arena);
+	mu_run_test(test_lrec_arena_small_records);
+	mu_run_test(test_lrec_wide_index);
+	mu_run_test(test_lrec_json_streaming);
 	return 0;
 }
 
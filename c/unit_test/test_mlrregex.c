@@ -17,7 +17,7 @@ static char * test_save_regex_captures() {
 	const size_t nmatchmax = 10;
 	regmatch_t matches[nmatchmax];
 	string_array_t* pregex_captures = NULL;
-	regex_t regex;
+	mlr_regex_t regex;
 
 	char* input  = "abcde";
 	char* sregex = "abcde";
@@ -28,7 +28,7 @@ static char * test_save_regex_captures() {
 	mu_assert_lf(pregex_captures->length == 1);
 	mu_assert_lf(pregex_captures->strings[0] != NULL);
 	mu_assert_lf(streq(pregex_captures->strings[0], "abcde"));
-	regfree(&regex);
+	mlr_regfree(&regex);
 
 	input  = "abcde";
 	sregex = "a(.*)e";
@@ -38,7 +38,7 @@ static char * test_save_regex_captures() {
 	mu_assert_lf(pregex_captures->length == 2);
 	mu_assert_lf(pregex_captures->strings[0] != NULL);
 	mu_assert_lf(streq(pregex_captures->strings[1], "bcd"));
-	regfree(&regex);
+	mlr_regfree(&regex);
 
 	input  = "abcde";
 	sregex = "a(b)(.)(d)e";
@@ -50,7 +50,7 @@ static char * test_save_regex_captures() {
 	mu_assert_lf(streq(pregex_captures->strings[1], "b"));
 	mu_assert_lf(streq(pregex_captures->strings[2], "c"));
 	mu_assert_lf(streq(pregex_captures->strings[3], "d"));
-	regfree(&regex);
+	mlr_regfree(&regex);
 
 	input  = "abcdefghij";
 	sregex = "(a)(b)(c)(d)(e)(f)(g)(h)(i)";
@@ -68,7 +68,7 @@ static char * test_save_regex_captures() {
 	mu_assert_lf(streq(pregex_captures->strings[7], "g"));
 	mu_assert_lf(streq(pregex_captures->strings[8], "h"));
 	mu_assert_lf(streq(pregex_captures->strings[9], "i"));
-	regfree(&regex);
+	mlr_regfree(&regex);
 
 	string_array_free(pregex_captures);
 
@@ -133,11 +133,82 @@ static char * test_interpolate_regex_captures() {
 	return 0;
 }
 
+// ----------------------------------------------------------------
+static char * test_regcomp_cached() {
+	regmatch_t matches[1];
+
+	mlr_regex_t* pa = regcomp_cached_or_die("a+b", 0);
+	mu_assert_lf(regcomp_cached_or_die("a+b", 0) == pa);
+	mu_assert_lf(regmatch_or_die(pa, "xaaby", 1, matches));
+
+	mlr_regex_t* pa_icase = regcomp_cached_or_die("a+b", REG_ICASE);
+	mu_assert_lf(pa_icase != pa);
+	mu_assert_lf(regmatch_or_die(pa_icase, "xAAby", 1, matches));
+	mu_assert_lf(!regmatch_or_die(pa, "xAAby", 1, matches));
+
+	// Push "a+b" out past the cache capacity while keeping "a+b"/i recently used.
+	char buf[32];
+	for (int i = 0; i < 1000; i++) {
+		sprintf(buf, "^c%d$", i);
+		mlr_regex_t* pc = regcomp_cached_or_die(buf, 0);
+		mu_assert_lf(regmatch_or_die(pc, buf+1, 1, matches) == FALSE);
+		buf[strlen(buf)-1] = 0;
+		mu_assert_lf(regmatch_or_die(pc, buf+1, 1, matches) == TRUE);
+		mu_assert_lf(regcomp_cached_or_die("a+b", REG_ICASE) == pa_icase);
+	}
+	pa = regcomp_cached_or_die("a+b", 0);
+	mu_assert_lf(regmatch_or_die(pa, "xaaby", 1, matches));
+	mu_assert_lf(!regmatch_or_die(pa, "xAAby", 1, matches));
+
+	return 0;
+}
+
+// ----------------------------------------------------------------
+// Literal, anchored-literal, and alternation-of-literals patterns are matched without regexec; the
+// results should be as from regexec on the same compiled regex.
+static char * test_literal_fast_paths() {
+	char* patterns[] = {
+		"abc", "^abc", "abc$", "^abc$", "a|ab|abc", "bc|abcd|c", "b|abc", "x\\", "^a|b", "a.c", "",
+		"ab|cd|ef", "cde|bcdef|d", "aa|aaa", "a||b", "$", "^", "^$",
+		"\xc3\xa9", "\xc3\xa9" "c", "^\xc3\xa9", "o|\xc3\xa9",
+	};
+	char* inputs[] = {
+		"", "a", "abc", "xabcx", "ABC", "xAbC", "abcd", "zabcdz", "cdef", "aaaa", "x\\y", "bcdefg",
+		"\xc3\xa9" "cole", "\xc3\xa9" "COLE", "x\xc3\xa9" "c",
+	};
+	int cflagses[] = { 0, REG_ICASE, REG_NOSUB };
+	const size_t nmatchmax = 3;
+
+	for (int i = 0; i < sizeof(patterns)/sizeof(patterns[0]); i++) {
+		for (int j = 0; j < sizeof(cflagses)/sizeof(cflagses[0]); j++) {
+			mlr_regex_t regex;
+			regcomp_or_die(&regex, patterns[i], cflagses[j]);
+			for (int k = 0; k < sizeof(inputs)/sizeof(inputs[0]); k++) {
+				regmatch_t fast_matches[nmatchmax];
+				regmatch_t regexec_matches[nmatchmax];
+				int fast_matched = regmatch_or_die(&regex, inputs[k], nmatchmax, fast_matches);
+				int regexec_matched = regexec(&regex.regex, inputs[k], nmatchmax, regexec_matches, 0) == 0;
+				mu_assert_lf(fast_matched == regexec_matched);
+				if (fast_matched && !(cflagses[j] & REG_NOSUB)) {
+					for (int m = 0; m < nmatchmax; m++) {
+						mu_assert_lf(fast_matches[m].rm_so == regexec_matches[m].rm_so);
+						mu_assert_lf(fast_matches[m].rm_eo == regexec_matches[m].rm_eo);
+					}
+				}
+			}
+			mlr_regfree(&regex);
+		}
+	}
+
+	return 0;
+}
 
 // ================================================================
 static char * all_tests() {
 	mu_run_test(test_save_regex_captures);
 	mu_run_test(test_interpolate_regex_captures);
+	mu_run_test(test_regcomp_cached);
+	mu_run_test(test_literal_fast_paths);
 	return 0;
 }
 
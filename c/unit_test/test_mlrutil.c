@@ -130,6 +130,59 @@ static char * test_scanners() {
 	mu_assert("error: mlr_alloc_string_from_double", streq(mlr_alloc_string_from_double(4.25, "%.4f"), "4.2500"));
 	mu_assert("error: mlr_alloc_string_from_ull", streq(mlr_alloc_string_from_ull(12345LL), "12345"));
 	mu_assert("error: mlr_alloc_string_from_int", streq(mlr_alloc_string_from_int(12345), "12345"));
+
+	mu_assert_lf(streq(mlr_alloc_string_from_ll(-9223372036854775807LL-1), "-9223372036854775808"));
+	mu_assert_lf(streq(mlr_alloc_string_from_ll(0LL), "0"));
+	mu_assert_lf(streq(mlr_alloc_string_from_ull(18446744073709551615ULL), "18446744073709551615"));
+	mu_assert_lf(streq(mlr_alloc_string_from_double(0.1, "%lf"), "0.100000"));
+	mu_assert_lf(streq(mlr_alloc_string_from_double(-2.5, "%lf"), "-2.500000"));
+	mu_assert_lf(streq(mlr_alloc_string_from_double(-0.0000001, "%lf"), "-0.000000"));
+	mu_assert_lf(streq(mlr_alloc_string_from_double(0.0078125, "%lf"), "0.007812")); // tie: to even
+	mu_assert_lf(streq(mlr_alloc_string_from_double(0.0234375, "%lf"), "0.023438")); // tie: to even
+	mu_assert_lf(streq(mlr_alloc_string_from_double(999999.9999996, "%lf"), "1000000.000000"));
+	mu_assert_lf(streq(mlr_alloc_string_from_double(1e15, "%lf"), "1000000000000000.000000"));
+	mu_assert_lf(streq(mlr_alloc_string_from_double(3.25, "%.3e"), "3.250e+00"));
+
+	char buf[MLR_NUMBER_FORMAT_BUFFER_SIZE];
+	mu_assert_lf(mlr_format_ll(buf, -120LL) == 4 && streq(buf, "-120"));
+	mu_assert_lf(mlr_format_double(buf, sizeof(buf), 1.5, "%lf") == 8 && streq(buf, "1.500000"));
+	return 0;
+}
+
+// ----------------------------------------------------------------
+static char * test_number_inference() {
+	long long intv;
+	double fltv;
+
+	mu_assert_lf(mlr_try_int_from_string("12345", &intv) && intv == 12345LL);
+	mu_assert_lf(mlr_try_int_from_string("-17", &intv) && intv == -17LL);
+	mu_assert_lf(mlr_try_int_from_string("0xff", &intv) && intv == 255LL);
+	mu_assert_lf(mlr_try_int_from_string("0xffffffffffffffff", &intv) && intv == -1LL);
+	mu_assert_lf(mlr_try_int_from_string("-0x10", &intv) && intv == -16LL);
+	mu_assert_lf(mlr_try_int_from_string("9223372036854775807", &intv) && intv == 9223372036854775807LL);
+	mu_assert_lf(!mlr_try_int_from_string("1.5", &intv));
+	mu_assert_lf(!mlr_try_int_from_string("300ms", &intv));
+	mu_assert_lf(!mlr_try_int_from_string("abc", &intv));
+	mu_assert_lf(!mlr_try_int_from_string("", &intv));
+
+	mu_assert_lf(mlr_try_float_from_string("1.5", &fltv) && fltv == 1.5);
+	mu_assert_lf(mlr_try_float_from_string("-0.25", &fltv) && fltv == -0.25);
+	mu_assert_lf(mlr_try_float_from_string("6.02e23", &fltv) && fltv == 6.02e23);
+	mu_assert_lf(mlr_try_float_from_string("0.1", &fltv) && fltv == 0.1);
+	mu_assert_lf(mlr_try_float_from_string("3.14159265358979323846", &fltv) && fltv == 3.14159265358979323846);
+	mu_assert_lf(mlr_try_float_from_string("1e-300", &fltv) && fltv == 1e-300);
+	mu_assert_lf(mlr_try_float_from_string(".5", &fltv) && fltv == 0.5);
+	mu_assert_lf(mlr_try_float_from_string("7", &fltv) && fltv == 7.0);
+	mu_assert_lf(!mlr_try_float_from_string("1.5x", &fltv));
+	mu_assert_lf(!mlr_try_float_from_string("pan", &fltv));
+
+	mu_assert_lf(mlr_try_int_or_float_from_string("123", &intv, &fltv) == MLR_SCANNED_INT && intv == 123LL);
+	mu_assert_lf(mlr_try_int_or_float_from_string("0xcafe", &intv, &fltv) == MLR_SCANNED_INT && intv == 0xcafeLL);
+	mu_assert_lf(mlr_try_int_or_float_from_string("1.25e2", &intv, &fltv) == MLR_SCANNED_FLOAT && fltv == 125.0);
+	mu_assert_lf(mlr_try_int_or_float_from_string("12345678901234567890", &intv, &fltv) == MLR_SCANNED_INT);
+	mu_assert_lf(mlr_try_int_or_float_from_string("wye", &intv, &fltv) == MLR_SCANNED_NEITHER);
+	mu_assert_lf(mlr_try_int_or_float_from_string("1-2", &intv, &fltv) == MLR_SCANNED_NEITHER);
+
 	return 0;
 }
 
@@ -161,6 +214,7 @@ static char * all_tests() {
 	mu_run_test(test_strdup_quoted);
 	mu_run_test(test_starts_or_ends_with);
 	mu_run_test(test_scanners);
+	mu_run_test(test_number_inference);
 	mu_run_test(test_paste);
 	mu_run_test(test_unbackslash);
 	return 0;
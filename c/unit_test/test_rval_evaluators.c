@@ -432,6 +432,184 @@ static char * test_logical_xor() {
 	return 0;
 }
 
+// ----------------------------------------------------------------
+// Evaluates the same expression with the tree-walking and bytecode evaluators over records of
+// mixed types, including absent and empty values, and checks that the results agree.
+static char * test_bytecode_vs_tree() {
+	printf("\n");
+	printf("-- TEST_RVAL_EVALUATORS test_bytecode_vs_tree ENTER\n");
+	context_t ctx = {.nr = 888, .fnr = 999, .filenum = 123, .filename = "filename-goes-here", .force_eof = FALSE,
+		.ips = "=", .ifs = ",", .irs = "\n", .ops = "=", .ofs = ",", .ors = "\n", .auto_line_term = "\n"
+	};
+	context_t* pctx = &ctx;
+
+	// ($x * 2 + $y > 3 && $s != "q") ? $x - $y * $y : strlen($s . "abc") + abs($x)
+	mlr_dsl_ast_node_t* pcond = mlr_dsl_ast_node_alloc_binary("&&", MD_AST_NODE_TYPE_OPERATOR,
+		mlr_dsl_ast_node_alloc_binary(">", MD_AST_NODE_TYPE_OPERATOR,
+			mlr_dsl_ast_node_alloc_binary("+", MD_AST_NODE_TYPE_OPERATOR,
+				mlr_dsl_ast_node_alloc_binary("*", MD_AST_NODE_TYPE_OPERATOR,
+					mlr_dsl_ast_node_alloc("x", MD_AST_NODE_TYPE_FIELD_NAME),
+					mlr_dsl_ast_node_alloc("2", MD_AST_NODE_TYPE_NUMERIC_LITERAL)),
+				mlr_dsl_ast_node_alloc("y", MD_AST_NODE_TYPE_FIELD_NAME)),
+			mlr_dsl_ast_node_alloc("3", MD_AST_NODE_TYPE_NUMERIC_LITERAL)),
+		mlr_dsl_ast_node_alloc_binary("!=", MD_AST_NODE_TYPE_OPERATOR,
+			mlr_dsl_ast_node_alloc("s", MD_AST_NODE_TYPE_FIELD_NAME),
+			mlr_dsl_ast_node_alloc("q", MD_AST_NODE_TYPE_STRING_LITERAL)));
+	mlr_dsl_ast_node_t* pthen = mlr_dsl_ast_node_alloc_binary("-", MD_AST_NODE_TYPE_OPERATOR,
+		mlr_dsl_ast_node_alloc("x", MD_AST_NODE_TYPE_FIELD_NAME),
+		mlr_dsl_ast_node_alloc_binary("*", MD_AST_NODE_TYPE_OPERATOR,
+			mlr_dsl_ast_node_alloc("y", MD_AST_NODE_TYPE_FIELD_NAME),
+			mlr_dsl_ast_node_alloc("y", MD_AST_NODE_TYPE_FIELD_NAME)));
+	mlr_dsl_ast_node_t* pelse = mlr_dsl_ast_node_alloc_binary("+", MD_AST_NODE_TYPE_OPERATOR,
+		mlr_dsl_ast_node_alloc_unary("strlen", MD_AST_NODE_TYPE_FUNCTION_CALLSITE,
+			mlr_dsl_ast_node_alloc_binary(".", MD_AST_NODE_TYPE_OPERATOR,
+				mlr_dsl_ast_node_alloc("s", MD_AST_NODE_TYPE_FIELD_NAME),
+				mlr_dsl_ast_node_alloc("abc", MD_AST_NODE_TYPE_STRING_LITERAL))),
+		mlr_dsl_ast_node_alloc_unary("abs", MD_AST_NODE_TYPE_FUNCTION_CALLSITE,
+			mlr_dsl_ast_node_alloc("x", MD_AST_NODE_TYPE_FIELD_NAME)));
+	mlr_dsl_ast_node_t* pnode = mlr_dsl_ast_node_alloc_ternary("? :", MD_AST_NODE_TYPE_OPERATOR,
+		pcond, pthen, pelse);
+
+	fmgr_t* pfmgr = fmgr_alloc();
+	rval_evaluator_t* ptree = rval_evaluator_alloc_from_ast(pnode, pfmgr, TYPE_INFER_STRING_FLOAT_INT, 0);
+	pfmgr->compile_to_bytecode = TRUE;
+	rval_evaluator_t* pbytecode = rval_evaluator_alloc_from_ast(pnode, pfmgr, TYPE_INFER_STRING_FLOAT_INT, 0);
+	fmgr_resolve_func_callsites(pfmgr);
+	fmgr_free(pfmgr, &ctx);
+
+	char* xs[] = { "1", "4", "-2.5", "", "abc", "0x10", "9223372036854775807", NULL };
+	char* ys[] = { "1", "0.5", "", "-7", NULL };
+	char* ss[] = { "q", "hello", "", NULL };
+
+	for (int i = 0; i < 8; i++) {
+		for (int j = 0; j < 5; j++) {
+			for (int k = 0; k < 4; k++) {
+				lrec_t* prec = lrec_unbacked_alloc();
+				if (xs[i] != NULL)
+					lrec_put(prec, "x", xs[i], NO_FREE);
+				if (ys[j] != NULL)
+					lrec_put(prec, "y", ys[j], NO_FREE);
+				if (ss[k] != NULL)
+					lrec_put(prec, "s", ss[k], NO_FREE);
+				lhmsmv_t* ptyped_overlay = lhmsmv_alloc();
+				string_array_t* pregex_captures = NULL;
+				loop_stack_t* ploop_stack = loop_stack_alloc();
+				variables_t variables = (variables_t) {
+					.pinrec           = prec,
+					.ptyped_overlay   = ptyped_overlay,
+					.poosvars         = NULL,
+					.ppregex_captures = &pregex_captures,
+					.pctx             = pctx,
+					.ploop_stack      = ploop_stack,
+				};
+
+				mv_t tree_val = ptree->pprocess_func(ptree->pvstate, &variables);
+				mv_t bytecode_val = pbytecode->pprocess_func(pbytecode->pvstate, &variables);
+				char* tree_desc = mv_describe_val(tree_val);
+				char* bytecode_desc = mv_describe_val(bytecode_val);
+				printf("x=%s,y=%s,s=%s: tree %s bytecode %s\n",
+					xs[i] == NULL ? "(absent)" : xs[i],
+					ys[j] == NULL ? "(absent)" : ys[j],
+					ss[k] == NULL ? "(absent)" : ss[k],
+					tree_desc, bytecode_desc);
+				mu_assert_lf(tree_val.type == bytecode_val.type);
+				mu_assert_lf(streq(tree_desc, bytecode_desc));
+
+				free(tree_desc);
+				free(bytecode_desc);
+				mv_free(&tree_val);
+				mv_free(&bytecode_val);
+				loop_stack_free(ploop_stack);
+				lhmsmv_free(ptyped_overlay);
+				lrec_free(prec);
+			}
+		}
+	}
+
+	ptree->pfree_func(ptree);
+	pbytecode->pfree_func(pbytecode);
+	mlr_dsl_ast_node_free(pnode);
+
+	return 0;
+}
+
+// ----------------------------------------------------------------
+static char * test_constant_folding() {
+	printf("\n");
+	printf("-- TEST_RVAL_EVALUATORS test_constant_folding ENTER\n");
+	context_t ctx = {.nr = 888, .fnr = 999, .filenum = 123, .filename = "filename-goes-here", .force_eof = FALSE,
+		.ips = "=", .ifs = ",", .irs = "\n", .ops = "=", .ofs = ",", .ors = "\n", .auto_line_term = "\n"
+	};
+	fmgr_t* pfmgr = fmgr_alloc();
+	mv_t val;
+
+	// 2 * PI / 180
+	mlr_dsl_ast_node_t* pnode = mlr_dsl_ast_node_alloc_binary("/", MD_AST_NODE_TYPE_OPERATOR,
+		mlr_dsl_ast_node_alloc_binary("*", MD_AST_NODE_TYPE_OPERATOR,
+			mlr_dsl_ast_node_alloc("2", MD_AST_NODE_TYPE_NUMERIC_LITERAL),
+			mlr_dsl_ast_node_alloc("PI", MD_AST_NODE_TYPE_CONTEXT_VARIABLE)),
+		mlr_dsl_ast_node_alloc("180", MD_AST_NODE_TYPE_NUMERIC_LITERAL));
+	mu_assert_lf(rval_evaluator_try_fold(pnode, pfmgr, TYPE_INFER_STRING_FLOAT_INT, 0, &val));
+	mu_assert_lf(val.type == MT_FLOAT);
+	mu_assert_lf(val.u.fltv == 2 * M_PI / 180);
+	mlr_dsl_ast_node_free(pnode);
+
+	// strlen("abc") . "x"
+	pnode = mlr_dsl_ast_node_alloc_binary(".", MD_AST_NODE_TYPE_OPERATOR,
+		mlr_dsl_ast_node_alloc_unary("strlen", MD_AST_NODE_TYPE_FUNCTION_CALLSITE,
+			mlr_dsl_ast_node_alloc("abc", MD_AST_NODE_TYPE_STRING_LITERAL)),
+		mlr_dsl_ast_node_alloc("x", MD_AST_NODE_TYPE_STRING_LITERAL));
+	mu_assert_lf(rval_evaluator_try_fold(pnode, pfmgr, TYPE_INFER_STRING_FLOAT_INT, 0, &val));
+	mu_assert_lf(val.type == MT_STRING);
+	mu_assert_lf(streq(val.u.strv, "3x"));
+	mv_free(&val);
+	mlr_dsl_ast_node_free(pnode);
+
+	// Not folded: impure functions, $-variables, regex captures, and integer division by zero.
+	pnode = mlr_dsl_ast_node_alloc_binary("<", MD_AST_NODE_TYPE_OPERATOR,
+		mlr_dsl_ast_node_alloc_zary("urand", MD_AST_NODE_TYPE_FUNCTION_CALLSITE),
+		mlr_dsl_ast_node_alloc("2", MD_AST_NODE_TYPE_NUMERIC_LITERAL));
+	mu_assert_lf(!rval_evaluator_try_fold(pnode, pfmgr, TYPE_INFER_STRING_FLOAT_INT, 0, &val));
+	mlr_dsl_ast_node_free(pnode);
+
+	pnode = mlr_dsl_ast_node_alloc_binary("+", MD_AST_NODE_TYPE_OPERATOR,
+		mlr_dsl_ast_node_alloc("x", MD_AST_NODE_TYPE_FIELD_NAME),
+		mlr_dsl_ast_node_alloc("2", MD_AST_NODE_TYPE_NUMERIC_LITERAL));
+	mu_assert_lf(!rval_evaluator_try_fold(pnode, pfmgr, TYPE_INFER_STRING_FLOAT_INT, 0, &val));
+	mlr_dsl_ast_node_free(pnode);
+
+	pnode = mlr_dsl_ast_node_alloc_binary(".", MD_AST_NODE_TYPE_OPERATOR,
+		mlr_dsl_ast_node_alloc("\\1", MD_AST_NODE_TYPE_STRING_LITERAL),
+		mlr_dsl_ast_node_alloc("x", MD_AST_NODE_TYPE_STRING_LITERAL));
+	mu_assert_lf(!rval_evaluator_try_fold(pnode, pfmgr, TYPE_INFER_STRING_FLOAT_INT, 0, &val));
+	mlr_dsl_ast_node_free(pnode);
+
+	pnode = mlr_dsl_ast_node_alloc_binary("//", MD_AST_NODE_TYPE_OPERATOR,
+		mlr_dsl_ast_node_alloc("7", MD_AST_NODE_TYPE_NUMERIC_LITERAL),
+		mlr_dsl_ast_node_alloc_binary("-", MD_AST_NODE_TYPE_OPERATOR,
+			mlr_dsl_ast_node_alloc("1", MD_AST_NODE_TYPE_NUMERIC_LITERAL),
+			mlr_dsl_ast_node_alloc("1", MD_AST_NODE_TYPE_NUMERIC_LITERAL)));
+	mu_assert_lf(!rval_evaluator_try_fold(pnode, pfmgr, TYPE_INFER_STRING_FLOAT_INT, 0, &val));
+	mlr_dsl_ast_node_free(pnode);
+
+	// false && $x is false without looking at $x.
+	pnode = mlr_dsl_ast_node_alloc_binary("&&", MD_AST_NODE_TYPE_OPERATOR,
+		mlr_dsl_ast_node_alloc("false", MD_AST_NODE_TYPE_BOOLEAN_LITERAL),
+		mlr_dsl_ast_node_alloc("x", MD_AST_NODE_TYPE_FIELD_NAME));
+	rval_evaluator_t* pevaluator = rval_evaluator_alloc_from_ast(pnode, pfmgr, TYPE_INFER_STRING_FLOAT_INT, 0);
+	variables_t variables = (variables_t) { .pinrec = NULL, .pctx = &ctx };
+	val = pevaluator->pprocess_func(pevaluator->pvstate, &variables);
+	mu_assert_lf(val.type == MT_BOOLEAN);
+	mu_assert_lf(val.u.boolv == FALSE);
+	pevaluator->pfree_func(pevaluator);
+	mlr_dsl_ast_node_free(pnode);
+
+	fmgr_resolve_func_callsites(pfmgr);
+	fmgr_free(pfmgr, &ctx);
+
+	return 0;
+}
+
 // ================================================================
 static char * all_tests() {
 	mu_run_test(test_caps);
@@ -440,6 +618,8 @@ static char * all_tests() {
 	mu_run_test(test_logical_and);
 	mu_run_test(test_logical_or);
 	mu_run_test(test_logical_xor);
+	mu_run_test(test_bytecode_vs_tree);
+	mu_run_test(test_constant_folding);
 	// There is more operator testing in reg_test/run
 	return 0;
 }
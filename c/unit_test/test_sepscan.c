@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <string.h>
+#include "lib/minunit.h"
+#include "lib/mlr_globals.h"
+#include "lib/mlrutil.h"
+#include "lib/sepscan.h"
+
+int tests_run         = 0;
+int tests_failed      = 0;
+int assertions_run    = 0;
+int assertions_failed = 0;
+
+// ----------------------------------------------------------------
+// Checks a kernel against a byte-at-a-time search, for separators at every
+// offset of buffers of every length up to a few vector widths, so that the
+// vector loops and the scalar tails are both exercised.
+static int check_kernel(sepscan_func_t* pfunc) {
+	char buf[100];
+	for (int len = 0; len <= 96; len++) {
+		for (int pos = 0; pos <= len; pos++) {
+			memset(buf, 'x', sizeof(buf));
+			if (pos < len)
+				buf[pos] = ',';
+			buf[len] = ','; // Must not be found: it's at end
+			char* expected = &buf[pos];
+			if (pfunc(buf, &buf[len], '\n', ',', '=', '=') != expected)
+				return FALSE;
+			if (pos < len) {
+				buf[pos] = 0;
+				if (pfunc(buf, &buf[len], '\n', ',', '=', '=') != expected)
+					return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+static char * test_kernels() {
+	mu_assert_lf(check_kernel(sepscan_find_scalar));
+	if (sepscan_have_sse2())
+		mu_assert_lf(check_kernel(sepscan_find_sse2));
+	if (sepscan_have_avx2())
+		mu_assert_lf(check_kernel(sepscan_find_avx2));
+	return 0;
+}
+
+// ----------------------------------------------------------------
+static char * test_find() {
+	char* s = "abc=defghijklmnopqrstuvwxyz0123456789ABCDEFGHIJ,x=3\n";
+	char* e = s + strlen(s);
+	mu_assert_lf(sepscan_find(s, e, '\n', ',', '=', '=') == &s[3]);
+	mu_assert_lf(sepscan_find(&s[4], e, '\n', ',', '=', '=') == &s[47]);
+	mu_assert_lf(sepscan_find(&s[4], e, '\n', ',', ',', ',') == &s[47]);
+	mu_assert_lf(sepscan_find(&s[50], e, '\n', ',', ',', ',') == &s[51]);
+	mu_assert_lf(sepscan_find(s, e, ';', ';', ';', ';') == e);
+	mu_assert_lf(sepscan_find(e, e, ';', ';', ';', ';') == e);
+	return 0;
+}
+
+// ================================================================
+static char * all_tests() {
+	mu_run_test(test_kernels);
+	mu_run_test(test_find);
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	mlr_global_init(argv[0], NULL);
+	printf("TEST_SEPSCAN ENTER\n");
+	char *result = all_tests();
+	printf("\n");
+	if (result != 0) {
+		printf("Not all unit tests passed\n");
+	}
+	else {
+		printf("TEST_SEPSCAN: ALL UNIT TESTS PASSED\n");
+	}
+	printf("Tests      passed: %d of %d\n", tests_run - tests_failed, tests_run);
+	printf("Assertions passed: %d of %d\n", assertions_run - assertions_failed, assertions_run);
+
+	return result != 0;
+}